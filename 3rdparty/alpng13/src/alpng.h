@@ -44,6 +44,9 @@ alpng.h -- Main include file.
 
 extern char* alpng_error_msg;
 
+/* called regularly while decoding, allows the application to do other work (NULL by default) */
+extern void (*alpng_yield_hook)(void);
+
 /* registers PNG extension for load/save_bitmap */
 void alpng_init(void);
 
@@ -37,6 +37,8 @@ alpng_common.c -- Anything which doesn't fit anywhere else.
 
 char* alpng_error_msg = "No error.";
 
+void (*alpng_yield_hook)(void) = NULL;
+
 unsigned char ALPNG_PNG_HEADER[] = { 137, 80, 78, 71, 13, 10, 26, 10 };
 int ALPNG_PNG_HEADER_LEN = sizeof(ALPNG_PNG_HEADER);
 
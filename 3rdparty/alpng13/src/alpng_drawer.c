@@ -108,6 +108,7 @@ static BITMAP* read_rgb_with_alpha8(uint8_t* data, uint32_t data_length, struct
         return 0;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         for (x = 0; x < header->width; x++) {
             b->line[y][x * 4 + _rgb_r_shift_32 / 8] = data[1 + y * header->byte_width + x * 4];
             b->line[y][x * 4 + _rgb_g_shift_32 / 8] = data[2 + y * header->byte_width + x * 4];
@@ -131,6 +132,7 @@ static BITMAP* read_rgb_with_alpha16(uint8_t* data, uint32_t data_length, struct
         return 0;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         for (x = 0; x < header->width; x++) {
             b->line[y][x * 4 + _rgb_r_shift_32 / 8] = data[1 + y * header->byte_width + x * 8];
             b->line[y][x * 4 + _rgb_g_shift_32 / 8] = data[3 + y * header->byte_width + x * 8];
@@ -154,6 +156,7 @@ static BITMAP* read_grayscale_with_alpha8(uint8_t* data, uint32_t data_length, s
         return 0;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         for (x = 0; x < header->width; x++) {
             b->line[y][x * 4 + _rgb_r_shift_32 / 8] = data[1 + y * header->byte_width + x * 2];
             b->line[y][x * 4 + _rgb_g_shift_32 / 8] = data[1 + y * header->byte_width + x * 2];
@@ -177,6 +180,7 @@ static BITMAP* read_grayscale_with_alpha16(uint8_t* data, uint32_t data_length,
         return 0;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         for (x = 0; x < header->width; x++) {
             b->line[y][x * 4 + _rgb_r_shift_32 / 8] = data[1 + y * header->byte_width + x * 4];
             b->line[y][x * 4 + _rgb_g_shift_32 / 8] = data[1 + y * header->byte_width + x * 4];
@@ -200,6 +204,7 @@ static BITMAP* read_rgb16(uint8_t* data, uint32_t data_length, struct alpng_head
         return 0;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         for (x = 0; x < header->width; x++) {
             b->line[y][x * 3 + _rgb_r_shift_24 / 8] = data[1 + y * header->byte_width + x * 6];
             b->line[y][x * 3 + _rgb_g_shift_24 / 8] = data[3 + y * header->byte_width + x * 6];
@@ -222,6 +227,7 @@ static BITMAP* read_rgb8(uint8_t* data, uint32_t data_length, struct alpng_heade
         return 0;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         for (x = 0; x < header->width; x++) {
             b->line[y][x * 3 + _rgb_r_shift_24 / 8] = data[1 + y * header->byte_width + x * 3];
             b->line[y][x * 3 + _rgb_g_shift_24 / 8] = data[2 + y * header->byte_width + x * 3];
@@ -244,6 +250,7 @@ static BITMAP* read_grayscale16(uint8_t* data, uint32_t data_length, struct alpn
         return 0;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         for (x = 0; x < header->width; x++) {
             b->line[y][x * 3 + _rgb_r_shift_24 / 8] = data[1 + y * header->byte_width + x * 2];
             b->line[y][x * 3 + _rgb_g_shift_24 / 8] = data[1 + y * header->byte_width + x * 2];
@@ -288,6 +295,7 @@ static BITMAP* read_grayscale(uint8_t* data, uint32_t data_length, struct alpng_
         mask |= 1 << i;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         i = 0;
         for (x = 0; x < width; x++) {
             for (sx = j - 1; sx >= 0; sx--) {
@@ -325,6 +333,7 @@ static BITMAP* read_paletted(uint8_t* data, uint32_t data_length, struct alpng_h
         mask |= 1 << i;
     }
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         i = 0;
         for (x = 0; x < width; x++) {
             for (sx = j - 1; sx >= 0; sx--) {
@@ -92,6 +92,7 @@ int alpng_unfilter(uint8_t* data, struct alpng_header* header) {
     unsigned int y, x, filter_type, i, a, b, c;
     unsigned int filter_delta = calc_filter_delta(header);
     for (y = 0; y < header->height; y++) {
+        ALPNG_YIELD();
         i = y * header->byte_width;
         filter_type = data[i];
         switch (filter_type) {
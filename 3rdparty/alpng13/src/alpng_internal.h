@@ -36,6 +36,8 @@ alpng_internal.h -- Internally used structures and functions.
 extern unsigned char ALPNG_PNG_HEADER[];
 extern int ALPNG_PNG_HEADER_LEN;
 
+#define ALPNG_YIELD() do { if (alpng_yield_hook) alpng_yield_hook(); } while (0)
+
 struct alpng_chunk {
     uint32_t type;
     uint32_t length;
@@ -34,21 +34,42 @@ original_zlib.c -- Wrapper around original zlib implementation.
 #if defined(ALPNG_ZLIB) && (ALPNG_ZLIB == 1)
 
 #include <allegro.h>
+#include <string.h>
 #include <zlib.h>
+#include "../alpng.h"
+#include "../alpng_internal.h"
 #include "../inflate/inflate.h"
 #include "deflate.h"
 
+#define ALPNG_INFLATE_CHUNK (16 * 1024)
+
 /* Unpacks data. Returns 0 on error, unpacked data length otherwise.
    error_msg is assigned to the text of error message (text "OK" on success).
  */
 unsigned int alpng_inflate(struct input_data* data, unsigned char* unpacked_array, unsigned int unpacked_length, char** error_msg) {
-    uLongf real_length = unpacked_length;
-    int res = uncompress(unpacked_array, &real_length, data->data, data->length);
-    if (res != Z_OK) {
+    z_stream zs;
+    int res;
+    memset(&zs, 0, sizeof(zs));
+    zs.next_in = data->data;
+    zs.avail_in = data->length;
+    zs.next_out = unpacked_array;
+    if (inflateInit(&zs) != Z_OK) {
+        *error_msg = "Cannot decompress data!";
+        return 0;
+    }
+    /* inflate in chunks so the application can do other work in between */
+    do {
+        uLong left = unpacked_length - zs.total_out;
+        zs.avail_out = left < ALPNG_INFLATE_CHUNK ? left : ALPNG_INFLATE_CHUNK;
+        res = inflate(&zs, Z_NO_FLUSH);
+        ALPNG_YIELD();
+    } while (res == Z_OK);
+    inflateEnd(&zs);
+    if (res != Z_STREAM_END) {
         *error_msg = "Cannot decompress data!";
         return 0;
     }
-    return real_length;
+    return zs.total_out;
 }
 
 int alpng_deflate(uint8_t* data, uint32_t data_length, uint8_t** compressed_data, uint32_t* compressed_data_length, char** error_msg) {
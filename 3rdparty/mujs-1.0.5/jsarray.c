@@ -2,45 +2,6 @@
 #include "jsvalue.h"
 #include "jsbuiltin.h"
 
-int js_getlength(js_State *J, int idx)
-{
-	int len;
-	js_getproperty(J, idx, "length");
-	len = js_tointeger(J, -1);
-	js_pop(J, 1);
-	return len;
-}
-
-void js_setlength(js_State *J, int idx, int len)
-{
-	js_pushnumber(J, len);
-	js_setproperty(J, idx < 0 ? idx - 1 : idx, "length");
-}
-
-int js_hasindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	return js_hasproperty(J, idx, js_itoa(buf, i));
-}
-
-void js_getindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	js_getproperty(J, idx, js_itoa(buf, i));
-}
-
-void js_setindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	js_setproperty(J, idx, js_itoa(buf, i));
-}
-
-void js_delindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	js_delproperty(J, idx, js_itoa(buf, i));
-}
-
 static void jsB_new_Array(js_State *J)
 {
 	int i, top = js_gettop(J);
@@ -63,6 +24,18 @@ static void jsB_new_Array(js_State *J)
 	}
 }
 
+/* Return the array at idx if its elements are all in the flat vector. */
+static js_Object *Ap_flat(js_State *J, int idx)
+{
+	js_Object *obj;
+	if (!js_isobject(J, idx))
+		return NULL;
+	obj = js_toobject(J, idx);
+	if (obj->type != JS_CARRAY || !obj->u.a.simple || obj->u.a.length != obj->u.a.flat_length)
+		return NULL;
+	return obj;
+}
+
 static void Ap_concat(js_State *J)
 {
 	int i, top = js_gettop(J);
@@ -203,6 +176,7 @@ static void Ap_reverse(js_State *J)
 
 static void Ap_shift(js_State *J)
 {
+	js_Object *obj;
 	int k, len;
 
 	len = js_getlength(J, 0);
@@ -213,6 +187,14 @@ static void Ap_shift(js_State *J)
 		return;
 	}
 
+	obj = Ap_flat(J, 0);
+	if (obj) {
+		js_pushvalue(J, obj->u.a.array[0]);
+		memmove(obj->u.a.array, obj->u.a.array + 1, (len - 1) * sizeof *obj->u.a.array);
+		obj->u.a.flat_length = obj->u.a.length = len - 1;
+		return;
+	}
+
 	js_getindex(J, 0, 0);
 
 	for (k = 1; k < len; ++k) {
@@ -228,6 +210,7 @@ static void Ap_shift(js_State *J)
 
 static void Ap_slice(js_State *J)
 {
+	js_Object *obj;
 	int len, s, e, n;
 	double sv, ev;
 
@@ -243,6 +226,15 @@ static void Ap_slice(js_State *J)
 	s = sv < 0 ? 0 : sv > len ? len : sv;
 	e = ev < 0 ? 0 : ev > len ? len : ev;
 
+	obj = Ap_flat(J, 0);
+	if (obj && s < e) {
+		js_Object *res = js_toobject(J, -1);
+		jsV_growarray(J, res, e - s);
+		memcpy(res->u.a.array, obj->u.a.array + s, (e - s) * sizeof *res->u.a.array);
+		res->u.a.flat_length = res->u.a.length = e - s;
+		return;
+	}
+
 	for (n = 0; s < e; ++s, ++n)
 		if (js_hasindex(J, 0, s))
 			js_setindex(J, -2, n);
@@ -395,11 +387,24 @@ static void Ap_splice(js_State *J)
 
 static void Ap_unshift(js_State *J)
 {
+	js_Object *obj;
 	int i, top = js_gettop(J);
 	int k, len;
 
 	len = js_getlength(J, 0);
 
+	obj = Ap_flat(J, 0);
+	if (obj && len + top - 1 <= JS_FLATLIMIT) {
+		jsV_growarray(J, obj, len + top - 1);
+		memmove(obj->u.a.array + top - 1, obj->u.a.array, len * sizeof *obj->u.a.array);
+		jsG_barrier(J, obj);
+		for (i = 1; i < top; ++i)
+			obj->u.a.array[i - 1] = *js_tovalue(J, i);
+		obj->u.a.flat_length = obj->u.a.length = len + top - 1;
+		js_pushnumber(J, len + top - 1);
+		return;
+	}
+
 	for (k = len; k > 0; --k) {
 		int from = k - 1;
 		int to = k + top - 2;
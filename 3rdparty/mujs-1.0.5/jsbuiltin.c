@@ -200,6 +200,8 @@ void jsB_init(js_State *J)
 	J->String_prototype = jsV_newobject(J, JS_CSTRING, J->Object_prototype);
 	J->RegExp_prototype = jsV_newobject(J, JS_COBJECT, J->Object_prototype);
 	J->Date_prototype = jsV_newobject(J, JS_CDATE, J->Object_prototype);
+	J->ArrayBuffer_prototype = jsV_newobject(J, JS_COBJECT, J->Object_prototype);
+	J->DataView_prototype = jsV_newobject(J, JS_COBJECT, J->Object_prototype);
 
 	/* All the native error types */
 	J->Error_prototype = jsV_newobject(J, JS_CERROR, J->Object_prototype);
@@ -213,6 +215,7 @@ void jsB_init(js_State *J)
 	/* Create the constructors and fill out the prototype objects */
 	jsB_initobject(J);
 	jsB_initarray(J);
+	jsB_inittypedarray(J);
 	jsB_initfunction(J);
 	jsB_initboolean(J);
 	jsB_initnumber(J);
@@ -4,6 +4,7 @@
 void jsB_init(js_State *J);
 void jsB_initobject(js_State *J);
 void jsB_initarray(js_State *J);
+void jsB_inittypedarray(js_State *J);
 void jsB_initfunction(js_State *J);
 void jsB_initboolean(js_State *J);
 void jsB_initnumber(js_State *J);
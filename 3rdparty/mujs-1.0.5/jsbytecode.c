@@ -0,0 +1,353 @@
+#include "jsi.h"
+#include "jscompile.h"
+#include "jsvalue.h"
+
+/*
+	Serialized form of compiled functions, so that scripts do not have to
+	be parsed and compiled again. The data is only meant to be read back by
+	the same build of the interpreter on the same machine: numbers are
+	stored in native byte order and the header holds a hash of the opcode
+	table, so any change to the instruction set invalidates old files.
+
+	header: "MJSC" version optimized ophash
+	function: name script lightweight strict arguments numparams line
+		numtab strtab vartab cachetab code funtab
+
+	Every operand is checked against the tables of its function when the
+	code is loaded, a corrupt file can't make the interpreter index out of
+	bounds or jump into the middle of an instruction.
+*/
+
+#define JS_BCMAGIC "MJSC"
+#define JS_BCVERSION 3
+
+/* FNV-1a over the name and operand count of every opcode and the sizes of the stored types */
+static int ophash(void)
+{
+	unsigned int h = 2166136261u;
+	const char *s;
+	int op;
+
+	for (op = 0; op <= OP_GETMETHOD_S; ++op) {
+		for (s = jsC_opcodestring(op); *s; ++s)
+			h = (h ^ (unsigned char)*s) * 16777619u;
+		h = (h ^ jsC_oplength(op)) * 16777619u;
+	}
+	h = (h ^ sizeof(js_Instruction)) * 16777619u;
+	h = (h ^ sizeof(int)) * 16777619u;
+	h = (h ^ sizeof(double)) * 16777619u;
+	return (int)h;
+}
+
+static void putint(js_State *J, js_Buffer **sb, int v)
+{
+	js_putm(J, sb, (const char *)&v, (const char *)&v + sizeof v);
+}
+
+static void putstr(js_State *J, js_Buffer **sb, const char *s)
+{
+	js_puts(J, sb, s);
+	js_putc(J, sb, 0);
+}
+
+static void putfunction(js_State *J, js_Buffer **sb, js_Function *F)
+{
+	int i;
+
+	putstr(J, sb, F->name);
+	putint(J, sb, F->script);
+	putint(J, sb, F->lightweight);
+	putint(J, sb, F->strict);
+	putint(J, sb, F->arguments);
+	putint(J, sb, F->numparams);
+	putint(J, sb, F->line);
+
+	putint(J, sb, F->numlen);
+	js_putm(J, sb, (const char *)F->numtab, (const char *)(F->numtab + F->numlen));
+
+	putint(J, sb, F->strlen);
+	for (i = 0; i < F->strlen; ++i)
+		putstr(J, sb, F->strtab[i]);
+
+	putint(J, sb, F->varlen);
+	for (i = 0; i < F->varlen; ++i)
+		putstr(J, sb, F->vartab[i]);
+
+	putint(J, sb, F->cachelen);
+	for (i = 0; i < F->cachelen; ++i) {
+		putstr(J, sb, F->cachetab[i].name);
+		putint(J, sb, F->cachetab[i].line);
+	}
+
+	putint(J, sb, F->codelen);
+	js_putm(J, sb, (const char *)F->code, (const char *)(F->code + F->codelen));
+
+	putint(J, sb, F->funlen);
+	for (i = 0; i < F->funlen; ++i) {
+		if (F->funtab[i] == F) {
+			putint(J, sb, 1);
+		} else {
+			putint(J, sb, 0);
+			putfunction(J, sb, F->funtab[i]);
+		}
+	}
+}
+
+void js_savebytecode(js_State *J, int idx, js_Writer write, void *ctx)
+{
+	js_Buffer *sb = NULL;
+	js_Object *obj;
+
+	if (!js_iscallable(J, idx))
+		js_typeerror(J, "not a function");
+	obj = js_toobject(J, idx);
+	if (obj->type != JS_CFUNCTION && obj->type != JS_CSCRIPT)
+		js_typeerror(J, "not a compiled function");
+
+	if (js_try(J)) {
+		js_free(J, sb);
+		js_throw(J);
+	}
+
+	js_puts(J, &sb, JS_BCMAGIC);
+	js_putc(J, &sb, JS_BCVERSION);
+	js_putc(J, &sb, J->optimize);
+	putint(J, &sb, ophash());
+	putfunction(J, &sb, obj->u.f.function);
+
+	write(ctx, sb->s, sb->n);
+
+	js_endtry(J);
+	js_free(J, sb);
+}
+
+typedef struct {
+	const char *p, *end;
+	const char *filename;
+} js_BytecodeReader;
+
+static JS_NORETURN void badbytecode(js_State *J, js_BytecodeReader *R)
+{
+	js_error(J, "%s: invalid bytecode", R->filename);
+}
+
+static void getmem(js_State *J, js_BytecodeReader *R, void *dst, int n)
+{
+	if (n < 0 || R->end - R->p < n)
+		badbytecode(J, R);
+	if (n > 0)
+		memcpy(dst, R->p, n);
+	R->p += n;
+}
+
+static int getint(js_State *J, js_BytecodeReader *R)
+{
+	int v;
+	getmem(J, R, &v, sizeof v);
+	return v;
+}
+
+static int getcount(js_State *J, js_BytecodeReader *R)
+{
+	int n = getint(J, R);
+	if (n < 0 || n > R->end - R->p)
+		badbytecode(J, R);
+	return n;
+}
+
+static void *newtab(js_State *J, int n, int size)
+{
+	return n > 0 ? js_malloc(J, n * size) : NULL;
+}
+
+static const char *getstr(js_State *J, js_BytecodeReader *R)
+{
+	const char *s = R->p;
+	const char *e = memchr(s, 0, R->end - s);
+	if (!e)
+		badbytecode(J, R);
+	R->p = e + 1;
+	return js_intern(J, s);
+}
+
+static void checkindex(js_State *J, js_BytecodeReader *R, int i, int len)
+{
+	if (i < 0 || i >= len)
+		badbytecode(J, R);
+}
+
+/* Check every opcode and operand of a loaded function against its tables. */
+static void checkcode(js_State *J, js_BytecodeReader *R, js_Function *F)
+{
+	js_Instruction *code = F->code;
+	int n = F->codelen;
+	unsigned char *start;
+	int pc, op, last = -1;
+
+	start = js_malloc(J, n + 1);
+	memset(start, 0, n + 1);
+
+	if (js_try(J)) {
+		js_free(J, start);
+		js_throw(J);
+	}
+
+	for (pc = 0; pc < n; pc += 2 + jsC_oplength(op)) {
+		if (pc + 2 > n)
+			badbytecode(J, R);
+		op = code[pc+1];
+		if (op > OP_GETMETHOD_S || pc + 2 + jsC_oplength(op) > n)
+			badbytecode(J, R);
+		start[pc] = 1;
+		last = op;
+
+		switch (op) {
+		case OP_NUMBER:
+			checkindex(J, R, code[pc+2], F->numlen);
+			break;
+		case OP_STRING:
+		case OP_NEWREGEXP:
+		case OP_HASVAR:
+		case OP_GETVAR:
+		case OP_SETVAR:
+		case OP_DELVAR:
+		case OP_DELPROP_S:
+		case OP_CATCH:
+		case OP_GETVARUNDEF:
+			checkindex(J, R, code[pc+2], F->strlen);
+			break;
+		case OP_GETPROP_S:
+		case OP_SETPROP_S:
+		case OP_GETMETHOD_S:
+			checkindex(J, R, code[pc+2], F->strlen);
+			checkindex(J, R, code[pc+3], F->cachelen);
+			break;
+		case OP_CLOSURE:
+			checkindex(J, R, code[pc+2], F->funlen);
+			break;
+		case OP_GETLOCAL:
+		case OP_SETLOCAL:
+		case OP_DELLOCAL:
+		case OP_SETLOCALPOP:
+		case OP_GETLOCALINT:
+			checkindex(J, R, code[pc+2] - 1, F->varlen);
+			break;
+		case OP_GETLOCAL2:
+			checkindex(J, R, code[pc+2] - 1, F->varlen);
+			checkindex(J, R, code[pc+3] - 1, F->varlen);
+			break;
+		}
+	}
+
+	/* execution must not run off the end of the code */
+	if (last != OP_RETURN && last != OP_JUMP && last != OP_THROW)
+		badbytecode(J, R);
+
+	/* jumps and exception landing pads must hit the start of an instruction */
+	for (pc = 0; pc < n; pc += 2 + jsC_oplength(op)) {
+		op = code[pc+1];
+		if (op == OP_JUMP || op == OP_JTRUE || op == OP_JFALSE || op == OP_JCASE || op == OP_TRY)
+			if (code[pc+2] >= n || !start[code[pc+2]])
+				badbytecode(J, R);
+		if (op == OP_TRY && !start[pc+3])
+			badbytecode(J, R);
+	}
+
+	js_endtry(J);
+	js_free(J, start);
+}
+
+static js_Function *getfunction(js_State *J, js_BytecodeReader *R)
+{
+	js_Function *F;
+	int i, n;
+
+	F = js_malloc(J, sizeof *F);
+	memset(F, 0, sizeof *F);
+	F->gcmark = jsG_newmark(J);
+	F->gcnext = J->gcfun;
+	J->gcfun = F;
+	++J->gccounter;
+
+	F->filename = js_intern(J, R->filename);
+	F->name = getstr(J, R);
+	F->script = getint(J, R);
+	F->lightweight = getint(J, R);
+	F->strict = getint(J, R);
+	F->arguments = getint(J, R);
+	F->numparams = getint(J, R);
+	F->line = F->lastline = getint(J, R);
+
+	n = getcount(J, R);
+	F->numtab = newtab(J, n, sizeof *F->numtab);
+	F->numcap = n;
+	getmem(J, R, F->numtab, n * sizeof *F->numtab);
+	F->numlen = n;
+
+	n = getcount(J, R);
+	F->strtab = newtab(J, n, sizeof *F->strtab);
+	F->strcap = n;
+	for (i = 0; i < n; ++i)
+		F->strtab[F->strlen++] = getstr(J, R);
+
+	n = getcount(J, R);
+	F->vartab = newtab(J, n, sizeof *F->vartab);
+	F->varcap = n;
+	for (i = 0; i < n; ++i)
+		F->vartab[F->varlen++] = getstr(J, R);
+
+	n = getcount(J, R);
+	F->cachetab = newtab(J, n, sizeof *F->cachetab);
+	F->cachecap = n;
+	for (i = 0; i < n; ++i) {
+		js_InlineCache *ic = &F->cachetab[F->cachelen++];
+		memset(ic, 0, sizeof *ic);
+		ic->name = getstr(J, R);
+		ic->hash = jsS_internhash(ic->name);
+		ic->line = getint(J, R);
+	}
+
+	n = getcount(J, R);
+	F->code = newtab(J, n, sizeof *F->code);
+	F->codecap = n;
+	getmem(J, R, F->code, n * sizeof *F->code);
+	F->codelen = n;
+
+	n = getcount(J, R);
+	F->funtab = newtab(J, n, sizeof *F->funtab);
+	F->funcap = n;
+	for (i = 0; i < n; ++i) {
+		js_Function *sub = getint(J, R) ? F : getfunction(J, R);
+		F->funtab[F->funlen++] = sub;
+	}
+
+	checkcode(J, R, F);
+
+	return F;
+}
+
+void js_loadbytecode(js_State *J, const char *filename, const void *data, int size)
+{
+	js_BytecodeReader R;
+	js_Function *F;
+	char header[6];
+
+	R.p = data;
+	R.end = R.p + size;
+	R.filename = filename;
+
+	getmem(J, &R, header, sizeof header);
+	if (memcmp(header, JS_BCMAGIC, 4) || header[4] != JS_BCVERSION || getint(J, &R) != ophash())
+		badbytecode(J, &R);
+	if (header[5] != J->optimize)
+		js_error(J, "%s: bytecode was compiled with different optimizer settings", filename);
+
+	F = getfunction(J, &R);
+	if (R.p != R.end)
+		badbytecode(J, &R);
+
+	if (F->script)
+		js_newscript(J, F, J->GE);
+	else
+		js_newfunction(J, F, J->GE);
+}
@@ -14,6 +14,7 @@ static void cfunbody(JF, js_Ast *name, js_Ast *params, js_Ast *body);
 static void cexp(JF, js_Ast *exp);
 static void cstmlist(JF, js_Ast *list);
 static void cstm(JF, js_Ast *stm);
+static void optimize(JF);
 
 void jsC_error(js_State *J, js_Ast *node, const char *fmt, ...)
 {
@@ -55,7 +56,7 @@ static js_Function *newfun(js_State *J, int line, js_Ast *name, js_Ast *params,
 {
 	js_Function *F = js_malloc(J, sizeof *F);
 	memset(F, 0, sizeof *F);
-	F->gcmark = 0;
+	F->gcmark = jsG_newmark(J);
 	F->gcnext = J->gcfun;
 	J->gcfun = F;
 	++J->gccounter;
@@ -67,6 +68,8 @@ static js_Function *newfun(js_State *J, int line, js_Ast *name, js_Ast *params,
 	F->name = name ? name->string : "";
 
 	cfunbody(J, F, name, params, body);
+	if (J->optimize)
+		optimize(J, F);
 
 	return F;
 }
@@ -138,6 +141,19 @@ static int addstring(JF, const char *value)
 	return F->strlen++;
 }
 
+static void addfree(JF, const char *name)
+{
+	int i;
+	for (i = 0; i < F->freelen; ++i)
+		if (!strcmp(F->freetab[i], name))
+			return;
+	if (F->freelen >= F->freecap) {
+		F->freecap = F->freecap ? F->freecap * 2 : 16;
+		F->freetab = js_realloc(J, F->freetab, F->freecap * sizeof *F->freetab);
+	}
+	F->freetab[F->freelen++] = name;
+}
+
 static int addlocal(JF, js_Ast *ident, int reuse)
 {
 	const char *name = ident->string;
@@ -180,7 +196,6 @@ static int findlocal(JF, const char *name)
 
 static void emitfunction(JF, js_Function *fun)
 {
-	F->lightweight = 0;
 	emit(J, F, OP_CLOSURE);
 	emitarg(J, F, addfunction(J, F, fun));
 }
@@ -211,6 +226,22 @@ static void emitstring(JF, int opcode, const char *str)
 	emitarg(J, F, addstring(J, F, str));
 }
 
+static void emitpropcache(JF, int opcode, const char *str)
+{
+	js_InlineCache *ic;
+	emitstring(J, F, opcode, str);
+	if (F->cachelen >= F->cachecap) {
+		F->cachecap = F->cachecap ? F->cachecap * 2 : 16;
+		F->cachetab = js_realloc(J, F->cachetab, F->cachecap * sizeof *F->cachetab);
+	}
+	ic = &F->cachetab[F->cachelen];
+	memset(ic, 0, sizeof *ic);
+	ic->name = js_intern(J, str);
+	ic->hash = jsS_internhash(ic->name);
+	ic->line = F->lastline;
+	emitarg(J, F, F->cachelen++);
+}
+
 static void emitlocal(JF, int oploc, int opvar, js_Ast *ident)
 {
 	int is_arguments = !strcmp(ident->string, "arguments");
@@ -234,6 +265,7 @@ static void emitlocal(JF, int oploc, int opvar, js_Ast *ident)
 
 	i = findlocal(J, F, ident->string);
 	if (i < 0) {
+		addfree(J, F, ident->string);
 		emitstring(J, F, opvar, ident->string);
 	} else {
 		emit(J, F, oploc);
@@ -421,7 +453,7 @@ static void cassign(JF, js_Ast *exp)
 		cexp(J, F, lhs->a);
 		cexp(J, F, rhs);
 		emitline(J, F, exp);
-		emitstring(J, F, OP_SETPROP_S, lhs->b->string);
+		emitpropcache(J, F, OP_SETPROP_S, lhs->b->string);
 		break;
 	default:
 		jsC_error(J, lhs, "invalid l-value in assignment");
@@ -459,7 +491,7 @@ static void cassignforin(JF, js_Ast *stm)
 		cexp(J, F, lhs->a);
 		emitline(J, F, lhs);
 		emit(J, F, OP_ROT2);
-		emitstring(J, F, OP_SETPROP_S, lhs->b->string);
+		emitpropcache(J, F, OP_SETPROP_S, lhs->b->string);
 		emit(J, F, OP_POP);
 		break;
 	default:
@@ -485,7 +517,7 @@ static void cassignop1(JF, js_Ast *lhs)
 		cexp(J, F, lhs->a);
 		emitline(J, F, lhs);
 		emit(J, F, OP_DUP);
-		emitstring(J, F, OP_GETPROP_S, lhs->b->string);
+		emitpropcache(J, F, OP_GETPROP_S, lhs->b->string);
 		break;
 	default:
 		jsC_error(J, lhs, "invalid l-value in assignment");
@@ -508,7 +540,7 @@ static void cassignop2(JF, js_Ast *lhs, int postfix)
 	case EXP_MEMBER:
 		emitline(J, F, lhs);
 		if (postfix) emit(J, F, OP_ROT3);
-		emitstring(J, F, OP_SETPROP_S, lhs->b->string);
+		emitpropcache(J, F, OP_SETPROP_S, lhs->b->string);
 		break;
 	default:
 		jsC_error(J, lhs, "invalid l-value in assignment");
@@ -556,6 +588,7 @@ static void ceval(JF, js_Ast *fun, js_Ast *args)
 {
 	int n = cargs(J, F, args);
 	F->lightweight = 0;
+	F->dyneval = 1;
 	if (n == 0)
 		emit(J, F, OP_UNDEF);
 	else while (n-- > 1)
@@ -577,7 +610,7 @@ static void ccall(JF, js_Ast *fun, js_Ast *args)
 	case EXP_MEMBER:
 		cexp(J, F, fun->a);
 		emit(J, F, OP_DUP);
-		emitstring(J, F, OP_GETPROP_S, fun->b->string);
+		emitpropcache(J, F, OP_GETPROP_S, fun->b->string);
 		emit(J, F, OP_ROT2);
 		break;
 	case EXP_IDENTIFIER:
@@ -670,7 +703,7 @@ static void cexp(JF, js_Ast *exp)
 	case EXP_MEMBER:
 		cexp(J, F, exp->a);
 		emitline(J, F, exp);
-		emitstring(J, F, OP_GETPROP_S, exp->b->string);
+		emitpropcache(J, F, OP_GETPROP_S, exp->b->string);
 		break;
 
 	case EXP_CALL:
@@ -1300,7 +1333,9 @@ static void cstm(JF, js_Ast *stm)
 	case STM_TRY:
 		emitline(J, F, stm);
 		if (stm->b && stm->c) {
-			F->lightweight = 0;
+			/* a catch variable that shadows a local must be looked up by name */
+			if (findlocal(J, F, stm->b->string) >= 0)
+				F->lightweight = 0;
 			if (stm->d)
 				ctrycatchfinally(J, F, stm->a, stm->b, stm->c, stm->d);
 			else
@@ -1337,6 +1372,197 @@ static void cstmlist(JF, js_Ast *list)
 	}
 }
 
+/* Bytecode optimizer */
+
+int jsC_oplength(int opcode)
+{
+	switch (opcode) {
+	case OP_NEWREGEXP:
+	case OP_GETPROP_S:
+	case OP_SETPROP_S:
+	case OP_GETLOCAL2:
+	case OP_GETLOCALINT:
+	case OP_GETMETHOD_S:
+		return 2;
+	case OP_INTEGER:
+	case OP_NUMBER:
+	case OP_STRING:
+	case OP_CLOSURE:
+	case OP_GETLOCAL:
+	case OP_SETLOCAL:
+	case OP_DELLOCAL:
+	case OP_HASVAR:
+	case OP_GETVAR:
+	case OP_SETVAR:
+	case OP_DELVAR:
+	case OP_DELPROP_S:
+	case OP_CALL:
+	case OP_NEW:
+	case OP_JCASE:
+	case OP_TRY:
+	case OP_CATCH:
+	case OP_JUMP:
+	case OP_JTRUE:
+	case OP_JFALSE:
+	case OP_SETLOCALPOP:
+	case OP_GETVARUNDEF:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static int isjump(int opcode)
+{
+	return opcode == OP_JUMP || opcode == OP_JTRUE || opcode == OP_JFALSE ||
+		opcode == OP_JCASE || opcode == OP_TRY;
+}
+
+static int jumpdest(js_Instruction *code, int pc)
+{
+	int n = 0;
+	/* follow chains of unconditional jumps, but not forever */
+	while (code[pc+1] == OP_JUMP && n++ < 16)
+		pc = code[pc+2];
+	return pc;
+}
+
+/* Returns the number of code words fused into the superinstruction in out. */
+static int fuse(js_Instruction *code, int n, unsigned char *target, int pc, js_Instruction *out)
+{
+	int a = pc + 2 + jsC_oplength(code[pc+1]);
+	int b;
+
+	if (a >= n || target[a] || code[a] != code[pc])
+		return 0;
+
+	switch (code[pc+1]) {
+	case OP_SETLOCAL:
+		if (code[a+1] == OP_POP) {
+			out[0] = OP_SETLOCALPOP;
+			out[1] = code[pc+2];
+			return a + 2 - pc;
+		}
+		break;
+	case OP_GETLOCAL:
+		if (code[a+1] == OP_GETLOCAL || code[a+1] == OP_INTEGER) {
+			out[0] = code[a+1] == OP_GETLOCAL ? OP_GETLOCAL2 : OP_GETLOCALINT;
+			out[1] = code[pc+2];
+			out[2] = code[a+2];
+			return a + 3 - pc;
+		}
+		break;
+	case OP_GETVAR:
+		if (code[a+1] == OP_UNDEF) {
+			out[0] = OP_GETVARUNDEF;
+			out[1] = code[pc+2];
+			return a + 2 - pc;
+		}
+		break;
+	case OP_DUP:
+		b = a + 4;
+		if (code[a+1] == OP_GETPROP_S && b < n && !target[b] && code[b] == code[pc] && code[b+1] == OP_ROT2) {
+			out[0] = OP_GETMETHOD_S;
+			out[1] = code[a+2];
+			out[2] = code[a+3];
+			return b + 2 - pc;
+		}
+		break;
+	}
+	return 0;
+}
+
+/*
+	Rewrite the finished bytecode of a function: thread jumps to jumps,
+	remove unreachable code and jumps to the next instruction, and fuse
+	common instruction sequences into superinstructions. Jump targets are
+	never fused away, so every target has a place in the new code.
+*/
+static void optimize(JF)
+{
+	int n = F->codelen;
+	char *block;
+	int *map, *fix;
+	js_Instruction *code, sup[3];
+	unsigned char *target;
+	int pc, next, len, k, nfix, op, dest, live, i;
+
+	block = js_malloc(J, (n + 1) * (2 * sizeof *map + sizeof *code + sizeof *target));
+	map = (int*)block;
+	fix = map + n + 1;
+	code = (js_Instruction*)(fix + n + 1);
+	target = (unsigned char*)(code + n + 1);
+
+	memcpy(code, F->code, n * sizeof *code);
+	memset(target, 0, n + 1);
+
+	for (pc = 0; pc < n; pc += 2 + jsC_oplength(op)) {
+		op = code[pc+1];
+		if (isjump(op))
+			code[pc+2] = jumpdest(code, code[pc+2]);
+	}
+
+	for (pc = 0; pc < n; pc += 2 + jsC_oplength(op)) {
+		op = code[pc+1];
+		if (isjump(op))
+			target[code[pc+2]] = 1;
+		if (op == OP_TRY)
+			target[pc+3] = 1; /* exception landing pad */
+	}
+
+	k = nfix = 0;
+	live = 1;
+	for (pc = 0; pc < n; pc += len) {
+		op = code[pc+1];
+		len = 2 + jsC_oplength(op);
+		if (target[pc])
+			live = 1;
+		if (!live)
+			continue;
+		map[pc] = k;
+
+		if (op == OP_JUMP) {
+			dest = code[pc+2];
+			live = 0;
+			if (code[dest+1] == OP_RETURN) {
+				F->code[k++] = code[pc];
+				F->code[k++] = OP_RETURN;
+				continue;
+			}
+			next = pc + len;
+			while (next < n && !target[next])
+				next += 2 + jsC_oplength(code[next+1]);
+			if (next == dest)
+				continue;
+		}
+
+		if (op == OP_RETURN || op == OP_THROW)
+			live = 0;
+
+		len = fuse(code, n, target, pc, sup);
+		if (len > 0) {
+			F->code[k++] = code[pc];
+			for (i = 0; i <= jsC_oplength(sup[0]); ++i)
+				F->code[k++] = sup[i];
+			continue;
+		}
+
+		len = 2 + jsC_oplength(op);
+		if (isjump(op))
+			fix[nfix++] = k + 2;
+		memcpy(F->code + k, code + pc, len * sizeof *code);
+		k += len;
+	}
+
+	while (nfix > 0) {
+		--nfix;
+		F->code[fix[nfix]] = map[F->code[fix[nfix]]];
+	}
+	F->codelen = k;
+
+	js_free(J, block);
+}
+
 /* Declarations and programs */
 
 static int listlength(js_Ast *list)
@@ -1396,6 +1622,35 @@ static void cfundecs(JF, js_Ast *list)
 	}
 }
 
+/*
+	A lightweight function keeps its locals on the stack and has no
+	environment of its own, so its inner functions are created in the scope
+	of the enclosing function. That is only correct if none of them refers
+	to a local of this function by name. This is checked once all locals are
+	known, the free names of the inner functions that are not locals here
+	are passed on to the enclosing function.
+*/
+static void cclosures(JF)
+{
+	int i, k;
+	for (i = 0; i < F->funlen; ++i) {
+		js_Function *fun = F->funtab[i];
+		if (fun->dyneval) {
+			F->lightweight = 0;
+			F->dyneval = 1;
+		}
+		for (k = 0; k < fun->freelen; ++k) {
+			if (findlocal(J, F, fun->freetab[k]) < 0)
+				addfree(J, F, fun->freetab[k]);
+			else
+				F->lightweight = 0;
+		}
+		js_free(J, fun->freetab);
+		fun->freetab = NULL;
+		fun->freelen = fun->freecap = 0;
+	}
+}
+
 static void cfunbody(JF, js_Ast *name, js_Ast *params, js_Ast *body)
 {
 	F->lightweight = 1;
@@ -1437,6 +1692,8 @@ static void cfunbody(JF, js_Ast *name, js_Ast *params, js_Ast *body)
 		emit(J, F, OP_UNDEF);
 		emit(J, F, OP_RETURN);
 	}
+
+	cclosures(J, F);
 }
 
 js_Function *jsC_compilefunction(js_State *J, js_Ast *prog)
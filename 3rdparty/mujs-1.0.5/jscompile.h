@@ -43,9 +43,9 @@ enum js_OpCode
 	OP_INITSETTER,	/* <obj> <key> <closure> -- <obj> */
 
 	OP_GETPROP,	/* <obj> <name> -- <value> */
-	OP_GETPROP_S,	/* <obj> -S- <value> */
+	OP_GETPROP_S,	/* <obj> -S,C- <value> */
 	OP_SETPROP,	/* <obj> <name> <value> -- <value> */
-	OP_SETPROP_S,	/* <obj> <value> -S- <value> */
+	OP_SETPROP_S,	/* <obj> <value> -S,C- <value> */
 	OP_DELPROP,	/* <obj> <name> -- <success> */
 	OP_DELPROP_S,	/* <obj> -S- <success> */
 
@@ -105,6 +105,32 @@ enum js_OpCode
 	OP_JTRUE,
 	OP_JFALSE,
 	OP_RETURN,
+
+	/* Superinstructions, only emitted by the bytecode optimizer */
+	OP_SETLOCALPOP,	/* <value> -K- */
+	OP_GETLOCAL2,	/* -K,K- <value> <value> */
+	OP_GETLOCALINT,	/* -K,K- <value> (number-32768) */
+	OP_GETVARUNDEF,	/* -S- <value> undefined */
+	OP_GETMETHOD_S,	/* <obj> -S,C- <value> <obj> */
+};
+
+/*
+	Inline cache for the named property load and store opcodes (their C
+	operand). A hit needs the receiver to have the cached shape, or for
+	inherited properties, the cached prototype and no own property of that
+	name. Inherited entries are dropped when any prototype object changes.
+*/
+struct js_InlineCache
+{
+	const char *name; /* interned */
+	unsigned int hash;
+	int line;
+	int type; /* enum js_Class of the receiver */
+	unsigned int shape;
+	js_Object *proto; /* NULL for own properties */
+	unsigned int epoch;
+	struct js_Property *ref;
+	unsigned int hits, misses;
 };
 
 struct js_Function
@@ -131,6 +157,14 @@ struct js_Function
 	const char **vartab;
 	int varcap, varlen;
 
+	/* names resolved outside the function and its inner functions, only kept while compiling the enclosing function */
+	const char **freetab;
+	int freecap, freelen;
+	int dyneval; /* calls eval directly (or an inner function does), which can see every enclosing variable */
+
+	js_InlineCache *cachetab;
+	int cachecap, cachelen;
+
 	const char *filename;
 	int line, lastline;
 
@@ -140,6 +174,7 @@ struct js_Function
 
 js_Function *jsC_compilefunction(js_State *J, js_Ast *prog);
 js_Function *jsC_compilescript(js_State *J, js_Ast *prog, int default_strict);
+int jsC_oplength(int opcode);
 const char *jsC_opcodestring(enum js_OpCode opcode);
 void jsC_dumpfunction(js_State *J, js_Function *fun);
 
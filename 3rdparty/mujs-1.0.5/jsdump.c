@@ -814,12 +814,19 @@ void jsC_dumpfunction(js_State *J, js_Function *F)
 			p += 2;
 			break;
 
+		case OP_GETPROP_S:
+		case OP_SETPROP_S:
+		case OP_GETMETHOD_S:
+			pc(' ');
+			ps(F->strtab[*p++]);
+			printf(" [%d]", *p++);
+			break;
+
 		case OP_GETVAR:
+		case OP_GETVARUNDEF:
 		case OP_HASVAR:
 		case OP_SETVAR:
 		case OP_DELVAR:
-		case OP_GETPROP_S:
-		case OP_SETPROP_S:
 		case OP_DELPROP_S:
 		case OP_CATCH:
 			pc(' ');
@@ -829,9 +836,20 @@ void jsC_dumpfunction(js_State *J, js_Function *F)
 		case OP_GETLOCAL:
 		case OP_SETLOCAL:
 		case OP_DELLOCAL:
+		case OP_SETLOCALPOP:
+			printf(" %s", F->vartab[*p++ - 1]);
+			break;
+
+		case OP_GETLOCAL2:
+			printf(" %s", F->vartab[*p++ - 1]);
 			printf(" %s", F->vartab[*p++ - 1]);
 			break;
 
+		case OP_GETLOCALINT:
+			printf(" %s", F->vartab[*p++ - 1]);
+			printf(" %d", (*p++) - 32768);
+			break;
+
 		case OP_CLOSURE:
 		case OP_CALL:
 		case OP_NEW:
@@ -868,7 +886,7 @@ void js_dumpvalue(js_State *J, js_Value v)
 	case JS_TNUMBER: printf("%.9g", v.u.number); break;
 	case JS_TSHRSTR: printf("'%s'", v.u.shrstr); break;
 	case JS_TLITSTR: printf("'%s'", v.u.litstr); break;
-	case JS_TMEMSTR: printf("'%s'", v.u.memstr->p); break;
+	case JS_TMEMSTR: printf("'%.*s'", jsV_memlen(&v), v.u.memstr->p); break;
 	case JS_TOBJECT:
 		if (v.u.object == J->G) {
 			printf("[Global]");
@@ -895,6 +913,9 @@ void js_dumpvalue(js_State *J, js_Value v)
 		case JS_CUSERDATA:
 			printf("[Userdata %s %p]", v.u.object->u.user.tag, v.u.object->u.user.data);
 			break;
+		case JS_CARRAYBUFFER: printf("[ArrayBuffer %p]", (void*)v.u.object); break;
+		case JS_CTYPEDARRAY: printf("[%s %p]", jsV_typedname(v.u.object), (void*)v.u.object); break;
+		case JS_CDATAVIEW: printf("[DataView %p]", (void*)v.u.object); break;
 		default: printf("[Object %p]", (void*)v.u.object); break;
 		}
 		break;
@@ -904,20 +925,25 @@ void js_dumpvalue(js_State *J, js_Value v)
 static void js_dumpproperty(js_State *J, js_Property *node)
 {
 	minify = 0;
-	if (node->left->level)
-		js_dumpproperty(J, node->left);
 	printf("\t%s: ", node->name);
 	js_dumpvalue(J, node->value);
 	printf(",\n");
-	if (node->right->level)
-		js_dumpproperty(J, node->right);
 }
 
 void js_dumpobject(js_State *J, js_Object *obj)
 {
+	int k;
 	minify = 0;
 	printf("{\n");
-	if (obj->properties->level)
-		js_dumpproperty(J, obj->properties);
+	if (obj->type == JS_CARRAY && obj->u.a.simple) {
+		for (k = 0; k < obj->u.a.flat_length; ++k) {
+			printf("\t%d: ", k);
+			js_dumpvalue(J, obj->u.a.array[k]);
+			printf(",\n");
+		}
+	}
+	for (k = 0; k < obj->propcap; ++k)
+		if (obj->properties[k])
+			js_dumpproperty(J, obj->properties[k]);
 	printf("}\n");
 }
@@ -5,11 +5,17 @@
 
 #include "regexp.h"
 
-static void jsG_markobject(js_State *J, int mark, js_Object *obj);
-
 static void jsG_freeenvironment(js_State *J, js_Environment *env)
 {
-	js_free(J, env);
+	jsP_free(J, JS_POOLENVIRONMENT, env);
+}
+
+static void jsG_freestring(js_State *J, js_String *str)
+{
+	if (str->pool < 0)
+		js_free(J, str);
+	else
+		jsP_free(J, str->pool, str);
 }
 
 static void jsG_freefunction(js_State *J, js_Function *fun)
@@ -18,15 +24,19 @@ static void jsG_freefunction(js_State *J, js_Function *fun)
 	js_free(J, fun->numtab);
 	js_free(J, fun->strtab);
 	js_free(J, fun->vartab);
+	js_free(J, fun->freetab);
+	js_free(J, fun->cachetab);
 	js_free(J, fun->code);
 	js_free(J, fun);
 }
 
-static void jsG_freeproperty(js_State *J, js_Property *node)
+static void jsG_freeproperties(js_State *J, js_Object *obj)
 {
-	if (node->left->level) jsG_freeproperty(J, node->left);
-	if (node->right->level) jsG_freeproperty(J, node->right);
-	js_free(J, node);
+	int i;
+	for (i = 0; i < obj->propcap; ++i)
+		if (obj->properties[i])
+			jsP_free(J, JS_POOLPROPERTY, obj->properties[i]);
+	js_free(J, obj->properties);
 }
 
 static void jsG_freeiterator(js_State *J, js_Iterator *node)
@@ -40,192 +50,324 @@ static void jsG_freeiterator(js_State *J, js_Iterator *node)
 
 static void jsG_freeobject(js_State *J, js_Object *obj)
 {
-	if (obj->properties->level)
-		jsG_freeproperty(J, obj->properties);
+	if (obj->properties)
+		jsG_freeproperties(J, obj);
 	if (obj->type == JS_CREGEXP) {
 		js_free(J, obj->u.r.source);
 		js_regfreex(J->alloc, J->actx, obj->u.r.prog);
 	}
+	if (obj->type == JS_CARRAY && obj->u.a.simple)
+		js_free(J, obj->u.a.array);
 	if (obj->type == JS_CITERATOR)
 		jsG_freeiterator(J, obj->u.iter.head);
 	if (obj->type == JS_CUSERDATA && obj->u.user.finalize)
 		obj->u.user.finalize(J, obj->u.user.data);
-	js_free(J, obj);
+	if (obj->type == JS_CARRAYBUFFER && !obj->u.ab.external)
+		js_free(J, obj->u.ab.data);
+	jsP_free(J, JS_POOLOBJECT, obj);
+}
+
+/*
+	The collector is an incremental tri-colour mark and sweep. White objects
+	have a stale gcmark, black objects have the current J->gcmark and gray
+	objects (marked but not scanned yet) have -J->gcmark and sit on the
+	J->gcgray list. Environments, functions and strings are marked black
+	right away, only objects are scanned in steps.
+
+	While marking, storing a value into a black object turns it gray again
+	(jsG_barrier). Such objects are kept on J->gcgrayagain and scanned once
+	more together with the roots (stack and environments) before sweeping,
+	so a hot object that is written to in every step cannot keep the mark
+	phase from finishing. Objects allocated while sweeping are created black
+	so they survive the current cycle.
+*/
+
+#define ISWHITE(J, x) ((x)->gcmark != (J)->gcmark && (x)->gcmark != -(J)->gcmark)
+
+static void jsG_grayobject(js_State *J, js_Object *obj)
+{
+	obj->gcmark = -J->gcmark;
+	obj->gcgray = J->gcgray;
+	J->gcgray = obj;
+}
+
+void jsG_grayagain(js_State *J, js_Object *obj)
+{
+	obj->gcmark = -J->gcmark;
+	obj->gcgray = J->gcgrayagain;
+	J->gcgrayagain = obj;
 }
 
-static void jsG_markfunction(js_State *J, int mark, js_Function *fun)
+static void jsG_markfunction(js_State *J, js_Function *fun)
 {
 	int i;
-	fun->gcmark = mark;
+	fun->gcmark = J->gcmark;
 	for (i = 0; i < fun->funlen; ++i)
-		if (fun->funtab[i]->gcmark != mark)
-			jsG_markfunction(J, mark, fun->funtab[i]);
+		if (fun->funtab[i]->gcmark != J->gcmark)
+			jsG_markfunction(J, fun->funtab[i]);
 }
 
-static void jsG_markenvironment(js_State *J, int mark, js_Environment *env)
+static void jsG_markenvironment(js_State *J, js_Environment *env)
 {
 	do {
-		env->gcmark = mark;
-		if (env->variables->gcmark != mark)
-			jsG_markobject(J, mark, env->variables);
+		env->gcmark = J->gcmark;
+		if (ISWHITE(J, env->variables))
+			jsG_grayobject(J, env->variables);
 		env = env->outer;
-	} while (env && env->gcmark != mark);
+	} while (env && env->gcmark != J->gcmark);
 }
 
-static void jsG_markproperty(js_State *J, int mark, js_Property *node)
+static void jsG_markvalue(js_State *J, js_Value *v)
 {
-	if (node->left->level) jsG_markproperty(J, mark, node->left);
-	if (node->right->level) jsG_markproperty(J, mark, node->right);
+	if (v->type == JS_TMEMSTR)
+		v->u.memstr->gcmark = J->gcmark;
+	else if (v->type == JS_TOBJECT && ISWHITE(J, v->u.object))
+		jsG_grayobject(J, v->u.object);
+}
 
-	if (node->value.type == JS_TMEMSTR && node->value.u.memstr->gcmark != mark)
-		node->value.u.memstr->gcmark = mark;
-	if (node->value.type == JS_TOBJECT && node->value.u.object->gcmark != mark)
-		jsG_markobject(J, mark, node->value.u.object);
-	if (node->getter && node->getter->gcmark != mark)
-		jsG_markobject(J, mark, node->getter);
-	if (node->setter && node->setter->gcmark != mark)
-		jsG_markobject(J, mark, node->setter);
+static void jsG_markref(js_State *J, js_Object *obj)
+{
+	if (obj && ISWHITE(J, obj))
+		jsG_grayobject(J, obj);
 }
 
-static void jsG_markobject(js_State *J, int mark, js_Object *obj)
+/* Mark the children of a gray object and return the amount of work done */
+static int jsG_scanobject(js_State *J, js_Object *obj)
 {
-	obj->gcmark = mark;
-	if (obj->properties->level)
-		jsG_markproperty(J, mark, obj->properties);
-	if (obj->prototype && obj->prototype->gcmark != mark)
-		jsG_markobject(J, mark, obj->prototype);
-	if (obj->type == JS_CITERATOR) {
-		jsG_markobject(J, mark, obj->u.iter.target);
+	int work = 1;
+	int i;
+
+	obj->gcmark = J->gcmark;
+	for (i = 0; i < obj->propcap; ++i) {
+		js_Property *node = obj->properties[i];
+		if (node) {
+			jsG_markvalue(J, &node->value);
+			jsG_markref(J, node->getter);
+			jsG_markref(J, node->setter);
+			++work;
+		}
+	}
+	if (obj->type == JS_CARRAY && obj->u.a.simple) {
+		for (i = 0; i < obj->u.a.flat_length; ++i)
+			jsG_markvalue(J, &obj->u.a.array[i]);
+		work += obj->u.a.flat_length;
 	}
+	jsG_markref(J, obj->prototype);
+	if (obj->type == JS_CITERATOR)
+		jsG_markref(J, obj->u.iter.target);
+	if (obj->type == JS_CARRAYBUFFER)
+		jsG_markref(J, obj->u.ab.owner);
+	if (obj->type == JS_CTYPEDARRAY || obj->type == JS_CDATAVIEW)
+		jsG_markref(J, obj->u.ta.buffer);
 	if (obj->type == JS_CFUNCTION || obj->type == JS_CSCRIPT) {
-		if (obj->u.f.scope && obj->u.f.scope->gcmark != mark)
-			jsG_markenvironment(J, mark, obj->u.f.scope);
-		if (obj->u.f.function && obj->u.f.function->gcmark != mark)
-			jsG_markfunction(J, mark, obj->u.f.function);
+		if (obj->u.f.scope && obj->u.f.scope->gcmark != J->gcmark)
+			jsG_markenvironment(J, obj->u.f.scope);
+		if (obj->u.f.function && obj->u.f.function->gcmark != J->gcmark)
+			jsG_markfunction(J, obj->u.f.function);
 	}
+	return work;
 }
 
-static void jsG_markstack(js_State *J, int mark)
+static void jsG_markroots(js_State *J)
 {
-	js_Value *v = J->stack;
-	int n = J->top;
-	while (n--) {
-		if (v->type == JS_TMEMSTR && v->u.memstr->gcmark != mark)
-			v->u.memstr->gcmark = mark;
-		if (v->type == JS_TOBJECT && v->u.object->gcmark != mark)
-			jsG_markobject(J, mark, v->u.object);
-		++v;
-	}
+	int i;
+
+	jsG_markref(J, J->Object_prototype);
+	jsG_markref(J, J->Array_prototype);
+	jsG_markref(J, J->Function_prototype);
+	jsG_markref(J, J->Boolean_prototype);
+	jsG_markref(J, J->Number_prototype);
+	jsG_markref(J, J->String_prototype);
+	jsG_markref(J, J->RegExp_prototype);
+	jsG_markref(J, J->Date_prototype);
+	jsG_markref(J, J->ArrayBuffer_prototype);
+	jsG_markref(J, J->DataView_prototype);
+	for (i = 0; i < JS_TACOUNT; ++i)
+		jsG_markref(J, J->TypedArray_prototype[i]);
+
+	jsG_markref(J, J->Error_prototype);
+	jsG_markref(J, J->EvalError_prototype);
+	jsG_markref(J, J->RangeError_prototype);
+	jsG_markref(J, J->ReferenceError_prototype);
+	jsG_markref(J, J->SyntaxError_prototype);
+	jsG_markref(J, J->TypeError_prototype);
+	jsG_markref(J, J->URIError_prototype);
+
+	jsG_markref(J, J->R);
+	jsG_markref(J, J->G);
+
+	for (i = 0; i < J->top; ++i)
+		jsG_markvalue(J, &J->stack[i]);
+
+	jsG_markenvironment(J, J->E);
+	jsG_markenvironment(J, J->GE);
+	for (i = 0; i < J->envtop; ++i)
+		jsG_markenvironment(J, J->envstack[i]);
 }
 
-void js_gc(js_State *J, int report)
+static void jsG_startcycle(js_State *J)
 {
-	js_Function *fun, *nextfun, **prevnextfun;
-	js_Object *obj, *nextobj, **prevnextobj;
-	js_String *str, *nextstr, **prevnextstr;
-	js_Environment *env, *nextenv, **prevnextenv;
-	int nenv = 0, nfun = 0, nobj = 0, nstr = 0;
-	int genv = 0, gfun = 0, gobj = 0, gstr = 0;
-	int mark;
-	int i;
+	J->gcmark = J->gcmark == 1 ? 2 : 1;
+	J->gcgray = NULL;
+	J->gcgrayagain = NULL;
+	memset(J->gcswept, 0, sizeof J->gcswept);
+	memset(J->gcfreed, 0, sizeof J->gcfreed);
+	J->gcstate = JS_GCMARK;
+	jsG_markroots(J);
+}
 
-	if (J->gcpause) {
-		if (report)
-			js_report(J, "garbage collector is paused");
-		return;
+static void jsG_startsweep(js_State *J)
+{
+	/* the stack and the environments are not guarded by barriers, mark them again */
+	jsG_markroots(J);
+	while (J->gcgrayagain) {
+		js_Object *obj = J->gcgrayagain;
+		J->gcgrayagain = obj->gcgray;
+		jsG_scanobject(J, obj);
+	}
+	while (J->gcgray) {
+		js_Object *obj = J->gcgray;
+		J->gcgray = obj->gcgray;
+		jsG_scanobject(J, obj);
 	}
 
-	J->gccounter = 0;
-
-	mark = J->gcmark = J->gcmark == 1 ? 2 : 1;
-
-	jsG_markobject(J, mark, J->Object_prototype);
-	jsG_markobject(J, mark, J->Array_prototype);
-	jsG_markobject(J, mark, J->Function_prototype);
-	jsG_markobject(J, mark, J->Boolean_prototype);
-	jsG_markobject(J, mark, J->Number_prototype);
-	jsG_markobject(J, mark, J->String_prototype);
-	jsG_markobject(J, mark, J->RegExp_prototype);
-	jsG_markobject(J, mark, J->Date_prototype);
-
-	jsG_markobject(J, mark, J->Error_prototype);
-	jsG_markobject(J, mark, J->EvalError_prototype);
-	jsG_markobject(J, mark, J->RangeError_prototype);
-	jsG_markobject(J, mark, J->ReferenceError_prototype);
-	jsG_markobject(J, mark, J->SyntaxError_prototype);
-	jsG_markobject(J, mark, J->TypeError_prototype);
-	jsG_markobject(J, mark, J->URIError_prototype);
-
-	jsG_markobject(J, mark, J->R);
-	jsG_markobject(J, mark, J->G);
-
-	jsG_markstack(J, mark);
+	J->gcsweepenv = &J->gcenv;
+	J->gcsweepfun = &J->gcfun;
+	J->gcsweepobj = &J->gcobj;
+	J->gcsweepstr = &J->gcstr;
+	J->gcstate = JS_GCSWEEP;
+}
 
-	jsG_markenvironment(J, mark, J->E);
-	jsG_markenvironment(J, mark, J->GE);
-	for (i = 0; i < J->envtop; ++i)
-		jsG_markenvironment(J, mark, J->envstack[i]);
+/* Sweep at most work nodes */
+static void jsG_sweep(js_State *J, int work)
+{
+	int mark = J->gcmark;
 
-	prevnextenv = &J->gcenv;
-	for (env = J->gcenv; env; env = nextenv) {
-		nextenv = env->gcnext;
+	while (work > 0 && *J->gcsweepenv) {
+		js_Environment *env = *J->gcsweepenv;
 		if (env->gcmark != mark) {
-			*prevnextenv = nextenv;
+			*J->gcsweepenv = env->gcnext;
 			jsG_freeenvironment(J, env);
-			++genv;
+			++J->gcfreed[0];
 		} else {
-			prevnextenv = &env->gcnext;
+			J->gcsweepenv = &env->gcnext;
 		}
-		++nenv;
+		++J->gcswept[0];
+		--work;
 	}
 
-	prevnextfun = &J->gcfun;
-	for (fun = J->gcfun; fun; fun = nextfun) {
-		nextfun = fun->gcnext;
+	while (work > 0 && *J->gcsweepfun) {
+		js_Function *fun = *J->gcsweepfun;
 		if (fun->gcmark != mark) {
-			*prevnextfun = nextfun;
+			*J->gcsweepfun = fun->gcnext;
 			jsG_freefunction(J, fun);
-			++gfun;
+			++J->gcfreed[1];
 		} else {
-			prevnextfun = &fun->gcnext;
+			J->gcsweepfun = &fun->gcnext;
 		}
-		++nfun;
+		++J->gcswept[1];
+		--work;
 	}
 
-	prevnextobj = &J->gcobj;
-	for (obj = J->gcobj; obj; obj = nextobj) {
-		nextobj = obj->gcnext;
+	while (work > 0 && *J->gcsweepobj) {
+		js_Object *obj = *J->gcsweepobj;
 		if (obj->gcmark != mark) {
-			*prevnextobj = nextobj;
+			*J->gcsweepobj = obj->gcnext;
 			jsG_freeobject(J, obj);
-			++gobj;
+			++J->gcfreed[2];
 		} else {
-			prevnextobj = &obj->gcnext;
+			J->gcsweepobj = &obj->gcnext;
 		}
-		++nobj;
+		++J->gcswept[2];
+		--work;
 	}
 
-	prevnextstr = &J->gcstr;
-	for (str = J->gcstr; str; str = nextstr) {
-		nextstr = str->gcnext;
+	while (work > 0 && *J->gcsweepstr) {
+		js_String *str = *J->gcsweepstr;
 		if (str->gcmark != mark) {
-			*prevnextstr = nextstr;
-			js_free(J, str);
-			++gstr;
+			*J->gcsweepstr = str->gcnext;
+			jsG_freestring(J, str);
+			++J->gcfreed[3];
 		} else {
-			prevnextstr = &str->gcnext;
+			J->gcsweepstr = &str->gcnext;
 		}
-		++nstr;
+		++J->gcswept[3];
+		--work;
 	}
+}
 
+static void jsG_endcycle(js_State *J, int report)
+{
+	J->gcstate = JS_GCIDLE;
+	++J->gccycles;
+	jsP_release(J, JS_POOLKEEP);
 	if (report) {
 		char buf[256];
 		snprintf(buf, sizeof buf, "garbage collected: %d/%d envs, %d/%d funs, %d/%d objs, %d/%d strs",
-			genv, nenv, gfun, nfun, gobj, nobj, gstr, nstr);
+			J->gcfreed[0], J->gcswept[0], J->gcfreed[1], J->gcswept[1],
+			J->gcfreed[2], J->gcswept[2], J->gcfreed[3], J->gcswept[3]);
 		js_report(J, buf);
 	}
 }
 
+int js_gcstep(js_State *J, int work, int report)
+{
+	if (J->gcpause)
+		return J->gcstate == JS_GCIDLE;
+
+	if (J->gcstate == JS_GCIDLE)
+		jsG_startcycle(J);
+
+	if (J->gcstate == JS_GCMARK) {
+		while (J->gcgray && work > 0) {
+			js_Object *obj = J->gcgray;
+			J->gcgray = obj->gcgray;
+			work -= jsG_scanobject(J, obj);
+		}
+		if (J->gcgray)
+			return 0;
+		jsG_startsweep(J);
+	}
+
+	jsG_sweep(J, work);
+	if (*J->gcsweepenv || *J->gcsweepfun || *J->gcsweepobj || *J->gcsweepstr)
+		return 0;
+
+	jsG_endcycle(J, report);
+	return 1;
+}
+
+void js_gcincremental(js_State *J, int enable)
+{
+	J->gcincremental = enable;
+}
+
+/* Run by the interpreter every JS_GCLIMIT allocations */
+void jsG_collect(js_State *J)
+{
+	if (J->gcincremental) {
+		J->gccounter = 0;
+		js_gcstep(J, JS_GCLIMIT * JS_GCSTEPMUL, 0);
+	} else
+		js_gc(J, 0);
+}
+
+void js_gc(js_State *J, int report)
+{
+	if (J->gcpause) {
+		if (report)
+			js_report(J, "garbage collector is paused");
+		return;
+	}
+
+	J->gccounter = 0;
+
+	/* the marks of a cycle in progress are incomplete, finish it first */
+	if (J->gcstate != JS_GCIDLE)
+		js_gcstep(J, INT_MAX, 0);
+	js_gcstep(J, INT_MAX, report);
+}
+
 void js_freestate(js_State *J)
 {
 	js_Function *fun, *nextfun;
@@ -243,8 +385,9 @@ void js_freestate(js_State *J)
 	for (obj = J->gcobj; obj; obj = nextobj)
 		nextobj = obj->gcnext, jsG_freeobject(J, obj);
 	for (str = J->gcstr; str; str = nextstr)
-		nextstr = str->gcnext, js_free(J, str);
+		nextstr = str->gcnext, jsG_freestring(J, str);
 
+	jsP_release(J, 0);
 	jsS_freestrings(J);
 
 	js_free(J, J->lexbuf.text);
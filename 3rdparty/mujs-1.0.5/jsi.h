@@ -64,16 +64,40 @@ typedef struct js_Ast js_Ast;
 typedef struct js_Function js_Function;
 typedef struct js_Environment js_Environment;
 typedef struct js_StringNode js_StringNode;
+typedef struct js_InlineCache js_InlineCache;
 typedef struct js_Jumpbuf js_Jumpbuf;
 typedef struct js_StackTrace js_StackTrace;
+typedef struct js_Pool js_Pool;
+typedef struct js_Slab js_Slab;
+
+/* Dispatch bytecode through computed gotos; build with -DJS_THREADED=0 to use a plain switch */
+
+#ifndef JS_THREADED
+#ifdef __GNUC__
+#define JS_THREADED 1
+#else
+#define JS_THREADED 0
+#endif
+#endif
+
+/* Allocate objects, properties, environments and short strings from slab pools; build with -DJS_POOLS=0 to use js_malloc for each of them */
+
+#ifndef JS_POOLS
+#define JS_POOLS 1
+#endif
 
 /* Limits */
 
 #define JS_STACKSIZE 256	/* value stack size */
 #define JS_ENVLIMIT 64		/* environment stack size */
 #define JS_TRYLIMIT 64		/* exception stack size */
-#define JS_GCLIMIT 10000	/* run gc cycle every N allocations */
+#define JS_GCLIMIT 10000	/* run gc cycle (or an incremental step) every N allocations */
+#define JS_GCSTEPMUL 2		/* incremental gc work units per allocation */
+#define JS_POOLSLAB 8192	/* bytes per slab of the allocation pools */
+#define JS_POOLKEEP 1		/* empty slabs kept per pool after a gc cycle */
 #define JS_ASTLIMIT 100		/* max nested expressions */
+#define JS_FLATLIMIT (1<<24)	/* max number of elements in flat array storage */
+#define JS_PROPLINEAR 8		/* objects with up to N properties are searched linearly */
 
 /* instruction size -- change to int if you get integer overflow syntax errors */
 typedef unsigned short js_Instruction;
@@ -82,9 +106,52 @@ typedef unsigned short js_Instruction;
 
 char *js_strdup(js_State *J, const char *s);
 const char *js_intern(js_State *J, const char *s);
+const char *jsS_lookupintern(js_State *J, const char *s, unsigned int *hash);
+unsigned int jsS_internhash(const char *s);
+unsigned int jsS_hash(const char *s);
 void jsS_dumpstrings(js_State *J);
 void jsS_freestrings(js_State *J);
 
+/* Garbage collector */
+
+void jsG_collect(js_State *J);
+void jsG_grayagain(js_State *J, js_Object *obj);
+
+/* Write barrier: a black object that is stored into while marking is scanned again */
+#define jsG_barrier(J, obj) \
+	((J)->gcstate == JS_GCMARK && (obj)->gcmark == (J)->gcmark ? jsG_grayagain(J, obj) : (void)0)
+
+/* Mark of new allocations, they must survive a cycle that is already sweeping */
+#define jsG_newmark(J) ((J)->gcstate == JS_GCSWEEP ? (J)->gcmark : 0)
+
+/* Allocation pools */
+
+enum {
+	JS_POOLOBJECT,
+	JS_POOLPROPERTY,
+	JS_POOLENVIRONMENT,
+	JS_POOLSTR32,
+	JS_POOLSTR64,
+	JS_POOLSTR128,
+	JS_POOLCOUNT
+};
+
+struct js_Pool
+{
+	const char *name;
+	int size; /* item size */
+	int count; /* items per slab */
+	js_Slab *avail; /* slabs with free items */
+	int slabs, used, peak;
+	unsigned int released; /* empty slabs given back so far */
+};
+
+void jsP_initpools(js_State *J);
+void *jsP_alloc(js_State *J, int pool);
+void jsP_free(js_State *J, int pool, void *ptr);
+int jsP_stringpool(int size);
+void jsP_release(js_State *J, int keep);
+
 /* Portable strtod and printf float formatting */
 
 void js_fmtexp(char *p, int e);
@@ -161,10 +228,12 @@ struct js_State
 	js_Report report;
 	js_Panic panic;
 
-	js_StringNode *strings;
+	js_StringNode **strings;
+	int strlen, strcap;
 
 	int default_strict;
 	int strict;
+	int optimize;
 
 	/* parser input source */
 	const char *filename;
@@ -194,6 +263,9 @@ struct js_State
 	js_Object *String_prototype;
 	js_Object *RegExp_prototype;
 	js_Object *Date_prototype;
+	js_Object *ArrayBuffer_prototype;
+	js_Object *DataView_prototype;
+	js_Object *TypedArray_prototype[9]; /* one per JS_TA* element type */
 
 	js_Object *Error_prototype;
 	js_Object *EvalError_prototype;
@@ -206,6 +278,8 @@ struct js_State
 	unsigned int seed; /* Math.random seed */
 
 	int nextref; /* for js_ref use */
+	unsigned int nextshape; /* for js_Object shape ids */
+	unsigned int protoepoch; /* changes whenever a prototype object gains or loses properties */
 	js_Object *R; /* registry of hidden values */
 	js_Object *G; /* the global object */
 	js_Environment *E; /* current environment scope */
@@ -224,6 +298,21 @@ struct js_State
 	js_Object *gcobj;
 	js_String *gcstr;
 
+	/* incremental collection state, see jsgc.c */
+	int gcstate;
+	int gcincremental;
+	unsigned int gccycles;
+	js_Object *gcgray;
+	js_Object *gcgrayagain;
+	js_Environment **gcsweepenv;
+	js_Function **gcsweepfun;
+	js_Object **gcsweepobj;
+	js_String **gcsweepstr;
+	int gcswept[4], gcfreed[4]; /* envs, funs, objs and strs of the current cycle */
+
+	/* slab pools for fixed size allocations, see jspool.c */
+	js_Pool pools[JS_POOLCOUNT];
+
 	/* environments on the call stack but currently not in scope */
 	int envtop;
 	js_Environment *envstack[JS_ENVLIMIT];
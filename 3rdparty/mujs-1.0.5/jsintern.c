@@ -29,107 +29,107 @@ void js_putm(js_State *J, js_Buffer **sb, const char *s, const char *e)
 		js_putc(J, sb, *s++);
 }
 
-/* Use an AA-tree to quickly look up interned strings. */
+/*
+	Use an open addressing hash table (linear probing, power of two size) to
+	quickly look up interned strings. The hash is stored with every string so
+	that property tables can reuse it without hashing the name again.
+*/
 
 struct js_StringNode
 {
-	js_StringNode *left, *right;
-	int level;
+	unsigned int hash;
 	char string[1];
 };
 
-static js_StringNode jsS_sentinel = { &jsS_sentinel, &jsS_sentinel, 0, ""};
-
-static js_StringNode *jsS_newstringnode(js_State *J, const char *string, const char **result)
+unsigned int jsS_hash(const char *s)
 {
-	int n = strlen(string);
-	js_StringNode *node = js_malloc(J, soffsetof(js_StringNode, string) + n + 1);
-	node->left = node->right = &jsS_sentinel;
-	node->level = 1;
-	memcpy(node->string, string, n + 1);
-	return *result = node->string, node;
+	unsigned int h = 2166136261u;
+	while (*s)
+		h = (h ^ (unsigned char)*s++) * 16777619u;
+	return h;
 }
 
-static js_StringNode *jsS_skew(js_StringNode *node)
+unsigned int jsS_internhash(const char *s)
 {
-	if (node->left->level == node->level) {
-		js_StringNode *temp = node;
-		node = node->left;
-		temp->left = node->right;
-		node->right = temp;
-	}
-	return node;
+	return ((js_StringNode*)(s - soffsetof(js_StringNode, string)))->hash;
 }
 
-static js_StringNode *jsS_split(js_StringNode *node)
+static void jsS_growstrings(js_State *J)
 {
-	if (node->right->right->level == node->level) {
-		js_StringNode *temp = node;
-		node = node->right;
-		temp->right = node->left;
-		node->left = temp;
-		++node->level;
+	js_StringNode **table;
+	int i, k, cap = J->strcap ? J->strcap * 2 : 1024;
+	table = js_malloc(J, cap * sizeof *table);
+	memset(table, 0, cap * sizeof *table);
+	for (i = 0; i < J->strcap; ++i) {
+		if (J->strings[i]) {
+			k = J->strings[i]->hash & (cap - 1);
+			while (table[k])
+				k = (k + 1) & (cap - 1);
+			table[k] = J->strings[i];
+		}
 	}
-	return node;
+	js_free(J, J->strings);
+	J->strings = table;
+	J->strcap = cap;
 }
 
-static js_StringNode *jsS_insert(js_State *J, js_StringNode *node, const char *string, const char **result)
+static int jsS_find(js_State *J, const char *s, unsigned int hash)
 {
-	if (node != &jsS_sentinel) {
-		int c = strcmp(string, node->string);
-		if (c < 0)
-			node->left = jsS_insert(J, node->left, string, result);
-		else if (c > 0)
-			node->right = jsS_insert(J, node->right, string, result);
-		else
-			return *result = node->string, node;
-		node = jsS_skew(node);
-		node = jsS_split(node);
-		return node;
+	int k = hash & (J->strcap - 1);
+	while (J->strings[k]) {
+		js_StringNode *node = J->strings[k];
+		if (node->string == s || (node->hash == hash && !strcmp(node->string, s)))
+			return k;
+		k = (k + 1) & (J->strcap - 1);
 	}
-	return jsS_newstringnode(J, string, result);
+	return k;
 }
 
-static void dumpstringnode(js_StringNode *node, int level)
+const char *jsS_lookupintern(js_State *J, const char *s, unsigned int *hash)
 {
-	int i;
-	if (node->left != &jsS_sentinel)
-		dumpstringnode(node->left, level + 1);
-	printf("%d: ", node->level);
-	for (i = 0; i < level; ++i)
-		putchar('\t');
-	printf("'%s'\n", node->string);
-	if (node->right != &jsS_sentinel)
-		dumpstringnode(node->right, level + 1);
+	js_StringNode *node;
+	if (!J->strcap)
+		return NULL;
+	*hash = jsS_hash(s);
+	node = J->strings[jsS_find(J, s, *hash)];
+	return node ? node->string : NULL;
 }
 
 void jsS_dumpstrings(js_State *J)
 {
-	js_StringNode *root = J->strings;
+	int i;
 	printf("interned strings {\n");
-	if (root && root != &jsS_sentinel)
-		dumpstringnode(root, 1);
+	for (i = 0; i < J->strcap; ++i)
+		if (J->strings[i])
+			printf("%d: '%s'\n", i, J->strings[i]->string);
 	printf("}\n");
 }
 
-static void jsS_freestringnode(js_State *J, js_StringNode *node)
-{
-	if (node->left != &jsS_sentinel) jsS_freestringnode(J, node->left);
-	if (node->right != &jsS_sentinel) jsS_freestringnode(J, node->right);
-	js_free(J, node);
-}
-
 void jsS_freestrings(js_State *J)
 {
-	if (J->strings && J->strings != &jsS_sentinel)
-		jsS_freestringnode(J, J->strings);
+	int i;
+	for (i = 0; i < J->strcap; ++i)
+		js_free(J, J->strings[i]);
+	js_free(J, J->strings);
 }
 
 const char *js_intern(js_State *J, const char *s)
 {
-	const char *result;
-	if (!J->strings)
-		J->strings = &jsS_sentinel;
-	J->strings = jsS_insert(J, J->strings, s, &result);
-	return result;
+	js_StringNode *node;
+	unsigned int hash = jsS_hash(s);
+	int k, n;
+
+	if (2 * (J->strlen + 1) > J->strcap)
+		jsS_growstrings(J);
+
+	k = jsS_find(J, s, hash);
+	if (!J->strings[k]) {
+		n = strlen(s);
+		node = js_malloc(J, soffsetof(js_StringNode, string) + n + 1);
+		node->hash = hash;
+		memcpy(node->string, s, n + 1);
+		J->strings[k] = node;
+		++J->strlen;
+	}
+	return J->strings[k]->string;
 }
@@ -49,6 +49,15 @@ static void Op_toString(js_State *J)
 			js_pushliteral(J, "]");
 			js_concat(J);
 			break;
+		case JS_CARRAYBUFFER: js_pushliteral(J, "[object ArrayBuffer]"); break;
+		case JS_CDATAVIEW: js_pushliteral(J, "[object DataView]"); break;
+		case JS_CTYPEDARRAY:
+			js_pushliteral(J, "[object ");
+			js_pushliteral(J, jsV_typedname(self));
+			js_concat(J);
+			js_pushliteral(J, "]");
+			js_concat(J);
+			break;
 		}
 	}
 }
@@ -58,12 +67,20 @@ static void Op_valueOf(js_State *J)
 	js_copy(J, 0);
 }
 
+static int Op_isflatindex(js_State *J, js_Object *self, const char *name)
+{
+	int k;
+	if (self->type == JS_CARRAY && self->u.a.simple)
+		return js_isarrayindex(J, name, &k) && k < self->u.a.flat_length;
+	return 0;
+}
+
 static void Op_hasOwnProperty(js_State *J)
 {
 	js_Object *self = js_toobject(J, 0);
 	const char *name = js_tostring(J, 1);
 	js_Property *ref = jsV_getownproperty(J, self, name);
-	js_pushboolean(J, ref != NULL);
+	js_pushboolean(J, ref != NULL || Op_isflatindex(J, self, name));
 }
 
 static void Op_isPrototypeOf(js_State *J)
@@ -87,7 +104,7 @@ static void Op_propertyIsEnumerable(js_State *J)
 	js_Object *self = js_toobject(J, 0);
 	const char *name = js_tostring(J, 1);
 	js_Property *ref = jsV_getownproperty(J, self, name);
-	js_pushboolean(J, ref && !(ref->atts & JS_DONTENUM));
+	js_pushboolean(J, (ref && !(ref->atts & JS_DONTENUM)) || Op_isflatindex(J, self, name));
 }
 
 static void O_getPrototypeOf(js_State *J)
@@ -109,6 +126,7 @@ static void O_getOwnPropertyDescriptor(js_State *J)
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
 	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
 	ref = jsV_getproperty(J, obj, js_tostring(J, 2));
 	if (!ref)
 		js_pushundefined(J);
@@ -138,22 +156,12 @@ static void O_getOwnPropertyDescriptor(js_State *J)
 	}
 }
 
-static int O_getOwnPropertyNames_walk(js_State *J, js_Property *ref, int i)
-{
-	if (ref->left->level)
-		i = O_getOwnPropertyNames_walk(J, ref->left, i);
-	js_pushliteral(J, ref->name);
-	js_setindex(J, -2, i++);
-	if (ref->right->level)
-		i = O_getOwnPropertyNames_walk(J, ref->right, i);
-	return i;
-}
-
 static void O_getOwnPropertyNames(js_State *J)
 {
 	js_Object *obj;
-	int k;
-	int i;
+	const char *name;
+	char buf[32];
+	int i = 0, k;
 
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
@@ -161,10 +169,12 @@ static void O_getOwnPropertyNames(js_State *J)
 
 	js_newarray(J);
 
-	if (obj->properties->level)
-		i = O_getOwnPropertyNames_walk(J, obj->properties, 0);
-	else
-		i = 0;
+	js_pushiterator(J, 1, 2);
+	while ((name = js_nextiterator(J, -1))) {
+		js_pushliteral(J, name);
+		js_setindex(J, -3, i++);
+	}
+	js_pop(J, 1);
 
 	if (obj->type == JS_CARRAY) {
 		js_pushliteral(J, "length");
@@ -175,7 +185,7 @@ static void O_getOwnPropertyNames(js_State *J)
 		js_pushliteral(J, "length");
 		js_setindex(J, -2, i++);
 		for (k = 0; k < obj->u.s.length; ++k) {
-			js_pushnumber(J, k);
+			js_pushstring(J, js_itoa(buf, k));
 			js_setindex(J, -2, i++);
 		}
 	}
@@ -255,51 +265,35 @@ static void O_defineProperty(js_State *J)
 	js_copy(J, 1);
 }
 
-static void O_defineProperties_walk(js_State *J, js_Property *ref)
+static void O_defineProperties_walk(js_State *J, js_Object *obj, int idx)
 {
-	if (ref->left->level)
-		O_defineProperties_walk(J, ref->left);
-	if (!(ref->atts & JS_DONTENUM)) {
-		js_pushvalue(J, ref->value);
-		ToPropertyDescriptor(J, js_toobject(J, 1), ref->name, js_toobject(J, -1));
+	const char *name;
+	js_pushiterator(J, idx, 1);
+	while ((name = js_nextiterator(J, -1))) {
+		js_getproperty(J, idx, name);
+		if (!js_isobject(J, -1))
+			js_typeerror(J, "not an object");
+		ToPropertyDescriptor(J, obj, name, js_toobject(J, -1));
 		js_pop(J, 1);
 	}
-	if (ref->right->level)
-		O_defineProperties_walk(J, ref->right);
+	js_pop(J, 1);
 }
 
 static void O_defineProperties(js_State *J)
 {
-	js_Object *props;
 
 	if (!js_isobject(J, 1)) js_typeerror(J, "not an object");
 	if (!js_isobject(J, 2)) js_typeerror(J, "not an object");
 
-	props = js_toobject(J, 2);
-	if (props->properties->level)
-		O_defineProperties_walk(J, props->properties);
+	O_defineProperties_walk(J, js_toobject(J, 1), 2);
 
 	js_copy(J, 1);
 }
 
-static void O_create_walk(js_State *J, js_Object *obj, js_Property *ref)
-{
-	if (ref->left->level)
-		O_create_walk(J, obj, ref->left);
-	if (!(ref->atts & JS_DONTENUM)) {
-		if (ref->value.type != JS_TOBJECT)
-			js_typeerror(J, "not an object");
-		ToPropertyDescriptor(J, obj, ref->name, ref->value.u.object);
-	}
-	if (ref->right->level)
-		O_create_walk(J, obj, ref->right);
-}
-
 static void O_create(js_State *J)
 {
 	js_Object *obj;
 	js_Object *proto;
-	js_Object *props;
 
 	if (js_isobject(J, 1))
 		proto = js_toobject(J, 1);
@@ -314,54 +308,37 @@ static void O_create(js_State *J)
 	if (js_isdefined(J, 2)) {
 		if (!js_isobject(J, 2))
 			js_typeerror(J, "not an object");
-		props = js_toobject(J, 2);
-		if (props->properties->level)
-			O_create_walk(J, obj, props->properties);
+		O_defineProperties_walk(J, obj, 2);
 	}
 }
 
-static int O_keys_walk(js_State *J, js_Property *ref, int i)
-{
-	if (ref->left->level)
-		i = O_keys_walk(J, ref->left, i);
-	if (!(ref->atts & JS_DONTENUM)) {
-		js_pushliteral(J, ref->name);
-		js_setindex(J, -2, i++);
-	}
-	if (ref->right->level)
-		i = O_keys_walk(J, ref->right, i);
-	return i;
-}
-
 static void O_keys(js_State *J)
 {
-	js_Object *obj;
-	int i, k;
+	const char *name;
+	int i = 0;
 
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
-	obj = js_toobject(J, 1);
 
 	js_newarray(J);
 
-	if (obj->properties->level)
-		i = O_keys_walk(J, obj->properties, 0);
-	else
-		i = 0;
-
-	if (obj->type == JS_CSTRING) {
-		for (k = 0; k < obj->u.s.length; ++k) {
-			js_pushnumber(J, k);
-			js_setindex(J, -2, i++);
-		}
+	js_pushiterator(J, 1, 1);
+	while ((name = js_nextiterator(J, -1))) {
+		js_pushliteral(J, name);
+		js_setindex(J, -3, i++);
 	}
+	js_pop(J, 1);
 }
 
 static void O_preventExtensions(js_State *J)
 {
+	js_Object *obj;
+
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
-	js_toobject(J, 1)->extensible = 0;
+	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
+	obj->extensible = 0;
 	js_copy(J, 1);
 }
 
@@ -372,47 +349,30 @@ static void O_isExtensible(js_State *J)
 	js_pushboolean(J, js_toobject(J, 1)->extensible);
 }
 
-static void O_seal_walk(js_State *J, js_Property *ref)
-{
-	if (ref->left->level)
-		O_seal_walk(J, ref->left);
-	ref->atts |= JS_DONTCONF;
-	if (ref->right->level)
-		O_seal_walk(J, ref->right);
-}
-
 static void O_seal(js_State *J)
 {
 	js_Object *obj;
+	int i;
 
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
 
 	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
 	obj->extensible = 0;
 
-	if (obj->properties->level)
-		O_seal_walk(J, obj->properties);
+	for (i = 0; i < obj->propcap; ++i)
+		if (obj->properties[i])
+			obj->properties[i]->atts |= JS_DONTCONF;
+	jsV_reshape(J, obj);
 
 	js_copy(J, 1);
 }
 
-static int O_isSealed_walk(js_State *J, js_Property *ref)
-{
-	if (ref->left->level)
-		if (!O_isSealed_walk(J, ref->left))
-			return 0;
-	if (!(ref->atts & JS_DONTCONF))
-		return 0;
-	if (ref->right->level)
-		if (!O_isSealed_walk(J, ref->right))
-			return 0;
-	return 1;
-}
-
 static void O_isSealed(js_State *J)
 {
 	js_Object *obj;
+	int i;
 
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
@@ -423,63 +383,48 @@ static void O_isSealed(js_State *J)
 		return;
 	}
 
-	if (obj->properties->level)
-		js_pushboolean(J, O_isSealed_walk(J, obj->properties));
-	else
-		js_pushboolean(J, 1);
-}
+	for (i = 0; i < obj->propcap; ++i) {
+		if (obj->properties[i] && !(obj->properties[i]->atts & JS_DONTCONF)) {
+			js_pushboolean(J, 0);
+			return;
+		}
+	}
 
-static void O_freeze_walk(js_State *J, js_Property *ref)
-{
-	if (ref->left->level)
-		O_freeze_walk(J, ref->left);
-	ref->atts |= JS_READONLY | JS_DONTCONF;
-	if (ref->right->level)
-		O_freeze_walk(J, ref->right);
+	js_pushboolean(J, 1);
 }
 
 static void O_freeze(js_State *J)
 {
 	js_Object *obj;
+	int i;
 
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
 
 	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
 	obj->extensible = 0;
 
-	if (obj->properties->level)
-		O_freeze_walk(J, obj->properties);
+	for (i = 0; i < obj->propcap; ++i)
+		if (obj->properties[i])
+			obj->properties[i]->atts |= JS_READONLY | JS_DONTCONF;
+	jsV_reshape(J, obj);
 
 	js_copy(J, 1);
 }
 
-static int O_isFrozen_walk(js_State *J, js_Property *ref)
-{
-	if (ref->left->level)
-		if (!O_isFrozen_walk(J, ref->left))
-			return 0;
-	if (!(ref->atts & JS_READONLY))
-		return 0;
-	if (!(ref->atts & JS_DONTCONF))
-		return 0;
-	if (ref->right->level)
-		if (!O_isFrozen_walk(J, ref->right))
-			return 0;
-	return 1;
-}
-
 static void O_isFrozen(js_State *J)
 {
 	js_Object *obj;
+	int i;
 
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
 
 	obj = js_toobject(J, 1);
 
-	if (obj->properties->level) {
-		if (!O_isFrozen_walk(J, obj->properties)) {
+	for (i = 0; i < obj->propcap; ++i) {
+		if (obj->properties[i] && (obj->properties[i]->atts & (JS_READONLY | JS_DONTCONF)) != (JS_READONLY | JS_DONTCONF)) {
 			js_pushboolean(J, 0);
 			return;
 		}
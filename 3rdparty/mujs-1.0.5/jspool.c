@@ -0,0 +1,173 @@
+#include "jsi.h"
+#include "jsvalue.h"
+#include "jsrun.h"
+
+/*
+	Objects, properties, environments and short strings are allocated from
+	per size pools instead of one js_malloc call each. A pool gets its
+	memory in slabs of JS_POOLSLAB bytes. Every item is preceded by a
+	pointer to its slab; each slab has its own free list and a count of
+	used items, so empty slabs can be given back with jsP_release after a
+	collection.
+
+	The slabs of a pool that have free items are on its doubly linked avail
+	list. A full slab is unlinked and goes back to the front of the list as
+	soon as one of its items is freed.
+*/
+
+struct js_Slab
+{
+	js_Slab *next, *prev;
+	int used;
+	void *free;
+};
+
+typedef union {
+	js_Slab *slab;
+	double align;
+} js_PoolItem;
+
+#define SLABHEAD ((int)((sizeof(js_Slab) + 7) & ~7))
+#define ITEMSIZE(size) ((int)sizeof(js_PoolItem) + (((size) + 7) & ~7))
+
+static const struct { const char *name; int size; } pooltab[JS_POOLCOUNT] = {
+	{ "object", sizeof(js_Object) },
+	{ "property", sizeof(js_Property) },
+	{ "environment", sizeof(js_Environment) },
+	{ "string32", 32 },
+	{ "string64", 64 },
+	{ "string128", 128 },
+};
+
+void jsP_initpools(js_State *J)
+{
+	int i;
+	for (i = 0; i < JS_POOLCOUNT; ++i) {
+		js_Pool *pool = &J->pools[i];
+		pool->name = pooltab[i].name;
+		pool->size = pooltab[i].size;
+		pool->count = (JS_POOLSLAB - SLABHEAD) / ITEMSIZE(pool->size);
+	}
+}
+
+static void jsP_link(js_Pool *pool, js_Slab *slab)
+{
+	slab->prev = NULL;
+	slab->next = pool->avail;
+	if (pool->avail)
+		pool->avail->prev = slab;
+	pool->avail = slab;
+}
+
+static void jsP_unlink(js_Pool *pool, js_Slab *slab)
+{
+	if (slab->prev)
+		slab->prev->next = slab->next;
+	else
+		pool->avail = slab->next;
+	if (slab->next)
+		slab->next->prev = slab->prev;
+}
+
+static js_Slab *jsP_newslab(js_State *J, js_Pool *pool)
+{
+	int itemsize = ITEMSIZE(pool->size);
+	js_Slab *slab = js_malloc(J, JS_POOLSLAB);
+	char *p = (char*)slab + SLABHEAD + (pool->count - 1) * itemsize;
+	int i;
+
+	/* build the free list from the last item so items are handed out in address order */
+	slab->used = 0;
+	slab->free = NULL;
+	for (i = 0; i < pool->count; ++i, p -= itemsize) {
+		js_PoolItem *item = (js_PoolItem*)p;
+		item->slab = slab;
+		*(void**)(item + 1) = slab->free;
+		slab->free = item + 1;
+	}
+
+	jsP_link(pool, slab);
+	++pool->slabs;
+	return slab;
+}
+
+void *jsP_alloc(js_State *J, int n)
+{
+	js_Pool *pool = &J->pools[n];
+#if JS_POOLS
+	js_Slab *slab = pool->avail ? pool->avail : jsP_newslab(J, pool);
+	void *ptr = slab->free;
+	slab->free = *(void**)ptr;
+	++slab->used;
+	if (!slab->free)
+		jsP_unlink(pool, slab);
+#else
+	void *ptr = js_malloc(J, pool->size);
+#endif
+	if (++pool->used > pool->peak)
+		pool->peak = pool->used;
+	return ptr;
+}
+
+void jsP_free(js_State *J, int n, void *ptr)
+{
+	js_Pool *pool = &J->pools[n];
+#if JS_POOLS
+	js_Slab *slab = ((js_PoolItem*)ptr - 1)->slab;
+	if (!slab->free)
+		jsP_link(pool, slab);
+	*(void**)ptr = slab->free;
+	slab->free = ptr;
+	--slab->used;
+#else
+	js_free(J, ptr);
+#endif
+	--pool->used;
+}
+
+/* Pool for a js_String of size bytes, or -1 if it is too long for the pools (strings of up to 15 bytes are kept in the js_Value itself) */
+int jsP_stringpool(int size)
+{
+#if JS_POOLS
+	if (size <= 32) return JS_POOLSTR32;
+	if (size <= 64) return JS_POOLSTR64;
+	if (size <= 128) return JS_POOLSTR128;
+#endif
+	return -1;
+}
+
+/* Give back the empty slabs of every pool, except for keep spares per pool */
+void jsP_release(js_State *J, int keep)
+{
+	int i;
+	for (i = 0; i < JS_POOLCOUNT; ++i) {
+		js_Pool *pool = &J->pools[i];
+		js_Slab *slab = pool->avail, *next;
+		int spare = 0;
+		for (; slab; slab = next) {
+			next = slab->next;
+			if (slab->used == 0 && spare++ >= keep) {
+				jsP_unlink(pool, slab);
+				js_free(J, slab);
+				--pool->slabs;
+				++pool->released;
+			}
+		}
+	}
+}
+
+int js_poolinfo(js_State *J, int n, js_PoolInfo *info)
+{
+	js_Pool *pool;
+	if (n < 0 || n >= JS_POOLCOUNT)
+		return 0;
+	pool = &J->pools[n];
+	info->name = pool->name;
+	info->size = pool->size;
+	info->used = pool->used;
+	info->peak = pool->peak;
+	info->capacity = pool->slabs * pool->count;
+	info->slabs = pool->slabs;
+	info->released = pool->released;
+	return 1;
+}
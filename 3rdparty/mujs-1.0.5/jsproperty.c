@@ -2,161 +2,182 @@
 #include "jsvalue.h"
 
 /*
-	Use an AA-tree to quickly look up properties in objects:
+	Property names are interned, so the property tables compare name pointers
+	instead of strings:
 
-	The level of every leaf node is one.
-	The level of every left child is one less than its parent.
-	The level of every right child is equal or one less than its parent.
-	The level of every right grandchild is less than its grandparent.
-	Every node of level greater than one has two children.
+	Objects with up to JS_PROPLINEAR properties keep them packed at the start
+	of obj->properties and search them linearly. Larger objects use an open
+	addressing hash table (linear probing, power of two size, at most half
+	full) keyed by the hash stored with the interned name.
 
-	A link where the child's level is equal to that of its parent is called a horizontal link.
-	Individual right horizontal links are allowed, but consecutive ones are forbidden.
-	Left horizontal links are forbidden.
-
-	skew() fixes left horizontal links.
-	split() fixes consecutive right horizontal links.
+	Enumeration does not depend on the table layout; the iterators sort the
+	names to keep the familiar order.
 */
 
-static js_Property sentinel = {
-	"",
-	&sentinel, &sentinel,
-	0, 0,
-	{ {0}, {0}, JS_TUNDEFINED },
-	NULL, NULL
-};
-
-static js_Property *newproperty(js_State *J, js_Object *obj, const char *name)
+static js_Property *newproperty(js_State *J, const char *name)
 {
-	js_Property *node = js_malloc(J, sizeof *node);
-	node->name = js_intern(J, name);
-	node->left = node->right = &sentinel;
-	node->level = 1;
+	js_Property *node = jsP_alloc(J, JS_POOLPROPERTY);
+	node->name = name;
+	node->hash = jsS_internhash(name);
 	node->atts = 0;
 	node->value.type = JS_TUNDEFINED;
 	node->value.u.number = 0;
 	node->getter = NULL;
 	node->setter = NULL;
-	++obj->count;
 	return node;
 }
 
-static js_Property *lookup(js_Property *node, const char *name)
+static int find(js_Object *obj, const char *name, unsigned int hash)
 {
-	while (node != &sentinel) {
-		int c = strcmp(name, node->name);
-		if (c == 0)
-			return node;
-		else if (c < 0)
-			node = node->left;
-		else
-			node = node->right;
+	int k;
+	if (obj->propcap <= JS_PROPLINEAR) {
+		for (k = 0; k < obj->count; ++k)
+			if (obj->properties[k]->name == name)
+				return k;
+		return k;
 	}
-	return NULL;
+	k = hash & (obj->propcap - 1);
+	while (obj->properties[k] && obj->properties[k]->name != name)
+		k = (k + 1) & (obj->propcap - 1);
+	return k;
 }
 
-static js_Property *skew(js_Property *node)
+static js_Property *lookup(js_Object *obj, const char *name, unsigned int hash)
 {
-	if (node->left->level == node->level) {
-		js_Property *temp = node;
-		node = node->left;
-		temp->left = node->right;
-		node->right = temp;
-	}
-	return node;
+	int k;
+	if (!obj->count)
+		return NULL;
+	k = find(obj, name, hash);
+	return k < obj->propcap ? obj->properties[k] : NULL;
 }
 
-static js_Property *split(js_Property *node)
+static void growproperties(js_State *J, js_Object *obj)
 {
-	if (node->right->right->level == node->level) {
-		js_Property *temp = node;
-		node = node->right;
-		temp->right = node->left;
-		node->left = temp;
-		++node->level;
+	js_Property **table;
+	int i, k, cap;
+
+	if (obj->propcap < JS_PROPLINEAR) {
+		cap = obj->propcap ? obj->propcap * 2 : 4;
+		if (cap > JS_PROPLINEAR)
+			cap = JS_PROPLINEAR;
+		obj->properties = js_realloc(J, obj->properties, cap * sizeof *table);
+		for (i = obj->propcap; i < cap; ++i)
+			obj->properties[i] = NULL;
+		obj->propcap = cap;
+		return;
 	}
-	return node;
+
+	cap = obj->propcap * 2;
+	while (cap <= JS_PROPLINEAR * 2)
+		cap *= 2;
+	table = js_malloc(J, cap * sizeof *table);
+	memset(table, 0, cap * sizeof *table);
+	for (i = 0; i < obj->propcap; ++i) {
+		if (obj->properties[i]) {
+			k = obj->properties[i]->hash & (cap - 1);
+			while (table[k])
+				k = (k + 1) & (cap - 1);
+			table[k] = obj->properties[i];
+		}
+	}
+	js_free(J, obj->properties);
+	obj->properties = table;
+	obj->propcap = cap;
 }
 
-static js_Property *insert(js_State *J, js_Object *obj, js_Property *node, const char *name, js_Property **result)
+js_Property *jsV_lookupproperty(js_Object *obj, const char *name, unsigned int hash)
 {
-	if (node != &sentinel) {
-		int c = strcmp(name, node->name);
-		if (c < 0)
-			node->left = insert(J, obj, node->left, name, result);
-		else if (c > 0)
-			node->right = insert(J, obj, node->right, name, result);
-		else
-			return *result = node;
-		node = skew(node);
-		node = split(node);
-		return node;
-	}
-	return *result = newproperty(J, obj, name);
+	return lookup(obj, name, hash);
 }
 
-static void freeproperty(js_State *J, js_Object *obj, js_Property *node)
+void jsV_reshape(js_State *J, js_Object *obj)
 {
-	js_free(J, node);
-	--obj->count;
+	obj->shape = ++J->nextshape;
+	if (obj->isprototype)
+		++J->protoepoch;
 }
 
-static js_Property *delete(js_State *J, js_Object *obj, js_Property *node, const char *name)
+static js_Property *insert(js_State *J, js_Object *obj, const char *name)
 {
-	js_Property *temp, *succ;
-
-	if (node != &sentinel) {
-		int c = strcmp(name, node->name);
-		if (c < 0) {
-			node->left = delete(J, obj, node->left, name);
-		} else if (c > 0) {
-			node->right = delete(J, obj, node->right, name);
-		} else {
-			if (node->left == &sentinel) {
-				temp = node;
-				node = node->right;
-				freeproperty(J, obj, temp);
-			} else if (node->right == &sentinel) {
-				temp = node;
-				node = node->left;
-				freeproperty(J, obj, temp);
-			} else {
-				succ = node->right;
-				while (succ->left != &sentinel)
-					succ = succ->left;
-				node->name = succ->name;
-				node->atts = succ->atts;
-				node->value = succ->value;
-				node->right = delete(J, obj, node->right, succ->name);
-			}
-		}
+	js_Property *node;
+	const char *iname;
+	unsigned int hash;
+
+	iname = jsS_lookupintern(J, name, &hash);
+	if (iname) {
+		node = lookup(obj, iname, hash);
+		if (node)
+			return node;
+	} else {
+		iname = js_intern(J, name);
+		hash = jsS_internhash(iname);
+	}
 
-		if (node->left->level < node->level - 1 ||
-			node->right->level < node->level - 1)
-		{
-			if (node->right->level > --node->level)
-				node->right->level = node->level;
-			node = skew(node);
-			node->right = skew(node->right);
-			node->right->right = skew(node->right->right);
-			node = split(node);
-			node->right = split(node->right);
+	if (obj->propcap <= JS_PROPLINEAR ? obj->count == obj->propcap : 2 * (obj->count + 1) > obj->propcap)
+		growproperties(J, obj);
+
+	node = newproperty(J, iname);
+	obj->properties[find(obj, iname, hash)] = node;
+	++obj->count;
+	jsV_reshape(J, obj);
+	return node;
+}
+
+static void delete(js_State *J, js_Object *obj, const char *name, unsigned int hash)
+{
+	js_Property *node;
+	int i, k, h;
+
+	if (!obj->count)
+		return;
+	i = find(obj, name, hash);
+	if (i >= obj->propcap || !obj->properties[i])
+		return;
+	node = obj->properties[i];
+
+	if (obj->propcap <= JS_PROPLINEAR) {
+		obj->properties[i] = obj->properties[obj->count - 1];
+		obj->properties[obj->count - 1] = NULL;
+	} else {
+		/* shift back the entries of the probe sequence so no tombstones are needed */
+		obj->properties[i] = NULL;
+		k = (i + 1) & (obj->propcap - 1);
+		while (obj->properties[k]) {
+			h = obj->properties[k]->hash & (obj->propcap - 1);
+			if (((k - h) & (obj->propcap - 1)) >= ((k - i) & (obj->propcap - 1))) {
+				obj->properties[i] = obj->properties[k];
+				obj->properties[k] = NULL;
+				i = k;
+			}
+			k = (k + 1) & (obj->propcap - 1);
 		}
 	}
-	return node;
+
+	jsP_free(J, JS_POOLPROPERTY, node);
+	--obj->count;
+	jsV_reshape(J, obj);
 }
 
 js_Object *jsV_newobject(js_State *J, enum js_Class type, js_Object *prototype)
 {
-	js_Object *obj = js_malloc(J, sizeof *obj);
+	js_Object *obj = jsP_alloc(J, JS_POOLOBJECT);
 	memset(obj, 0, sizeof *obj);
-	obj->gcmark = 0;
+	obj->gcmark = jsG_newmark(J);
 	obj->gcnext = J->gcobj;
 	J->gcobj = obj;
 	++J->gccounter;
 
+	/* inherited elements are only looked up in the property table */
+	if (prototype) {
+		jsV_unflattenarray(J, prototype);
+		if (!prototype->isprototype) {
+			prototype->isprototype = 1;
+			++J->protoepoch;
+		}
+	}
+	obj->shape = ++J->nextshape;
+
 	obj->type = type;
-	obj->properties = &sentinel;
 	obj->prototype = prototype;
 	obj->extensible = 1;
 	return obj;
@@ -164,14 +185,22 @@ js_Object *jsV_newobject(js_State *J, enum js_Class type, js_Object *prototype)
 
 js_Property *jsV_getownproperty(js_State *J, js_Object *obj, const char *name)
 {
-	return lookup(obj->properties, name);
+	unsigned int hash;
+	if (!obj->count)
+		return NULL;
+	name = jsS_lookupintern(J, name, &hash);
+	return name ? lookup(obj, name, hash) : NULL;
 }
 
 js_Property *jsV_getpropertyx(js_State *J, js_Object *obj, const char *name, int *own)
 {
+	unsigned int hash;
 	*own = 1;
+	name = jsS_lookupintern(J, name, &hash);
+	if (!name)
+		return NULL;
 	do {
-		js_Property *ref = lookup(obj->properties, name);
+		js_Property *ref = lookup(obj, name, hash);
 		if (ref)
 			return ref;
 		obj = obj->prototype;
@@ -182,8 +211,12 @@ js_Property *jsV_getpropertyx(js_State *J, js_Object *obj, const char *name, int
 
 js_Property *jsV_getproperty(js_State *J, js_Object *obj, const char *name)
 {
+	unsigned int hash;
+	name = jsS_lookupintern(J, name, &hash);
+	if (!name)
+		return NULL;
 	do {
-		js_Property *ref = lookup(obj->properties, name);
+		js_Property *ref = lookup(obj, name, hash);
 		if (ref)
 			return ref;
 		obj = obj->prototype;
@@ -193,8 +226,12 @@ js_Property *jsV_getproperty(js_State *J, js_Object *obj, const char *name)
 
 static js_Property *jsV_getenumproperty(js_State *J, js_Object *obj, const char *name)
 {
+	unsigned int hash;
+	name = jsS_lookupintern(J, name, &hash);
+	if (!name)
+		return NULL;
 	do {
-		js_Property *ref = lookup(obj->properties, name);
+		js_Property *ref = lookup(obj, name, hash);
 		if (ref && !(ref->atts & JS_DONTENUM))
 			return ref;
 		obj = obj->prototype;
@@ -207,38 +244,99 @@ js_Property *jsV_setproperty(js_State *J, js_Object *obj, const char *name)
 	js_Property *result;
 
 	if (!obj->extensible) {
-		result = lookup(obj->properties, name);
+		result = jsV_getownproperty(J, obj, name);
 		if (J->strict && !result)
 			js_typeerror(J, "object is non-extensible");
 		return result;
 	}
 
-	obj->properties = insert(J, obj, obj->properties, name, &result);
-
-	return result;
+	return insert(J, obj, name);
 }
 
 void jsV_delproperty(js_State *J, js_Object *obj, const char *name)
 {
-	obj->properties = delete(J, obj, obj->properties, name);
+	unsigned int hash;
+	if (!obj->count)
+		return;
+	name = jsS_lookupintern(J, name, &hash);
+	if (name)
+		delete(J, obj, name, hash);
 }
 
 /* Flatten hierarchy of enumerable properties into an iterator object */
 
-static js_Iterator *itwalk(js_State *J, js_Iterator *iter, js_Property *prop, js_Object *seen)
+static js_Iterator *itsort(js_Iterator *list)
+{
+	js_Iterator *a = NULL, *b = NULL, *head, **tail, *next;
+	if (!list || !list->next)
+		return list;
+	while (list) {
+		next = list->next;
+		list->next = a;
+		a = list;
+		list = next;
+		if (list) {
+			next = list->next;
+			list->next = b;
+			b = list;
+			list = next;
+		}
+	}
+	a = itsort(a);
+	b = itsort(b);
+	tail = &head;
+	while (a && b) {
+		if (strcmp(a->name, b->name) < 0) {
+			*tail = a;
+			a = a->next;
+		} else {
+			*tail = b;
+			b = b->next;
+		}
+		tail = &(*tail)->next;
+	}
+	*tail = a ? a : b;
+	return head;
+}
+
+static js_Iterator *itwalk(js_State *J, js_Iterator *iter, js_Object *obj, js_Object *seen, int all)
 {
-	if (prop->right != &sentinel)
-		iter = itwalk(J, iter, prop->right, seen);
-	if (!(prop->atts & JS_DONTENUM)) {
-		if (!seen || !jsV_getenumproperty(J, seen, prop->name)) {
+	js_Iterator *head = NULL, *tail;
+	js_Property *prop;
+	int i;
+	for (i = 0; i < obj->propcap; ++i) {
+		prop = obj->properties[i];
+		if (prop && (all || !(prop->atts & JS_DONTENUM))) {
+			if (!seen || !jsV_getenumproperty(J, seen, prop->name)) {
+				js_Iterator *node = js_malloc(J, sizeof *node);
+				node->name = prop->name;
+				node->next = head;
+				head = node;
+			}
+		}
+	}
+	if (!head)
+		return iter;
+	head = itsort(head);
+	for (tail = head; tail->next; tail = tail->next)
+		;
+	tail->next = iter;
+	return head;
+}
+
+static js_Iterator *itarray(js_State *J, js_Iterator *iter, js_Object *obj, js_Object *seen)
+{
+	char buf[32];
+	int k;
+	for (k = obj->u.a.flat_length - 1; k >= 0; --k) {
+		js_itoa(buf, k);
+		if (!seen || !jsV_getenumproperty(J, seen, buf)) {
 			js_Iterator *head = js_malloc(J, sizeof *head);
-			head->name = prop->name;
+			head->name = js_intern(J, buf);
 			head->next = iter;
 			iter = head;
 		}
 	}
-	if (prop->left != &sentinel)
-		iter = itwalk(J, iter, prop->left, seen);
 	return iter;
 }
 
@@ -247,30 +345,36 @@ static js_Iterator *itflatten(js_State *J, js_Object *obj)
 	js_Iterator *iter = NULL;
 	if (obj->prototype)
 		iter = itflatten(J, obj->prototype);
-	if (obj->properties != &sentinel)
-		iter = itwalk(J, iter, obj->properties, obj->prototype);
+	iter = itwalk(J, iter, obj, obj->prototype, 0);
+	if (obj->type == JS_CARRAY && obj->u.a.simple)
+		iter = itarray(J, iter, obj, obj->prototype);
 	return iter;
 }
 
+/* own: 0 = enumerable properties including inherited ones, 1 = own enumerable, 2 = all own properties except string characters */
 js_Object *jsV_newiterator(js_State *J, js_Object *obj, int own)
 {
 	char buf[32];
-	int k;
+	int k, n = 0;
 	js_Object *io = jsV_newobject(J, JS_CITERATOR, NULL);
 	io->u.iter.target = obj;
 	if (own) {
-		io->u.iter.head = NULL;
-		if (obj->properties != &sentinel)
-			io->u.iter.head = itwalk(J, io->u.iter.head, obj->properties, NULL);
+		io->u.iter.head = itwalk(J, NULL, obj, NULL, own > 1);
+		if (obj->type == JS_CARRAY && obj->u.a.simple)
+			io->u.iter.head = itarray(J, io->u.iter.head, obj, NULL);
 	} else {
 		io->u.iter.head = itflatten(J, obj);
 	}
-	if (obj->type == JS_CSTRING) {
+	if (obj->type == JS_CSTRING && own < 2)
+		n = obj->u.s.length;
+	if (obj->type == JS_CTYPEDARRAY)
+		n = jsV_typedlength(obj);
+	if (n > 0) {
 		js_Iterator *tail = io->u.iter.head;
 		if (tail)
 			while (tail->next)
 				tail = tail->next;
-		for (k = 0; k < obj->u.s.length; ++k) {
+		for (k = 0; k < n; ++k) {
 			js_itoa(buf, k);
 			if (!jsV_getenumproperty(J, obj, buf)) {
 				js_Iterator *node = js_malloc(J, sizeof *node);
@@ -298,15 +402,61 @@ const char *jsV_nextiterator(js_State *J, js_Object *io)
 		const char *name = io->u.iter.head->name;
 		js_free(J, io->u.iter.head);
 		io->u.iter.head = next;
+		if (io->u.iter.target->type == JS_CARRAY && io->u.iter.target->u.a.simple)
+			if (js_isarrayindex(J, name, &k) && k < io->u.iter.target->u.a.flat_length)
+				return name;
 		if (jsV_getproperty(J, io->u.iter.target, name))
 			return name;
 		if (io->u.iter.target->type == JS_CSTRING)
 			if (js_isarrayindex(J, name, &k) && k < io->u.iter.target->u.s.length)
 				return name;
+		if (io->u.iter.target->type == JS_CTYPEDARRAY)
+			if (js_isarrayindex(J, name, &k) && k < jsV_typedlength(io->u.iter.target))
+				return name;
 	}
 	return NULL;
 }
 
+/*
+	Arrays keep their elements in a flat vector instead of the property tree
+	as long as they are dense (every index below flat_length is present),
+	extensible and all elements have default attributes. Anything else moves
+	the elements into the property tree for good.
+*/
+
+void jsV_growarray(js_State *J, js_Object *obj, int capacity)
+{
+	int newcap = obj->u.a.flat_capacity;
+	if (capacity <= newcap)
+		return;
+	if (newcap < 8)
+		newcap = 8;
+	while (newcap < capacity)
+		newcap *= 2;
+	obj->u.a.array = js_realloc(J, obj->u.a.array, newcap * sizeof *obj->u.a.array);
+	obj->u.a.flat_capacity = newcap;
+}
+
+void jsV_unflattenarray(js_State *J, js_Object *obj)
+{
+	char buf[32];
+	js_Property *ref;
+	int k;
+	if (obj->type != JS_CARRAY || !obj->u.a.simple)
+		return;
+	/* keep the flat vector until everything is copied in case we run out of memory */
+	for (k = 0; k < obj->u.a.flat_length; ++k) {
+		ref = jsV_setproperty(J, obj, js_itoa(buf, k));
+		if (ref)
+			ref->value = obj->u.a.array[k];
+	}
+	js_free(J, obj->u.a.array);
+	obj->u.a.array = NULL;
+	obj->u.a.simple = 0;
+	obj->u.a.flat_length = 0;
+	obj->u.a.flat_capacity = 0;
+}
+
 /* Walk all the properties and delete them one by one for arrays */
 
 void jsV_resizearray(js_State *J, js_Object *obj, int newlen)
@@ -314,7 +464,10 @@ void jsV_resizearray(js_State *J, js_Object *obj, int newlen)
 	char buf[32];
 	const char *s;
 	int k;
-	if (newlen < obj->u.a.length) {
+	if (obj->u.a.simple) {
+		if (newlen < obj->u.a.flat_length)
+			obj->u.a.flat_length = newlen;
+	} else if (newlen < obj->u.a.length) {
 		if (obj->u.a.length > obj->count * 2) {
 			js_Object *it = jsV_newiterator(J, obj, 1);
 			while ((s = jsV_nextiterator(J, it))) {
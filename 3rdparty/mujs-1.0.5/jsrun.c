@@ -60,10 +60,21 @@ void js_free(js_State *J, void *ptr)
 
 js_String *jsV_newmemstring(js_State *J, const char *s, int n)
 {
-	js_String *v = js_malloc(J, soffsetof(js_String, p) + n + 1);
+	return jsV_newmemstringx(J, s, n, n);
+}
+
+/* New memory string with room for cap bytes (plus terminator), holding the n bytes at s */
+js_String *jsV_newmemstringx(js_State *J, const char *s, int n, int cap)
+{
+	int size = soffsetof(js_String, p) + cap + 1;
+	int pool = jsP_stringpool(size);
+	js_String *v = pool < 0 ? js_malloc(J, size) : jsP_alloc(J, pool);
+	v->pool = pool;
+	v->len = n;
+	v->cap = cap;
 	memcpy(v->p, s, n);
 	v->p[n] = 0;
-	v->gcmark = 0;
+	v->gcmark = jsG_newmark(J);
 	v->gcnext = J->gcstr;
 	J->gcstr = v;
 	++J->gccounter;
@@ -121,6 +132,7 @@ void js_pushstring(js_State *J, const char *v)
 	} else {
 		STACK[TOP].type = JS_TMEMSTR;
 		STACK[TOP].u.memstr = jsV_newmemstring(J, v, n);
+		jsV_setmemlen(&STACK[TOP], n);
 	}
 	++TOP;
 }
@@ -136,6 +148,7 @@ void js_pushlstring(js_State *J, const char *v, int n)
 	} else {
 		STACK[TOP].type = JS_TMEMSTR;
 		STACK[TOP].u.memstr = jsV_newmemstring(J, v, n);
+		jsV_setmemlen(&STACK[TOP], n);
 	}
 	++TOP;
 }
@@ -443,6 +456,9 @@ void js_rot(js_State *J, int n)
 int js_isarrayindex(js_State *J, const char *p, int *idx)
 {
 	int n = 0;
+	/* only the canonical form is an array index, "" and "01" are plain names */
+	if (p[0] == 0 || (p[0] == '0' && p[1] != 0))
+		return 0;
 	while (*p) {
 		int c = *p++;
 		if (c >= '0' && c <= '9') {
@@ -477,6 +493,12 @@ static int jsR_hasproperty(js_State *J, js_Object *obj, const char *name)
 			js_pushnumber(J, obj->u.a.length);
 			return 1;
 		}
+		if (obj->u.a.simple && js_isarrayindex(J, name, &k)) {
+			if (k < obj->u.a.flat_length) {
+				js_pushvalue(J, obj->u.a.array[k]);
+				return 1;
+			}
+		}
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -518,6 +540,17 @@ static int jsR_hasproperty(js_State *J, js_Object *obj, const char *name)
 	else if (obj->type == JS_CUSERDATA) {
 		if (obj->u.user.has && obj->u.user.has(J, obj->u.user.data, name))
 			return 1;
+		if (obj->u.user.getindex && js_isarrayindex(J, name, &k))
+			if (obj->u.user.getindex(J, obj->u.user.data, k))
+				return 1;
+	}
+
+	else if (obj->type == JS_CTYPEDARRAY || obj->type == JS_CARRAYBUFFER || obj->type == JS_CDATAVIEW) {
+		if (jsV_gettypedproperty(J, obj, name))
+			return 1;
+		if (obj->type == JS_CTYPEDARRAY && js_isarrayindex(J, name, &k))
+			if (jsV_gettypedindex(J, obj, k))
+				return 1;
 	}
 
 	ref = jsV_getproperty(J, obj, name);
@@ -541,6 +574,67 @@ static void jsR_getproperty(js_State *J, js_Object *obj, const char *name)
 		js_pushundefined(J);
 }
 
+/* Store an element of an array with flat storage, k may be at most flat_length */
+static void jsR_setarrayindex(js_State *J, js_Object *obj, int k, js_Value *value)
+{
+	if (k == obj->u.a.flat_length) {
+		jsV_growarray(J, obj, k + 1);
+		obj->u.a.flat_length = k + 1;
+		if (k >= obj->u.a.length)
+			obj->u.a.length = k + 1;
+	}
+	jsG_barrier(J, obj);
+	obj->u.a.array[k] = *value;
+}
+
+/* Check for array[number] where the element is in flat storage (or, if append is set, may be added to it) */
+static int jsR_flatindex(js_State *J, int idx, int key, int append)
+{
+	js_Value *v = stackidx(J, idx);
+	js_Value *k = stackidx(J, key);
+	if (v->type == JS_TOBJECT && k->type == JS_TNUMBER) {
+		js_Object *obj = v->u.object;
+		if (obj->type == JS_CARRAY && obj->u.a.simple) {
+			double x = k->u.number;
+			int n = obj->u.a.flat_length;
+			if (append && n < JS_FLATLIMIT)
+				++n;
+			if (x >= 0 && x < n && x == (int)x)
+				return (int)x;
+		}
+	}
+	return -1;
+}
+
+/* Index of a typed array element access in the view, or -1 */
+static int jsR_typedindex(js_State *J, int idx, int key)
+{
+	js_Value *v = stackidx(J, idx);
+	js_Value *k = stackidx(J, key);
+	if (v->type == JS_TOBJECT && k->type == JS_TNUMBER && v->u.object->type == JS_CTYPEDARRAY) {
+		double x = k->u.number;
+		if (x >= 0 && x < INT_MAX && x == (int)x)
+			return (int)x;
+	}
+	return -1;
+}
+
+/* Index of a userdata element access with index hooks, or -1 */
+static int jsR_userindex(js_State *J, int idx, int key, int put)
+{
+	js_Value *v = stackidx(J, idx);
+	js_Value *k = stackidx(J, key);
+	if (v->type == JS_TOBJECT && k->type == JS_TNUMBER) {
+		js_Object *obj = v->u.object;
+		if (obj->type == JS_CUSERDATA && (put ? obj->u.user.putindex != NULL : obj->u.user.getindex != NULL)) {
+			double x = k->u.number;
+			if (x >= 0 && x < INT_MAX && x == (int)x)
+				return (int)x;
+		}
+	}
+	return -1;
+}
+
 static void jsR_setproperty(js_State *J, js_Object *obj, const char *name)
 {
 	js_Value *value = stackidx(J, -1);
@@ -557,9 +651,17 @@ static void jsR_setproperty(js_State *J, js_Object *obj, const char *name)
 			jsV_resizearray(J, obj, newlen);
 			return;
 		}
-		if (js_isarrayindex(J, name, &k))
+		if (js_isarrayindex(J, name, &k)) {
+			if (obj->u.a.simple) {
+				if (k <= obj->u.a.flat_length && k < JS_FLATLIMIT) {
+					jsR_setarrayindex(J, obj, k, value);
+					return;
+				}
+				jsV_unflattenarray(J, obj);
+			}
 			if (k >= obj->u.a.length)
 				obj->u.a.length = k + 1;
+		}
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -584,6 +686,18 @@ static void jsR_setproperty(js_State *J, js_Object *obj, const char *name)
 	else if (obj->type == JS_CUSERDATA) {
 		if (obj->u.user.put && obj->u.user.put(J, obj->u.user.data, name))
 			return;
+		if (obj->u.user.putindex && js_isarrayindex(J, name, &k))
+			if (obj->u.user.putindex(J, obj->u.user.data, k))
+				return;
+	}
+
+	else if (obj->type == JS_CTYPEDARRAY || obj->type == JS_CARRAYBUFFER || obj->type == JS_CDATAVIEW) {
+		if (jsV_istypedproperty(obj, name))
+			goto readonly;
+		if (obj->type == JS_CTYPEDARRAY && js_isarrayindex(J, name, &k)) {
+			jsV_settypedindex(J, obj, k, value);
+			return;
+		}
 	}
 
 	/* First try to find a setter in prototype chain */
@@ -608,10 +722,12 @@ static void jsR_setproperty(js_State *J, js_Object *obj, const char *name)
 		ref = jsV_setproperty(J, obj, name);
 
 	if (ref) {
-		if (!(ref->atts & JS_READONLY))
+		if (!(ref->atts & JS_READONLY)) {
+			jsG_barrier(J, obj);
 			ref->value = *value;
-		else
+		} else {
 			goto readonly;
+		}
 	}
 
 	return;
@@ -621,6 +737,102 @@ readonly:
 		js_typeerror(J, "'%s' is read-only", name);
 }
 
+/* Inline caches for named property access, see js_InlineCache in jscompile.h */
+
+static int jsR_cacheable(js_Object *obj, const char *name)
+{
+	switch (obj->type) {
+	case JS_CARRAY:
+	case JS_CSTRING:
+		return strcmp(name, "length") != 0;
+	case JS_CREGEXP:
+		return 0;
+	case JS_CUSERDATA:
+		return !obj->u.user.has && !obj->u.user.put;
+	case JS_CARRAYBUFFER:
+	case JS_CTYPEDARRAY:
+	case JS_CDATAVIEW:
+		return !jsV_istypedproperty(obj, name);
+	default:
+		return 1;
+	}
+}
+
+static js_Property *jsR_cachedproperty(js_State *J, js_InlineCache *ic, js_Object *obj)
+{
+	if (!ic->ref || (int)obj->type != ic->type)
+		return NULL;
+	if (!ic->proto)
+		return obj->shape == ic->shape ? ic->ref : NULL;
+	if (ic->epoch != J->protoepoch)
+		return NULL;
+	if (obj->shape == ic->shape)
+		return ic->ref;
+	if (obj->prototype == ic->proto && jsR_cacheable(obj, ic->name) && !jsV_lookupproperty(obj, ic->name, ic->hash))
+		return ic->ref;
+	return NULL;
+}
+
+static void jsR_getpropertycached(js_State *J, js_Object *obj, js_InlineCache *ic)
+{
+	js_Property *ref;
+	int own;
+
+	ref = jsR_cachedproperty(J, ic, obj);
+	if (ref) {
+		++ic->hits;
+	} else {
+		++ic->misses;
+		if (!jsR_cacheable(obj, ic->name)) {
+			jsR_getproperty(J, obj, ic->name);
+			return;
+		}
+		ref = jsV_getpropertyx(J, obj, ic->name, &own);
+		if (!ref) {
+			js_pushundefined(J);
+			return;
+		}
+		ic->type = obj->type;
+		ic->shape = obj->shape;
+		ic->proto = own ? NULL : obj->prototype;
+		ic->epoch = J->protoepoch;
+		ic->ref = ref;
+	}
+
+	if (ref->getter) {
+		js_pushobject(J, ref->getter);
+		js_pushobject(J, obj);
+		js_call(J, 0);
+	} else {
+		js_pushvalue(J, ref->value);
+	}
+}
+
+static void jsR_setpropertycached(js_State *J, js_Object *obj, js_InlineCache *ic)
+{
+	js_Property *ref;
+
+	/* only plain writes to own data properties are cached */
+	if (ic->ref && !ic->proto && obj->shape == ic->shape) {
+		++ic->hits;
+		jsG_barrier(J, obj);
+		ic->ref->value = *stackidx(J, -1);
+		return;
+	}
+
+	++ic->misses;
+	jsR_setproperty(J, obj, ic->name);
+	if (jsR_cacheable(obj, ic->name)) {
+		ref = jsV_lookupproperty(obj, ic->name, ic->hash);
+		if (ref && !ref->getter && !ref->setter && !(ref->atts & JS_READONLY)) {
+			ic->type = obj->type;
+			ic->shape = obj->shape;
+			ic->proto = NULL;
+			ic->ref = ref;
+		}
+	}
+}
+
 static void jsR_defproperty(js_State *J, js_Object *obj, const char *name,
 	int atts, js_Value *value, js_Object *getter, js_Object *setter)
 {
@@ -630,6 +842,8 @@ static void jsR_defproperty(js_State *J, js_Object *obj, const char *name,
 	if (obj->type == JS_CARRAY) {
 		if (!strcmp(name, "length"))
 			goto readonly;
+		if (js_isarrayindex(J, name, &k))
+			jsV_unflattenarray(J, obj);
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -653,8 +867,20 @@ static void jsR_defproperty(js_State *J, js_Object *obj, const char *name,
 			return;
 	}
 
+	else if (obj->type == JS_CTYPEDARRAY || obj->type == JS_CARRAYBUFFER || obj->type == JS_CDATAVIEW) {
+		if (jsV_istypedproperty(obj, name))
+			goto readonly;
+		if (obj->type == JS_CTYPEDARRAY && js_isarrayindex(J, name, &k)) {
+			if (!value || getter || setter)
+				goto readonly;
+			jsV_settypedindex(J, obj, k, value);
+			return;
+		}
+	}
+
 	ref = jsV_setproperty(J, obj, name);
 	if (ref) {
+		jsG_barrier(J, obj);
 		if (value) {
 			if (!(ref->atts & JS_READONLY))
 				ref->value = *value;
@@ -674,6 +900,7 @@ static void jsR_defproperty(js_State *J, js_Object *obj, const char *name,
 				js_typeerror(J, "'%s' is non-configurable", name);
 		}
 		ref->atts |= atts;
+		jsV_reshape(J, obj);
 	}
 
 	return;
@@ -691,6 +918,15 @@ static int jsR_delproperty(js_State *J, js_Object *obj, const char *name)
 	if (obj->type == JS_CARRAY) {
 		if (!strcmp(name, "length"))
 			goto dontconf;
+		if (obj->u.a.simple && js_isarrayindex(J, name, &k)) {
+			if (k >= obj->u.a.flat_length)
+				return 1;
+			if (k == obj->u.a.flat_length - 1) {
+				--obj->u.a.flat_length;
+				return 1;
+			}
+			jsV_unflattenarray(J, obj);
+		}
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -714,6 +950,14 @@ static int jsR_delproperty(js_State *J, js_Object *obj, const char *name)
 			return 1;
 	}
 
+	else if (obj->type == JS_CTYPEDARRAY || obj->type == JS_CARRAYBUFFER || obj->type == JS_CDATAVIEW) {
+		if (jsV_istypedproperty(obj, name))
+			goto dontconf;
+		if (obj->type == JS_CTYPEDARRAY && js_isarrayindex(J, name, &k))
+			if (k < jsV_typedlength(obj))
+				goto dontconf;
+	}
+
 	ref = jsV_getownproperty(J, obj, name);
 	if (ref) {
 		if (ref->atts & JS_DONTCONF)
@@ -825,6 +1069,71 @@ int js_hasproperty(js_State *J, int idx, const char *name)
 	return jsR_hasproperty(J, js_toobject(J, idx), name);
 }
 
+/* Array element accessors, with a shortcut for arrays with flat storage */
+
+int js_getlength(js_State *J, int idx)
+{
+	js_Value *v = stackidx(J, idx);
+	int len;
+	if (v->type == JS_TOBJECT && v->u.object->type == JS_CARRAY)
+		return v->u.object->u.a.length;
+	if (v->type == JS_TOBJECT && v->u.object->type == JS_CTYPEDARRAY)
+		return jsV_typedlength(v->u.object);
+	js_getproperty(J, idx, "length");
+	len = js_tointeger(J, -1);
+	js_pop(J, 1);
+	return len;
+}
+
+void js_setlength(js_State *J, int idx, int len)
+{
+	js_pushnumber(J, len);
+	js_setproperty(J, idx < 0 ? idx - 1 : idx, "length");
+}
+
+int js_hasindex(js_State *J, int idx, int i)
+{
+	char buf[32];
+	js_Object *obj = js_toobject(J, idx);
+	if (obj->type == JS_CARRAY && obj->u.a.simple && i >= 0 && i < obj->u.a.flat_length) {
+		js_pushvalue(J, obj->u.a.array[i]);
+		return 1;
+	}
+	if (obj->type == JS_CUSERDATA && obj->u.user.getindex && i >= 0)
+		if (obj->u.user.getindex(J, obj->u.user.data, i))
+			return 1;
+	if (obj->type == JS_CTYPEDARRAY && i >= 0)
+		return jsV_gettypedindex(J, obj, i);
+	return jsR_hasproperty(J, obj, js_itoa(buf, i));
+}
+
+void js_getindex(js_State *J, int idx, int i)
+{
+	if (!js_hasindex(J, idx, i))
+		js_pushundefined(J);
+}
+
+void js_setindex(js_State *J, int idx, int i)
+{
+	char buf[32];
+	js_Object *obj = js_toobject(J, idx);
+	if (obj->type == JS_CARRAY && obj->u.a.simple && i >= 0 && i <= obj->u.a.flat_length && i < JS_FLATLIMIT)
+		jsR_setarrayindex(J, obj, i, stackidx(J, -1));
+	else if (obj->type == JS_CUSERDATA && obj->u.user.putindex && i >= 0 && obj->u.user.putindex(J, obj->u.user.data, i))
+		;
+	else if (obj->type == JS_CTYPEDARRAY && i >= 0)
+		jsV_settypedindex(J, obj, i, stackidx(J, -1));
+	else
+		jsR_setproperty(J, obj, js_itoa(buf, i));
+	js_pop(J, 1);
+}
+
+void js_delindex(js_State *J, int idx, int i)
+{
+	char buf[32];
+	jsR_delproperty(J, js_toobject(J, idx), js_itoa(buf, i));
+}
+
 /* Iterator */
 
 void js_pushiterator(js_State *J, int idx, int own)
@@ -841,8 +1150,8 @@ const char *js_nextiterator(js_State *J, int idx)
 
 js_Environment *jsR_newenvironment(js_State *J, js_Object *vars, js_Environment *outer)
 {
-	js_Environment *E = js_malloc(J, sizeof *E);
-	E->gcmark = 0;
+	js_Environment *E = jsP_alloc(J, JS_POOLENVIRONMENT);
+	E->gcmark = jsG_newmark(J);
 	E->gcnext = J->gcenv;
 	J->gcenv = E;
 	++J->gccounter;
@@ -891,10 +1200,12 @@ static void js_setvar(js_State *J, const char *name)
 				js_pop(J, 1);
 				return;
 			}
-			if (!(ref->atts & JS_READONLY))
+			if (!(ref->atts & JS_READONLY)) {
+				jsG_barrier(J, E->variables);
 				ref->value = *stackidx(J, -1);
-			else if (J->strict)
+			} else if (J->strict) {
 				js_typeerror(J, "'%s' is read-only", name);
+			}
 			return;
 		}
 		E = E->outer;
@@ -1285,6 +1596,71 @@ void js_trap(js_State *J, int pc)
 	js_stacktrace(J);
 }
 
+#ifdef JS_OPSTATS
+/* Opcode and opcode pair counters, used to pick the superinstructions in jscompile.c */
+
+static unsigned long jsR_opcount[256];
+static unsigned long jsR_paircount[256][256];
+
+void jsR_dumpopstats(js_State *J, int n)
+{
+	unsigned long total = 0, best;
+	int a, b, ba, bb, i;
+
+	for (a = 0; a < 256; ++a)
+		total += jsR_opcount[a];
+	printf("%lu instructions\n", total);
+
+	for (i = 0; i < n; ++i) {
+		best = 0;
+		ba = bb = 0;
+		for (a = 0; a < 256; ++a)
+			for (b = 0; b < 256; ++b)
+				if (jsR_paircount[a][b] > best)
+					best = jsR_paircount[ba = a][bb = b];
+		if (!best)
+			break;
+		printf("%10lu %5.2f%% %s %s\n", best, best * 100.0 / total, jsC_opcodestring(ba), jsC_opcodestring(bb));
+		jsR_paircount[ba][bb] = 0;
+	}
+
+	memset(jsR_opcount, 0, sizeof jsR_opcount);
+	memset(jsR_paircount, 0, sizeof jsR_paircount);
+}
+#endif
+
+#ifdef JS_OPSTATS
+#define COUNTOP() (++jsR_opcount[opcode], ++jsR_paircount[lastop][opcode], lastop = opcode)
+#else
+#define COUNTOP() ((void)0)
+#endif
+
+/* Fetch the next instruction, running the garbage collector when it is due */
+#define FETCH() \
+	do { \
+		if (J->gccounter > JS_GCLIMIT) \
+			jsG_collect(J); \
+		J->trace[J->tracetop].line = *pc++; \
+		opcode = *pc++; \
+		COUNTOP(); \
+	} while (0)
+
+/*
+	With JS_THREADED every handler jumps straight to the handler of the next
+	instruction through a table of label addresses (a GCC extension), so the
+	indirect branch of each opcode gets its own prediction slot. Otherwise
+	the handlers are plain switch cases.
+*/
+#if JS_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define CASE(op) case op: L_##op
+#define NEXT do { FETCH(); goto *optable[opcode]; } while (0)
+#else
+#define CASE(op) case op
+#define NEXT break
+#endif
+
 static void jsR_run(js_State *J, js_Function *F)
 {
 	js_Function **FT = F->funtab;
@@ -1305,40 +1681,45 @@ static void jsR_run(js_State *J, js_Function *F)
 	int ix, iy, okay;
 	int b;
 
+#ifdef JS_OPSTATS
+	enum js_OpCode lastop = OP_RETURN;
+#endif
+
+#if JS_THREADED
+	static const void *optable[] = {
+#include "oplabels.h"
+	};
+#endif
+
 	savestrict = J->strict;
 	J->strict = F->strict;
 
 	while (1) {
-		if (J->gccounter > JS_GCLIMIT)
-			js_gc(J, 0);
-
-		J->trace[J->tracetop].line = *pc++;
-
-		opcode = *pc++;
+		FETCH();
 
 		switch (opcode) {
-		case OP_POP: js_pop(J, 1); break;
-		case OP_DUP: js_dup(J); break;
-		case OP_DUP2: js_dup2(J); break;
-		case OP_ROT2: js_rot2(J); break;
-		case OP_ROT3: js_rot3(J); break;
-		case OP_ROT4: js_rot4(J); break;
-
-		case OP_INTEGER: js_pushnumber(J, *pc++ - 32768); break;
-		case OP_NUMBER: js_pushnumber(J, NT[*pc++]); break;
-		case OP_STRING: js_pushliteral(J, ST[*pc++]); break;
-
-		case OP_CLOSURE: js_newfunction(J, FT[*pc++], J->E); break;
-		case OP_NEWOBJECT: js_newobject(J); break;
-		case OP_NEWARRAY: js_newarray(J); break;
-		case OP_NEWREGEXP: js_newregexp(J, ST[pc[0]], pc[1]); pc += 2; break;
-
-		case OP_UNDEF: js_pushundefined(J); break;
-		case OP_NULL: js_pushnull(J); break;
-		case OP_TRUE: js_pushboolean(J, 1); break;
-		case OP_FALSE: js_pushboolean(J, 0); break;
-
-		case OP_THIS:
+		CASE(OP_POP): js_pop(J, 1); NEXT;
+		CASE(OP_DUP): js_dup(J); NEXT;
+		CASE(OP_DUP2): js_dup2(J); NEXT;
+		CASE(OP_ROT2): js_rot2(J); NEXT;
+		CASE(OP_ROT3): js_rot3(J); NEXT;
+		CASE(OP_ROT4): js_rot4(J); NEXT;
+
+		CASE(OP_INTEGER): js_pushnumber(J, *pc++ - 32768); NEXT;
+		CASE(OP_NUMBER): js_pushnumber(J, NT[*pc++]); NEXT;
+		CASE(OP_STRING): js_pushliteral(J, ST[*pc++]); NEXT;
+
+		CASE(OP_CLOSURE): js_newfunction(J, FT[*pc++], J->E); NEXT;
+		CASE(OP_NEWOBJECT): js_newobject(J); NEXT;
+		CASE(OP_NEWARRAY): js_newarray(J); NEXT;
+		CASE(OP_NEWREGEXP): js_newregexp(J, ST[pc[0]], pc[1]); pc += 2; NEXT;
+
+		CASE(OP_UNDEF): js_pushundefined(J); NEXT;
+		CASE(OP_NULL): js_pushnull(J); NEXT;
+		CASE(OP_TRUE): js_pushboolean(J, 1); NEXT;
+		CASE(OP_FALSE): js_pushboolean(J, 0); NEXT;
+
+		CASE(OP_THIS):
 			if (J->strict) {
 				js_copy(J, 0);
 			} else {
@@ -1347,13 +1728,13 @@ static void jsR_run(js_State *J, js_Function *F)
 				else
 					js_pushglobal(J);
 			}
-			break;
+			NEXT;
 
-		case OP_CURRENT:
+		CASE(OP_CURRENT):
 			js_currentfunction(J);
-			break;
+			NEXT;
 
-		case OP_GETLOCAL:
+		CASE(OP_GETLOCAL):
 			if (lightweight) {
 				CHECKSTACK(1);
 				STACK[TOP++] = STACK[BOT + *pc++];
@@ -1362,17 +1743,17 @@ static void jsR_run(js_State *J, js_Function *F)
 				if (!js_hasvar(J, str))
 					js_referenceerror(J, "'%s' is not defined", str);
 			}
-			break;
+			NEXT;
 
-		case OP_SETLOCAL:
+		CASE(OP_SETLOCAL):
 			if (lightweight) {
 				STACK[BOT + *pc++] = STACK[TOP-1];
 			} else {
 				js_setvar(J, VT[*pc++]);
 			}
-			break;
+			NEXT;
 
-		case OP_DELLOCAL:
+		CASE(OP_DELLOCAL):
 			if (lightweight) {
 				++pc;
 				js_pushboolean(J, 0);
@@ -1380,111 +1761,161 @@ static void jsR_run(js_State *J, js_Function *F)
 				b = js_delvar(J, VT[*pc++]);
 				js_pushboolean(J, b);
 			}
-			break;
+			NEXT;
 
-		case OP_GETVAR:
+		CASE(OP_GETVAR):
 			str = ST[*pc++];
 			if (!js_hasvar(J, str))
 				js_referenceerror(J, "'%s' is not defined", str);
-			break;
+			NEXT;
 
-		case OP_HASVAR:
+		CASE(OP_HASVAR):
 			if (!js_hasvar(J, ST[*pc++]))
 				js_pushundefined(J);
-			break;
+			NEXT;
 
-		case OP_SETVAR:
+		CASE(OP_SETVAR):
 			js_setvar(J, ST[*pc++]);
-			break;
+			NEXT;
 
-		case OP_DELVAR:
+		CASE(OP_DELVAR):
 			b = js_delvar(J, ST[*pc++]);
 			js_pushboolean(J, b);
-			break;
+			NEXT;
 
-		case OP_IN:
+		CASE(OP_IN):
 			str = js_tostring(J, -2);
 			if (!js_isobject(J, -1))
 				js_typeerror(J, "operand to 'in' is not an object");
 			b = js_hasproperty(J, -1, str);
 			js_pop(J, 2 + b);
 			js_pushboolean(J, b);
-			break;
+			NEXT;
 
-		case OP_INITPROP:
+		CASE(OP_INITPROP):
 			obj = js_toobject(J, -3);
 			str = js_tostring(J, -2);
 			jsR_setproperty(J, obj, str);
 			js_pop(J, 2);
-			break;
+			NEXT;
 
-		case OP_INITGETTER:
+		CASE(OP_INITGETTER):
 			obj = js_toobject(J, -3);
 			str = js_tostring(J, -2);
 			jsR_defproperty(J, obj, str, 0, NULL, jsR_tofunction(J, -1), NULL);
 			js_pop(J, 2);
-			break;
+			NEXT;
 
-		case OP_INITSETTER:
+		CASE(OP_INITSETTER):
 			obj = js_toobject(J, -3);
 			str = js_tostring(J, -2);
 			jsR_defproperty(J, obj, str, 0, NULL, NULL, jsR_tofunction(J, -1));
 			js_pop(J, 2);
-			break;
+			NEXT;
 
-		case OP_GETPROP:
+		CASE(OP_GETPROP):
+			ix = jsR_flatindex(J, -2, -1, 0);
+			if (ix >= 0) {
+				obj = stackidx(J, -2)->u.object;
+				*stackidx(J, -2) = obj->u.a.array[ix];
+				js_pop(J, 1);
+				NEXT;
+			}
+			ix = jsR_userindex(J, -2, -1, 0);
+			if (ix >= 0) {
+				obj = stackidx(J, -2)->u.object;
+				if (obj->u.user.getindex(J, obj->u.user.data, ix)) {
+					js_rot3pop2(J);
+					NEXT;
+				}
+			}
+			ix = jsR_typedindex(J, -2, -1);
+			if (ix >= 0) {
+				if (!jsV_gettypedindex(J, stackidx(J, -2)->u.object, ix))
+					js_pushundefined(J);
+				js_rot3pop2(J);
+				NEXT;
+			}
 			str = js_tostring(J, -1);
 			obj = js_toobject(J, -2);
 			jsR_getproperty(J, obj, str);
 			js_rot3pop2(J);
-			break;
+			NEXT;
 
-		case OP_GETPROP_S:
-			str = ST[*pc++];
+		CASE(OP_GETPROP_S):
+			++pc; /* the name is in the cache */
+			if (js_isstring(J, -1) && !strcmp(F->cachetab[*pc].name, "length")) {
+				/* don't box (and intern) a string that may be under construction just to count it */
+				int n = utflen(jsV_peekstring(J, stackidx(J, -1)));
+				++pc;
+				js_pop(J, 1);
+				js_pushnumber(J, n);
+				NEXT;
+			}
 			obj = js_toobject(J, -1);
-			jsR_getproperty(J, obj, str);
+			jsR_getpropertycached(J, obj, &F->cachetab[*pc++]);
 			js_rot2pop1(J);
-			break;
-
-		case OP_SETPROP:
+			NEXT;
+
+		CASE(OP_SETPROP):
+			ix = jsR_flatindex(J, -3, -2, 1);
+			if (ix >= 0) {
+				jsR_setarrayindex(J, stackidx(J, -3)->u.object, ix, stackidx(J, -1));
+				js_rot3pop2(J);
+				NEXT;
+			}
+			ix = jsR_userindex(J, -3, -2, 1);
+			if (ix >= 0) {
+				obj = stackidx(J, -3)->u.object;
+				if (obj->u.user.putindex(J, obj->u.user.data, ix)) {
+					js_rot3pop2(J);
+					NEXT;
+				}
+			}
+			ix = jsR_typedindex(J, -3, -2);
+			if (ix >= 0) {
+				jsV_settypedindex(J, stackidx(J, -3)->u.object, ix, stackidx(J, -1));
+				js_rot3pop2(J);
+				NEXT;
+			}
 			str = js_tostring(J, -2);
 			obj = js_toobject(J, -3);
 			jsR_setproperty(J, obj, str);
 			js_rot3pop2(J);
-			break;
+			NEXT;
 
-		case OP_SETPROP_S:
-			str = ST[*pc++];
+		CASE(OP_SETPROP_S):
+			++pc; /* the name is in the cache */
 			obj = js_toobject(J, -2);
-			jsR_setproperty(J, obj, str);
+			jsR_setpropertycached(J, obj, &F->cachetab[*pc++]);
 			js_rot2pop1(J);
-			break;
+			NEXT;
 
-		case OP_DELPROP:
+		CASE(OP_DELPROP):
 			str = js_tostring(J, -1);
 			obj = js_toobject(J, -2);
 			b = jsR_delproperty(J, obj, str);
 			js_pop(J, 2);
 			js_pushboolean(J, b);
-			break;
+			NEXT;
 
-		case OP_DELPROP_S:
+		CASE(OP_DELPROP_S):
 			str = ST[*pc++];
 			obj = js_toobject(J, -1);
 			b = jsR_delproperty(J, obj, str);
 			js_pop(J, 1);
 			js_pushboolean(J, b);
-			break;
+			NEXT;
 
-		case OP_ITERATOR:
+		CASE(OP_ITERATOR):
 			if (js_iscoercible(J, -1)) {
 				obj = jsV_newiterator(J, js_toobject(J, -1), 0);
 				js_pop(J, 1);
 				js_pushobject(J, obj);
 			}
-			break;
+			NEXT;
 
-		case OP_NEXTITER:
+		CASE(OP_NEXTITER):
 			if (js_isobject(J, -1)) {
 				obj = js_toobject(J, -1);
 				str = jsV_nextiterator(J, obj);
@@ -1499,160 +1930,160 @@ static void jsR_run(js_State *J, js_Function *F)
 				js_pop(J, 1);
 				js_pushboolean(J, 0);
 			}
-			break;
+			NEXT;
 
 		/* Function calls */
 
-		case OP_EVAL:
+		CASE(OP_EVAL):
 			js_eval(J);
-			break;
+			NEXT;
 
-		case OP_CALL:
+		CASE(OP_CALL):
 			js_call(J, *pc++);
-			break;
+			NEXT;
 
-		case OP_NEW:
+		CASE(OP_NEW):
 			js_construct(J, *pc++);
-			break;
+			NEXT;
 
 		/* Unary operators */
 
-		case OP_TYPEOF:
+		CASE(OP_TYPEOF):
 			str = js_typeof(J, -1);
 			js_pop(J, 1);
 			js_pushliteral(J, str);
-			break;
+			NEXT;
 
-		case OP_POS:
+		CASE(OP_POS):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x);
-			break;
+			NEXT;
 
-		case OP_NEG:
+		CASE(OP_NEG):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, -x);
-			break;
+			NEXT;
 
-		case OP_BITNOT:
+		CASE(OP_BITNOT):
 			ix = js_toint32(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, ~ix);
-			break;
+			NEXT;
 
-		case OP_LOGNOT:
+		CASE(OP_LOGNOT):
 			b = js_toboolean(J, -1);
 			js_pop(J, 1);
 			js_pushboolean(J, !b);
-			break;
+			NEXT;
 
-		case OP_INC:
+		CASE(OP_INC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x + 1);
-			break;
+			NEXT;
 
-		case OP_DEC:
+		CASE(OP_DEC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x - 1);
-			break;
+			NEXT;
 
-		case OP_POSTINC:
+		CASE(OP_POSTINC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x + 1);
 			js_pushnumber(J, x);
-			break;
+			NEXT;
 
-		case OP_POSTDEC:
+		CASE(OP_POSTDEC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x - 1);
 			js_pushnumber(J, x);
-			break;
+			NEXT;
 
 		/* Multiplicative operators */
 
-		case OP_MUL:
+		CASE(OP_MUL):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, x * y);
-			break;
+			NEXT;
 
-		case OP_DIV:
+		CASE(OP_DIV):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, x / y);
-			break;
+			NEXT;
 
-		case OP_MOD:
+		CASE(OP_MOD):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, fmod(x, y));
-			break;
+			NEXT;
 
 		/* Additive operators */
 
-		case OP_ADD:
+		CASE(OP_ADD):
 			js_concat(J);
-			break;
+			NEXT;
 
-		case OP_SUB:
+		CASE(OP_SUB):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, x - y);
-			break;
+			NEXT;
 
 		/* Shift operators */
 
-		case OP_SHL:
+		CASE(OP_SHL):
 			ix = js_toint32(J, -2);
 			uy = js_touint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix << (uy & 0x1F));
-			break;
+			NEXT;
 
-		case OP_SHR:
+		CASE(OP_SHR):
 			ix = js_toint32(J, -2);
 			uy = js_touint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix >> (uy & 0x1F));
-			break;
+			NEXT;
 
-		case OP_USHR:
+		CASE(OP_USHR):
 			ux = js_touint32(J, -2);
 			uy = js_touint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ux >> (uy & 0x1F));
-			break;
+			NEXT;
 
 		/* Relational operators */
 
-		case OP_LT: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b < 0); break;
-		case OP_GT: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b > 0); break;
-		case OP_LE: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b <= 0); break;
-		case OP_GE: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b >= 0); break;
+		CASE(OP_LT): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b < 0); NEXT;
+		CASE(OP_GT): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b > 0); NEXT;
+		CASE(OP_LE): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b <= 0); NEXT;
+		CASE(OP_GE): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b >= 0); NEXT;
 
-		case OP_INSTANCEOF:
+		CASE(OP_INSTANCEOF):
 			b = js_instanceof(J);
 			js_pop(J, 2);
 			js_pushboolean(J, b);
-			break;
+			NEXT;
 
 		/* Equality */
 
-		case OP_EQ: b = js_equal(J); js_pop(J, 2); js_pushboolean(J, b); break;
-		case OP_NE: b = js_equal(J); js_pop(J, 2); js_pushboolean(J, !b); break;
-		case OP_STRICTEQ: b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, b); break;
-		case OP_STRICTNE: b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, !b); break;
+		CASE(OP_EQ): b = js_equal(J); js_pop(J, 2); js_pushboolean(J, b); NEXT;
+		CASE(OP_NE): b = js_equal(J); js_pop(J, 2); js_pushboolean(J, !b); NEXT;
+		CASE(OP_STRICTEQ): b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, b); NEXT;
+		CASE(OP_STRICTNE): b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, !b); NEXT;
 
-		case OP_JCASE:
+		CASE(OP_JCASE):
 			offset = *pc++;
 			b = js_strictequal(J);
 			if (b) {
@@ -1661,50 +2092,50 @@ static void jsR_run(js_State *J, js_Function *F)
 			} else {
 				js_pop(J, 1);
 			}
-			break;
+			NEXT;
 
 		/* Binary bitwise operators */
 
-		case OP_BITAND:
+		CASE(OP_BITAND):
 			ix = js_toint32(J, -2);
 			iy = js_toint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix & iy);
-			break;
+			NEXT;
 
-		case OP_BITXOR:
+		CASE(OP_BITXOR):
 			ix = js_toint32(J, -2);
 			iy = js_toint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix ^ iy);
-			break;
+			NEXT;
 
-		case OP_BITOR:
+		CASE(OP_BITOR):
 			ix = js_toint32(J, -2);
 			iy = js_toint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix | iy);
-			break;
+			NEXT;
 
 		/* Try and Catch */
 
-		case OP_THROW:
+		CASE(OP_THROW):
 			js_throw(J);
 
-		case OP_TRY:
+		CASE(OP_TRY):
 			offset = *pc++;
 			if (js_trypc(J, pc)) {
 				pc = J->trybuf[J->trytop].pc;
 			} else {
 				pc = pcstart + offset;
 			}
-			break;
+			NEXT;
 
-		case OP_ENDTRY:
+		CASE(OP_ENDTRY):
 			js_endtry(J);
-			break;
+			NEXT;
 
-		case OP_CATCH:
+		CASE(OP_CATCH):
 			str = ST[*pc++];
 			obj = jsV_newobject(J, JS_COBJECT, NULL);
 			js_pushobject(J, obj);
@@ -1712,53 +2143,114 @@ static void jsR_run(js_State *J, js_Function *F)
 			js_setproperty(J, -2, str);
 			J->E = jsR_newenvironment(J, obj, J->E);
 			js_pop(J, 1);
-			break;
+			NEXT;
 
-		case OP_ENDCATCH:
+		CASE(OP_ENDCATCH):
 			J->E = J->E->outer;
-			break;
+			NEXT;
 
 		/* With */
 
-		case OP_WITH:
+		CASE(OP_WITH):
 			obj = js_toobject(J, -1);
 			J->E = jsR_newenvironment(J, obj, J->E);
 			js_pop(J, 1);
-			break;
+			NEXT;
 
-		case OP_ENDWITH:
+		CASE(OP_ENDWITH):
 			J->E = J->E->outer;
-			break;
+			NEXT;
 
 		/* Branching */
 
-		case OP_DEBUGGER:
+		CASE(OP_DEBUGGER):
 			js_trap(J, (int)(pc - pcstart) - 1);
-			break;
+			NEXT;
 
-		case OP_JUMP:
+		CASE(OP_JUMP):
 			pc = pcstart + *pc;
-			break;
+			NEXT;
 
-		case OP_JTRUE:
+		CASE(OP_JTRUE):
 			offset = *pc++;
 			b = js_toboolean(J, -1);
 			js_pop(J, 1);
 			if (b)
 				pc = pcstart + offset;
-			break;
+			NEXT;
 
-		case OP_JFALSE:
+		CASE(OP_JFALSE):
 			offset = *pc++;
 			b = js_toboolean(J, -1);
 			js_pop(J, 1);
 			if (!b)
 				pc = pcstart + offset;
-			break;
+			NEXT;
 
-		case OP_RETURN:
+		CASE(OP_RETURN):
 			J->strict = savestrict;
 			return;
+
+		/* Superinstructions */
+
+		CASE(OP_SETLOCALPOP):
+			if (lightweight) {
+				STACK[BOT + *pc++] = STACK[TOP-1];
+			} else {
+				js_setvar(J, VT[*pc++]);
+			}
+			js_pop(J, 1);
+			NEXT;
+
+		CASE(OP_GETLOCAL2):
+			if (lightweight) {
+				CHECKSTACK(2);
+				STACK[TOP++] = STACK[BOT + pc[0]];
+				STACK[TOP++] = STACK[BOT + pc[1]];
+				pc += 2;
+			} else {
+				str = VT[*pc++];
+				if (!js_hasvar(J, str))
+					js_referenceerror(J, "'%s' is not defined", str);
+				str = VT[*pc++];
+				if (!js_hasvar(J, str))
+					js_referenceerror(J, "'%s' is not defined", str);
+			}
+			NEXT;
+
+		CASE(OP_GETLOCALINT):
+			if (lightweight) {
+				CHECKSTACK(2);
+				STACK[TOP++] = STACK[BOT + *pc++];
+			} else {
+				str = VT[*pc++];
+				if (!js_hasvar(J, str))
+					js_referenceerror(J, "'%s' is not defined", str);
+			}
+			js_pushnumber(J, *pc++ - 32768);
+			NEXT;
+
+		CASE(OP_GETVARUNDEF):
+			str = ST[*pc++];
+			if (!js_hasvar(J, str))
+				js_referenceerror(J, "'%s' is not defined", str);
+			js_pushundefined(J);
+			NEXT;
+
+		CASE(OP_GETMETHOD_S):
+			++pc; /* the name is in the cache */
+			obj = js_toobject(J, -1);
+			jsR_getpropertycached(J, obj, &F->cachetab[*pc++]);
+			js_rot2(J);
+			NEXT;
 		}
 	}
 }
+
+#if JS_THREADED
+#pragma GCC diagnostic pop
+#endif
+#undef CASE
+#undef NEXT
+#undef FETCH
+#undef COUNTOP
@@ -3,6 +3,10 @@
 
 js_Environment *jsR_newenvironment(js_State *J, js_Object *variables, js_Environment *outer);
 
+#ifdef JS_OPSTATS
+void jsR_dumpopstats(js_State *J, int n);
+#endif
+
 struct js_Environment
 {
 	js_Environment *outer;
@@ -255,6 +255,7 @@ js_State *js_newstate(js_Alloc alloc, void *actx, int flags)
 
 	if (flags & JS_STRICT)
 		J->strict = J->default_strict = 1;
+	J->optimize = !(flags & JS_NOOPTIMIZE);
 
 	J->trace[0].name = "-top-";
 	J->trace[0].file = "native";
@@ -272,6 +273,8 @@ js_State *js_newstate(js_Alloc alloc, void *actx, int flags)
 	J->gcmark = 1;
 	J->nextref = 0;
 
+	jsP_initpools(J);
+
 	J->R = jsV_newobject(J, JS_COBJECT, NULL);
 	J->G = jsV_newobject(J, JS_COBJECT, NULL);
 	J->E = jsR_newenvironment(J, J->G, NULL);
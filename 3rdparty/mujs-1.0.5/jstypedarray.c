@@ -0,0 +1,817 @@
+#include "jsi.h"
+#include "jsvalue.h"
+#include "jsbuiltin.h"
+
+/*
+	ArrayBuffer, the typed array views and DataView.
+
+	A buffer either owns its bytes or uses the storage of a native object
+	(js_newarraybufferx). Storage that its owner may reallocate is reached
+	through pointers to the owner's data pointer and element count
+	(js_newarraybufferp), so it is looked up again on every access and views
+	never see a stale copy. Views created without an explicit length follow
+	the length of their buffer.
+*/
+
+static const int typedsize[JS_TACOUNT] = { 1, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+static const char *typedname[JS_TACOUNT] = {
+	"Int8Array", "Uint8Array", "Uint8ClampedArray", "Int16Array", "Uint16Array",
+	"Int32Array", "Uint32Array", "Float32Array", "Float64Array",
+};
+
+const char *jsV_typedname(js_Object *obj)
+{
+	return typedname[obj->u.ta.kind];
+}
+
+unsigned char *jsV_bufferdata(js_Object *buf, unsigned int *length)
+{
+	if (buf->u.ab.pdata) {
+		*length = *buf->u.ab.plength * buf->u.ab.scale;
+		return *buf->u.ab.pdata;
+	}
+	*length = buf->u.ab.length;
+	return buf->u.ab.data;
+}
+
+/* The bytes a view can access right now and their number in elements (bytes for DataView) */
+unsigned char *jsV_typeddata(js_Object *obj, unsigned int *length)
+{
+	unsigned int size = obj->type == JS_CDATAVIEW ? 1 : typedsize[obj->u.ta.kind];
+	unsigned int n;
+	unsigned char *data = jsV_bufferdata(obj->u.ta.buffer, &n);
+	if (obj->u.ta.offset > n) {
+		*length = 0;
+		return data;
+	}
+	n = (n - obj->u.ta.offset) / size;
+	if (obj->u.ta.tracking)
+		*length = n;
+	else
+		*length = obj->u.ta.length <= n ? obj->u.ta.length : 0; /* out of bounds views are empty */
+	return data + obj->u.ta.offset;
+}
+
+int jsV_typedlength(js_Object *obj)
+{
+	unsigned int n;
+	jsV_typeddata(obj, &n);
+	return n;
+}
+
+static double jsV_loadtyped(int kind, const unsigned char *p)
+{
+	switch (kind) {
+	case JS_TAINT8: return *(const signed char *)p;
+	case JS_TAUINT8:
+	case JS_TAUINT8C: return *p;
+	case JS_TAINT16: return *(const short *)p;
+	case JS_TAUINT16: return *(const unsigned short *)p;
+	case JS_TAINT32: return *(const int *)p;
+	case JS_TAUINT32: return *(const unsigned int *)p;
+	case JS_TAFLOAT32: return *(const float *)p;
+	default: return *(const double *)p;
+	}
+}
+
+/* ToInt32 without the fmod() for values that fit */
+static int jsV_typedint(double x)
+{
+	if (x >= -2147483648.0 && x < 2147483648.0)
+		return (int)x;
+	if (x >= 0 && x < 4294967296.0)
+		return (int)(unsigned int)x;
+	return jsV_numbertoint32(x);
+}
+
+static unsigned char jsV_clampbyte(double x)
+{
+	double f, r;
+	if (!(x > 0))
+		return 0;
+	if (x >= 255)
+		return 255;
+	f = floor(x);
+	r = x - f;
+	if (r > 0.5 || (r == 0.5 && ((int)f & 1)))
+		f += 1;
+	return f;
+}
+
+static void jsV_storetyped(int kind, unsigned char *p, double x)
+{
+	switch (kind) {
+	case JS_TAINT8:
+	case JS_TAUINT8: *p = jsV_typedint(x); break;
+	case JS_TAUINT8C: *p = jsV_clampbyte(x); break;
+	case JS_TAINT16:
+	case JS_TAUINT16: *(unsigned short *)p = jsV_typedint(x); break;
+	case JS_TAINT32:
+	case JS_TAUINT32: *(int *)p = jsV_typedint(x); break;
+	case JS_TAFLOAT32: *(float *)p = x; break;
+	default: *(double *)p = x; break;
+	}
+}
+
+int jsV_gettypedindex(js_State *J, js_Object *obj, int k)
+{
+	unsigned int n;
+	unsigned char *p = jsV_typeddata(obj, &n);
+	if (k < 0 || (unsigned int)k >= n)
+		return 0;
+	js_pushnumber(J, jsV_loadtyped(obj->u.ta.kind, p + k * typedsize[obj->u.ta.kind]));
+	return 1;
+}
+
+/* Stores to indices outside the view are ignored */
+void jsV_settypedindex(js_State *J, js_Object *obj, int k, js_Value *v)
+{
+	double x = v->type == JS_TNUMBER ? v->u.number : jsV_tonumber(J, v);
+	unsigned int n;
+	unsigned char *p = jsV_typeddata(obj, &n);
+	if (k >= 0 && (unsigned int)k < n)
+		jsV_storetyped(obj->u.ta.kind, p + k * typedsize[obj->u.ta.kind], x);
+}
+
+int jsV_istypedproperty(js_Object *obj, const char *name)
+{
+	if (!strcmp(name, "byteLength"))
+		return 1;
+	if (obj->type == JS_CARRAYBUFFER)
+		return 0;
+	if (!strcmp(name, "byteOffset") || !strcmp(name, "buffer"))
+		return 1;
+	return obj->type == JS_CTYPEDARRAY && !strcmp(name, "length");
+}
+
+/* length, byteLength, byteOffset and buffer of buffers and views */
+int jsV_gettypedproperty(js_State *J, js_Object *obj, const char *name)
+{
+	unsigned int n;
+	if (!jsV_istypedproperty(obj, name))
+		return 0;
+	if (obj->type == JS_CARRAYBUFFER) {
+		jsV_bufferdata(obj, &n);
+		js_pushnumber(J, n);
+		return 1;
+	}
+	if (name[0] == 'b' && name[1] == 'u') {
+		js_pushobject(J, obj->u.ta.buffer);
+		return 1;
+	}
+	jsV_typeddata(obj, &n);
+	if (name[0] == 'l')
+		js_pushnumber(J, n);
+	else if (name[4] == 'L')
+		js_pushnumber(J, obj->type == JS_CDATAVIEW ? n : n * typedsize[obj->u.ta.kind]);
+	else
+		js_pushnumber(J, obj->u.ta.offset);
+	return 1;
+}
+
+/* Public API for native storage */
+
+void js_newarraybuffer(js_State *J, unsigned int length)
+{
+	js_Object *obj;
+	if (length > INT_MAX)
+		js_rangeerror(J, "invalid array buffer length");
+	obj = jsV_newobject(J, JS_CARRAYBUFFER, J->ArrayBuffer_prototype);
+	js_pushobject(J, obj);
+	obj->u.ab.data = js_malloc(J, length ? length : 1);
+	memset(obj->u.ab.data, 0, length);
+	obj->u.ab.length = length;
+}
+
+static js_Object *jsB_newexternal(js_State *J, int owner)
+{
+	js_Object *obj;
+	js_Object *ref = js_isobject(J, owner) ? js_toobject(J, owner) : NULL;
+	obj = jsV_newobject(J, JS_CARRAYBUFFER, J->ArrayBuffer_prototype);
+	obj->u.ab.external = 1;
+	obj->u.ab.owner = ref;
+	js_pushobject(J, obj);
+	return obj;
+}
+
+void js_newarraybufferx(js_State *J, int owner, void *data, unsigned int length)
+{
+	js_Object *obj = jsB_newexternal(J, owner);
+	obj->u.ab.data = data;
+	obj->u.ab.length = length;
+}
+
+void js_newarraybufferp(js_State *J, int owner, void **data, unsigned int *count, unsigned int scale)
+{
+	js_Object *obj = jsB_newexternal(J, owner);
+	obj->u.ab.pdata = (unsigned char **)data;
+	obj->u.ab.plength = count;
+	obj->u.ab.scale = scale;
+}
+
+int js_isarraybuffer(js_State *J, int idx)
+{
+	return js_isobject(J, idx) && js_toobject(J, idx)->type == JS_CARRAYBUFFER;
+}
+
+void *js_toarraybuffer(js_State *J, int idx, unsigned int *length)
+{
+	js_Object *obj = js_toobject(J, idx);
+	if (obj->type != JS_CARRAYBUFFER)
+		js_typeerror(J, "not an ArrayBuffer");
+	return jsV_bufferdata(obj, length);
+}
+
+/* Helpers */
+
+static js_Object *jsB_tobuffer(js_State *J, int idx)
+{
+	js_Object *obj = js_toobject(J, idx);
+	if (obj->type != JS_CARRAYBUFFER)
+		js_typeerror(J, "not an ArrayBuffer");
+	return obj;
+}
+
+static js_Object *jsB_totyped(js_State *J, int idx)
+{
+	js_Object *obj = js_toobject(J, idx);
+	if (obj->type != JS_CTYPEDARRAY)
+		js_typeerror(J, "not a typed array");
+	return obj;
+}
+
+static js_Object *jsB_todataview(js_State *J, int idx)
+{
+	js_Object *obj = js_toobject(J, idx);
+	if (obj->type != JS_CDATAVIEW)
+		js_typeerror(J, "not a DataView");
+	return obj;
+}
+
+/* Length or offset argument: undefined and NaN are dflt, anything else must be an integer in 0..INT_MAX */
+static double jsB_toindex(js_State *J, int idx, double dflt, const char *error)
+{
+	double x;
+	if (!js_isdefined(J, idx))
+		return dflt;
+	x = js_tonumber(J, idx);
+	if (isnan(x))
+		return 0;
+	if (x < 0 || x > INT_MAX || x != floor(x))
+		js_rangeerror(J, "%s", error);
+	return x;
+}
+
+/* Clamp a relative index argument (negative counts from the end) to 0..len */
+static int jsB_relindex(js_State *J, int idx, int len, int dflt)
+{
+	double x;
+	if (!js_isdefined(J, idx))
+		return dflt;
+	x = js_tointeger(J, idx);
+	if (x < 0)
+		x += len;
+	if (x < 0)
+		return 0;
+	if (x > len)
+		return len;
+	return x;
+}
+
+static js_Object *jsB_newview(js_State *J, enum js_Class type, int kind, js_Object *buf, unsigned int offset, unsigned int length, int tracking)
+{
+	js_Object *obj = jsV_newobject(J, type, type == JS_CDATAVIEW ? J->DataView_prototype : J->TypedArray_prototype[kind]);
+	obj->u.ta.buffer = buf;
+	obj->u.ta.offset = offset;
+	obj->u.ta.length = length;
+	obj->u.ta.tracking = tracking;
+	obj->u.ta.kind = kind;
+	js_pushobject(J, obj);
+	return obj;
+}
+
+/* Push a zero filled typed array with its own buffer */
+static js_Object *jsB_newtypedlength(js_State *J, int kind, double length)
+{
+	js_Object *obj;
+	if (length < 0 || length > INT_MAX / typedsize[kind])
+		js_rangeerror(J, "invalid typed array length");
+	js_newarraybuffer(J, length * typedsize[kind]);
+	obj = jsB_newview(J, JS_CTYPEDARRAY, kind, js_toobject(J, -1), 0, length, 0);
+	js_rot2pop1(J);
+	return obj;
+}
+
+/* ArrayBuffer */
+
+static void jsB_ArrayBuffer(js_State *J)
+{
+	js_typeerror(J, "constructor ArrayBuffer requires 'new'");
+}
+
+static void jsB_new_ArrayBuffer(js_State *J)
+{
+	js_newarraybuffer(J, jsB_toindex(J, 1, 0, "invalid array buffer length"));
+}
+
+static void ABp_slice(js_State *J)
+{
+	js_Object *self = jsB_tobuffer(J, 0);
+	unsigned int len;
+	unsigned char *src;
+	int s, e;
+
+	jsV_bufferdata(self, &len);
+	s = jsB_relindex(J, 1, len, 0);
+	e = jsB_relindex(J, 2, len, len);
+	if (e < s)
+		e = s;
+	js_newarraybuffer(J, e - s);
+
+	/* the owner may have moved the storage while the arguments were converted */
+	src = jsV_bufferdata(self, &len);
+	if ((unsigned int)e <= len)
+		memcpy(js_toobject(J, -1)->u.ab.data, src + s, e - s);
+}
+
+static void AB_isView(js_State *J)
+{
+	if (js_isobject(J, 1)) {
+		js_Object *obj = js_toobject(J, 1);
+		js_pushboolean(J, obj->type == JS_CTYPEDARRAY || obj->type == JS_CDATAVIEW);
+	} else {
+		js_pushboolean(J, 0);
+	}
+}
+
+/* Typed array constructors */
+
+static void jsB_newtyped(js_State *J, int kind)
+{
+	int size = typedsize[kind];
+	js_Object *obj, *src;
+	unsigned int buflen, n;
+	unsigned char *p, *q;
+	double offset, len;
+	int i;
+
+	if (js_isobject(J, 1) && js_toobject(J, 1)->type == JS_CARRAYBUFFER) {
+		src = js_toobject(J, 1);
+		offset = jsB_toindex(J, 2, 0, "invalid typed array offset");
+		len = jsB_toindex(J, 3, -1, "invalid typed array length");
+		jsV_bufferdata(src, &buflen);
+		if (offset < 0 || offset > buflen || (int)offset % size)
+			js_rangeerror(J, "start offset of %s should be a multiple of %d", typedname[kind], size);
+		if (js_isdefined(J, 3)) {
+			if (len < 0 || offset + len * size > buflen)
+				js_rangeerror(J, "invalid typed array length");
+			jsB_newview(J, JS_CTYPEDARRAY, kind, src, offset, len, 0);
+		} else {
+			if (!src->u.ab.pdata && (buflen - (unsigned int)offset) % size)
+				js_rangeerror(J, "byte length of %s should be a multiple of %d", typedname[kind], size);
+			jsB_newview(J, JS_CTYPEDARRAY, kind, src, offset, 0, 1);
+		}
+		return;
+	}
+
+	if (js_isobject(J, 1) && js_toobject(J, 1)->type == JS_CTYPEDARRAY) {
+		src = js_toobject(J, 1);
+		obj = jsB_newtypedlength(J, kind, jsV_typedlength(src));
+		q = jsV_typeddata(src, &n);
+		p = obj->u.ta.buffer->u.ab.data;
+		if (src->u.ta.kind == kind)
+			memcpy(p, q, n * size);
+		else
+			for (i = 0; i < (int)n; ++i)
+				jsV_storetyped(kind, p + i * size, jsV_loadtyped(src->u.ta.kind, q + i * typedsize[src->u.ta.kind]));
+		return;
+	}
+
+	if (js_isobject(J, 1)) {
+		n = js_getlength(J, 1);
+		obj = jsB_newtypedlength(J, kind, n);
+		for (i = 0; i < (int)n; ++i) {
+			js_getindex(J, 1, i);
+			jsV_settypedindex(J, obj, i, js_tovalue(J, -1));
+			js_pop(J, 1);
+		}
+		return;
+	}
+
+	jsB_newtypedlength(J, kind, jsB_toindex(J, 1, 0, "invalid typed array length"));
+}
+
+#define TYPEDCTOR(NAME, KIND) \
+	static void jsB_##NAME(js_State *J) { js_typeerror(J, "constructor " #NAME " requires 'new'"); } \
+	static void jsB_new_##NAME(js_State *J) { jsB_newtyped(J, KIND); }
+
+TYPEDCTOR(Int8Array, JS_TAINT8)
+TYPEDCTOR(Uint8Array, JS_TAUINT8)
+TYPEDCTOR(Uint8ClampedArray, JS_TAUINT8C)
+TYPEDCTOR(Int16Array, JS_TAINT16)
+TYPEDCTOR(Uint16Array, JS_TAUINT16)
+TYPEDCTOR(Int32Array, JS_TAINT32)
+TYPEDCTOR(Uint32Array, JS_TAUINT32)
+TYPEDCTOR(Float32Array, JS_TAFLOAT32)
+TYPEDCTOR(Float64Array, JS_TAFLOAT64)
+
+static const js_CFunction typedcall[JS_TACOUNT] = {
+	jsB_Int8Array, jsB_Uint8Array, jsB_Uint8ClampedArray, jsB_Int16Array, jsB_Uint16Array,
+	jsB_Int32Array, jsB_Uint32Array, jsB_Float32Array, jsB_Float64Array,
+};
+
+static const js_CFunction typednew[JS_TACOUNT] = {
+	jsB_new_Int8Array, jsB_new_Uint8Array, jsB_new_Uint8ClampedArray, jsB_new_Int16Array, jsB_new_Uint16Array,
+	jsB_new_Int32Array, jsB_new_Uint32Array, jsB_new_Float32Array, jsB_new_Float64Array,
+};
+
+/* %TypedArray%.prototype */
+
+static void TAp_subarray(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int len = jsV_typedlength(self);
+	int s = jsB_relindex(J, 1, len, 0);
+	int e = jsB_relindex(J, 2, len, len);
+	if (e < s)
+		e = s;
+	jsB_newview(J, JS_CTYPEDARRAY, self->u.ta.kind, self->u.ta.buffer,
+		self->u.ta.offset + s * typedsize[self->u.ta.kind], e - s, 0);
+}
+
+static void TAp_slice(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int size = typedsize[self->u.ta.kind];
+	int len = jsV_typedlength(self);
+	int s = jsB_relindex(J, 1, len, 0);
+	int e = jsB_relindex(J, 2, len, len);
+	unsigned int n;
+	unsigned char *p;
+	js_Object *obj;
+	if (e < s)
+		e = s;
+	obj = jsB_newtypedlength(J, self->u.ta.kind, e - s);
+	p = jsV_typeddata(self, &n);
+	if ((unsigned int)e <= n)
+		memcpy(obj->u.ta.buffer->u.ab.data, p + s * size, (e - s) * size);
+}
+
+static void TAp_set(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int kind = self->u.ta.kind;
+	int size = typedsize[kind];
+	double offset = js_isdefined(J, 2) ? js_tointeger(J, 2) : 0;
+	unsigned int len, n;
+	unsigned char *p, *q;
+	double *tmp;
+	int i;
+
+	if (offset < 0)
+		js_rangeerror(J, "offset is out of bounds");
+
+	if (js_isobject(J, 1) && js_toobject(J, 1)->type == JS_CTYPEDARRAY) {
+		js_Object *src = js_toobject(J, 1);
+		p = jsV_typeddata(self, &len);
+		q = jsV_typeddata(src, &n);
+		if (offset + n > len)
+			js_rangeerror(J, "offset is out of bounds");
+		p += (int)offset * size;
+		if (src->u.ta.kind == kind) {
+			memmove(p, q, n * size);
+		} else {
+			/* the source may overlap the destination */
+			tmp = js_malloc(J, (n ? n : 1) * sizeof *tmp);
+			for (i = 0; i < (int)n; ++i)
+				tmp[i] = jsV_loadtyped(src->u.ta.kind, q + i * typedsize[src->u.ta.kind]);
+			for (i = 0; i < (int)n; ++i)
+				jsV_storetyped(kind, p + i * size, tmp[i]);
+			js_free(J, tmp);
+		}
+	} else {
+		n = js_getlength(J, 1);
+		if (offset + n > jsV_typedlength(self))
+			js_rangeerror(J, "offset is out of bounds");
+		for (i = 0; i < (int)n; ++i) {
+			js_getindex(J, 1, i);
+			jsV_settypedindex(J, self, offset + i, js_tovalue(J, -1));
+			js_pop(J, 1);
+		}
+	}
+	js_pushundefined(J);
+}
+
+static void TAp_fill(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int size = typedsize[self->u.ta.kind];
+	double x = js_tonumber(J, 1);
+	int len = jsV_typedlength(self);
+	int s = jsB_relindex(J, 2, len, 0);
+	int e = jsB_relindex(J, 3, len, len);
+	unsigned int n;
+	unsigned char *p = jsV_typeddata(self, &n);
+	if ((unsigned int)e > n)
+		e = n;
+	for (; s < e; ++s)
+		jsV_storetyped(self->u.ta.kind, p + s * size, x);
+	js_copy(J, 0);
+}
+
+static void TAp_copyWithin(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int size = typedsize[self->u.ta.kind];
+	int len = jsV_typedlength(self);
+	int t = jsB_relindex(J, 1, len, 0);
+	int s = jsB_relindex(J, 2, len, 0);
+	int e = jsB_relindex(J, 3, len, len);
+	unsigned int n;
+	unsigned char *p = jsV_typeddata(self, &n);
+	int count = e - s;
+	if (count > len - t)
+		count = len - t;
+	if (count > 0 && (unsigned int)(t + count) <= n && (unsigned int)(s + count) <= n)
+		memmove(p + t * size, p + s * size, count * size);
+	js_copy(J, 0);
+}
+
+static int compare_number(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	if (x != x)
+		return y != y ? 0 : 1;
+	if (y != y)
+		return -1;
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void TAp_sort(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int kind = self->u.ta.kind;
+	int size = typedsize[kind];
+	unsigned int n;
+	unsigned char *p;
+	double *tmp;
+	int i;
+
+	/* with a comparison function the generic Array.prototype.sort is used */
+	if (js_isdefined(J, 1)) {
+		js_pushobject(J, J->Array_prototype);
+		js_getproperty(J, -1, "sort");
+		js_copy(J, 0);
+		js_copy(J, 1);
+		js_call(J, 1);
+		return;
+	}
+
+	p = jsV_typeddata(self, &n);
+	tmp = js_malloc(J, (n ? n : 1) * sizeof *tmp);
+	for (i = 0; i < (int)n; ++i)
+		tmp[i] = jsV_loadtyped(kind, p + i * size);
+	qsort(tmp, n, sizeof *tmp, compare_number);
+	for (i = 0; i < (int)n; ++i)
+		jsV_storetyped(kind, p + i * size, tmp[i]);
+	js_free(J, tmp);
+	js_copy(J, 0);
+}
+
+static void TAp_map(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int hasthis = js_gettop(J) >= 3;
+	int len = jsV_typedlength(self);
+	js_Object *obj;
+	int k;
+
+	if (!js_iscallable(J, 1))
+		js_typeerror(J, "callback is not a function");
+
+	obj = jsB_newtypedlength(J, self->u.ta.kind, len);
+	for (k = 0; k < len; ++k) {
+		js_copy(J, 1);
+		if (hasthis)
+			js_copy(J, 2);
+		else
+			js_pushundefined(J);
+		if (!jsV_gettypedindex(J, self, k))
+			js_pushundefined(J);
+		js_pushnumber(J, k);
+		js_copy(J, 0);
+		js_call(J, 3);
+		jsV_settypedindex(J, obj, k, js_tovalue(J, -1));
+		js_pop(J, 1);
+	}
+}
+
+static void TAp_filter(js_State *J)
+{
+	js_Object *self = jsB_totyped(J, 0);
+	int hasthis = js_gettop(J) >= 3;
+	int len = jsV_typedlength(self);
+	int k, n = 0;
+
+	if (!js_iscallable(J, 1))
+		js_typeerror(J, "callback is not a function");
+
+	/* collect the values in an array first, the new length is not known yet */
+	js_newarray(J);
+	for (k = 0; k < len; ++k) {
+		if (!jsV_gettypedindex(J, self, k))
+			break;
+		js_copy(J, 1);
+		if (hasthis)
+			js_copy(J, 2);
+		else
+			js_pushundefined(J);
+		js_copy(J, -3);
+		js_pushnumber(J, k);
+		js_copy(J, 0);
+		js_call(J, 3);
+		if (js_toboolean(J, -1)) {
+			js_pop(J, 1);
+			js_setindex(J, -2, n++);
+		} else {
+			js_pop(J, 2);
+		}
+	}
+
+	js_pushobject(J, J->TypedArray_prototype[self->u.ta.kind]);
+	js_getproperty(J, -1, "constructor");
+	js_rot2pop1(J);
+	js_rot2(J);
+	js_construct(J, 1);
+}
+
+/* DataView */
+
+static void jsB_DataView(js_State *J)
+{
+	js_typeerror(J, "constructor DataView requires 'new'");
+}
+
+static void jsB_new_DataView(js_State *J)
+{
+	js_Object *buf = jsB_tobuffer(J, 1);
+	double offset = jsB_toindex(J, 2, 0, "start offset is outside the bounds of the buffer");
+	double len = jsB_toindex(J, 3, -1, "invalid DataView length");
+	unsigned int buflen;
+
+	jsV_bufferdata(buf, &buflen);
+	if (offset < 0 || offset > buflen)
+		js_rangeerror(J, "start offset is outside the bounds of the buffer");
+	if (js_isdefined(J, 3)) {
+		if (len < 0 || offset + len > buflen)
+			js_rangeerror(J, "invalid DataView length");
+		jsB_newview(J, JS_CDATAVIEW, JS_TAUINT8, buf, offset, len, 0);
+	} else {
+		jsB_newview(J, JS_CDATAVIEW, JS_TAUINT8, buf, offset, 0, 1);
+	}
+}
+
+static int islittleendian(void)
+{
+	unsigned short x = 1;
+	return *(unsigned char *)&x;
+}
+
+/* Copy n bytes, reversing their order if the requested byte order differs from the host */
+static void jsB_copyorder(unsigned char *dst, const unsigned char *src, int n, int little)
+{
+	int i;
+	if (n == 1 || little == islittleendian())
+		memcpy(dst, src, n);
+	else
+		for (i = 0; i < n; ++i)
+			dst[i] = src[n - 1 - i];
+}
+
+static unsigned char *jsB_dataviewbytes(js_State *J, js_Object *self, int size)
+{
+	double offset = js_tointeger(J, 1);
+	unsigned int n;
+	unsigned char *p = jsV_typeddata(self, &n);
+	if (offset < 0 || offset + size > n)
+		js_rangeerror(J, "offset is outside the bounds of the DataView");
+	return p + (int)offset;
+}
+
+static void jsB_dataviewget(js_State *J, int kind)
+{
+	js_Object *self = jsB_todataview(J, 0);
+	int size = typedsize[kind];
+	unsigned char *p = jsB_dataviewbytes(J, self, size);
+	union { double d; unsigned char b[8]; } tmp;
+	jsB_copyorder(tmp.b, p, size, js_toboolean(J, 2));
+	js_pushnumber(J, jsV_loadtyped(kind, tmp.b));
+}
+
+static void jsB_dataviewset(js_State *J, int kind)
+{
+	js_Object *self = jsB_todataview(J, 0);
+	int size = typedsize[kind];
+	double x = js_tonumber(J, 2);
+	unsigned char *p = jsB_dataviewbytes(J, self, size);
+	union { double d; unsigned char b[8]; } tmp;
+	jsV_storetyped(kind, tmp.b, x);
+	jsB_copyorder(p, tmp.b, size, js_toboolean(J, 3));
+	js_pushundefined(J);
+}
+
+#define DATAVIEWACCESS(NAME, KIND) \
+	static void DVp_get##NAME(js_State *J) { jsB_dataviewget(J, KIND); } \
+	static void DVp_set##NAME(js_State *J) { jsB_dataviewset(J, KIND); }
+
+DATAVIEWACCESS(Int8, JS_TAINT8)
+DATAVIEWACCESS(Uint8, JS_TAUINT8)
+DATAVIEWACCESS(Int16, JS_TAINT16)
+DATAVIEWACCESS(Uint16, JS_TAUINT16)
+DATAVIEWACCESS(Int32, JS_TAINT32)
+DATAVIEWACCESS(Uint32, JS_TAUINT32)
+DATAVIEWACCESS(Float32, JS_TAFLOAT32)
+DATAVIEWACCESS(Float64, JS_TAFLOAT64)
+
+/* Reuse a generic Array.prototype method for typed arrays */
+static void jsB_arraymethod(js_State *J, const char *name)
+{
+	js_pushobject(J, J->Array_prototype);
+	js_getproperty(J, -1, name);
+	js_defproperty(J, -3, name, JS_DONTENUM);
+	js_pop(J, 1);
+}
+
+void jsB_inittypedarray(js_State *J)
+{
+	static const char *generic[] = {
+		"toString", "join", "reverse", "indexOf", "lastIndexOf",
+		"every", "some", "forEach", "reduce", "reduceRight",
+	};
+	js_Object *proto;
+	int i;
+
+	js_pushobject(J, J->ArrayBuffer_prototype);
+	{
+		jsB_propf(J, "ArrayBuffer.prototype.slice", ABp_slice, 2);
+	}
+	js_newcconstructor(J, jsB_ArrayBuffer, jsB_new_ArrayBuffer, "ArrayBuffer", 1);
+	{
+		jsB_propf(J, "ArrayBuffer.isView", AB_isView, 1);
+	}
+	js_defglobal(J, "ArrayBuffer", JS_DONTENUM);
+
+	/* %TypedArray%.prototype, shared by all typed array prototypes */
+	proto = jsV_newobject(J, JS_COBJECT, J->Object_prototype);
+	js_pushobject(J, proto);
+	{
+		jsB_propf(J, "TypedArray.prototype.subarray", TAp_subarray, 2);
+		jsB_propf(J, "TypedArray.prototype.slice", TAp_slice, 2);
+		jsB_propf(J, "TypedArray.prototype.set", TAp_set, 2);
+		jsB_propf(J, "TypedArray.prototype.fill", TAp_fill, 3);
+		jsB_propf(J, "TypedArray.prototype.copyWithin", TAp_copyWithin, 3);
+		jsB_propf(J, "TypedArray.prototype.sort", TAp_sort, 1);
+		jsB_propf(J, "TypedArray.prototype.map", TAp_map, 1);
+		jsB_propf(J, "TypedArray.prototype.filter", TAp_filter, 1);
+		for (i = 0; i < (int)nelem(generic); ++i)
+			jsB_arraymethod(J, generic[i]);
+	}
+	js_pop(J, 1);
+
+	for (i = 0; i < JS_TACOUNT; ++i) {
+		J->TypedArray_prototype[i] = jsV_newobject(J, JS_COBJECT, proto);
+		js_pushobject(J, J->TypedArray_prototype[i]);
+		{
+			jsB_propn(J, "BYTES_PER_ELEMENT", typedsize[i]);
+		}
+		js_newcconstructor(J, typedcall[i], typednew[i], typedname[i], 3);
+		{
+			jsB_propn(J, "BYTES_PER_ELEMENT", typedsize[i]);
+		}
+		js_defglobal(J, typedname[i], JS_DONTENUM);
+	}
+
+	js_pushobject(J, J->DataView_prototype);
+	{
+		jsB_propf(J, "DataView.prototype.getInt8", DVp_getInt8, 1);
+		jsB_propf(J, "DataView.prototype.getUint8", DVp_getUint8, 1);
+		jsB_propf(J, "DataView.prototype.getInt16", DVp_getInt16, 2);
+		jsB_propf(J, "DataView.prototype.getUint16", DVp_getUint16, 2);
+		jsB_propf(J, "DataView.prototype.getInt32", DVp_getInt32, 2);
+		jsB_propf(J, "DataView.prototype.getUint32", DVp_getUint32, 2);
+		jsB_propf(J, "DataView.prototype.getFloat32", DVp_getFloat32, 2);
+		jsB_propf(J, "DataView.prototype.getFloat64", DVp_getFloat64, 2);
+		jsB_propf(J, "DataView.prototype.setInt8", DVp_setInt8, 2);
+		jsB_propf(J, "DataView.prototype.setUint8", DVp_setUint8, 2);
+		jsB_propf(J, "DataView.prototype.setInt16", DVp_setInt16, 3);
+		jsB_propf(J, "DataView.prototype.setUint16", DVp_setUint16, 3);
+		jsB_propf(J, "DataView.prototype.setInt32", DVp_setInt32, 3);
+		jsB_propf(J, "DataView.prototype.setUint32", DVp_setUint32, 3);
+		jsB_propf(J, "DataView.prototype.setFloat32", DVp_setFloat32, 3);
+		jsB_propf(J, "DataView.prototype.setFloat64", DVp_setFloat64, 3);
+	}
+	js_newcconstructor(J, jsB_DataView, jsB_new_DataView, "DataView", 1);
+	js_defglobal(J, "DataView", JS_DONTENUM);
+}
@@ -5,7 +5,6 @@
 #include "utf.h"
 
 #define JSV_ISSTRING(v) (v->type==JS_TSHRSTR || v->type==JS_TMEMSTR || v->type==JS_TLITSTR)
-#define JSV_TOSTRING(v) (v->type==JS_TSHRSTR ? v->u.shrstr : v->type==JS_TLITSTR ? v->u.litstr : v->type==JS_TMEMSTR ? v->u.memstr->p : "")
 
 int jsV_numbertointeger(double n)
 {
@@ -216,7 +215,7 @@ double jsV_tonumber(js_State *J, js_Value *v)
 	case JS_TBOOLEAN: return v->u.boolean;
 	case JS_TNUMBER: return v->u.number;
 	case JS_TLITSTR: return jsV_stringtonumber(J, v->u.litstr);
-	case JS_TMEMSTR: return jsV_stringtonumber(J, v->u.memstr->p);
+	case JS_TMEMSTR: return jsV_stringtonumber(J, jsV_memstring(J, v));
 	case JS_TOBJECT:
 		jsV_toprimitive(J, v, JS_HNUMBER);
 		return jsV_tonumber(J, v);
@@ -288,6 +287,38 @@ const char *jsV_numbertostring(js_State *J, char buf[32], double f)
 	return buf;
 }
 
+int jsV_memlen(const js_Value *v)
+{
+	int n;
+	memcpy(&n, v->pad, sizeof n);
+	return n;
+}
+
+void jsV_setmemlen(js_Value *v, int n)
+{
+	memcpy(v->pad, &n, sizeof n);
+}
+
+/* Terminated contents of a memory string value; a value that is shorter than its shared buffer gets its own copy */
+const char *jsV_memstring(js_State *J, js_Value *v)
+{
+	js_String *s = v->u.memstr;
+	int n = jsV_memlen(v);
+	if (s->len != n) {
+		v->u.memstr = jsV_newmemstring(J, s->p, n);
+		return v->u.memstr->p;
+	}
+	return s->p;
+}
+
+/* ToString() for internal use: the result is only valid until the next string is appended to */
+const char *jsV_peekstring(js_State *J, js_Value *v)
+{
+	if (v->type == JS_TMEMSTR)
+		return jsV_memstring(J, v);
+	return jsV_tostring(J, v);
+}
+
 /* ToString() on a value */
 const char *jsV_tostring(js_State *J, js_Value *v)
 {
@@ -300,7 +331,11 @@ const char *jsV_tostring(js_State *J, js_Value *v)
 	case JS_TNULL: return "null";
 	case JS_TBOOLEAN: return v->u.boolean ? "true" : "false";
 	case JS_TLITSTR: return v->u.litstr;
-	case JS_TMEMSTR: return v->u.memstr->p;
+	case JS_TMEMSTR:
+		/* the caller may keep the pointer, so the buffer must not be appended to any more */
+		p = jsV_memstring(J, v);
+		v->u.memstr->cap = v->u.memstr->len;
+		return p;
 	case JS_TNUMBER:
 		p = jsV_numbertostring(J, buf, v->u.number);
 		if (p == buf) {
@@ -314,6 +349,7 @@ const char *jsV_tostring(js_State *J, js_Value *v)
 			} else {
 				v->type = JS_TMEMSTR;
 				v->u.memstr = jsV_newmemstring(J, p, n);
+				jsV_setmemlen(v, n);
 				return v->u.memstr->p;
 			}
 		}
@@ -359,7 +395,7 @@ js_Object *jsV_toobject(js_State *J, js_Value *v)
 	case JS_TBOOLEAN: return jsV_newboolean(J, v->u.boolean);
 	case JS_TNUMBER: return jsV_newnumber(J, v->u.number);
 	case JS_TLITSTR: return jsV_newstring(J, v->u.litstr);
-	case JS_TMEMSTR: return jsV_newstring(J, v->u.memstr->p);
+	case JS_TMEMSTR: return jsV_newstring(J, jsV_memstring(J, v));
 	case JS_TOBJECT: return v->u.object;
 	}
 }
@@ -385,7 +421,9 @@ void js_newarguments(js_State *J)
 
 void js_newarray(js_State *J)
 {
-	js_pushobject(J, jsV_newobject(J, JS_CARRAY, J->Array_prototype));
+	js_Object *obj = jsV_newobject(J, JS_CARRAY, J->Array_prototype);
+	obj->u.a.simple = 1;
+	js_pushobject(J, obj);
 }
 
 void js_newboolean(js_State *J, int v)
@@ -483,10 +521,19 @@ void js_newuserdatax(js_State *J, const char *tag, void *data, js_HasProperty ha
 	obj->u.user.has = has;
 	obj->u.user.put = put;
 	obj->u.user.delete = delete;
+	obj->u.user.getindex = NULL;
+	obj->u.user.putindex = NULL;
 	obj->u.user.finalize = finalize;
 	js_pushobject(J, obj);
 }
 
+void js_newuserdatai(js_State *J, const char *tag, void *data, js_GetIndex getindex, js_PutIndex putindex, js_Finalize finalize)
+{
+	js_newuserdatax(J, tag, data, NULL, NULL, NULL, finalize);
+	js_toobject(J, -1)->u.user.getindex = getindex;
+	js_toobject(J, -1)->u.user.putindex = putindex;
+}
+
 void js_newuserdata(js_State *J, const char *tag, void *data, js_Finalize finalize)
 {
 	js_newuserdatax(J, tag, data, NULL, NULL, NULL, finalize);
@@ -526,20 +573,59 @@ void js_concat(js_State *J)
 	js_toprimitive(J, -1, JS_HNONE);
 
 	if (js_isstring(J, -2) || js_isstring(J, -1)) {
-		const char *sa = js_tostring(J, -2);
-		const char *sb = js_tostring(J, -1);
-		/* TODO: create js_String directly */
-		char *sab = js_malloc(J, strlen(sa) + strlen(sb) + 1);
-		strcpy(sab, sa);
-		strcat(sab, sb);
-		if (js_try(J)) {
-			js_free(J, sab);
-			js_throw(J);
+		js_Value *va = js_tovalue(J, -2);
+		js_Value *vb = js_tovalue(J, -1);
+		js_String *s;
+		const char *sa, *sb;
+		int la, lb;
+
+		/*
+			The left side ends its buffer: append to it in place. The values
+			that share the buffer keep their own length, and the buffer is
+			grown geometrically so building a string in a loop is linear.
+		*/
+		if (va->type == JS_TMEMSTR && jsV_memlen(va) == va->u.memstr->len) {
+			s = va->u.memstr;
+			la = s->len;
+			sb = jsV_peekstring(J, vb);
+			lb = strlen(sb);
+			if (lb > INT_MAX / 2 - la)
+				js_rangeerror(J, "invalid string length");
+			if (la + lb > s->cap) {
+				s = jsV_newmemstringx(J, s->p, la, (la + lb) * 2);
+				va->u.memstr = s;
+			}
+			memmove(s->p + la, sb, lb);
+			s->len = la + lb;
+			s->p[s->len] = 0;
+			jsV_setmemlen(va, s->len);
+			js_pop(J, 1);
+			return;
+		}
+
+		sa = jsV_peekstring(J, va);
+		sb = jsV_peekstring(J, vb);
+		la = strlen(sa);
+		lb = strlen(sb);
+		if (lb > INT_MAX / 2 - la)
+			js_rangeerror(J, "invalid string length");
+		if (la + lb <= soffsetof(js_Value, type)) {
+			char buf[16];
+			memcpy(buf, sa, la);
+			memcpy(buf + la, sb, lb);
+			js_pop(J, 2);
+			js_pushlstring(J, buf, la + lb);
+		} else {
+			js_Value v;
+			v.type = JS_TMEMSTR;
+			v.u.memstr = s = jsV_newmemstringx(J, sa, la, la + lb);
+			memcpy(s->p + la, sb, lb);
+			s->len = la + lb;
+			s->p[s->len] = 0;
+			jsV_setmemlen(&v, s->len);
+			js_pop(J, 2);
+			js_pushvalue(J, v);
 		}
-		js_pop(J, 2);
-		js_pushstring(J, sab);
-		js_endtry(J);
-		js_free(J, sab);
 	} else {
 		double x = js_tonumber(J, -2);
 		double y = js_tonumber(J, -1);
@@ -555,7 +641,7 @@ int js_compare(js_State *J, int *okay)
 
 	*okay = 1;
 	if (js_isstring(J, -2) && js_isstring(J, -1)) {
-		return strcmp(js_tostring(J, -2), js_tostring(J, -1));
+		return strcmp(jsV_peekstring(J, js_tovalue(J, -2)), jsV_peekstring(J, js_tovalue(J, -1)));
 	} else {
 		double x = js_tonumber(J, -2);
 		double y = js_tonumber(J, -1);
@@ -572,7 +658,7 @@ int js_equal(js_State *J)
 
 retry:
 	if (JSV_ISSTRING(x) && JSV_ISSTRING(y))
-		return !strcmp(JSV_TOSTRING(x), JSV_TOSTRING(y));
+		return !strcmp(jsV_peekstring(J, x), jsV_peekstring(J, y));
 	if (x->type == y->type) {
 		if (x->type == JS_TUNDEFINED) return 1;
 		if (x->type == JS_TNULL) return 1;
@@ -618,7 +704,7 @@ int js_strictequal(js_State *J)
 	js_Value *y = js_tovalue(J, -1);
 
 	if (JSV_ISSTRING(x) && JSV_ISSTRING(y))
-		return !strcmp(JSV_TOSTRING(x), JSV_TOSTRING(y));
+		return !strcmp(jsV_peekstring(J, x), jsV_peekstring(J, y));
 
 	if (x->type != y->type) return 0;
 	if (x->type == JS_TUNDEFINED) return 1;
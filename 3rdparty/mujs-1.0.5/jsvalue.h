@@ -39,6 +39,23 @@ enum js_Class {
 	JS_CARGUMENTS,
 	JS_CITERATOR,
 	JS_CUSERDATA,
+	JS_CARRAYBUFFER,
+	JS_CTYPEDARRAY,
+	JS_CDATAVIEW,
+};
+
+/* Element types of typed arrays, see jstypedarray.c */
+enum {
+	JS_TAINT8,
+	JS_TAUINT8,
+	JS_TAUINT8C,
+	JS_TAINT16,
+	JS_TAUINT16,
+	JS_TAINT32,
+	JS_TAUINT32,
+	JS_TAFLOAT32,
+	JS_TAFLOAT64,
+	JS_TACOUNT
 };
 
 /*
@@ -58,14 +75,23 @@ struct js_Value
 		js_String *memstr;
 		js_Object *object;
 	} u;
-	char pad[7]; /* extra storage for shrstr */
+	char pad[7]; /* extra storage for shrstr, string length for memstr */
 	char type; /* type tag and zero terminator for shrstr */
 };
 
+/*
+	Memory strings can be shared buffers that grow by appending, see
+	js_concat in jsvalue.c. A memstr value records its own length in the
+	padding of the js_Value (jsV_memlen), it may be shorter than the buffer.
+*/
+
 struct js_String
 {
 	js_String *gcnext;
 	char gcmark;
+	signed char pool; /* allocation pool, -1 if allocated with js_malloc */
+	int len; /* length of the longest value using this buffer */
+	int cap; /* room for appending without a copy, len if pinned */
 	char p[1];
 };
 
@@ -81,8 +107,11 @@ struct js_Object
 {
 	enum js_Class type;
 	int extensible;
-	js_Property *properties;
+	int isprototype;
+	unsigned int shape; /* changes whenever properties are added, removed or redefined */
+	js_Property **properties; /* see jsproperty.c for the table layout */
 	int count; /* number of properties, for array sparseness check */
+	int propcap;
 	js_Object *prototype;
 	union {
 		int boolean;
@@ -93,6 +122,10 @@ struct js_Object
 		} s;
 		struct {
 			int length;
+			int simple; /* elements are stored in array[0..flat_length) */
+			int flat_length;
+			int flat_capacity;
+			js_Value *array;
 		} a;
 		struct {
 			js_Function *function;
@@ -115,18 +148,36 @@ struct js_Object
 			js_HasProperty has;
 			js_Put put;
 			js_Delete delete;
+			js_GetIndex getindex;
+			js_PutIndex putindex;
 			js_Finalize finalize;
 		} user;
+		struct {
+			unsigned char *data;
+			unsigned int length;
+			unsigned char **pdata; /* native storage that may move: data is *pdata */
+			unsigned int *plength; /* ...and its length is *plength * scale */
+			unsigned int scale;
+			js_Object *owner; /* keeps the native object alive */
+			int external; /* data is not freed with the buffer */
+		} ab;
+		struct {
+			js_Object *buffer;
+			unsigned int offset; /* in bytes */
+			unsigned int length; /* in elements, bytes for DataView */
+			int tracking; /* length follows the buffer */
+			int kind;
+		} ta;
 	} u;
 	js_Object *gcnext;
+	js_Object *gcgray; /* next object on the gray list */
 	int gcmark;
 };
 
 struct js_Property
 {
 	const char *name;
-	js_Property *left, *right;
-	int level;
+	unsigned int hash;
 	int atts;
 	js_Value value;
 	js_Object *getter;
@@ -141,6 +192,7 @@ struct js_Iterator
 
 /* jsrun.c */
 js_String *jsV_newmemstring(js_State *J, const char *s, int n);
+js_String *jsV_newmemstringx(js_State *J, const char *s, int n, int cap);
 js_Value *js_tovalue(js_State *J, int idx);
 void js_toprimitive(js_State *J, int idx, int hint);
 js_Object *js_toobject(js_State *J, int idx);
@@ -152,6 +204,10 @@ int jsV_toboolean(js_State *J, js_Value *v);
 double jsV_tonumber(js_State *J, js_Value *v);
 double jsV_tointeger(js_State *J, js_Value *v);
 const char *jsV_tostring(js_State *J, js_Value *v);
+const char *jsV_peekstring(js_State *J, js_Value *v);
+const char *jsV_memstring(js_State *J, js_Value *v);
+int jsV_memlen(const js_Value *v);
+void jsV_setmemlen(js_Value *v, int n);
 js_Object *jsV_toobject(js_State *J, js_Value *v);
 void jsV_toprimitive(js_State *J, js_Value *v, int preferred);
 
@@ -168,6 +224,8 @@ double jsV_stringtonumber(js_State *J, const char *string);
 /* jsproperty.c */
 js_Object *jsV_newobject(js_State *J, enum js_Class type, js_Object *prototype);
 js_Property *jsV_getownproperty(js_State *J, js_Object *obj, const char *name);
+js_Property *jsV_lookupproperty(js_Object *obj, const char *name, unsigned int hash);
+void jsV_reshape(js_State *J, js_Object *obj);
 js_Property *jsV_getpropertyx(js_State *J, js_Object *obj, const char *name, int *own);
 js_Property *jsV_getproperty(js_State *J, js_Object *obj, const char *name);
 js_Property *jsV_setproperty(js_State *J, js_Object *obj, const char *name);
@@ -178,6 +236,18 @@ js_Object *jsV_newiterator(js_State *J, js_Object *obj, int own);
 const char *jsV_nextiterator(js_State *J, js_Object *iter);
 
 void jsV_resizearray(js_State *J, js_Object *obj, int newlen);
+void jsV_growarray(js_State *J, js_Object *obj, int capacity);
+void jsV_unflattenarray(js_State *J, js_Object *obj);
+
+/* jstypedarray.c */
+const char *jsV_typedname(js_Object *obj);
+unsigned char *jsV_bufferdata(js_Object *buf, unsigned int *length);
+unsigned char *jsV_typeddata(js_Object *obj, unsigned int *length);
+int jsV_typedlength(js_Object *obj);
+int jsV_gettypedindex(js_State *J, js_Object *obj, int k);
+void jsV_settypedindex(js_State *J, js_Object *obj, int k, js_Value *v);
+int jsV_istypedproperty(js_Object *obj, const char *name);
+int jsV_gettypedproperty(js_State *J, js_Object *obj, const char *name);
 
 /* jsdump.c */
 void js_dumpobject(js_State *J, js_Object *obj);
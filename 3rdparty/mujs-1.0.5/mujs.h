@@ -39,7 +39,20 @@ typedef void (*js_Finalize)(js_State *J, void *p);
 typedef int (*js_HasProperty)(js_State *J, void *p, const char *name);
 typedef int (*js_Put)(js_State *J, void *p, const char *name);
 typedef int (*js_Delete)(js_State *J, void *p, const char *name);
+typedef int (*js_GetIndex)(js_State *J, void *p, int i);
+typedef int (*js_PutIndex)(js_State *J, void *p, int i);
 typedef void (*js_Report)(js_State *J, const char *message);
+typedef void (*js_Writer)(void *ctx, const void *data, int size);
+
+/* Occupancy of an allocation pool, see js_poolinfo */
+typedef struct {
+	const char *name;
+	int size; /* bytes per item */
+	int used, peak; /* items in use now and at most */
+	int capacity; /* items in all slabs */
+	int slabs; /* slabs currently allocated */
+	unsigned int released; /* empty slabs given back after gc cycles */
+} js_PoolInfo;
 
 /* Basic functions */
 js_State *js_newstate(js_Alloc alloc, void *actx, int flags);
@@ -49,6 +62,9 @@ void js_setreport(js_State *J, js_Report report);
 js_Panic js_atpanic(js_State *J, js_Panic panic);
 void js_freestate(js_State *J);
 void js_gc(js_State *J, int report);
+int js_gcstep(js_State *J, int work, int report);
+void js_gcincremental(js_State *J, int enable);
+int js_poolinfo(js_State *J, int pool, js_PoolInfo *info);
 
 int js_dostring(js_State *J, const char *source);
 int js_dofile(js_State *J, const char *filename);
@@ -69,6 +85,14 @@ void js_endtry(js_State *J);
 /* State constructor flags */
 enum {
 	JS_STRICT = 1,
+	JS_NOOPTIMIZE = 2,
+};
+
+/* Garbage collector phases */
+enum {
+	JS_GCIDLE,
+	JS_GCMARK,
+	JS_GCSWEEP,
 };
 
 /* RegExp flags */
@@ -106,6 +130,8 @@ JS_NORETURN void js_throw(js_State *J);
 
 void js_loadstring(js_State *J, const char *filename, const char *source);
 void js_loadfile(js_State *J, const char *filename);
+void js_loadbytecode(js_State *J, const char *filename, const void *data, int size);
+void js_savebytecode(js_State *J, int idx, js_Writer write, void *ctx);
 
 void js_eval(js_State *J);
 void js_call(js_State *J, int n);
@@ -156,7 +182,11 @@ void js_newcfunction(js_State *J, js_CFunction fun, const char *name, int length
 void js_newcconstructor(js_State *J, js_CFunction fun, js_CFunction con, const char *name, int length);
 void js_newuserdata(js_State *J, const char *tag, void *data, js_Finalize finalize);
 void js_newuserdatax(js_State *J, const char *tag, void *data, js_HasProperty has, js_Put put, js_Delete del, js_Finalize finalize);
+void js_newuserdatai(js_State *J, const char *tag, void *data, js_GetIndex getindex, js_PutIndex putindex, js_Finalize finalize);
 void js_newregexp(js_State *J, const char *pattern, int flags);
+void js_newarraybuffer(js_State *J, unsigned int length);
+void js_newarraybufferx(js_State *J, int owner, void *data, unsigned int length);
+void js_newarraybufferp(js_State *J, int owner, void **data, unsigned int *count, unsigned int scale);
 
 void js_pushiterator(js_State *J, int idx, int own);
 const char *js_nextiterator(js_State *J, int idx);
@@ -171,6 +201,7 @@ int js_isprimitive(js_State *J, int idx);
 int js_isobject(js_State *J, int idx);
 int js_isarray(js_State *J, int idx);
 int js_isregexp(js_State *J, int idx);
+int js_isarraybuffer(js_State *J, int idx);
 int js_iscoercible(js_State *J, int idx);
 int js_iscallable(js_State *J, int idx);
 int js_isuserdata(js_State *J, int idx, const char *tag);
@@ -180,6 +211,7 @@ int js_toboolean(js_State *J, int idx);
 double js_tonumber(js_State *J, int idx);
 const char *js_tostring(js_State *J, int idx);
 void *js_touserdata(js_State *J, int idx, const char *tag);
+void *js_toarraybuffer(js_State *J, int idx, unsigned int *length);
 
 const char *js_trystring(js_State *J, int idx, const char *error);
 double js_trynumber(js_State *J, int idx, double error);
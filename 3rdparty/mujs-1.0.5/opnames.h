@@ -81,3 +81,8 @@
 "jtrue",
 "jfalse",
 "return",
+"setlocalpop",
+"getlocal2",
+"getlocalint",
+"getvarundef",
+"getmethod_s",
@@ -1560,6 +1560,227 @@ int zip_entry_extract(struct zip_t *zip,
              : ZIP_EINVIDX;
 }
 
+struct zip_entry_checkpoint_t {
+  mz_zip_reader_extract_iter_state state;
+  mz_uint8 dict[TINFL_LZ_DICT_SIZE];
+};
+
+struct zip_entry_reader_t {
+  mz_zip_archive *pzip;
+  mz_uint index;
+  mz_zip_reader_extract_iter_state *iter;
+  mz_uint64 data_ofs;
+  mz_uint64 pos;
+  mz_uint64 checkpoint;
+  struct zip_entry_checkpoint_t **checkpoints;
+  size_t num_checkpoints;
+};
+
+static int zip_entry_reader_restart(struct zip_entry_reader_t *reader) {
+  if (reader->iter) {
+    mz_zip_reader_extract_iter_free(reader->iter);
+  }
+  reader->pos = 0;
+  reader->iter =
+      mz_zip_reader_extract_iter_new(reader->pzip, reader->index, 0);
+  return reader->iter ? 0 : ZIP_EINVIDX;
+}
+
+static void zip_entry_reader_save(struct zip_entry_reader_t *reader) {
+  mz_zip_reader_extract_iter_state *iter = reader->iter;
+  struct zip_entry_checkpoint_t *cp = NULL;
+  struct zip_entry_checkpoint_t **cps = NULL;
+
+  cps = (struct zip_entry_checkpoint_t **)realloc(
+      reader->checkpoints,
+      (reader->num_checkpoints + 1) * sizeof(struct zip_entry_checkpoint_t *));
+  if (!cps) {
+    return;
+  }
+  reader->checkpoints = cps;
+  cp = (struct zip_entry_checkpoint_t *)malloc(
+      sizeof(struct zip_entry_checkpoint_t));
+  if (!cp) {
+    return;
+  }
+
+  memcpy(&cp->state, iter, sizeof(mz_zip_reader_extract_iter_state));
+  memcpy(cp->dict, iter->pWrite_buf, TINFL_LZ_DICT_SIZE);
+  if (!reader->pzip->m_pState->m_pMem) {
+    // forget the unconsumed part of the read buffer, it is read again from
+    // the file when the checkpoint is restored
+    cp->state.cur_file_ofs -= iter->read_buf_avail;
+    cp->state.comp_remaining += iter->read_buf_avail;
+    cp->state.read_buf_avail = 0;
+    cp->state.read_buf_ofs = 0;
+  }
+  reader->checkpoints[reader->num_checkpoints++] = cp;
+}
+
+static void zip_entry_reader_restore(struct zip_entry_reader_t *reader,
+                                     size_t n) {
+  mz_zip_reader_extract_iter_state *iter = reader->iter;
+  void *read_buf = iter->pRead_buf;
+  void *write_buf = iter->pWrite_buf;
+  struct zip_entry_checkpoint_t *cp = reader->checkpoints[n];
+
+  memcpy(iter, &cp->state, sizeof(mz_zip_reader_extract_iter_state));
+  if (!reader->pzip->m_pState->m_pMem) {
+    iter->pRead_buf = read_buf;
+  }
+  iter->pWrite_buf = write_buf;
+  memcpy(write_buf, cp->dict, TINFL_LZ_DICT_SIZE);
+  reader->pos = (mz_uint64)(n + 1) * reader->checkpoint;
+}
+
+struct zip_entry_reader_t *zip_entry_reader_open(struct zip_t *zip,
+                                                 size_t checkpoint) {
+  struct zip_entry_reader_t *reader = NULL;
+
+  if (!zip || zip->archive.m_zip_mode != MZ_ZIP_MODE_READING ||
+      zip->entry.index < (ssize_t)0) {
+    // the entry is not found or we do not have read access
+    return NULL;
+  }
+
+  reader = (struct zip_entry_reader_t *)calloc(
+      1, sizeof(struct zip_entry_reader_t));
+  if (!reader) {
+    return NULL;
+  }
+  reader->pzip = &(zip->archive);
+  reader->index = (mz_uint)zip->entry.index;
+  if (zip_entry_reader_restart(reader) < 0) {
+    free(reader);
+    return NULL;
+  }
+  reader->data_ofs = reader->iter->cur_file_ofs;
+  if (reader->iter->file_stat.m_method) {
+    // stored entries seek directly and need no checkpoints
+    reader->checkpoint = checkpoint;
+  }
+
+  return reader;
+}
+
+ssize_t zip_entry_reader_read(struct zip_entry_reader_t *reader, void *buf,
+                              size_t bufsize) {
+  mz_uint64 size;
+  size_t total = 0;
+
+  if (!reader || !reader->iter) {
+    return ZIP_ENOINIT;
+  }
+
+  size = reader->iter->file_stat.m_uncomp_size;
+  while (total < bufsize && reader->pos < size) {
+    size_t n = bufsize - total;
+    size_t got;
+
+    if (reader->checkpoint) {
+      // stop at the next checkpoint
+      mz_uint64 next =
+          (reader->pos / reader->checkpoint + 1) * reader->checkpoint;
+      n = (size_t)MZ_MIN((mz_uint64)n, next - reader->pos);
+    }
+
+    got = mz_zip_reader_extract_iter_read(reader->iter, (mz_uint8 *)buf + total,
+                                          n);
+    if (!got) {
+      break;
+    }
+    total += got;
+    reader->pos += got;
+
+    if (reader->checkpoint && reader->pos < size &&
+        reader->pos % reader->checkpoint == 0 &&
+        reader->pos / reader->checkpoint == reader->num_checkpoints + 1) {
+      zip_entry_reader_save(reader);
+    }
+  }
+
+  if (!total && reader->pos < size) {
+    return ZIP_EFREAD;
+  }
+  return (ssize_t)total;
+}
+
+int zip_entry_reader_seek(struct zip_entry_reader_t *reader,
+                          unsigned long long offset) {
+  mz_zip_reader_extract_iter_state *iter;
+  mz_uint8 skip[1024];
+
+  if (!reader || !reader->iter) {
+    return ZIP_ENOINIT;
+  }
+  iter = reader->iter;
+  if (offset > iter->file_stat.m_uncomp_size) {
+    return ZIP_EFSEEK;
+  }
+
+  if (!iter->file_stat.m_method) {
+    // stored entry: just move the file offset
+    iter->cur_file_ofs = reader->data_ofs + offset;
+    iter->out_buf_ofs = offset;
+    iter->comp_remaining = iter->file_stat.m_comp_size - offset;
+    if (reader->pzip->m_pState->m_pMem) {
+      iter->pRead_buf =
+          (mz_uint8 *)reader->pzip->m_pState->m_pMem + iter->cur_file_ofs;
+    }
+    reader->pos = offset;
+    return 0;
+  }
+
+  if (offset < reader->pos ||
+      (reader->checkpoint &&
+       offset / reader->checkpoint > reader->pos / reader->checkpoint &&
+       offset / reader->checkpoint <= reader->num_checkpoints)) {
+    // start from the last checkpoint before offset (or the beginning)
+    size_t n = reader->checkpoint
+                   ? (size_t)MZ_MIN(offset / reader->checkpoint,
+                                    (mz_uint64)reader->num_checkpoints)
+                   : 0;
+    if (n > 0) {
+      zip_entry_reader_restore(reader, n - 1);
+    } else if (zip_entry_reader_restart(reader) < 0) {
+      return ZIP_EINVIDX;
+    }
+  }
+
+  while (reader->pos < offset) {
+    ssize_t got = zip_entry_reader_read(
+        reader, skip, (size_t)MZ_MIN(offset - reader->pos, sizeof(skip)));
+    if (got <= 0) {
+      return ZIP_EFSEEK;
+    }
+  }
+  return 0;
+}
+
+unsigned long long zip_entry_reader_tell(struct zip_entry_reader_t *reader) {
+  return reader ? reader->pos : 0;
+}
+
+unsigned long long zip_entry_reader_size(struct zip_entry_reader_t *reader) {
+  return reader && reader->iter ? reader->iter->file_stat.m_uncomp_size : 0;
+}
+
+void zip_entry_reader_close(struct zip_entry_reader_t *reader) {
+  size_t i;
+
+  if (!reader) {
+    return;
+  }
+  if (reader->iter) {
+    mz_zip_reader_extract_iter_free(reader->iter);
+  }
+  for (i = 0; i < reader->num_checkpoints; ++i) {
+    free(reader->checkpoints[i]);
+  }
+  free(reader->checkpoints);
+  free(reader);
+}
+
 ssize_t zip_entries_total(struct zip_t *zip) {
   if (!zip) {
     // zip_t handler is not initialized
@@ -353,6 +353,85 @@ zip_entry_extract(struct zip_t *zip,
                                        const void *data, size_t size),
                   void *arg);
 
+/**
+ * Incremental reader for a zip entry, see zip_entry_reader_open().
+ */
+struct zip_entry_reader_t;
+
+/**
+ * Opens the current zip entry for incremental reading.
+ *
+ * The data is inflated on demand, so the entry never has to fit into memory as
+ * a whole. Every `checkpoint` bytes of output the inflate state is saved, so
+ * that zip_entry_reader_seek() does not have to restart at the beginning of
+ * the entry when seeking backwards. Each checkpoint costs about 43KiB of
+ * memory.
+ *
+ * The reader does not depend on the current entry, zip_entry_close() may be
+ * called right after this function. It must be closed before the archive.
+ *
+ * @param zip zip archive handler.
+ * @param checkpoint distance between checkpoints (in bytes), 0 disables them.
+ *
+ * @return the reader on success, NULL on error.
+ */
+extern ZIP_EXPORT struct zip_entry_reader_t *
+zip_entry_reader_open(struct zip_t *zip, size_t checkpoint);
+
+/**
+ * Reads the next bytes of the entry.
+ *
+ * @param reader entry reader.
+ * @param buf output buffer.
+ * @param bufsize output buffer size (in bytes).
+ *
+ * @return the number of bytes actually read (0 at the end of the entry),
+ *         negative number (< 0) on error.
+ */
+extern ZIP_EXPORT ssize_t zip_entry_reader_read(
+    struct zip_entry_reader_t *reader, void *buf, size_t bufsize);
+
+/**
+ * Moves the read position of the entry.
+ *
+ * Stored entries seek directly, compressed entries inflate from the nearest
+ * checkpoint before the new position.
+ *
+ * @param reader entry reader.
+ * @param offset new absolute position (in bytes).
+ *
+ * @return the return code - 0 on success, negative number (< 0) on error.
+ */
+extern ZIP_EXPORT int zip_entry_reader_seek(struct zip_entry_reader_t *reader,
+                                            unsigned long long offset);
+
+/**
+ * Returns the read position of the entry.
+ *
+ * @param reader entry reader.
+ *
+ * @return the current position (in bytes).
+ */
+extern ZIP_EXPORT unsigned long long
+zip_entry_reader_tell(struct zip_entry_reader_t *reader);
+
+/**
+ * Returns the uncompressed size of the entry.
+ *
+ * @param reader entry reader.
+ *
+ * @return the size (in bytes).
+ */
+extern ZIP_EXPORT unsigned long long
+zip_entry_reader_size(struct zip_entry_reader_t *reader);
+
+/**
+ * Closes an entry reader and frees all checkpoints.
+ *
+ * @param reader entry reader.
+ */
+extern ZIP_EXPORT void zip_entry_reader_close(struct zip_entry_reader_t *reader);
+
 /**
  * Returns the number of all entries (files and directories) in the zip archive.
  *
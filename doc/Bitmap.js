@@ -1,5 +1,5 @@
 /**
-* Load a BMP, TGA, PCX or PNG image.
+* Load a BMP, TGA, PCX, QOI or PNG image.
 *
 * **Note: PNG module must be loaded by calling LoadLibrary("png") before using this function with PNG files!**
 * **Note: JPEG module must be loaded by calling LoadLibrary("jpeg") before loading JPEG files!**
@@ -17,7 +17,7 @@
 *//**
 * create Bitmap from integer array.
 * @constructor 
-* @param {number[]} data 32bit integer data interpreted as ARGB.
+* @param {number[]|IntArray|ByteArray} data 32bit integer data interpreted as ARGB or a ByteArray with four bytes (R, G, B, A) per pixel.
 * @param {number} width bitmap width.
 * @param {number} height bitmap height.
 *//**
@@ -79,6 +79,26 @@ Bitmap.prototype.DrawTrans = function (x, y) { };
  * @returns {number} the color of the pixel.
  */
 Bitmap.prototype.GetPixel = function (x, y) { };
+/**
+ * Get direct access to the pixels of a 32bpp Bitmap. The returned PixelView can be indexed like an array and reads/writes the Bitmap memory directly.
+ * By default it has one ARGB number per pixel, with bytes=true four entries (R, G, B, A) per pixel like p5js pixels[].
+ * Index of pixel (x, y) is y * view.stride + x (times 4 in byte mode). The view becomes invalid after UnlockPixels() or the next LockPixels().
+ * @param {boolean} [bytes] true for a view with one entry per color component.
+ * @returns {PixelView} the pixel view.
+ * @throws Throws an error if the Bitmap does not have 32bpp.
+ */
+Bitmap.prototype.LockPixels = function (bytes) { };
+/**
+ * End direct pixel access started with LockPixels() and mark the Bitmap as changed.
+ */
+Bitmap.prototype.UnlockPixels = function () { };
+/**
+ * Get an ArrayBuffer that shares the memory of a 32bpp Bitmap (no copy). Wrap it in a Uint32Array() for one ARGB value per pixel, pixel (x, y) is at index y * width + x.
+ * Writes are not tracked: when the Bitmap is the current render destination call UnlockPixels() after writing to mark it as changed.
+ * @returns {ArrayBuffer} the pixel memory.
+ * @throws Throws an error if the Bitmap does not have 32bpp or is a sub-bitmap.
+ */
+Bitmap.prototype.GetBuffer = function () { };
 /**
  * draw the bitmap directly into the 3dfx/voodoo framebuffer (only works when fxInit() was called).
  * 
@@ -107,6 +127,12 @@ Bitmap.prototype.SavePcxImage = function (fname) { };
  * @param {string} fname filename.
  */
 Bitmap.prototype.SaveTgaImage = function (fname) { };
+/**
+ * Save bitmap to QOI file (fast lossless compression, see https://qoiformat.org/).
+ * Bitmaps with alpha values are saved with alpha channel.
+ * @param {string} fname filename.
+ */
+Bitmap.prototype.SaveQoiImage = function (fname) { };
 /**
  * Save bitmap to PNG file.
  * 
@@ -68,3 +68,8 @@ ByteArray.prototype.ToString = function () { };
 * @returns {number[]} the contents of the ByteArray as Javascript array.
 */
 ByteArray.prototype.ToArray = function () { };
+/**
+ * get an ArrayBuffer that shares the storage of the ByteArray (no copy). Wrap it in a Uint8Array() to access it, the length of the view follows the ByteArray when it grows or shrinks.
+ * @returns {ArrayBuffer} the ByteArray storage.
+ */
+ByteArray.prototype.GetBuffer = function () { };
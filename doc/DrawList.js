@@ -0,0 +1,113 @@
+/**
+ * Create an empty DrawList. A DrawList records drawing commands and draws all of them with a single call to Execute().
+ * Lists can be executed several times, or cleared and refilled every frame (the memory is kept).
+ * @class
+ */
+function DrawList() { }
+/**
+ * append a point.
+ * @param {number} x x coordinate.
+ * @param {number} y y coordinate.
+ * @param {Color} c color.
+ */
+DrawList.prototype.Plot = function (x, y, c) { };
+/**
+ * append a line.
+ * @param {number} x1 start x coordinate.
+ * @param {number} y1 start y coordinate.
+ * @param {number} x2 end x coordinate.
+ * @param {number} y2 end y coordinate.
+ * @param {Color} c color.
+ */
+DrawList.prototype.Line = function (x1, y1, x2, y2, c) { };
+/**
+ * append a box.
+ * @param {number} x1 start x coordinate.
+ * @param {number} y1 start y coordinate.
+ * @param {number} x2 end x coordinate.
+ * @param {number} y2 end y coordinate.
+ * @param {Color} c color.
+ */
+DrawList.prototype.Box = function (x1, y1, x2, y2, c) { };
+/**
+ * append a filled box.
+ * @param {number} x1 start x coordinate.
+ * @param {number} y1 start y coordinate.
+ * @param {number} x2 end x coordinate.
+ * @param {number} y2 end y coordinate.
+ * @param {Color} c color.
+ */
+DrawList.prototype.FilledBox = function (x1, y1, x2, y2, c) { };
+/**
+ * append a circle.
+ * @param {number} x x coordinate.
+ * @param {number} y y coordinate.
+ * @param {number} r radius.
+ * @param {Color} c color.
+ */
+DrawList.prototype.Circle = function (x, y, r, c) { };
+/**
+ * append a filled circle.
+ * @param {number} x x coordinate.
+ * @param {number} y y coordinate.
+ * @param {number} r radius.
+ * @param {Color} c color.
+ */
+DrawList.prototype.FilledCircle = function (x, y, r, c) { };
+/**
+ * append an ellipse.
+ * @param {number} xc x coordinate.
+ * @param {number} yc y coordinate.
+ * @param {number} xa x radius.
+ * @param {number} ya y radius.
+ * @param {Color} c color.
+ */
+DrawList.prototype.Ellipse = function (xc, yc, xa, ya, c) { };
+/**
+ * append a filled ellipse.
+ * @param {number} xc x coordinate.
+ * @param {number} yc y coordinate.
+ * @param {number} xa x radius.
+ * @param {number} ya y radius.
+ * @param {Color} c color.
+ */
+DrawList.prototype.FilledEllipse = function (xc, yc, xa, ya, c) { };
+/**
+ * append drawing a Bitmap (see Bitmap.Draw()).
+ * @param {Bitmap} bm the Bitmap.
+ * @param {number} x x coordinate.
+ * @param {number} y y coordinate.
+ */
+DrawList.prototype.Draw = function (bm, x, y) { };
+/**
+ * append drawing a Bitmap with transparency (see Bitmap.DrawTrans()).
+ * @param {Bitmap} bm the Bitmap.
+ * @param {number} x x coordinate.
+ * @param {number} y y coordinate.
+ */
+DrawList.prototype.DrawTrans = function (bm, x, y) { };
+/**
+ * append clearing the whole target.
+ * @param {Color} c color.
+ */
+DrawList.prototype.ClearScreen = function (c) { };
+/**
+ * append encoded commands. Each opcode (see DL) is followed by its arguments, e.g. [DL.PLOT, x, y, color, DL.LINE, x1, y1, x2, y2, color].
+ * Nothing is appended if the data contains an error.
+ * @param {number[]|IntArray} cmds the commands. Bitmap commands need a Bitmap as first argument and are only possible in an Array.
+ */
+DrawList.prototype.Append = function (cmds) { };
+/**
+ * draw all commands. The list is not changed.
+ * @param {Bitmap} [bm] the destination, defaults to the current render destination (see SetRenderBitmap()).
+ */
+DrawList.prototype.Execute = function (bm) { };
+/**
+ * remove all commands.
+ */
+DrawList.prototype.Clear = function () { };
+/**
+ * get the number of commands.
+ * @returns {number} the number of commands in the list.
+ */
+DrawList.prototype.Length = function () { };
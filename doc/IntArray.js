@@ -66,3 +66,8 @@ IntArray.prototype.ToString = function () { };
 * @returns {number[]} the contents of the IntArray as Javascript array.
 */
 IntArray.prototype.ToArray = function () { };
+/**
+ * get an ArrayBuffer that shares the storage of the IntArray (no copy). Wrap it in an Int32Array() to access it, the length of the view follows the IntArray when it grows or shrinks.
+ * @returns {ArrayBuffer} the IntArray storage.
+ */
+IntArray.prototype.GetBuffer = function () { };
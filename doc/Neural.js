@@ -97,6 +97,11 @@ DoubleArray.prototype.Push = function (val) { };
  * @returns {number} the former last value.
  */
 DoubleArray.prototype.Pop = function () { };
+/**
+ * get an ArrayBuffer that shares the storage of the DoubleArray (no copy). Wrap it in a Float64Array() to access it, the length of the view follows the DoubleArray when it grows or shrinks.
+ * @returns {ArrayBuffer} the DoubleArray storage.
+ */
+DoubleArray.prototype.GetBuffer = function () { };
 /**
  * retrieve and remove the first value in the DoubleArray.
  * @returns {number} the former first value.
@@ -49,3 +49,8 @@ Sample.prototype.Stop = function () { };
  * @returns {number} The sample value at that position. The sample data are always in unsigned format.
  */
 Sample.prototype.Get = function (idx) { };
+/**
+ * Get an ArrayBuffer that shares the sample data (no copy). Wrap it in a Uint8Array() (8 bit) or Uint16Array() (16 bit), stereo samples are interleaved left/right. The sample data are always in unsigned format.
+ * @returns {ArrayBuffer} the sample data.
+ */
+Sample.prototype.GetBuffer = function () { };
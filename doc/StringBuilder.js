@@ -0,0 +1,31 @@
+/**
+ * Create a StringBuilder. It collects strings in a growing native buffer and only creates a JS string when ToString() is called.
+ * @class
+ * 
+ * @param {...*} [values] initial contents, the string representation of all parameters is appended.
+ */
+function StringBuilder(values) {
+	/**
+	 * Number of bytes in the StringBuilder.
+	 * @member {number}
+	 */
+	this.length = 0;
+}
+/**
+ * append the string representation of all parameters.
+ * 
+ * @param {...*} values the values to append.
+ * 
+ * @returns {StringBuilder} this StringBuilder for chaining.
+ */
+StringBuilder.prototype.Append = function (values) { };
+/**
+ * get the contents as a string.
+ * 
+ * @returns {string} the contents of the StringBuilder.
+ */
+StringBuilder.prototype.ToString = function () { };
+/**
+ * remove all contents, the buffer is kept for reuse.
+ */
+StringBuilder.prototype.Clear = function () { };
@@ -13,11 +13,20 @@ function Setup() { }
 function Loop() { }
 
 /**
- * This function is called whenever mouse / keyboard input happens.
+ * This function is called whenever mouse / keyboard input happens. It is called once for every event since the last frame
+ * (it used to be called at most once per frame). Every call gets a new event object.
  * @param {Event} event the current event.
  */
 function Input(event) { }
 
+/**
+ * If defined this function is called instead of {@link Input} once per frame with all mouse / keyboard events since the last frame,
+ * plus an event for every change of the joystick buttons. Events are in the order they happened, use `ticks` for their timing.
+ * The array and the event objects are reused, copy the values you need after the call.
+ * @param {Event[]} events the events.
+ */
+function InputBatch(events) { }
+
 /**
  * @property {object} global the global context.
  */
@@ -254,6 +263,22 @@ function MidiOut(data) { }
  */
 function SetRenderBitmap(bm) { }
 
+/**
+ * Select how the render bitmap is copied to the screen after each Loop().
+ * In PRESENT.DIRTY mode all drawing functions record the area they changed and only these rectangles are copied
+ * (close rectangles are merged, if most of the screen changed it is copied as a whole).
+ * Drawing done by other means (e.g. 3dfx) is not tracked, use PRESENT.FULL (the default) then.
+ * @param {PRESENT} mode one of PRESENT.FULL or PRESENT.DIRTY.
+ * @throws Throws an error for unknown modes.
+ */
+function SetPresentMode(mode) { }
+
+/**
+ * Get statistics about the screen updates.
+ * @returns {PresentInfo} an info object.
+ */
+function PresentStats() { }
+
 /**
  * get the width of the drawing area.
  * @returns {number} the width of the drawing area.
@@ -304,8 +329,9 @@ function Line(x1, y1, x2, y2, c) { }
  * @param {number} y2 end y coordinate.
  * @param {number} w line width.
  * @param {number} c color.
+ * @param {number} [cap] line end style (CAP.ROUND, CAP.SQUARE or CAP.PROJECT), default is CAP.ROUND.
  */
-function CustomLine(x1, y1, x2, y2, w, c) { }
+function CustomLine(x1, y1, x2, y2, w, c, cap) { }
 
 /**
  * draw a box.
@@ -457,6 +483,12 @@ function SavePcxImage(fname) { }
  */
 function SaveTgaImage(fname) { }
 
+/**
+ * Save current screen to QOI file (fast lossless compression, see https://qoiformat.org/).
+ * @param {string} fname filename.
+ */
+function SaveQoiImage(fname) { }
+
 /**
  * Save current screen to PNG file.
  * 
@@ -483,6 +515,13 @@ function GetPixel(x, y) { }
  */
 function TransparencyEnabled(mode) { }
 
+/**
+ * Get the type of the blending kernels. Filled primitives and Bitmap.DrawTrans() on 32bpp bitmaps blend whole rows at once,
+ * using MMX for ALPHA, DARKEST, LIGHTEST, DIFFERENCE, MULTIPLY and SCREEN if the CPU supports it.
+ * @returns {string} "MMX" or "C".
+ */
+function BlendKernels() { }
+
 /**
  * @module other
  */
@@ -580,6 +619,70 @@ function Read(filename) { }
  */
 function ReadZIP(filename, entryname) { }
 
+/**
+ * Get statistics of the ZIP archive cache. The most recently used ZIP files are kept open with an index of their entry names,
+ * so reading several entries from the same archive (e.g. JSBOOT.ZIP) does not parse the central directory every time.
+ * @returns {ZipCacheInfo} an info object.
+ */
+function ZipCacheStats() { }
+
+/**
+ * Close all ZIP archives kept open by the ZIP archive cache.
+ * Archives are reopened automatically when they changed on disk or are opened for writing with `Zip`, so this is usually not needed.
+ */
+function ZipCacheFlush() { }
+
+/**
+ * Set the size of the image cache. Images loaded with `new Bitmap(filename)` are kept decoded (keyed by file/ZIP entry name and modification time),
+ * loading the same image again returns a Bitmap that shares the pixels with the cache until it is drawn to.
+ * The least recently used images are dropped when the cache is full.
+ * @param {number} bytes maximum number of bytes of decoded images (default 4MiB), 0 disables the cache.
+ */
+function SetImageCacheSize(bytes) { }
+
+/**
+ * Get statistics of the image cache.
+ * @returns {ImageCacheInfo} an info object.
+ */
+function ImageCacheStats() { }
+
+/**
+ * Drop all cached images that are not used by a Bitmap.
+ */
+function ImageCacheFlush() { }
+
+/**
+ * Load an image in the background. The decoder runs in time slices after each `Loop()` (using the remaining frame time, at least the
+ * time set with `SetBitmapLoadSlice()`), so rendering continues while large images are decoded.
+ * The callback is called after `Loop()` of the frame the image was finished in. Images found in the image cache are delivered with the next frame.
+ * PNG (png plugin), JPEG (jpeg plugin), BMP, PCX, TGA and LBM can be loaded from files and ZIP entries.
+ * @param {string} filename name of the image file or ZIP entry.
+ * @param {function(Bitmap, string)} callback called with the Bitmap or with `null` and an error message if loading failed.
+ * @param {function(number)} [progress] called once per frame while decoding with the fraction (0..1) of the file read so far.
+ * @returns {number} an id for `CancelBitmapLoad()`.
+ */
+function LoadBitmapAsync(filename, callback, progress) { }
+
+/**
+ * Cancel an image load started with `LoadBitmapAsync()`. The callbacks are not called anymore.
+ * @param {number} id the id returned by `LoadBitmapAsync()`.
+ * @returns {boolean} true if the load was still pending.
+ */
+function CancelBitmapLoad(id) { }
+
+/**
+ * Get the number of images requested with `LoadBitmapAsync()` whose callback was not called yet.
+ * @returns {number} number of pending loads.
+ */
+function BitmapLoadsPending() { }
+
+/**
+ * Set the minimum time spent decoding `LoadBitmapAsync()` images per frame. If a frame finishes early the remaining time is used as well.
+ * The slice is checked between rows/chunks of the image, so it may be exceeded by a few ms (the timer resolution is 10ms).
+ * @param {number} ms minimum number of ms per frame (default 10).
+ */
+function SetBitmapLoadSlice(ms) { }
+
 /**
  * Get directory listing.
  * @param {string} dname name of directory to list.
@@ -628,6 +731,43 @@ function Stat(name) { }
  */
 function Gc(info) { }
 
+/**
+ * Get statistics of the garbage collector pacing.
+ * Collections are triggered when the heap (JS heap + native memory of objects like Bitmap, IntArray or ByteArray) grows beyond the trigger size.
+ * @returns {GcInfo} an info object.
+ */
+function GcStats() { }
+
+/**
+ * Configure the garbage collector pacing.
+ * @param {number} percent how much the heap may grow (in percent of the live heap after the last collection) before the next collection is run. Default: 100.
+ * @param {number} [minimum] heap size in bytes below which no collection is triggered. Default: 1MiB.
+ */
+function SetGcGrowth(percent, minimum) { }
+
+/**
+ * Set the time the garbage collector may use per frame.
+ * A collection cycle is then run incrementally in small steps after each call to {@link Loop} instead of stopping the script until all garbage is freed.
+ * A full collection is still done when the heap grows to twice the trigger size before the cycle completes.
+ * @param {number} ms time per frame in milliseconds, 0 to always run full collections. Default: 2.
+ */
+function SetGcBudget(ms) { }
+
+/**
+ * Get the occupancy of the allocation pools of the JS engine.
+ * Objects, properties, environments and strings of up to 128 bytes are allocated from slabs of 8KiB, empty slabs are given back after each garbage collection cycle.
+ * @returns {PoolInfo[]} one entry per pool.
+ */
+function PoolStats() { }
+
+/**
+ * Get the hit/miss counters of the inline caches used for named property access (e.g. 'obj.name'), one entry per call site that was executed.
+ * A call site with many misses accesses objects with changing properties or many different objects that don't share a prototype.
+ * @param {boolean} [reset] reset all counters after reading them.
+ * @returns {InlineCacheInfo[]} a list of call sites.
+ */
+function InlineCacheStats(reset) { }
+
 /**
  * Get information system memory.
  * @returns {MemInfo} an info object.
@@ -741,7 +881,7 @@ function StringToBytes(str) { }
  * 
  * @param {string} p name of the single parameter.
  * @param {string} s the source of the function.
- * @param {string} [f] an optional filename where the source came from.
+ * @param {string} [f] an optional filename where the source came from. If provided the compiled function is kept in the bytecode cache.
  */
 function NamedFunction(p, s, f) { }
 
@@ -1631,3 +1771,34 @@ function FlicClose() { }
  * @returns {number} if 'loop' is false this function returns '-1' after the last frame was decoded. In all other cases the current frame number is returned.
  */
 function FlicPlay(x, y, loop) { }
+
+/**
+ * Start recording the screen into a FLC file. Every frame presented after Loop() is converted to a fixed 3-3-2 palette and
+ * only the lines that changed since the last frame are stored, the file can be played back with FlicOpen()/FlicPlay().
+ * If Loop() is faster than the recording frame rate frames are skipped, if it is slower the last frame is repeated.
+ * Only one recording can run at a given time. Not available with 3dfx.
+ * 
+ * @param {string} fname file name to write.
+ * @param {number} [fps] frame rate of the recording, defaults to the frame rate set with SetFramerate().
+ */
+function FlicRecordStart(fname, fps) { }
+
+/**
+ * Stop recording and finish the FLC file.
+ */
+function FlicRecordStop() { }
+
+/**
+ * @typedef {object} FlicRecordInfo
+ * @property {boolean} recording true while a recording is running.
+ * @property {number} frames number of frames written.
+ * @property {number} repeated number of frames that repeat the last image because Loop() was slower than the recording.
+ * @property {number} skipped number of presented frames that were not recorded because Loop() was faster than the recording.
+ * @property {number} bytes size of the FLC file.
+ */
+/**
+ * Get statistics of the current or last recording.
+ * 
+ * @returns {FlicRecordInfo} information about the recording.
+ */
+function FlicRecordStats() { }
@@ -5,6 +5,7 @@
  * @property {number} buttons mouse buttons, see {@link MOUSE}
  * @property {number} key key code, see {@link KEY}
  * @property {number} ticks event time.
+ * @property {number} joystick joystick index for joystick events (buttons, x and y then contain the joystick buttons and the position of the first stick) or -1.
  */
 class Event { }
 
@@ -57,6 +58,97 @@ class StatInfo { }
  */
 class MemInfo { }
 
+/**
+ * @typedef {object} GcInfo
+ * @property {number} heap number of bytes currently allocated by the JS engine.
+ * @property {number} native number of bytes of native memory owned by JS objects.
+ * @property {number} live heap size (JS + native) after the last collection.
+ * @property {number} trigger heap size that triggers the next collection.
+ * @property {number} freed number of bytes freed by the last collection.
+ * @property {number} growth allowed heap growth in percent.
+ * @property {number} minimum heap size below which no collection is triggered.
+ * @property {number} collections number of collections since start.
+ * @property {number} paced number of collections triggered by the pacer.
+ * @property {number} last_pause duration of the last full (stop-the-world) collection in ms.
+ * @property {number} max_pause longest full collection in ms.
+ * @property {number} total_pause sum of all collections and incremental steps in ms.
+ * @property {number} budget GC time per frame in ms, 0 if incremental collection is disabled.
+ * @property {number} steps number of incremental steps since start.
+ * @property {number} last_step duration of the last incremental step in ms.
+ * @property {number} max_step longest incremental step in ms.
+ * @property {number} frame GC time spent after the last call to Loop() in ms.
+ * @property {number} state state of the collector: 0 idle, 1 marking, 2 sweeping.
+ */
+class GcInfo { }
+
+/**
+ * @typedef {object} PoolInfo
+ * @property {string} name name of the pool ("object", "property", "environment", "string32", "string64" or "string128").
+ * @property {number} size size of an item in bytes.
+ * @property {number} used number of items in use.
+ * @property {number} peak highest number of items in use since start.
+ * @property {number} capacity number of items that fit into the currently allocated slabs.
+ * @property {number} slabs number of currently allocated slabs.
+ * @property {number} released number of empty slabs given back after garbage collection cycles.
+ */
+class PoolInfo { }
+
+/**
+ * @typedef {object} InlineCacheInfo
+ * @property {string} file the script file of the call site.
+ * @property {number} line the line of the call site.
+ * @property {string} name the property name.
+ * @property {number} hits number of accesses served by the cache.
+ * @property {number} misses number of accesses that needed a full lookup.
+ */
+class InlineCacheInfo { }
+
+/**
+ * @typedef {object} ZipCacheInfo
+ * @property {number} hits number of lookups served by an already open archive.
+ * @property {number} misses number of lookups that had to open the archive.
+ * @property {number} stale number of archives that were reopened because they changed on disk.
+ * @property {number} evictions number of archives that were closed to make room for another one.
+ * @property {number} failed number of lookups for missing archives or entries.
+ * @property {number} open number of archives currently open.
+ * @property {number} size maximum number of open archives.
+ */
+class ZipCacheInfo { }
+
+/**
+ * @typedef {object} ImageCacheInfo
+ * @property {number} size maximum number of bytes (see SetImageCacheSize()).
+ * @property {number} bytes number of bytes of the cached images.
+ * @property {number} entries number of cached images.
+ * @property {number} shared number of Bitmaps sharing their pixels with the cache.
+ * @property {number} hits number of images served from the cache.
+ * @property {number} misses number of images that had to be decoded.
+ * @property {number} evictions number of images dropped to stay within the size.
+ * @property {number} copies number of shared Bitmaps that got their own pixels when they were drawn to.
+ */
+class ImageCacheInfo { }
+
+/**
+ * @typedef {object} PresentInfo
+ * @property {number} mode the current present mode (PRESENT.FULL or PRESENT.DIRTY).
+ * @property {number} rects number of rectangles copied to the screen by the last frame.
+ * @property {number} bytes number of bytes copied to the screen by the last frame.
+ * @property {number} frames number of frames presented since start.
+ * @property {number} total_bytes number of bytes copied to the screen since start.
+ */
+class PresentInfo { }
+
+/**
+ * Array-like view on the pixels of a Bitmap, see Bitmap.LockPixels().
+ * @typedef {object} PixelView
+ * @property {number} width width of the Bitmap.
+ * @property {number} height height of the Bitmap.
+ * @property {number} stride number of entries per line.
+ * @property {number} length number of entries.
+ * @property {Bitmap} bitmap the Bitmap.
+ */
+class PixelView { }
+
 /**
  * @typedef {object} Matrix
  * @property {number[][]} v the 3x3 matrix data.
@@ -109,6 +109,7 @@ NO_COLOR = -1;
  * @property {number} HARD_LIGHT inverted OVERLAY
  * @property {number} DOGE divides the bottom layer by the inverted top layer
  * @property {number} BURN inverted doge
+ * @property {number} SUBSTRACT add and subtract 255 with saturation
  */
 BLEND = {
 	REPLACE: 0,
@@ -124,6 +125,7 @@ BLEND = {
 	HARD_LIGHT: 10,
 	DOGE: 11,
 	BURN: 12,
+	SUBSTRACT: 13,
 };
 
 /**
@@ -670,6 +670,56 @@ SYSTEM = {
 	TIMER: 0x10
 };
 
+/**
+ * SetPresentMode() modes.
+ * @property {*} FULL copy the whole render bitmap to the screen every frame (default).
+ * @property {*} DIRTY only copy the areas changed by drawing functions since the last frame.
+ */
+PRESENT = {
+	FULL: 0,
+	DIRTY: 1
+};
+
+/**
+ * CustomLine() line end styles.
+ * @property {*} ROUND round line ends (default).
+ * @property {*} SQUARE the line ends exactly at the end points.
+ * @property {*} PROJECT square line ends extended by half the line width.
+ */
+CAP = {
+	ROUND: 0,
+	SQUARE: 1,
+	PROJECT: 2
+};
+
+/**
+ * DrawList opcodes for DrawList.Append(), each opcode is followed by the given arguments.
+ * @property {*} PLOT x, y, color
+ * @property {*} LINE x1, y1, x2, y2, color
+ * @property {*} BOX x1, y1, x2, y2, color
+ * @property {*} FILLEDBOX x1, y1, x2, y2, color
+ * @property {*} CIRCLE x, y, r, color
+ * @property {*} FILLEDCIRCLE x, y, r, color
+ * @property {*} ELLIPSE xc, yc, xa, ya, color
+ * @property {*} FILLEDELLIPSE xc, yc, xa, ya, color
+ * @property {*} DRAW bitmap, x, y
+ * @property {*} DRAWTRANS bitmap, x, y
+ * @property {*} CLEARSCREEN color
+ */
+DL = {
+	PLOT: 1,
+	LINE: 2,
+	BOX: 3,
+	FILLEDBOX: 4,
+	CIRCLE: 5,
+	FILLEDCIRCLE: 6,
+	ELLIPSE: 7,
+	FILLEDELLIPSE: 8,
+	DRAW: 9,
+	DRAWTRANS: 10,
+	CLEARSCREEN: 11
+};
+
 /**
  * event interface.
  * @property {*} Mode.NONE no cursor
@@ -58,6 +58,7 @@ exports._currentEnv = {
 	_ellipseMode: CENTER,
 	_imageMode: CORNER,
 	_strokeWeight: 1,
+	_strokeCap: CAP.ROUND,
 	_matrix: null
 };
 
@@ -95,6 +96,7 @@ exports._cloneEnv = function () {
 		_ellipseMode: _currentEnv._ellipseMode,
 		_imageMode: _currentEnv._imageMode,
 		_strokeWeight: _currentEnv._strokeWeight,
+		_strokeCap: _currentEnv._strokeCap,
 		_matrix: matrix
 	};
 }
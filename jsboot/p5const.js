@@ -39,6 +39,10 @@ exports.TOP = 'top';
 exports.BOTTOM = 'bottom';
 exports.BASELINE = exports.BOTTOM;
 
+exports.ROUND = 'round';
+exports.SQUARE = 'butt';
+exports.PROJECT = 'square';
+
 exports.CLOSE = 'close';
 exports.POINTS = 'points';
 exports.LINES = 'lines';
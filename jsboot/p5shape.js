@@ -194,7 +194,7 @@ exports.line = function (x1, y1, x2, y2) {
 		if (_currentEnv._strokeWeight == 1) {
 			Line(tx1, ty1, tx2, ty2, _currentEnv._stroke);
 		} else {
-			CustomLine(tx1, ty1, tx2, ty2, _currentEnv._strokeWeight, _currentEnv._stroke);
+			CustomLine(tx1, ty1, tx2, ty2, _currentEnv._strokeWeight, _currentEnv._stroke, _currentEnv._strokeCap);
 		}
 	}
 };
@@ -217,7 +217,13 @@ exports.line = function (x1, y1, x2, y2) {
  */
 exports.point = function (x, y) {
 	if (_currentEnv._stroke != NO_COLOR) {
-		Plot(_transX(x, y), _transY(x, y), _currentEnv._stroke);
+		var tx = _transX(x, y);
+		var ty = _transY(x, y);
+		if (_currentEnv._strokeWeight == 1) {
+			Plot(tx, ty, _currentEnv._stroke);
+		} else {
+			CustomLine(tx, ty, tx, ty, _currentEnv._strokeWeight, _currentEnv._stroke, _currentEnv._strokeCap);
+		}
 	}
 };
 
@@ -526,7 +532,7 @@ exports.endShape = function (p) {
 			if (_currentEnv._strokeWeight == 1) {
 				Line(_shape[i][0], _shape[i][1], _shape[i + 1][0], _shape[i + 1][1], _currentEnv._stroke);
 			} else {
-				CustomLine(_shape[i][0], _shape[i][1], _shape[i + 1][0], _shape[i + 1][1], _strokeWeight, _currentEnv._stroke);
+				CustomLine(_shape[i][0], _shape[i][1], _shape[i + 1][0], _shape[i + 1][1], _currentEnv._strokeWeight, _currentEnv._stroke, _currentEnv._strokeCap);
 			}
 		}
 	} else if (_shapeMode === TRIANGLES) {
@@ -703,7 +709,12 @@ exports.loadImage = function (path) {
 		this.width = this.bm.width;
 		this.height = this.bm.height;
 	};
-	ret.prototype.loadPixels = function () { };
+	ret.prototype.loadPixels = function () {
+		this.pixels = this.bm.LockPixels(true);
+	};
+	ret.prototype.updatePixels = function () {
+		this.bm.UnlockPixels();
+	};
 	ret.prototype.get = function (x, y) {	// TODO: check!
 		var px = this.bm.GetPixel(x, y);
 		return color(GetRed(px), GetGreen(px), GetBlue(px), 255);
@@ -776,13 +787,18 @@ exports.createImage = function (width, height) {
 		this.width = this.bm.width;
 		this.height = this.bm.height;
 	};
-	ret.prototype.loadPixels = function () { };
+	ret.prototype.loadPixels = function () {
+		this.pixels = this.bm.LockPixels(true);
+	};
+	ret.prototype.updatePixels = function () {
+		this.bm.UnlockPixels();
+	};
 	ret.prototype.get = function (x, y) {	// TODO: check!
 		var px = this.bm.GetPixel(x, y);
 		return color(GetRed(px), GetGreen(px), GetBlue(px), 255);
 	};
 
-	return new ret(path);
+	return new ret();
 };
 
 /**
@@ -903,3 +919,29 @@ exports.imageMode = function (m) {
 exports.strokeWeight = function (w) {
 	_currentEnv._strokeWeight = w;
 };
+
+/**
+ * Sets the style for rendering line endings. These ends are either squared,
+ * extended, or rounded, each of which specified with the corresponding
+ * parameters: SQUARE, PROJECT, and ROUND. The default cap is ROUND.
+ *
+ * @method strokeCap
+ * @param  {Constant} cap either SQUARE, PROJECT, or ROUND
+ * @example
+ * strokeWeight(12.0);
+ * strokeCap(ROUND);
+ * line(20, 30, 80, 30);
+ * strokeCap(SQUARE);
+ * line(20, 50, 80, 50);
+ * strokeCap(PROJECT);
+ * line(20, 70, 80, 70);
+ */
+exports.strokeCap = function (cap) {
+	if (cap === SQUARE) {
+		_currentEnv._strokeCap = CAP.SQUARE;
+	} else if (cap === PROJECT) {
+		_currentEnv._strokeCap = CAP.PROJECT;
+	} else {
+		_currentEnv._strokeCap = CAP.ROUND;
+	}
+};
@@ -56,6 +56,7 @@ function CopyPx(d, s) {
 
 /**
  * Load a QOI image and return it as Bitmap.
+ * DOjS loads QOI natively with `new Bitmap(fname)` (including ZIP entries), the JS decoder is only used as fallback on older versions.
  * @see https://qoiformat.org/
  * 
  * @param {String} fname name of the QOI file.
@@ -63,6 +64,10 @@ function CopyPx(d, s) {
  * @returns {Bitmap} the loaded Bitmap.
  */
 function LoadQoi(fname) {
+	if (typeof SaveQoiImage === "function") {
+		return new Bitmap(fname);
+	}
+
 	// read file contents into an ByteArray
 	var f = new File(fname, FILE.READ);
 	var data = f.ReadInts();
@@ -88,7 +93,7 @@ function DecodeQoi(data) {
 		data.Get(2) != CharCode('i') ||
 		data.Get(3) != CharCode('f')
 	) {
-		throw new Error("[QOI] Not a QOI: " + fname);
+		throw new Error("[QOI] Not a QOI file");
 	}
 	p = 4;
 
@@ -201,6 +206,6 @@ function DecodeQoi(data) {
 }
 
 // export functions and version
-exports.__VERSION__ = 2;
+exports.__VERSION__ = 3;
 exports.DecodeQoi = DecodeQoi;
 exports.LoadQoi = LoadQoi;
@@ -35,6 +35,7 @@ SOFTWARE.
 #include "DOjS.h"
 #include "a3d.h"
 #include "bitmap.h"
+#include "dirty.h"
 
 //! convert angle in radians to allegro 0..256 representation
 #define RADTOALLEG(x) (x / (2 * M_PI) * 256)
@@ -178,6 +179,23 @@ static BITMAP *bitmap_or_null(js_State *J, int idx) {
     return texture;
 }
 
+/**
+ * @brief mark the screen area covered by the given vertices as dirty.
+ *
+ * @param vc number of vertices.
+ * @param vtx the vertices.
+ */
+static void dirty_v3d(int vc, V3D_f *vtx[]) {
+    float x1 = vtx[0]->x, y1 = vtx[0]->y, x2 = vtx[0]->x, y2 = vtx[0]->y;
+    for (int i = 1; i < vc; i++) {
+        x1 = MIN(x1, vtx[i]->x);
+        y1 = MIN(y1, vtx[i]->y);
+        x2 = MAX(x2, vtx[i]->x);
+        y2 = MAX(y2, vtx[i]->y);
+    }
+    dirty_add(DOjS.current_bm, (int)floor(x1), (int)floor(y1), (int)ceil(x2), (int)ceil(y2));
+}
+
 /**
  * @brief draw 3d triangle.
  * Triangle3D(type, texture, p1, p2, p3)
@@ -195,6 +213,7 @@ static void f_Triangle3D(js_State *J) {
     array_to_v3d(J, 5, &v3);
 
     triangle3d_f(DOjS.current_bm, type, texture, &v1, &v2, &v3);
+    dirty_v3d(3, (V3D_f *[]){&v1, &v2, &v3});
 }
 
 /**
@@ -214,6 +233,7 @@ static void f_Quad3D(js_State *J) {
     array_to_v3d(J, 6, &v4);
 
     quad3d_f(DOjS.current_bm, type, texture, &v1, &v2, &v3, &v4);
+    dirty_v3d(4, (V3D_f *[]){&v1, &v2, &v3, &v4});
 }
 
 /**
@@ -230,6 +250,9 @@ static void f_Polygon3D(js_State *J) {
     V3D_f **vtx = v3d_array(J, 3, &vc);
     if (vtx) {
         polygon3d_f(DOjS.current_bm, type, texture, vc, vtx);
+        if (vc > 0) {
+            dirty_v3d(vc, vtx);
+        }
     } else {
         js_error(J, "Cannot convert vertices");
     }
@@ -309,7 +332,10 @@ static void f_Clip3D(js_State *J) {
  *
  * @param J VM state.
  */
-static void f__RenderScene(js_State *J) { render_scene(); }
+static void f__RenderScene(js_State *J) {
+    render_scene();
+    dirty_add_all(DOjS.current_bm);
+}
 
 /**
  * @brief Deallocate memory previously allocated by create_scene. Use this to avoid memory leaks in your program.
@@ -28,6 +28,7 @@ SOFTWARE.
 #include <time.h>
 
 #include "DOjS.h"
+#include "dirty.h"
 
 #include "AnimatedGIF-1.4.7/src/AnimatedGIF.h"
 #include "AnimatedGIF-1.4.7/src/gif.inl"
@@ -216,6 +217,7 @@ static void GIF_PlayFrame(js_State *J) {
 
     g->skip = false;
     int res = GIF_playFrame(&g->gif, &nextDelay, g);
+    dirty_add(DOjS.current_bm, g->x, g->y, g->x + GIF_getCanvasWidth(&g->gif) - 1, g->y + GIF_getCanvasHeight(&g->gif) - 1);
     if (res < 0) {
         js_error(J, "Error decoding frame");
     } else if (res == 0) {
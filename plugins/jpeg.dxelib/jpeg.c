@@ -27,6 +27,7 @@ SOFTWARE.
 #include <time.h>
 
 #include "DOjS.h"
+#include "imgload.h"
 
 #define _NJ_INCLUDE_HEADER_ONLY
 #include "nanojpeg.c"
@@ -84,6 +85,7 @@ static BITMAP *load_jpg_pf(PACKFILE *f, RGB *pal) {
         if (njIsColor()) {
             LOG("Color JPEG\n");
             for (int y = 0; y < bm->h; y++) {
+                imgload_yield();
                 for (int x = 0; x < bm->w; x++) {
                     int offs = y * bm->w * 3 + x * 3;
                     bm->line[y][x * 4 + _rgb_r_shift_32 / 8] = jpgdata[0 + offs];
@@ -95,6 +97,7 @@ static BITMAP *load_jpg_pf(PACKFILE *f, RGB *pal) {
         } else {
             DEBUGF("BW JPEG\n");
             for (int y = 0; y < bm->h; y++) {
+                imgload_yield();
                 for (int x = 0; x < bm->w; x++) {
                     int offs = y * bm->w + x;
                     bm->line[y][x * 4 + _rgb_r_shift_32 / 8] = jpgdata[offs];
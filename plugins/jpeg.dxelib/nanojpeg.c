@@ -257,6 +257,9 @@ int main(int argc, char* argv[]) {
 
 #ifndef _NJ_INCLUDE_HEADER_ONLY
 
+// DOjS: give LoadBitmapAsync() a chance to suspend the decoder between macroblock rows
+#include "imgload.h"
+
 #ifdef _MSC_VER
     #define NJ_INLINE static __inline
     #define NJ_FORCE_INLINE static __forceinline
@@ -703,6 +706,7 @@ NJ_INLINE void njDecodeScan(void) {
         if (++mbx >= nj.mbwidth) {
             mbx = 0;
             if (++mby >= nj.mbheight) break;
+            imgload_yield();
         }
         if (nj.rstinterval && !(--rstcount)) {
             njByteAlign();
@@ -839,6 +843,7 @@ NJ_INLINE void njConvert(void) {
         const unsigned char *pcb = nj.comp[1].pixels;
         const unsigned char *pcr = nj.comp[2].pixels;
         for (yy = nj.height;  yy;  --yy) {
+            imgload_yield();
             for (x = 0;  x < nj.width;  ++x) {
                 register int y = py[x] << 8;
                 register int cb = pcb[x] - 128;
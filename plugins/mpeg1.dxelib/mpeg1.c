@@ -27,8 +27,11 @@ SOFTWARE.
 #include <time.h>
 
 #include "DOjS.h"
+#include "dirty.h"
+#include "zipfile.h"
 
 #define PLM_AUDIO_SEPARATE_CHANNELS
+#define PLM_ZIPSTREAM
 #define PL_MPEG_IMPLEMENTATION
 #include "pl_mpeg/pl_mpeg.h"
 
@@ -102,6 +105,7 @@ static void MPEG1_video_decode_callback(plm_t *self, plm_frame_t *frame, void *u
     plm_frame_to_rgba(frame, (uint8_t *)m->video_buffer->dat, frame->width * sizeof(uint32_t));
 
     blit(m->video_buffer, DOjS.current_bm, 0, 0, m->x, m->y, frame->width, frame->height);
+    dirty_add(DOjS.current_bm, m->x, m->y, m->x + frame->width - 1, m->y + frame->height - 1);
 }
 
 /**
@@ -162,7 +166,16 @@ static void new_MPEG1(js_State *J) {
     bzero(m, sizeof(mpeg1_t));
 
     const char *fname = js_tostring(J, 1);
-    m->plm = plm_create_with_filename(fname);
+    char *delim = strchr(fname, ZIP_DELIM);
+    if (!delim) {
+        m->plm = plm_create_with_filename(fname);
+    } else {
+        // stream the entry, it is inflated while decoding
+        zipstream_t *zs = open_zipstream1(fname);
+        if (zs) {
+            m->plm = plm_create_with_zipstream(zs, true);
+        }
+    }
     if (!m->plm) {
         free(m);
         js_error(J, "Could not open '%s'", fname);
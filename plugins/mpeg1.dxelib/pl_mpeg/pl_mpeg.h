@@ -284,6 +284,16 @@ plm_t *plm_create_with_filename(const char *filename);
 plm_t *plm_create_with_file(FILE *fh, int close_when_done);
 
 
+#ifdef PLM_ZIPSTREAM
+// Create a plmpeg instance with a DOjS ZIP file entry opened with 
+// open_zipstream1(). The entry is inflated on demand. Pass TRUE to 
+// close_when_done to let plmpeg call close_zipstream() on it when plm_destroy()
+// is called.
+
+plm_t *plm_create_with_zipstream(zipstream_t *zs, int close_when_done);
+#endif
+
+
 // Create a plmpeg instance with a pointer to memory as source. This assumes the
 // whole file is in memory. The memory is not copied. Pass TRUE to 
 // free_when_done to let plmpeg call free() on the pointer when plm_destroy() 
@@ -480,6 +490,15 @@ plm_buffer_t *plm_buffer_create_with_filename(const char *filename);
 plm_buffer_t *plm_buffer_create_with_file(FILE *fh, int close_when_done);
 
 
+#ifdef PLM_ZIPSTREAM
+// Create a buffer instance with a DOjS ZIP file entry. Pass TRUE to
+// close_when_done to let plmpeg call close_zipstream() on it when 
+// plm_destroy() is called.
+
+plm_buffer_t *plm_buffer_create_with_zipstream(zipstream_t *zs, int close_when_done);
+#endif
+
+
 // Create a buffer instance with a pointer to memory as source. This assumes
 // the whole file is in memory. The bytes are not copied. Pass 1 to 
 // free_when_done to let plmpeg call free() on the pointer when plm_destroy() 
@@ -852,6 +871,13 @@ plm_t *plm_create_with_file(FILE *fh, int close_when_done) {
 	return plm_create_with_buffer(buffer, TRUE);
 }
 
+#ifdef PLM_ZIPSTREAM
+plm_t *plm_create_with_zipstream(zipstream_t *zs, int close_when_done) {
+	plm_buffer_t *buffer = plm_buffer_create_with_zipstream(zs, close_when_done);
+	return plm_create_with_buffer(buffer, TRUE);
+}
+#endif
+
 plm_t *plm_create_with_memory(uint8_t *bytes, size_t length, int free_when_done) {
 	plm_buffer_t *buffer = plm_buffer_create_with_memory(bytes, length, free_when_done);
 	return plm_create_with_buffer(buffer, TRUE);
@@ -1326,6 +1352,9 @@ typedef struct plm_buffer_t {
 	int free_when_done;
 	int close_when_done;
 	FILE *fh;
+	#ifdef PLM_ZIPSTREAM
+	zipstream_t *zs;
+	#endif
 	plm_buffer_load_callback load_callback;
 	void *load_callback_user_data;
 	uint8_t *bytes;
@@ -1382,6 +1411,20 @@ plm_buffer_t *plm_buffer_create_with_file(FILE *fh, int close_when_done) {
 	return self;
 }
 
+#ifdef PLM_ZIPSTREAM
+plm_buffer_t *plm_buffer_create_with_zipstream(zipstream_t *zs, int close_when_done) {
+	plm_buffer_t *self = plm_buffer_create_with_capacity(PLM_BUFFER_DEFAULT_SIZE);
+	self->zs = zs;
+	self->close_when_done = close_when_done;
+	self->mode = PLM_BUFFER_MODE_FILE;
+	self->discard_read_bytes = TRUE;
+	self->total_size = size_zipstream(zs);
+
+	plm_buffer_set_load_callback(self, plm_buffer_load_file_callback, NULL);
+	return self;
+}
+#endif
+
 plm_buffer_t *plm_buffer_create_with_memory(uint8_t *bytes, size_t length, int free_when_done) {
 	plm_buffer_t *self = (plm_buffer_t *)malloc(sizeof(plm_buffer_t));
 	memset(self, 0, sizeof(plm_buffer_t));
@@ -1417,6 +1460,11 @@ void plm_buffer_destroy(plm_buffer_t *self) {
 	if (self->fh && self->close_when_done) {
 		fclose(self->fh);
 	}
+	#ifdef PLM_ZIPSTREAM
+	if (self->zs && self->close_when_done) {
+		close_zipstream(self->zs);
+	}
+	#endif
 	if (self->free_when_done) {
 		free(self->bytes);
 	}
@@ -1483,6 +1531,12 @@ void plm_buffer_seek(plm_buffer_t *self, size_t pos) {
 	self->has_ended = FALSE;
 
 	if (self->mode == PLM_BUFFER_MODE_FILE) {
+		#ifdef PLM_ZIPSTREAM
+		if (self->zs) {
+			seek_zipstream(self->zs, pos);
+		}
+		else
+		#endif
 		fseek(self->fh, pos, SEEK_SET);
 		self->bit_index = 0;
 		self->length = 0;
@@ -1502,6 +1556,11 @@ void plm_buffer_seek(plm_buffer_t *self, size_t pos) {
 }
 
 size_t plm_buffer_tell(plm_buffer_t *self) {
+	#ifdef PLM_ZIPSTREAM
+	if (self->zs) {
+		return tell_zipstream(self->zs) + (self->bit_index >> 3) - self->length;
+	}
+	#endif
 	return self->mode == PLM_BUFFER_MODE_FILE
 		? ftell(self->fh) + (self->bit_index >> 3) - self->length
 		: self->bit_index >> 3;
@@ -1528,7 +1587,14 @@ void plm_buffer_load_file_callback(plm_buffer_t *self, void *user) {
 	}
 
 	size_t bytes_available = self->capacity - self->length;
-	size_t bytes_read = fread(self->bytes + self->length, 1, bytes_available, self->fh);
+	size_t bytes_read;
+	#ifdef PLM_ZIPSTREAM
+	if (self->zs) {
+		bytes_read = read_zipstream(self->zs, self->bytes + self->length, bytes_available);
+	}
+	else
+	#endif
+	bytes_read = fread(self->bytes + self->length, 1, bytes_available, self->fh);
 	self->length += bytes_read;
 
 	if (bytes_read == 0) {
@@ -22,6 +22,7 @@ SOFTWARE.
 
 #include "DOjS.h"
 #include "bitmap.h"
+#include "imgcache.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -49,6 +50,11 @@ static void Bitmap_RenderSVG(js_State *J) {
     BITMAP *bm = js_touserdata(J, 0, TAG_BITMAP);
     const char *fname = js_tostring(J, 1);
 
+    if (!imgcache_own(bm)) {
+        JS_ENOMEM(J);
+        return;
+    }
+
     image = nsvgParseFromFile(fname, "px", 96.0f);
     if (image == NULL) {
         js_error(J, "Could not open SVG image '%s'.", fname);
@@ -250,6 +250,18 @@ static void DoubleArray_Append(js_State *J) {
     DA_UPDATE(J, "length", ia->size);
 }
 
+/**
+ * @brief get an ArrayBuffer that uses the storage of this DoubleArray, wrap it in a Float64Array() to access it.
+ * da.GetBuffer():ArrayBuffer
+ *
+ * @param J VM state.
+ */
+static void DoubleArray_GetBuffer(js_State *J) {
+    double_array_t *ia = js_touserdata(J, 0, TAG_DOUBLE_ARRAY);
+
+    js_newarraybufferp(J, 0, (void **)&ia->data, (unsigned int *)&ia->size, sizeof(DA_TYPE));
+}
+
 /***********************
 ** exported functions **
 ***********************/
@@ -271,6 +283,7 @@ void init_doublearray(js_State *J) {
         NPROTDEF(J, DoubleArray, ToArray, 0);
         NPROTDEF(J, DoubleArray, Clear, 0);
         NPROTDEF(J, DoubleArray, Append, 1);
+        NPROTDEF(J, DoubleArray, GetBuffer, 0);
     }
     CTORDEF(J, new_DoubleArray, TAG_DOUBLE_ARRAY, 0);
 
@@ -284,6 +297,7 @@ void init_doublearray(js_State *J) {
         NPROTDEF(J, DoubleArray, ToArray, 0);
         NPROTDEF(J, DoubleArray, Clear, 0);
         NPROTDEF(J, DoubleArray, Append, 1);
+        NPROTDEF(J, DoubleArray, GetBuffer, 0);
     }
     js_setregistry(J, TAG_DOUBLE_ARRAY);
 
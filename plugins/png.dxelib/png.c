@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include "DOjS.h"
 #include "bitmap.h"
+#include "imgload.h"
 
 void init_png(js_State *J);
 
@@ -75,6 +76,7 @@ void init_png(js_State *J) {
 
     /* Make Allegro aware of PNG file format. */
     alpng_init();
+    alpng_yield_hook = imgload_yield;  // allow LoadBitmapAsync() to decode in time slices
 
     NFUNCDEF(J, SavePngImage, 1);
 
@@ -43,7 +43,9 @@ void init_rawplay(js_State *J);
 ************/
 //! file userdata definition
 typedef struct __rawplay {
-    unsigned short *data;
+    unsigned short *data;   //!< samples of plain files
+    zipstream_t *zs;        //!< samples of ZIP file entries, streamed while playing
+    unsigned short *chunk;  //!< buffer for samples read from zs
     size_t size;
     size_t pos;
     AUDIOSTREAM *stream;
@@ -55,11 +57,19 @@ typedef struct __rawplay {
 *********************/
 
 static void RP_cleanup(rawplay_t *ov) {
-    if (ov->data) {
-        stop_audio_stream(ov->stream);
-        ov->stream = NULL;
+    if (ov->data || ov->zs) {
+        if (ov->stream) {
+            stop_audio_stream(ov->stream);
+            ov->stream = NULL;
+        }
         free(ov->data);
         ov->data = NULL;
+        if (ov->zs) {
+            close_zipstream(ov->zs);
+            ov->zs = NULL;
+        }
+        free(ov->chunk);
+        ov->chunk = NULL;
     }
 }
 
@@ -106,14 +116,16 @@ static void new_Rawplay(js_State *J) {
             return;
         }
     } else {
-        if (!read_zipfile1(fname, (void **)&ov->data, &ov->size)) {
+        ov->zs = open_zipstream1(fname);
+        if (!ov->zs) {
             free(ov);
             js_error(J, "Could not open '%s'", fname);
             return;
         }
+        ov->size = size_zipstream(ov->zs);
     }
     if (ov->size % 4 != 0) {
-        free(ov->data);
+        RP_cleanup(ov);
         free(ov);
         js_error(J, "Size not multiple of 4");
         return;
@@ -126,10 +138,20 @@ static void new_Rawplay(js_State *J) {
         ov->buffer_size = 1024 * 4;
     }
 
+    if (ov->zs) {
+        ov->chunk = malloc(ov->buffer_size * sizeof(unsigned short));
+        if (!ov->chunk) {
+            RP_cleanup(ov);
+            free(ov);
+            JS_ENOMEM(J);
+            return;
+        }
+    }
+
     // allocate stream
     ov->stream = play_audio_stream(ov->buffer_size, 16, true, samplerate, 255, 128);
     if (!ov->stream) {
-        free(ov->data);
+        RP_cleanup(ov);
         free(ov);
         JS_ENOMEM(J);
         return;
@@ -171,7 +193,7 @@ static void RP_Close(js_State *J) {
  */
 static void RP_CurrentSample(js_State *J) {
     rawplay_t *ov = js_touserdata(J, 0, TAG_RAWPLAY);
-    if (!ov->data) {
+    if (!ov->data && !ov->zs) {
         js_error(J, "Rawplay is closed");
         return;
     }
@@ -186,7 +208,7 @@ static void RP_CurrentSample(js_State *J) {
  */
 static void RP_Rewind(js_State *J) {
     rawplay_t *ov = js_touserdata(J, 0, TAG_RAWPLAY);
-    if (!ov->data) {
+    if (!ov->data && !ov->zs) {
         js_error(J, "Rawplay is closed");
         return;
     }
@@ -201,7 +223,7 @@ static void RP_Rewind(js_State *J) {
  */
 static void RP_Play(js_State *J) {
     rawplay_t *ov = js_touserdata(J, 0, TAG_RAWPLAY);
-    if (!ov->data) {
+    if (!ov->data && !ov->zs) {
         js_error(J, "Rawplay is closed");
         return;
     }
@@ -211,16 +233,30 @@ static void RP_Play(js_State *J) {
 
     short *mem_chunk = get_audio_stream_buffer(ov->stream);
     if (mem_chunk != NULL) {
+        const unsigned short *src;
+        size_t avail = ov->pos < ov->size ? MIN(ov->buffer_size, ov->size - ov->pos) : 0;
+        if (ov->zs) {
+            // only the samples for this buffer are inflated
+            if (avail && seek_zipstream(ov->zs, ov->pos * sizeof(unsigned short))) {
+                avail = read_zipstream(ov->zs, ov->chunk, avail * sizeof(unsigned short)) / sizeof(unsigned short);
+            } else {
+                avail = 0;
+            }
+            src = ov->chunk;
+        } else {
+            src = &ov->data[ov->pos];
+        }
+
         int idx = 0;
         for (int i = 0; i < ov->buffer_size; i++) {
-            if (ov->pos < ov->size) {
+            if (i < avail) {
                 if (left) {
-                    mem_chunk[idx] = ov->data[ov->pos] ^ 0x8000;
+                    mem_chunk[idx] = src[i] ^ 0x8000;
                 } else {
                     mem_chunk[idx] = 0x00;
                 }
                 if (right) {
-                    mem_chunk[idx + 1] = ov->data[ov->pos] ^ 0x8000;
+                    mem_chunk[idx + 1] = src[i] ^ 0x8000;
                 } else {
                     mem_chunk[idx + 1] = 0x00;
                 }
@@ -241,7 +277,7 @@ static void RP_Play(js_State *J) {
  */
 static void RP_Seek(js_State *J) {
     rawplay_t *ov = js_touserdata(J, 0, TAG_RAWPLAY);
-    if (!ov->data) {
+    if (!ov->data && !ov->zs) {
         js_error(J, "Rawplay is closed");
         return;
     }
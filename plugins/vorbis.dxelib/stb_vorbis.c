@@ -82,6 +82,10 @@
 #include <stdio.h>
 #endif
 
+#ifdef STB_VORBIS_ZIPSTREAM
+#include "zipfile.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -270,6 +274,14 @@ extern stb_vorbis * stb_vorbis_open_memory(const unsigned char *data, int len,
 // create an ogg vorbis decoder from an ogg vorbis stream in memory (note
 // this must be the entire stream!). on failure, returns NULL and sets *error
 
+#ifdef STB_VORBIS_ZIPSTREAM
+extern stb_vorbis * stb_vorbis_open_zipstream(zipstream_t *zs, int close_handle_on_close,
+                                  int *error, const stb_vorbis_alloc *alloc_buffer);
+// create an ogg vorbis decoder from a DOjS ZIP file entry opened with
+// open_zipstream1(). the entry is inflated on demand while decoding, so it
+// never has to be held in memory. on failure, returns NULL and sets *error.
+#endif
+
 #ifndef STB_VORBIS_NO_STDIO
 extern stb_vorbis * stb_vorbis_open_filename(const char *filename,
                                   int *error, const stb_vorbis_alloc *alloc_buffer);
@@ -802,6 +814,9 @@ struct stb_vorbis
    uint32 f_start;
    int close_on_free;
 #endif
+#ifdef STB_VORBIS_ZIPSTREAM
+   zipstream_t *zs;
+#endif
 
    uint8 *stream;
    uint8 *stream_start;
@@ -1341,6 +1356,14 @@ static uint8 get8(vorb *z)
       return *z->stream++;
    }
 
+   #ifdef STB_VORBIS_ZIPSTREAM
+   if (z->zs) {
+      uint8 c;
+      if (read_zipstream(z->zs, &c, 1) != 1) { z->eof = TRUE; return 0; }
+      return c;
+   }
+   #endif
+
    #ifndef STB_VORBIS_NO_STDIO
    {
    int c = fgetc(z->f);
@@ -1369,6 +1392,15 @@ static int getn(vorb *z, uint8 *data, int n)
       return 1;
    }
 
+   #ifdef STB_VORBIS_ZIPSTREAM
+   if (z->zs) {
+      if (read_zipstream(z->zs, data, n) == n)
+         return 1;
+      z->eof = 1;
+      return 0;
+   }
+   #endif
+
    #ifndef STB_VORBIS_NO_STDIO
    if (fread(data, n, 1, z->f) == 1)
       return 1;
@@ -1386,6 +1418,12 @@ static void skip(vorb *z, int n)
       if (z->stream >= z->stream_end) z->eof = 1;
       return;
    }
+   #ifdef STB_VORBIS_ZIPSTREAM
+   if (z->zs) {
+      if (!seek_zipstream(z->zs, tell_zipstream(z->zs) + n)) z->eof = 1;
+      return;
+   }
+   #endif
    #ifndef STB_VORBIS_NO_STDIO
    {
       long x = ftell(z->f);
@@ -1410,6 +1448,15 @@ static int set_file_offset(stb_vorbis *f, unsigned int loc)
          return 1;
       }
    }
+   #ifdef STB_VORBIS_ZIPSTREAM
+   if (f->zs) {
+      if (seek_zipstream(f->zs, loc))
+         return 1;
+      f->eof = 1;
+      seek_zipstream(f->zs, size_zipstream(f->zs));
+      return 0;
+   }
+   #endif
    #ifndef STB_VORBIS_NO_STDIO
    if (loc + f->f_start < loc || loc >= 0x80000000) {
       loc = 0x7fffffff;
@@ -4263,6 +4310,12 @@ static void vorbis_deinit(stb_vorbis *p)
       setup_free(p, p->window[i]);
       setup_free(p, p->bit_reverse[i]);
    }
+   #ifdef STB_VORBIS_ZIPSTREAM
+   if (p->zs) {
+      if (p->close_on_free) close_zipstream(p->zs);
+      return;
+   }
+   #endif
    #ifndef STB_VORBIS_NO_STDIO
    if (p->close_on_free) fclose(p->f);
    #endif
@@ -4292,6 +4345,9 @@ static void vorbis_init(stb_vorbis *p, const stb_vorbis_alloc *z)
    p->close_on_free = FALSE;
    p->f = NULL;
    #endif
+   #ifdef STB_VORBIS_ZIPSTREAM
+   p->zs = NULL;
+   #endif
 }
 
 int stb_vorbis_get_sample_offset(stb_vorbis *f)
@@ -4548,6 +4604,9 @@ unsigned int stb_vorbis_get_file_offset(stb_vorbis *f)
    if (f->push_mode) return 0;
    #endif
    if (USE_MEMORY(f)) return (unsigned int) (f->stream - f->stream_start);
+   #ifdef STB_VORBIS_ZIPSTREAM
+   if (f->zs) return (unsigned int) tell_zipstream(f->zs);
+   #endif
    #ifndef STB_VORBIS_NO_STDIO
    return (unsigned int) (ftell(f->f) - f->f_start);
    #endif
@@ -5096,6 +5155,28 @@ stb_vorbis * stb_vorbis_open_filename(const char *filename, int *error, const st
 }
 #endif // STB_VORBIS_NO_STDIO
 
+#ifdef STB_VORBIS_ZIPSTREAM
+stb_vorbis * stb_vorbis_open_zipstream(zipstream_t *zs, int close_on_free, int *error, const stb_vorbis_alloc *alloc)
+{
+   stb_vorbis *f, p;
+   vorbis_init(&p, alloc);
+   p.zs = zs;
+   p.stream_len   = (uint32) size_zipstream(zs);
+   p.close_on_free = close_on_free;
+   if (start_decoder(&p)) {
+      f = vorbis_alloc(&p);
+      if (f) {
+         *f = p;
+         vorbis_pump_first_frame(f);
+         return f;
+      }
+   }
+   if (error) *error = p.error;
+   vorbis_deinit(&p);
+   return NULL;
+}
+#endif // STB_VORBIS_ZIPSTREAM
+
 stb_vorbis * stb_vorbis_open_memory(const unsigned char *data, int len, int *error, const stb_vorbis_alloc *alloc)
 {
    stb_vorbis *f, p;
@@ -32,6 +32,7 @@ I'll keep it that way for now.
 #include <time.h>
 
 #include "DOjS.h"
+#include "zipfile.h"
 
 // #define STB_VORBIS_MAX_CHANNELS 2
 #define STB_VORBIS_NO_PUSHDATA_API
@@ -102,7 +103,17 @@ static void new_Ogg(js_State *J) {
 
     int err;
     const char *fname = js_tostring(J, 1);
-    ov->ogg = stb_vorbis_open_filename(fname, &err, NULL);
+    char *delim = strchr(fname, ZIP_DELIM);
+    if (!delim) {
+        ov->ogg = stb_vorbis_open_filename(fname, &err, NULL);
+    } else {
+        // stream the entry, it is inflated while playing
+        zipstream_t *zs = open_zipstream1(fname);
+        if (zs) {
+            // the decoder owns the stream now and closes it, even when opening fails
+            ov->ogg = stb_vorbis_open_zipstream(zs, true, &err, NULL);
+        }
+    }
     if (!ov->ogg) {
         free(ov);
         js_error(J, "Could not open '%s'", fname);
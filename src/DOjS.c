@@ -37,12 +37,17 @@ SOFTWARE.
 #include "3dfx-texinfo.h"
 #include "bitmap.h"
 #include "color.h"
+#include "dirty.h"
+#include "drawlist.h"
+#include "imgcache.h"
+#include "imgload.h"
 #include "edit.h"
 #include "file.h"
 #include "font.h"
 #include "flic.h"
 #include "funcs.h"
 #include "gfx.h"
+#include "input.h"
 #include "joystick.h"
 #include "midiplay.h"
 #include "socket.h"
@@ -55,12 +60,23 @@ SOFTWARE.
 #include "intarray.h"
 #include "bytearray.h"
 #include "blender.h"
+#include "bytecode.h"
 #include "ini.h"
 #include "inifile.h"
+#include "strbuild.h"
 
 #define AUTOSTART_FILE "=MAIN.JS"
 #define DOJS_EXE_NAME "DOJS.EXE"
 
+/************
+** structs **
+************/
+//! header in front of every block allocated by dojs_alloc(), the union keeps the payload aligned for doubles
+typedef union {
+    size_t size;   //!< size of the payload
+    double align;  //!< unused
+} alloc_header_t;
+
 /**************
 ** Variables **
 **************/
@@ -92,6 +108,8 @@ static void usage() {
     fputs("    -a             : Disable alpha (speeds up rendering).\n", stderr);
     fputs("    -x             : Allow raw disk write (CAUTION!).\n", stderr);
     fputs("    -t             : Disable TCP-stack.\n", stderr);
+    fputs("    -o             : Disable the bytecode optimizer.\n", stderr);
+    fputs("    -c             : Disable the bytecode cache (" BC_CACHE_DIR ").\n", stderr);
     fputs("    -n             : Disable JSLOG.TXT.\n", stderr);
     fputs("    -j <file>      : Redirect JSLOG.TXT to <file>.\n", stderr);
     fputs("\n", stderr);
@@ -170,78 +188,75 @@ static bool callGlobal(js_State *J, const char *name) {
 }
 
 /**
- * @brief handle input.
+ * @brief handle input. All events since the last frame are delivered, either as one array to InputBatch() or one by one to Input().
  *
  * @param J VM state.
  *
- * @return true if the found event was exit_key.
+ * @return true if one of the events was exit_key.
  * @return false if no or any other event occured.
  */
 static bool callInput(js_State *J) {
-    int key;
     bool ret = false;
+    int num;
 
-    if (keyboard_needs_poll()) {
-        poll_keyboard();
-    }
-    if (mouse_needs_poll()) {
-        poll_mouse();
-    }
-
-    if (keypressed()) {
-        key = readkey();
-        ret = ((key >> 8) == DOjS.exit_key);
-    } else {
-        key = -1;
-        ret = FALSE;
+    const input_event_t *events = collect_input(DOjS.input_batch_available, &num);
+    for (int i = 0; i < num; i++) {
+        if ((events[i].key != -1) && ((events[i].key >> 8) == DOjS.exit_key)) {
+            ret = true;
+        }
     }
 
     // do not call JS if nothing changed or no input function
-    if (!DOjS.input_available || ((key == -1) && (DOjS.last_mouse_x == mouse_x) && (DOjS.last_mouse_y == mouse_y) && (DOjS.last_mouse_b == mouse_b))) {
+    if (!num || !(DOjS.input_available || DOjS.input_batch_available)) {
         return ret;
     }
 
-    // store new values
-    DOjS.last_mouse_x = mouse_x;
-    DOjS.last_mouse_y = mouse_y;
-    DOjS.last_mouse_b = mouse_b;
-
     // call JS
-    js_getglobal(J, CB_INPUT);
-    js_pushnull(J);
-    js_newobject(J);
-    {
-        js_pushnumber(J, mouse_x);
-        js_setproperty(J, -2, "x");
-        js_pushnumber(J, mouse_y);
-        js_setproperty(J, -2, "y");
-        js_pushnumber(J, mouse_b);
-        js_setproperty(J, -2, "buttons");
-        js_pushnumber(J, key);
-        js_setproperty(J, -2, "key");
-        js_pushnumber(J, DOjS.sys_ticks);
-        js_setproperty(J, -2, "ticks");
-    }
-    if (js_pcall(J, 1)) {
-        set_last_error(js_trystring(J, -1, "Error"));
-        LOGF("Error calling Input(): %s\n", DOjS.lastError);
+    if (DOjS.input_batch_available) {
+        js_getglobal(J, CB_INPUT_BATCH);
+        js_pushnull(J);
+        push_input_batch(J, num);
+        if (js_pcall(J, 1)) {
+            set_last_error(js_trystring(J, -1, "Error"));
+            LOGF("Error calling InputBatch(): %s\n", DOjS.lastError);
+        }
+        js_pop(J, 1);
+    } else {
+        // compatibility: one Input() call per keyboard/mouse event
+        for (int i = 0; i < num; i++) {
+            js_getglobal(J, CB_INPUT);
+            js_pushnull(J);
+            push_input_event(J, i);
+            if (js_pcall(J, 1)) {
+                set_last_error(js_trystring(J, -1, "Error"));
+                LOGF("Error calling Input(): %s\n", DOjS.lastError);
+                js_pop(J, 1);
+                break;
+            }
+            js_pop(J, 1);
+        }
     }
-    js_pop(J, 1);
 
     return ret;
 }
 
 /**
- * @brief load and parse a javascript file from ZIP.
+ * @brief load and parse a javascript file from filesystem or ZIP. The compiled script is taken from the bytecode cache when possible.
  *
  * @param J VM state.
  * @param fname fname, ZIP-files using ZIP_DELIM.
  */
-static void dojs_loadfile_zip(js_State *J, const char *fname) {
+static void dojs_loadfile(js_State *J, const char *fname) {
     char *s, *p;
     size_t n;
+    bool ok;
 
-    if (!read_zipfile1(fname, (void **)&s, &n)) {
+    if (strchr(fname, ZIP_DELIM)) {
+        ok = read_zipfile1(fname, (void **)&s, &n);
+    } else {
+        ok = ut_read_file(fname, (void **)&s, &n);
+    }
+    if (!ok) {
         js_error(J, "cannot open file '%s'", fname);
         return;
     }
@@ -258,9 +273,7 @@ static void dojs_loadfile_zip(js_State *J, const char *fname) {
         while (*p && *p != '\n') ++p;
     }
 
-    DEBUGF("Parsing ZIP entry '%s'\n", fname);
-
-    js_loadstring(J, fname, p);
+    bc_loadstring(J, fname, p);
 
     free(s);
     js_endtry(J);
@@ -295,9 +308,9 @@ static void dojs_load_jsboot(js_State *J) {
     }
 }
 
-#ifdef MEMDEBUG
 /**
- * @brief debugging version of js_alloc()
+ * @brief js_alloc() that keeps track of the number of bytes allocated by the JS engine.
+ * Every block carries a small header with its size so free() and realloc() can be accounted, too.
  *
  * @param actx context (unused).
  * @param ptr pointer for remalloc()/free()
@@ -306,49 +319,32 @@ static void dojs_load_jsboot(js_State *J) {
  * @return void* (re)allocated memory
  */
 static void *dojs_alloc(void *actx, void *ptr, int size) {
-    void *ret = NULL;
+    alloc_header_t *hdr = ptr ? ((alloc_header_t *)ptr) - 1 : NULL;
+
     if (size == 0) {
-        free(ptr);
-        ret = NULL;
-        DEBUGF("DBG FREE(0x%p, %d) := 0x%p\n", ptr, size, ret);
-    } else if (!ptr) {
-        DOjS.num_allocs++;
-        ret = malloc((size_t)size);
-        DEBUGF("DBG MALL(0x%p, %d) := 0x%p\n", ptr, size, ret);
-        // if (!ret) {
-        //     LOGF("MALLOC failed");
-        //     exit(1);
-        // }
-    } else {
-        DOjS.num_allocs++;
-        ret = realloc(ptr, (size_t)size);
-        DEBUGF("DBG   RE(0x%p, %d) := 0x%p\n", ptr, size, ret);
-        // if (!ret) {
-        //     LOGF("REALLOC failed");
-        //     exit(1);
-        // }
+        if (hdr) {
+            DOjS.js_bytes -= hdr->size;
+            free(hdr);
+        }
+#ifdef MEMDEBUG
+        DEBUGF("DBG FREE(0x%p, %d) := 0x%p\n", ptr, size, NULL);
+#endif
+        return NULL;
     }
-    return ret;
-}
-#else
-/**
- * @brief debugging version of js_alloc()
- *
- * @param actx context (unused).
- * @param ptr pointer for remalloc()/free()
- * @param size realloc()/malloc() size, 0 for free().
- *
- * @return void* (re)allocated memory
- */
-static void *dojs_alloc(void *actx, void *ptr, int size) {
-    if (size == 0) {
-        free(ptr);
+
+    size_t old_size = hdr ? hdr->size : 0;
+    alloc_header_t *ret = realloc(hdr, sizeof(alloc_header_t) + (size_t)size);
+#ifdef MEMDEBUG
+    DEBUGF("DBG %s(0x%p, %d) := 0x%p\n", hdr ? "  RE" : "MALL", ptr, size, ret ? ret + 1 : NULL);
+#endif
+    if (!ret) {
         return NULL;
     }
     DOjS.num_allocs++;
-    return realloc(ptr, (size_t)size);
+    DOjS.js_bytes += (size_t)size - old_size;
+    ret->size = (size_t)size;
+    return ret + 1;
 }
-#endif
 
 /**
  * @brief call shutdown() on all registered libraries
@@ -380,22 +376,31 @@ static bool check_functions(js_State *J, const char *fname) {
     js_pushglobal(J);
 
     if (!js_hasproperty(J, 0, CB_INPUT)) {
-        DOjS.input_available = true;
+        DOjS.input_available = false;
         LOGF("Function %s not found in %s -> input disabled\n", CB_INPUT, fname);
     } else {
         DOjS.input_available = true;
+        js_pop(J, 1);
+    }
+    DOjS.input_batch_available = js_hasproperty(J, 0, CB_INPUT_BATCH);
+    if (DOjS.input_batch_available) {
+        js_pop(J, 1);
     }
 
     if (!js_hasproperty(J, 0, CB_LOOP)) {
         set_last_error("Script has no " CB_LOOP "() function");
         LOG("Script has no " CB_LOOP "() function\n");
         ret = false;
+    } else {
+        js_pop(J, 1);
     }
 
     if (!js_hasproperty(J, 0, CB_SETUP)) {
         set_last_error("Script has no " CB_SETUP "() function");
         LOG("Script has no " CB_SETUP "() function\n");
         ret = false;
+    } else {
+        js_pop(J, 1);
     }
 
     js_pop(J, 1);
@@ -431,6 +436,8 @@ static void run_script(int argc, char **argv, int args) {
 
     // (re)init out DOjS struct
     DOjS.num_allocs = 0;
+    DOjS.js_bytes = 0;
+    DOjS.native_bytes = 0;
     DOjS.exit_key = KEY_ESC;  // the exit key that will stop the script
     DOjS.sys_ticks = 0;
     DOjS.glide_enabled = false;
@@ -439,7 +446,7 @@ static void run_script(int argc, char **argv, int args) {
     clear_last_error();
 
     // create VM
-    J = js_newstate(dojs_alloc, NULL, 0);
+    J = js_newstate(dojs_alloc, NULL, DOjS.params.no_optimizer ? JS_NOOPTIMIZE : 0);
     js_atpanic(J, Panic);
     js_setreport(J, Report);
 
@@ -467,13 +474,19 @@ static void run_script(int argc, char **argv, int args) {
     } else {
         LOGF("NO Mouse detected: %s\n", allegro_error);
     }
+    init_input();
     PROPDEF_B(J, DOjS.mouse_available, "MOUSE_AVAILABLE");
     init_sound(J);  // sound init must be before midi init!
     init_midi(J);
     init_funcs(J, argc, argv, args);  // must be called after initalizing the booleans above!
+    init_gcpacer(J);
     init_lowlevel(J);
     init_gfx(J);
+    init_dirty(J);
+    init_drawlist(J);
     init_color(J);
+    init_imgcache(J);
+    init_imgload(J);
     init_bitmap(J);
     init_font(J);
     init_file(J);
@@ -488,6 +501,7 @@ static void run_script(int argc, char **argv, int args) {
     init_bytearray(J);
     init_flic(J);
     init_inifile(J);
+    init_strbuild(J);
 
     // create canvas
     bool screenSuccess = true;
@@ -522,6 +536,7 @@ static void run_script(int argc, char **argv, int args) {
         DOjS.render_bm = DOjS.current_bm = create_bitmap(SCREEN_W, SCREEN_H);
         clear_bitmap(DOjS.render_bm);
         DOjS.transparency_available = DOjS.params.no_alpha ? BLEND_REPLACE : BLEND_ALPHA;
+        init_blender();
         dojs_update_transparency();
 
         DEBUGF("GFX_Capabilities=%08X\n", gfx_capabilities);
@@ -539,14 +554,7 @@ static void run_script(int argc, char **argv, int args) {
                     // call loop() until someone calls Stop()
                     while (DOjS.keep_running) {
                         long start = DOjS.sys_ticks;
-                        if (DOjS.num_allocs > 1000) {
-#ifdef MEMDEBUG
-                            js_gc(J, 1);
-#else
-                            js_gc(J, 0);
-#endif
-                            DOjS.num_allocs = 0;
-                        }
+                        gc_check(J);
                         tick_socket();
                         if (!callGlobal(J, CB_LOOP)) {
                             if (!DOjS.lastError) {
@@ -560,10 +568,20 @@ static void run_script(int argc, char **argv, int args) {
                         if (DOjS.glide_enabled) {
                             grBufferSwap(1);
                         } else {
-                            blit(DOjS.render_bm, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+                            dirty_present();
                             if (DOjS.mouse_visible) {
                                 show_mouse(screen);
                             }
+                            flic_record_frame();
+                        }
+                        // advance an incremental GC cycle within the per-frame budget
+                        gc_frame(J);
+                        // decode images requested by LoadBitmapAsync() in the remaining frame time
+                        if (!imgload_tick(J, (1000 / DOjS.wanted_frame_rate) - (long)(DOjS.sys_ticks - start))) {
+                            set_last_error(js_trystring(J, -1, "Error"));
+                            LOGF("Error calling LoadBitmapAsync() callback: %s\n", DOjS.lastError);
+                            js_pop(J, 1);
+                            break;
                         }
                         long end = DOjS.sys_ticks;
                         long runtime = (end - start) + 1;
@@ -590,11 +608,13 @@ static void run_script(int argc, char **argv, int args) {
     }
     LOG("DOjS Shutdown...\n");
     js_freestate(J);
+    shutdown_imgload();
     dojs_shutdown_libraries();
     shutdown_flic();
     shutdown_midi();
     shutdown_sound();
     shutdown_joystick();
+    shutdown_input();
     shutdown_3dfx();
     if (DOjS.logfile) {
         fclose(DOjS.logfile);
@@ -642,24 +662,18 @@ int dojs_do_zipfile(js_State *J, const char *zipname, const char *fname) {
  * @return int TRUE if successfull, FALSE if not.
  */
 int dojs_do_file(js_State *J, const char *fname) {
-    char *delim = strchr(fname, ZIP_DELIM);
-    if (!delim) {
-        DEBUGF("Parsing plain file '%s'\n", fname);
-        return js_dofile(J, fname);
-    } else {
-        DEBUGF("Parsing ZIP file '%s'\n", fname);
-        if (js_try(J)) {
-            js_report(J, js_trystring(J, -1, "Error"));
-            js_pop(J, 1);
-            return 1;
-        }
-        dojs_loadfile_zip(J, fname);
-        js_pushundefined(J);
-        js_call(J, 0);
+    DEBUGF("Parsing file '%s'\n", fname);
+    if (js_try(J)) {
+        js_report(J, js_trystring(J, -1, "Error"));
         js_pop(J, 1);
-        js_endtry(J);
-        return 0;
+        return 1;
     }
+    dojs_loadfile(J, fname);
+    js_pushundefined(J);
+    js_call(J, 0);
+    js_pop(J, 1);
+    js_endtry(J);
+    return 0;
 }
 
 /**
@@ -730,52 +744,7 @@ bool dojs_check_library(const char *name) {
  * @brief set the active blender func from DOjS.transparency_available
  */
 void dojs_update_transparency() {
-    BLENDER_FUNC bfunc = NULL;
-    switch (DOjS.transparency_available) {
-        case BLEND_ALPHA:
-            bfunc = blender_alpha;
-            break;
-        case BLEND_ADD:
-            bfunc = blender_add;
-            break;
-        case BLEND_DARKEST:
-            bfunc = blender_darkest;
-            break;
-        case BLEND_LIGHTEST:
-            bfunc = blender_lightest;
-            break;
-        case BLEND_DIFFERENCE:
-            bfunc = blender_difference;
-            break;
-        case BLEND_EXCLUSION:
-            bfunc = blender_exclusion;
-            break;
-        case BLEND_MULTIPLY:
-            bfunc = blender_multiply;
-            break;
-        case BLEND_SCREEN:
-            bfunc = blender_screen;
-            break;
-        case BLEND_OVERLAY:
-            bfunc = blender_overlay;
-            break;
-        case BLEND_HARDLIGHT:
-            bfunc = blender_hardlight;
-            break;
-        case BLEND_DOGE:
-            bfunc = blender_doge;
-            break;
-        case BLEND_BURN:
-            bfunc = blender_burn;
-            break;
-        case BLEND_SUBSTRACT:
-            bfunc = blender_substract;
-            break;
-        default:
-            bfunc = NULL;
-            break;
-    }
-
+    BLENDER_FUNC bfunc = blender_select(DOjS.transparency_available);
     if (bfunc) {
         set_blender_mode(bfunc, bfunc, bfunc, 0, 0, 0, 0);
         drawing_mode(DRAW_MODE_TRANS, DOjS.render_bm, 0, 0);
@@ -870,6 +839,16 @@ int main(int argc, char **argv) {
             DOjS.params.no_alpha = true;
         }
 
+        value = ini_get(config, NULL, "o");
+        if (value) {
+            DOjS.params.no_optimizer = true;
+        }
+
+        value = ini_get(config, NULL, "c");
+        if (value) {
+            DOjS.params.no_bccache = true;
+        }
+
         value = ini_get(config, NULL, "x");
         if (value) {
             DOjS.params.raw_write = true;
@@ -890,7 +869,7 @@ int main(int argc, char **argv) {
 
     // check command line parameters
     int opt;
-    while ((opt = getopt(argc, argv, "tnxlrsfahw:b:j:")) != -1) {
+    while ((opt = getopt(argc, argv, "tnxlrsfaochw:b:j:")) != -1) {
         switch (opt) {
             case 'w':
                 DOjS.params.width = atoi(optarg);
@@ -916,6 +895,12 @@ int main(int argc, char **argv) {
             case 'a':
                 DOjS.params.no_alpha = true;
                 break;
+            case 'o':
+                DOjS.params.no_optimizer = true;
+                break;
+            case 'c':
+                DOjS.params.no_bccache = true;
+                break;
             case 'x':
                 DOjS.params.raw_write = true;
                 break;
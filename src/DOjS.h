@@ -28,12 +28,15 @@ SOFTWARE.
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "gcpacer.h"
+
 /************
 ** defines **
 ************/
-#define CB_SETUP "Setup"  //!< name of setup function (required)
-#define CB_LOOP "Loop"    //!< name of loop function (required)
-#define CB_INPUT "Input"  //!< name of input function (optional)
+#define CB_SETUP "Setup"             //!< name of setup function (required)
+#define CB_LOOP "Loop"               //!< name of loop function (required)
+#define CB_INPUT "Input"             //!< name of input function (optional)
+#define CB_INPUT_BATCH "InputBatch"  //!< name of batched input function (optional, replaces Input())
 
 #define SYSINFO ">>> "  //!< logfile line prefix for system messages
 
@@ -167,7 +170,7 @@ SOFTWARE.
 #endif
 
 #ifdef GC_BEFORE_MALLOC
-#define NEW_OBJECT_PREP(j) js_gc(j, false)
+#define NEW_OBJECT_PREP(j) gc_check(j)
 #else
 #define NEW_OBJECT_PREP(j)
 #endif
@@ -212,6 +215,8 @@ typedef struct {
     bool highres;        //!< use 50-line mode in editor
     bool raw_write;      //!< allow raw writes in JS
     bool no_tcpip;       //!< disable Watt32 TCP stack
+    bool no_optimizer;   //!< disable the bytecode optimizer
+    bool no_bccache;     //!< disable the bytecode cache
     int width;           //!< requested screen with
     int bpp;             //!< requested bit depth
 } cmd_params_t;
@@ -238,12 +243,15 @@ typedef struct {
     volatile unsigned long sys_ticks;     //!< tick counter
     FILE *logfile;                        //!< file for log output.
     char *lastError;                      //!< last error message generated by Report()
-    int num_allocs;                       //!< number of allocations for extra GC runs
+    int num_allocs;                       //!< number of allocations since start
+    size_t js_bytes;                      //!< number of bytes currently allocated by the JS engine
+    size_t native_bytes;                  //!< number of bytes of native memory owned by JS objects
     library_t *loaded_libraries;          //!< linked list of loaded libraries
     int last_mouse_x;                     //!< last reported mouse pos X
     int last_mouse_y;                     //!< last reported mouse pos y
     int last_mouse_b;                     //!< last reported mouse button
     bool input_available;                 //!< indicates if the input callback function is available
+    bool input_batch_available;           //!< indicates if the batched input callback function is available
     char *exitMessage;                    //!< a message to print to the console when DOjS shuts down
     const char *jsboot;                   //!< path/name of jsboot-file.
 } dojs_t;
@@ -23,13 +23,22 @@ SOFTWARE.
 #include "bitmap.h"
 
 #include <allegro.h>
+#include <allegro/internal/aintern.h>
 #include <mujs.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "3dfx-glide.h"
 #include "DOjS.h"
+#include "blender.h"
+#include "bytearray.h"
 #include "color.h"
+#include "dirty.h"
+#include "imgcache.h"
+#include "imgload.h"
+#include "intarray.h"
+#include "qoi.h"
 #include "util.h"
 #include "zipfile.h"
 
@@ -37,9 +46,99 @@ SOFTWARE.
 #include <glide.h>
 #endif
 
+/************
+** structs **
+************/
+//! array-like view on the pixels of a 32bpp Bitmap
+typedef struct {
+    BITMAP *bm;  //!< the bitmap or NULL after UnlockPixels()
+    int stride;  //!< distance between two lines in pixels
+    bool bytes;  //!< the view has four entries (R, G, B, A) per pixel instead of one ARGB value
+} pixelview_t;
+
 /*********************
 ** static functions **
 *********************/
+/**
+ * @brief calculate the amount of memory used by the pixel data of a bitmap.
+ *
+ * @param bm the bitmap.
+ *
+ * @return size_t number of bytes.
+ */
+static size_t Bitmap_size(BITMAP *bm) { return (size_t)bm->w * bm->h * ((bitmap_color_depth(bm) + 7) / 8); }
+
+/**
+ * @brief write a row of 32bpp pixels into a bitmap. The pixels are converted to the color depth of the bitmap
+ * and the current drawing mode is honored (like putpixel() would do).
+ *
+ * @param bm destination bitmap.
+ * @param x start x.
+ * @param y y position.
+ * @param src the pixels.
+ * @param n number of pixels.
+ */
+static void Bitmap_putRow(BITMAP *bm, int x, int y, const uint32_t *src, int n) {
+    // clip like putpixel()
+    int cl = 0, cr = bm->w, ct = 0, cb = bm->h;
+    if (bm->clip) {
+        cl = bm->cl;
+        cr = bm->cr;
+        ct = bm->ct;
+        cb = bm->cb;
+    }
+    if (y < ct || y >= cb) {
+        return;
+    }
+    if (x < cl) {
+        src += cl - x;
+        n -= cl - x;
+        x = cl;
+    }
+    if (x + n > cr) {
+        n = cr - x;
+    }
+    if (n <= 0) {
+        return;
+    }
+
+    if (is_memory_bitmap(bm) && _drawing_mode == DRAW_MODE_SOLID) {
+        switch (bitmap_color_depth(bm)) {
+            case 32:
+                memcpy((uint32_t *)bm->line[y] + x, src, n * sizeof(uint32_t));
+                return;
+            case 24: {
+                uint8_t *d = bm->line[y] + x * 3;
+                for (int i = 0; i < n; i++) {
+                    int c = makecol24(getr32(src[i]), getg32(src[i]), getb32(src[i]));
+                    *d++ = c & 0xFF;
+                    *d++ = (c >> 8) & 0xFF;
+                    *d++ = (c >> 16) & 0xFF;
+                }
+                return;
+            }
+            case 16:
+            case 15: {
+                int depth = bitmap_color_depth(bm);
+                uint16_t *d = (uint16_t *)bm->line[y] + x;
+                for (int i = 0; i < n; i++) {
+                    d[i] = makecol_depth(depth, getr32(src[i]), getg32(src[i]), getb32(src[i]));
+                }
+                return;
+            }
+            default:
+                break;
+        }
+    } else if (bitmap_color_depth(bm) == 32 && blender_blend_row(bm, (uint32_t *)bm->line[y] + x, src, n)) {
+        return;
+    }
+
+    // video bitmaps, 8bpp and XOR/pattern modes
+    for (int i = 0; i < n; i++) {
+        putpixel(bm, x + i, y, src[i]);
+    }
+}
+
 /**
  * @brief finalize an image and free resources.
  *
@@ -56,6 +155,10 @@ static void Bitmap_Finalize(js_State *J, void *data) {
         LOG("GC of current render Bitmap!");
     }
 
+    // Bitmaps sharing their pixels with the image cache only own the BITMAP struct
+    if (!imgcache_release(bm)) {
+        gc_native_free(Bitmap_size(bm));
+    }
     destroy_bitmap(bm);
 }
 
@@ -63,7 +166,7 @@ static void Bitmap_Finalize(js_State *J, void *data) {
  * @brief load an image or create an empty bitmap.
  * new Bitmap(filename:string)
  * new Bitmap(width:number, height:number)
- * new Bitmap(data:number[], width:number, height:number)
+ * new Bitmap(data:number[]|IntArray|ByteArray, width:number, height:number)
  * new Bitmap(x:number, y:number, width:number, height:number)
  * new Bitmap(x:number, y:number, width:number, height:number, buffer:GR_BUFFER)
  *
@@ -73,6 +176,7 @@ static void new_Bitmap(js_State *J) {
     NEW_OBJECT_PREP(J);
     const char *fname = "<<buffer>>";
     BITMAP *bm = NULL;
+    bool cached = false;
     if (js_isnumber(J, 1) && js_isnumber(J, 2) && js_isnumber(J, 3) && js_isnumber(J, 4) && js_isnumber(J, 5)) {
         int x = js_tonumber(J, 1);
         int y = js_tonumber(J, 2);
@@ -151,7 +255,11 @@ static void new_Bitmap(js_State *J) {
 
         char *delim = strchr(fname, ZIP_DELIM);
 
-        if (!delim) {
+        bm = imgcache_get(fname);
+        if (bm) {
+            cached = true;
+        } else if (!delim) {
+            imgload_sync();  // the decoders are not reentrant
             bm = load_bitmap(fname, NULL);
             if (!bm) {
                 js_error(J, "Can't load image '%s'", fname);
@@ -163,6 +271,7 @@ static void new_Bitmap(js_State *J) {
                 js_error(J, "Can't load image '%s'", fname);
                 return;
             }
+            imgload_sync();  // the decoders are not reentrant
             bm = load_bitmap_pf(pf, NULL, ut_getFilenameExt(fname));
             pack_fclose(pf);
 
@@ -171,8 +280,12 @@ static void new_Bitmap(js_State *J) {
                 return;
             }
         }
-    } else if (js_isarray(J, 1) && js_isnumber(J, 2) && js_isnumber(J, 3)) {
-        // new Bitmap(data[], width, height)
+        if (!cached) {
+            bm = imgcache_put(fname, bm);
+            cached = is_sub_bitmap(bm);
+        }
+    } else if ((js_isarray(J, 1) || js_isuserdata(J, 1, TAG_INT_ARRAY) || js_isuserdata(J, 1, TAG_BYTE_ARRAY)) && js_isnumber(J, 2) && js_isnumber(J, 3)) {
+        // new Bitmap(data[]|IntArray|ByteArray, width, height)
         int w = js_tonumber(J, 2);
         int h = js_tonumber(J, 3);
         bm = create_bitmap_ex(32, w, h);
@@ -182,18 +295,20 @@ static void new_Bitmap(js_State *J) {
             return;
         }
         clear_bitmap(bm);
-        int arr_len = js_getlength(J, 1);
-        int len = arr_len < w * h ? arr_len : w * h;
-        for (int i = 0; i < len; i++) {
-            js_getindex(J, 1, i);
-            putpixel(bm, i % w, i / w, js_touint32(J, -1));
-            js_pop(J, 1);
+        if (js_try(J)) {
+            destroy_bitmap(bm);
+            js_throw(J);
         }
+        Bitmap_putPixels(J, 1, bm, 0, 0, w, h);
+        js_endtry(J);
     } else {
         js_error(J, "Unsupported contructor call.");
         return;
     }
 
+    if (!cached) {
+        gc_native_alloc(Bitmap_size(bm));
+    }
     js_currentfunction(J);
     js_getproperty(J, -1, "prototype");
     js_newuserdata(J, TAG_BITMAP, bm, Bitmap_Finalize);
@@ -220,6 +335,7 @@ static void Bitmap_Draw(js_State *J) {
     int x = js_toint16(J, 1);
     int y = js_toint16(J, 2);
     blit(bm, DOjS.current_bm, 0, 0, x, y, bm->w, bm->h);
+    dirty_add(DOjS.current_bm, x, y, x + bm->w - 1, y + bm->h - 1);
 }
 
 /**
@@ -240,6 +356,7 @@ static void Bitmap_DrawAdvanced(js_State *J) {
     int destW = js_toint16(J, 7);
     int destH = js_toint16(J, 8);
     stretch_blit(bm, DOjS.current_bm, srcX, srcY, srcW, srcH, destX, destY, destW, destH);
+    dirty_add(DOjS.current_bm, destX, destY, destX + destW - 1, destY + destH - 1);
 }
 
 /**
@@ -250,6 +367,10 @@ static void Bitmap_DrawAdvanced(js_State *J) {
  */
 static void Bitmap_Clear(js_State *J) {
     BITMAP *bm = js_touserdata(J, 0, TAG_BITMAP);
+    if (!imgcache_own(bm)) {
+        JS_ENOMEM(J);
+        return;
+    }
     clear_bitmap(bm);
 }
 
@@ -264,6 +385,7 @@ static void Bitmap_DrawTrans(js_State *J) {
     int x = js_toint16(J, 1);
     int y = js_toint16(J, 2);
     draw_trans_sprite(DOjS.current_bm, bm, x, y);
+    dirty_add(DOjS.current_bm, x, y, x + bm->w - 1, y + bm->h - 1);
 }
 
 #ifdef LFB_3DFX
@@ -319,6 +441,197 @@ static void Bitmap_GetPixel(js_State *J) {
     js_pushnumber(J, getpixel(bm, x, y) | 0xFF000000);  // no alpha in bitmaps so far
 }
 
+/**
+ * @brief finalize a pixel view.
+ *
+ * @param J VM state.
+ * @param data the pixelview_t.
+ */
+static void PixelView_Finalize(js_State *J, void *data) { free(data); }
+
+/**
+ * @brief find the pixel for a view index.
+ *
+ * @param J VM state.
+ * @param pv the view.
+ * @param i the index.
+ *
+ * @return uint32_t* the pixel or NULL if the index is out of range.
+ */
+static uint32_t *PixelView_pixel(js_State *J, pixelview_t *pv, int i) {
+    if (!pv->bm) {
+        js_error(J, "Bitmap pixels are not locked");
+        return NULL;
+    }
+    if (pv->bytes) {
+        i /= 4;
+    }
+    int y = i / pv->stride;
+    int x = i - y * pv->stride;
+    if (y >= pv->bm->h || x >= pv->bm->w) {
+        return NULL;
+    }
+    return (uint32_t *)pv->bm->line[y] + x;
+}
+
+/**
+ * @brief read view[i].
+ *
+ * @param J VM state.
+ * @param data the pixelview_t.
+ * @param i the index.
+ *
+ * @return int 1 if the index was handled.
+ */
+static int PixelView_GetIndex(js_State *J, void *data, int i) {
+    static const int shift[] = {16, 8, 0, 24};  // R, G, B, A
+    pixelview_t *pv = data;
+    uint32_t *px = PixelView_pixel(J, pv, i);
+    if (!px) {
+        return 0;
+    }
+    if (pv->bytes) {
+        js_pushnumber(J, (*px >> shift[i & 3]) & 0xFF);
+    } else {
+        js_pushnumber(J, *px);
+    }
+    return 1;
+}
+
+/**
+ * @brief write view[i].
+ *
+ * @param J VM state.
+ * @param data the pixelview_t.
+ * @param i the index.
+ *
+ * @return int 1 if the index was handled.
+ */
+static int PixelView_PutIndex(js_State *J, void *data, int i) {
+    static const int shift[] = {16, 8, 0, 24};  // R, G, B, A
+    pixelview_t *pv = data;
+    uint32_t *px = PixelView_pixel(J, pv, i);
+    if (!px) {
+        return 0;
+    }
+    if (pv->bytes) {
+        int s = shift[i & 3];
+        *px = (*px & ~(0xFFUL << s)) | ((js_touint32(J, -1) & 0xFF) << s);
+    } else {
+        *px = js_touint32(J, -1);
+    }
+    return 1;
+}
+
+/**
+ * @brief invalidate the pixel view of a Bitmap (if any).
+ *
+ * @param J VM state.
+ */
+static void Bitmap_unlockView(js_State *J) {
+    js_getproperty(J, 0, "__pixels__");
+    if (js_isuserdata(J, -1, TAG_PIXELVIEW)) {
+        pixelview_t *pv = js_touserdata(J, -1, TAG_PIXELVIEW);
+        pv->bm = NULL;
+    }
+    js_pop(J, 1);
+    js_pushnull(J);
+    js_defproperty(J, 0, "__pixels__", JS_DONTENUM);
+}
+
+/**
+ * @brief get direct access to the pixels of a 32bpp Bitmap.
+ * img.LockPixels([bytes:boolean]):PixelView
+ *
+ * @param J VM state.
+ */
+static void Bitmap_LockPixels(js_State *J) {
+    BITMAP *bm = js_touserdata(J, 0, TAG_BITMAP);
+    bool bytes = js_toboolean(J, 1);
+
+    if (bitmap_color_depth(bm) != 32 || !is_memory_bitmap(bm)) {
+        js_error(J, "LockPixels() needs a 32bpp Bitmap");
+        return;
+    }
+    if (!imgcache_own(bm)) {
+        JS_ENOMEM(J);
+        return;
+    }
+
+    Bitmap_unlockView(J);
+
+    pixelview_t *pv = malloc(sizeof(pixelview_t));
+    if (!pv) {
+        JS_ENOMEM(J);
+        return;
+    }
+    pv->bm = bm;
+    pv->stride = bm->h > 1 ? (int)((bm->line[1] - bm->line[0]) / sizeof(uint32_t)) : bm->w;
+    pv->bytes = bytes;
+
+    js_newobject(J);
+    js_newuserdatai(J, TAG_PIXELVIEW, pv, PixelView_GetIndex, PixelView_PutIndex, PixelView_Finalize);
+
+    // the view keeps the Bitmap alive
+    js_copy(J, 0);
+    js_defproperty(J, -2, "bitmap", JS_READONLY | JS_DONTENUM | JS_DONTCONF);
+
+    js_pushnumber(J, bm->w);
+    js_defproperty(J, -2, "width", JS_READONLY | JS_DONTCONF);
+
+    js_pushnumber(J, bm->h);
+    js_defproperty(J, -2, "height", JS_READONLY | JS_DONTCONF);
+
+    js_pushnumber(J, bytes ? pv->stride * 4 : pv->stride);
+    js_defproperty(J, -2, "stride", JS_READONLY | JS_DONTCONF);
+
+    js_pushnumber(J, (bytes ? pv->stride * 4 : pv->stride) * bm->h);
+    js_defproperty(J, -2, "length", JS_READONLY | JS_DONTCONF);
+
+    js_copy(J, -1);
+    js_defproperty(J, 0, "__pixels__", JS_DONTENUM);
+}
+
+/**
+ * @brief end direct access to the pixels and mark the Bitmap as changed.
+ * img.UnlockPixels()
+ *
+ * @param J VM state.
+ */
+static void Bitmap_UnlockPixels(js_State *J) {
+    BITMAP *bm = js_touserdata(J, 0, TAG_BITMAP);
+    Bitmap_unlockView(J);
+    dirty_add_all(bm);
+}
+
+/**
+ * @brief get an ArrayBuffer over the pixels of a 32bpp Bitmap (ARGB, one Uint32 per pixel, no copy).
+ * Writes are not tracked: when the Bitmap is the current render destination call UnlockPixels() after writing to mark it as changed.
+ * img.GetBuffer():ArrayBuffer
+ *
+ * @param J VM state.
+ */
+static void Bitmap_GetBuffer(js_State *J) {
+    BITMAP *bm = js_touserdata(J, 0, TAG_BITMAP);
+
+    if (bitmap_color_depth(bm) != 32 || !is_memory_bitmap(bm)) {
+        js_error(J, "GetBuffer() needs a 32bpp Bitmap");
+        return;
+    }
+    // Bitmaps from the image cache are sub-bitmaps until they get their own copy of the pixels
+    if (!imgcache_own(bm)) {
+        JS_ENOMEM(J);
+        return;
+    }
+    if (is_sub_bitmap(bm)) {
+        js_error(J, "GetBuffer() does not work on sub-bitmaps");
+        return;
+    }
+
+    // memory bitmaps keep their lines in one block, the buffer keeps the Bitmap alive
+    js_newarraybufferx(J, 0, bm->line[0], bm->w * bm->h * sizeof(uint32_t));
+}
+
 /**
  * @brief save Bitmap to file.
  * SaveBmpImage(fname:string)
@@ -373,6 +686,24 @@ static void Bitmap_SaveTgaImage(js_State *J) {
     }
 }
 
+/**
+ * @brief save Bitmap to file.
+ * SaveQoiImage(fname:string)
+ *
+ * @param J the JS context.
+ */
+static void Bitmap_SaveQoiImage(js_State *J) {
+    BITMAP *bm = js_touserdata(J, 0, TAG_BITMAP);
+    const char *fname = js_tostring(J, 1);
+
+    PALETTE pal;
+    get_palette(pal);
+
+    if (save_qoi(fname, bm, (const struct RGB *)&pal) != 0) {
+        js_error(J, "Can't save Bitmap to QOI file '%s'", fname);
+    }
+}
+
 /***********************
 ** exported functions **
 ***********************/
@@ -397,16 +728,21 @@ void Bitmap_fromRGBA(js_State *J, const uint8_t *data, int w, int h) {
         return;
     }
     clear_bitmap(bm);
-    int len = w * h * 4 * sizeof(uint8_t);
-    int idx = 0;
-    for (int i = 0; i < len; i++) {
-        int r = data[idx++];
-        int g = data[idx++];
-        int b = data[idx++];
-        int a = data[idx++];
-        putpixel(bm, i % w, i / w, makeacol32(r, g, b, a));
+    uint32_t *row = malloc(w * sizeof(uint32_t));
+    if (!row) {
+        destroy_bitmap(bm);
+        JS_ENOMEM(J);
+        return;
     }
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++, data += 4) {
+            row[x] = makeacol32(data[0], data[1], data[2], data[3]);
+        }
+        Bitmap_putRow(bm, 0, y, row, w);
+    }
+    free(row);
 
+    gc_native_alloc(Bitmap_size(bm));
     js_currentfunction(J);
     js_getproperty(J, -1, "prototype");
     js_newuserdata(J, TAG_BITMAP, bm, Bitmap_Finalize);
@@ -422,6 +758,80 @@ void Bitmap_fromRGBA(js_State *J, const uint8_t *data, int w, int h) {
     js_defproperty(J, -2, "height", JS_READONLY | JS_DONTCONF);
 }
 
+/**
+ * @brief copy pixels from an Array of colors, an IntArray of colors or a ByteArray with RGBA bytes into a bitmap.
+ * The data is converted and written row by row.
+ *
+ * @param J VM state.
+ * @param idx stack index of the pixel data.
+ * @param bm destination bitmap.
+ * @param x destination x.
+ * @param y destination y.
+ * @param w width of the pixel data.
+ * @param h height of the pixel data.
+ *
+ * @return int the number of pixels copied.
+ */
+int Bitmap_putPixels(js_State *J, int idx, BITMAP *bm, int x, int y, int w, int h) {
+    const IA_TYPE *ints = NULL;
+    const BA_TYPE *bytes = NULL;
+    int num;
+
+    if (js_isuserdata(J, idx, TAG_INT_ARRAY)) {
+        int_array_t *ia = js_touserdata(J, idx, TAG_INT_ARRAY);
+        ints = ia->data;
+        num = ia->size;
+    } else if (js_isuserdata(J, idx, TAG_BYTE_ARRAY)) {
+        byte_array_t *ba = js_touserdata(J, idx, TAG_BYTE_ARRAY);
+        bytes = ba->data;
+        num = ba->size / 4;
+    } else if (js_isarray(J, idx)) {
+        num = js_getlength(J, idx);
+    } else {
+        js_error(J, "Pixel data must be an Array, IntArray or ByteArray");
+        return 0;
+    }
+
+    if (w <= 0 || h <= 0) {
+        return 0;
+    }
+    int len = num < w * h ? num : w * h;
+
+    uint32_t *row = NULL;
+    if (!ints) {
+        row = malloc(w * sizeof(uint32_t));
+        if (!row) {
+            JS_ENOMEM(J);
+            return 0;
+        }
+    }
+
+    for (int r = 0; r * w < len; r++) {
+        int n = MIN(w, len - r * w);
+        const uint32_t *src;
+        if (ints) {
+            src = (const uint32_t *)&ints[r * w];
+        } else if (bytes) {
+            const BA_TYPE *b = &bytes[r * w * 4];
+            for (int i = 0; i < n; i++, b += 4) {
+                row[i] = makeacol32(b[0], b[1], b[2], b[3]);
+            }
+            src = row;
+        } else {
+            for (int i = 0; i < n; i++) {
+                js_getindex(J, idx, r * w + i);
+                row[i] = js_touint32(J, -1);
+                js_pop(J, 1);
+            }
+            src = row;
+        }
+        Bitmap_putRow(bm, x, y + r, src, n);
+    }
+    free(row);
+
+    return len;
+}
+
 /**
  * @brief initialize bitmap subsystem.
  *
@@ -430,6 +840,9 @@ void Bitmap_fromRGBA(js_State *J, const uint8_t *data, int w, int h) {
 void init_bitmap(js_State *J) {
     DEBUGF("%s\n", __PRETTY_FUNCTION__);
 
+    // QOI is built in, new Bitmap("x.qoi") works for files and ZIP entries like all other formats
+    register_bitmap_file_type("qoi", load_qoi, save_qoi, load_qoi_pf);
+
     // define the Bitmap() object
     js_newobject(J);
     {
@@ -438,9 +851,13 @@ void init_bitmap(js_State *J) {
         NPROTDEF(J, Bitmap, Clear, 0);
         NPROTDEF(J, Bitmap, DrawTrans, 2);
         NPROTDEF(J, Bitmap, GetPixel, 2);
+        NPROTDEF(J, Bitmap, LockPixels, 1);
+        NPROTDEF(J, Bitmap, UnlockPixels, 0);
+        NPROTDEF(J, Bitmap, GetBuffer, 0);
         NPROTDEF(J, Bitmap, SaveBmpImage, 1);
         NPROTDEF(J, Bitmap, SavePcxImage, 1);
         NPROTDEF(J, Bitmap, SaveTgaImage, 1);
+        NPROTDEF(J, Bitmap, SaveQoiImage, 1);
 #ifdef LFB_3DFX
         NPROTDEF(J, Bitmap, FxDrawLfb, 4);
 #endif
@@ -449,3 +866,31 @@ void init_bitmap(js_State *J) {
 
     DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
 }
+
+/**
+ * @brief push a new Bitmap object for an existing BITMAP. Used to pass images to the script outside of a 'new Bitmap()' call.
+ *
+ * @param J VM state.
+ * @param bm the BITMAP, the Bitmap object owns it afterwards.
+ * @param fname value of the 'filename' property.
+ * @param cached true if bm shares its pixels with the image cache.
+ */
+void Bitmap_push(js_State *J, BITMAP *bm, const char *fname, bool cached) {
+    if (!cached) {
+        gc_native_alloc(Bitmap_size(bm));
+    }
+    js_getglobal(J, TAG_BITMAP);
+    js_getproperty(J, -1, "prototype");
+    js_newuserdata(J, TAG_BITMAP, bm, Bitmap_Finalize);
+    js_rot2pop1(J);
+
+    // add properties
+    js_pushstring(J, fname);
+    js_defproperty(J, -2, "filename", JS_READONLY | JS_DONTCONF);
+
+    js_pushnumber(J, bm->w);
+    js_defproperty(J, -2, "width", JS_READONLY | JS_DONTCONF);
+
+    js_pushnumber(J, bm->h);
+    js_defproperty(J, -2, "height", JS_READONLY | JS_DONTCONF);
+}
@@ -28,12 +28,15 @@ SOFTWARE.
 /************
 ** defines **
 ************/
-#define TAG_BITMAP "Bitmap"  //!< class name for Bitmap()
+#define TAG_BITMAP "Bitmap"        //!< class name for Bitmap()
+#define TAG_PIXELVIEW "PixelView"  //!< class name for Bitmap.LockPixels() views
 
 /***********************
 ** exported functions **
 ***********************/
 extern void init_bitmap(js_State *J);
 extern void Bitmap_fromRGBA(js_State *J, const uint8_t *data, int w, int h);
+extern void Bitmap_push(js_State *J, BITMAP *bm, const char *fname, bool cached);
+extern int Bitmap_putPixels(js_State *J, int idx, BITMAP *bm, int x, int y, int w, int h);
 
 #endif  // __BITMAP_H__
@@ -23,6 +23,11 @@ SOFTWARE.
 
 #include "blender.h"
 
+#include <allegro.h>
+#include <allegro/internal/aintern.h>
+#include <mmintrin.h>
+#include <stdint.h>
+
 /***********
 ** macros **
 ***********/
@@ -40,6 +45,34 @@ SOFTWARE.
 
 #define bOPAQUE(x, y) (a >= 254) ? (x) : (((x)*a + y * (255 - a)) >> 8)
 
+/************
+** structs **
+************/
+//! blends a row of sprite pixels onto a row of the destination, MASK_COLOR_32 pixels are skipped
+typedef void (*blend_span_t)(uint32_t *dst, const uint32_t *src, int n);
+
+//! blends a single color onto a row of the destination
+typedef void (*blend_fill_t)(uint32_t *dst, uint32_t color, int n);
+
+//! per mode blender functions
+typedef struct {
+    BLENDER_FUNC pixel;  //!< per pixel function for Allegro
+    blend_span_t span;   //!< sprite row kernel
+    blend_fill_t fill;   //!< hline/rectfill kernel
+} blend_kernel_t;
+
+/*********************
+** static variables **
+*********************/
+static blend_kernel_t blend_kernels[BLEND_SUBSTRACT + 1];  //!< kernels for all modes, MMX versions replace the C versions if available
+static blend_kernel_t *blend_current;                      //!< kernel of the active mode or NULL for BLEND_REPLACE
+static bool blend_mmx;                                     //!< MMX kernels are in use
+
+static void (*blend_orig_hline)(BITMAP *bmp, int x1, int y, int x2, int color);            //!< Allegro hline of 32bpp bitmaps
+static void (*blend_orig_hfill)(BITMAP *bmp, int x1, int y, int x2, int color);            //!< Allegro hfill of 32bpp bitmaps
+static void (*blend_orig_trans_sprite)(BITMAP *bmp, BITMAP *sprite, int x, int y);         //!< Allegro draw_trans_sprite of 32bpp bitmaps
+static void (*blend_orig_trans_rgba_sprite)(BITMAP *bmp, BITMAP *sprite, int x, int y);    //!< Allegro draw_trans_rgba_sprite of 32bpp bitmaps
+
 /***********************
 ** exported functions **
 ***********************/
@@ -357,3 +390,380 @@ unsigned long blender_substract(unsigned long src, unsigned long dest, unsigned
 
     bRET(r, g, b);
 }
+
+/*********************
+** static functions **
+*********************/
+//! sprite and fill kernels in C, the per pixel blender is inlined into the row loop
+#define BLEND_C_KERNELS(name)                                                        \
+    static void span_##name(uint32_t *dst, const uint32_t *src, int n) {             \
+        for (; n > 0; n--, dst++, src++) {                                           \
+            if (*src != MASK_COLOR_32) {                                             \
+                *dst = blender_##name(*src, *dst, 0);                                \
+            }                                                                        \
+        }                                                                            \
+    }                                                                                \
+    static void fill_##name(uint32_t *dst, uint32_t color, int n) {                  \
+        for (; n > 0; n--, dst++) {                                                  \
+            *dst = blender_##name(color, *dst, 0);                                   \
+        }                                                                            \
+    }
+
+BLEND_C_KERNELS(alpha)
+BLEND_C_KERNELS(add)
+BLEND_C_KERNELS(darkest)
+BLEND_C_KERNELS(lightest)
+BLEND_C_KERNELS(difference)
+BLEND_C_KERNELS(exclusion)
+BLEND_C_KERNELS(multiply)
+BLEND_C_KERNELS(screen)
+BLEND_C_KERNELS(overlay)
+BLEND_C_KERNELS(hardlight)
+BLEND_C_KERNELS(doge)
+BLEND_C_KERNELS(burn)
+BLEND_C_KERNELS(substract)
+
+/*
+ * MMX kernels. They work on one pixel per iteration with the four channels as 16bit words and produce exactly the
+ * same results as the C blenders. Only modes where all intermediate values fit into 16bit are implemented, the
+ * others use the C kernels.
+ */
+#define MMX_FUNC __attribute__((target("mmx")))
+
+//! expand the four bytes of a pixel into words
+#define mUNPACK(c) _mm_unpacklo_pi8(_mm_cvtsi32_si64(c), zero)
+
+//! pack words into a pixel with alpha=255
+#define mPACK(w) ((uint32_t)_mm_cvtsi64_si32(_mm_packs_pu16(w, zero)) | 0xFF000000UL)
+
+//! bOPAQUE() for words: (x * fa + d * fd) >> 8 with fa=256, fd=0 for opaque pixels
+#define mOPAQUE(x, d, fa, fd) _mm_srli_pi16(_mm_add_pi16(_mm_mullo_pi16(x, fa), _mm_mullo_pi16(d, fd)), 8)
+
+//! weights for bOPAQUE() in words
+#define mWEIGHTS(a, fa, fd)                        \
+    if (a >= 254) {                                \
+        fa = _mm_set1_pi16(256);                   \
+        fd = zero;                                 \
+    } else {                                       \
+        fa = _mm_set1_pi16(a);                     \
+        fd = _mm_set1_pi16(255 - a);               \
+    }
+
+// blend operations, sb/db are the packed pixels and s/d the unpacked words
+#define mDARKEST mUNPACK(_mm_cvtsi64_si32(_mm_sub_pi8(sb, _mm_subs_pu8(sb, db))))
+#define mLIGHTEST mUNPACK(_mm_cvtsi64_si32(_mm_add_pi8(db, _mm_subs_pu8(sb, db))))
+#define mDIFFERENCE mUNPACK(_mm_cvtsi64_si32(_mm_or_si64(_mm_subs_pu8(sb, db), _mm_subs_pu8(db, sb))))
+#define mMULTIPLY _mm_srli_pi16(_mm_mullo_pi16(s, d), 8)
+#define mSCREEN _mm_sub_pi16(c255, _mm_srli_pi16(_mm_mullo_pi16(_mm_sub_pi16(c255, s), _mm_sub_pi16(c255, d)), 8))
+
+//! sprite and fill kernels using MMX for the blend operation op
+#define BLEND_MMX_KERNELS(name, op)                                                   \
+    static MMX_FUNC void mmx_span_##name(uint32_t *dst, const uint32_t *src, int n) { \
+        __m64 zero = _mm_setzero_si64();                                              \
+        __m64 c255 = _mm_set1_pi16(255);                                              \
+        __m64 fa, fd;                                                                 \
+        for (; n > 0; n--, dst++, src++) {                                            \
+            uint32_t c = *src;                                                        \
+            if (c != MASK_COLOR_32) {                                                 \
+                int a = c >> 24;                                                      \
+                __m64 sb = _mm_cvtsi32_si64(c);                                       \
+                __m64 db = _mm_cvtsi32_si64(*dst);                                    \
+                __m64 s = _mm_unpacklo_pi8(sb, zero);                                 \
+                __m64 d = _mm_unpacklo_pi8(db, zero);                                 \
+                mWEIGHTS(a, fa, fd);                                                  \
+                *dst = mPACK(mOPAQUE(op, d, fa, fd));                                 \
+                (void)s;                                                              \
+            }                                                                         \
+        }                                                                             \
+        (void)c255;                                                                   \
+        _mm_empty();                                                                  \
+    }                                                                                 \
+    static MMX_FUNC void mmx_fill_##name(uint32_t *dst, uint32_t color, int n) {      \
+        __m64 zero = _mm_setzero_si64();                                              \
+        __m64 c255 = _mm_set1_pi16(255);                                              \
+        __m64 fa, fd;                                                                 \
+        int a = color >> 24;                                                          \
+        __m64 sb = _mm_cvtsi32_si64(color);                                           \
+        __m64 s = _mm_unpacklo_pi8(sb, zero);                                         \
+        mWEIGHTS(a, fa, fd);                                                          \
+        for (; n > 0; n--, dst++) {                                                   \
+            __m64 db = _mm_cvtsi32_si64(*dst);                                        \
+            __m64 d = _mm_unpacklo_pi8(db, zero);                                     \
+            *dst = mPACK(mOPAQUE(op, d, fa, fd));                                     \
+        }                                                                             \
+        (void)c255;                                                                   \
+        (void)sb;                                                                     \
+        (void)s;                                                                      \
+        _mm_empty();                                                                  \
+    }
+
+BLEND_MMX_KERNELS(darkest, mDARKEST)
+BLEND_MMX_KERNELS(lightest, mLIGHTEST)
+BLEND_MMX_KERNELS(difference, mDIFFERENCE)
+BLEND_MMX_KERNELS(multiply, mMULTIPLY)
+BLEND_MMX_KERNELS(screen, mSCREEN)
+
+/**
+ * @brief MMX sprite kernel for BLEND_ALPHA.
+ * r = ((a * (r1 - r2)) >> 8) + r2 is calculated as (a * r1 + (256 - a) * r2) >> 8 which stays in the unsigned 16bit range.
+ *
+ * @param dst destination row.
+ * @param src sprite row.
+ * @param n number of pixels.
+ */
+static MMX_FUNC void mmx_span_alpha(uint32_t *dst, const uint32_t *src, int n) {
+    __m64 zero = _mm_setzero_si64();
+    for (; n > 0; n--, dst++, src++) {
+        uint32_t c = *src;
+        if (c != MASK_COLOR_32) {
+            int a = c >> 24;
+            if (a >= 254) {
+                *dst = c;
+            } else if (a == 0) {
+                *dst |= 0xFF000000UL;
+            } else {
+                __m64 s = mUNPACK(c);
+                __m64 d = mUNPACK(*dst);
+                *dst = mPACK(mOPAQUE(s, d, _mm_set1_pi16(a), _mm_set1_pi16(256 - a)));
+            }
+        }
+    }
+    _mm_empty();
+}
+
+/**
+ * @brief MMX fill kernel for BLEND_ALPHA.
+ *
+ * @param dst destination row.
+ * @param color the color to blend.
+ * @param n number of pixels.
+ */
+static MMX_FUNC void mmx_fill_alpha(uint32_t *dst, uint32_t color, int n) {
+    int a = color >> 24;
+    if (a >= 254) {
+        for (; n > 0; n--) {
+            *dst++ = color;
+        }
+    } else {
+        __m64 zero = _mm_setzero_si64();
+        __m64 sa = _mm_mullo_pi16(mUNPACK(color), _mm_set1_pi16(a));  // the source part is the same for all pixels
+        __m64 fd = _mm_set1_pi16(256 - a);
+        for (; n > 0; n--, dst++) {
+            __m64 d = mUNPACK(*dst);
+            *dst = mPACK(_mm_srli_pi16(_mm_add_pi16(sa, _mm_mullo_pi16(d, fd)), 8));
+        }
+        _mm_empty();
+    }
+}
+
+/**
+ * @brief check if a 32bpp drawing operation can use the span kernels.
+ *
+ * @param bmp the destination bitmap.
+ *
+ * @return true if the current blend mode has a kernel and the bitmap is in memory.
+ */
+static bool blend_active(BITMAP *bmp) {
+    return blend_current && (_drawing_mode == DRAW_MODE_TRANS) && (_blender_func32 == blend_current->pixel) && is_memory_bitmap(bmp);
+}
+
+/**
+ * @brief blend a horizontal line using the fill kernel.
+ *
+ * @param bmp destination bitmap.
+ * @param x1 start x.
+ * @param y y position.
+ * @param x2 end x (inclusive).
+ * @param color the color.
+ */
+static void blend_fill_line(BITMAP *bmp, int x1, int y, int x2, int color) {
+    if (x1 > x2) {
+        int tmp = x1;
+        x1 = x2;
+        x2 = tmp;
+    }
+    if (bmp->clip) {
+        if (x1 < bmp->cl) {
+            x1 = bmp->cl;
+        }
+        if (x2 >= bmp->cr) {
+            x2 = bmp->cr - 1;
+        }
+        if ((x1 > x2) || (y < bmp->ct) || (y >= bmp->cb)) {
+            return;
+        }
+    }
+    blend_current->fill((uint32_t *)bmp->line[y] + x1, color, x2 - x1 + 1);
+}
+
+/**
+ * @brief replacement for the hline() of 32bpp bitmaps.
+ */
+static void blend_hline(BITMAP *bmp, int x1, int y, int x2, int color) {
+    if (blend_active(bmp)) {
+        blend_fill_line(bmp, x1, y, x2, color);
+    } else {
+        blend_orig_hline(bmp, x1, y, x2, color);
+    }
+}
+
+/**
+ * @brief replacement for the hfill() of 32bpp bitmaps (used by rectfill(), circlefill(), polygon(), ...).
+ */
+static void blend_hfill(BITMAP *bmp, int x1, int y, int x2, int color) {
+    if (blend_active(bmp)) {
+        blend_fill_line(bmp, x1, y, x2, color);
+    } else {
+        blend_orig_hfill(bmp, x1, y, x2, color);
+    }
+}
+
+/**
+ * @brief blend a 32bpp sprite row by row using the span kernel.
+ *
+ * @param bmp destination bitmap.
+ * @param sprite the sprite.
+ * @param x destination x.
+ * @param y destination y.
+ *
+ * @return false if the sprite can't be drawn with the span kernels.
+ */
+static bool blend_sprite(BITMAP *bmp, BITMAP *sprite, int x, int y) {
+    int sx = 0, sy = 0, w = sprite->w, h = sprite->h;
+
+    if (!blend_active(bmp) || (bitmap_color_depth(sprite) != 32) || !is_memory_bitmap(sprite)) {
+        return false;
+    }
+
+    if (bmp->clip) {
+        if (x < bmp->cl) {
+            sx = bmp->cl - x;
+        }
+        if (y < bmp->ct) {
+            sy = bmp->ct - y;
+        }
+        w = MIN(w, bmp->cr - x) - sx;
+        h = MIN(h, bmp->cb - y) - sy;
+        if ((w <= 0) || (h <= 0)) {
+            return true;
+        }
+    }
+
+    for (int i = 0; i < h; i++) {
+        blend_current->span((uint32_t *)bmp->line[y + sy + i] + x + sx, (const uint32_t *)sprite->line[sy + i] + sx, w);
+    }
+    return true;
+}
+
+/**
+ * @brief replacement for the draw_trans_sprite() of 32bpp bitmaps.
+ */
+static void blend_trans_sprite(BITMAP *bmp, BITMAP *sprite, int x, int y) {
+    if (!blend_sprite(bmp, sprite, x, y)) {
+        blend_orig_trans_sprite(bmp, sprite, x, y);
+    }
+}
+
+/**
+ * @brief replacement for the draw_trans_rgba_sprite() of 32bpp bitmaps.
+ */
+static void blend_trans_rgba_sprite(BITMAP *bmp, BITMAP *sprite, int x, int y) {
+    if (!blend_sprite(bmp, sprite, x, y)) {
+        blend_orig_trans_rgba_sprite(bmp, sprite, x, y);
+    }
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief set up the span kernels and hook them into the Allegro drawing functions of 32bpp memory bitmaps.
+ * Must be called after allegro_init().
+ */
+void init_blender() {
+#define bKERNEL(mode, name) blend_kernels[mode] = (blend_kernel_t){blender_##name, span_##name, fill_##name}
+#define bMMX(mode, name)                            \
+    blend_kernels[mode].span = mmx_span_##name; \
+    blend_kernels[mode].fill = mmx_fill_##name
+
+    bKERNEL(BLEND_ALPHA, alpha);
+    bKERNEL(BLEND_ADD, add);
+    bKERNEL(BLEND_DARKEST, darkest);
+    bKERNEL(BLEND_LIGHTEST, lightest);
+    bKERNEL(BLEND_DIFFERENCE, difference);
+    bKERNEL(BLEND_EXCLUSION, exclusion);
+    bKERNEL(BLEND_MULTIPLY, multiply);
+    bKERNEL(BLEND_SCREEN, screen);
+    bKERNEL(BLEND_OVERLAY, overlay);
+    bKERNEL(BLEND_HARDLIGHT, hardlight);
+    bKERNEL(BLEND_DOGE, doge);
+    bKERNEL(BLEND_BURN, burn);
+    bKERNEL(BLEND_SUBSTRACT, substract);
+
+    blend_mmx = (cpu_capabilities & CPU_MMX) != 0;
+    if (blend_mmx) {
+        bMMX(BLEND_ALPHA, alpha);
+        bMMX(BLEND_DARKEST, darkest);
+        bMMX(BLEND_LIGHTEST, lightest);
+        bMMX(BLEND_DIFFERENCE, difference);
+        bMMX(BLEND_MULTIPLY, multiply);
+        bMMX(BLEND_SCREEN, screen);
+    }
+#undef bKERNEL
+#undef bMMX
+
+    if (!blend_orig_hfill) {
+        blend_orig_hline = __linear_vtable32.hline;
+        blend_orig_hfill = __linear_vtable32.hfill;
+        blend_orig_trans_sprite = __linear_vtable32.draw_trans_sprite;
+        blend_orig_trans_rgba_sprite = __linear_vtable32.draw_trans_rgba_sprite;
+
+        __linear_vtable32.hline = blend_hline;
+        __linear_vtable32.hfill = blend_hfill;
+        __linear_vtable32.draw_trans_sprite = blend_trans_sprite;
+        __linear_vtable32.draw_trans_rgba_sprite = blend_trans_rgba_sprite;
+    }
+    LOGF("Blend kernels: %s\n", blend_mmx ? "MMX" : "C");
+}
+
+/**
+ * @brief select the span kernels for a blend mode.
+ *
+ * @param mode the blend mode.
+ *
+ * @return BLENDER_FUNC the per pixel function to pass to Allegro or NULL for BLEND_REPLACE and unknown modes.
+ */
+BLENDER_FUNC blender_select(blend_mode_t mode) {
+    if ((mode > BLEND_REPLACE) && (mode <= BLEND_SUBSTRACT) && blend_kernels[mode].pixel) {
+        blend_current = &blend_kernels[mode];
+        return blend_current->pixel;
+    } else {
+        blend_current = NULL;
+        return NULL;
+    }
+}
+
+/**
+ * @brief check which kernels are used.
+ *
+ * @return true if the MMX kernels are in use.
+ */
+bool blender_has_mmx() { return blend_mmx; }
+
+/**
+ * @brief blend a row of pixels with the current blend mode using the span kernel.
+ *
+ * @param bmp the bitmap dst belongs to.
+ * @param dst destination pixels.
+ * @param src source pixels, MASK_COLOR_32 pixels are skipped.
+ * @param n number of pixels.
+ *
+ * @return false if the span kernels are not active for this bitmap.
+ */
+bool blender_blend_row(BITMAP *bmp, uint32_t *dst, const uint32_t *src, int n) {
+    if (!blend_active(bmp)) {
+        return false;
+    }
+    blend_current->span(dst, src, n);
+    return true;
+}
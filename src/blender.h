@@ -42,4 +42,9 @@ unsigned long blender_doge(unsigned long src, unsigned long dest, unsigned long
 unsigned long blender_burn(unsigned long src, unsigned long dest, unsigned long n);
 unsigned long blender_substract(unsigned long src, unsigned long dest, unsigned long n);
 
+extern void init_blender(void);
+extern BLENDER_FUNC blender_select(blend_mode_t mode);
+extern bool blender_has_mmx(void);
+extern bool blender_blend_row(BITMAP *bmp, uint32_t *dst, const uint32_t *src, int n);
+
 #endif  // __BLENDER_H__
@@ -317,6 +317,18 @@ static void ByteArray_Append(js_State *J) {
     BA_UPDATE(J, "length", ba->size);
 }
 
+/**
+ * @brief get an ArrayBuffer that uses the storage of this ByteArray, wrap it in a Uint8Array() to access it.
+ * ba.GetBuffer():ArrayBuffer
+ *
+ * @param J VM state.
+ */
+static void ByteArray_GetBuffer(js_State *J) {
+    byte_array_t *ba = js_touserdata(J, 0, TAG_BYTE_ARRAY);
+
+    js_newarraybufferp(J, 0, (void **)&ba->data, (unsigned int *)&ba->size, sizeof(BA_TYPE));
+}
+
 /***********************
 ** exported functions **
 ***********************/
@@ -339,6 +351,7 @@ void init_bytearray(js_State *J) {
         NPROTDEF(J, ByteArray, Clear, 0);
         NPROTDEF(J, ByteArray, ToString, 0);
         NPROTDEF(J, ByteArray, Append, 1);
+        NPROTDEF(J, ByteArray, GetBuffer, 0);
     }
     CTORDEF(J, new_ByteArray, TAG_BYTE_ARRAY, 0);
 
@@ -353,6 +366,7 @@ void init_bytearray(js_State *J) {
         NPROTDEF(J, ByteArray, Clear, 0);
         NPROTDEF(J, ByteArray, ToString, 0);
         NPROTDEF(J, ByteArray, Append, 1);
+        NPROTDEF(J, ByteArray, GetBuffer, 0);
     }
     js_setregistry(J, TAG_BYTE_ARRAY);
 
@@ -380,6 +394,7 @@ void ByteArray_fromBytes(js_State *J, const uint8_t *data, uint32_t size) {
     }
     ba->alloc_size = size;
     ba->size = size;
+    gc_native_alloc(ba->alloc_size * sizeof(BA_TYPE));
 
     for (uint32_t i = 0; i < size; i++) {
         ba->data[i] = data[i];
@@ -422,6 +437,7 @@ void ByteArray_fromStruct(js_State *J, byte_array_t *ba) {
 void ByteArray_destroy(byte_array_t *ba) {
     if (ba) {
         if (ba->data) {
+            gc_native_free(ba->alloc_size * sizeof(BA_TYPE));
             free(ba->data);
         }
         free(ba);
@@ -445,6 +461,7 @@ byte_array_t *ByteArray_create() {
     }
     ba->alloc_size = BA_DEFAULT_SIZE;
     ba->size = 0;
+    gc_native_alloc(ba->alloc_size * sizeof(BA_TYPE));
 
     return ba;
 }
@@ -470,6 +487,8 @@ int ByteArray_push(byte_array_t *ba, BA_TYPE val) {
             larger[i] = ba->data[i];
         }
 
+        gc_native_free(ba->alloc_size * sizeof(BA_TYPE));
+        gc_native_alloc(larger_size * sizeof(BA_TYPE));
         free(ba->data);
         ba->data = larger;
         ba->alloc_size = larger_size;
@@ -0,0 +1,265 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "bytecode.h"
+
+#include <errno.h>
+#include <jsi.h>
+#include <jscompile.h>
+#include <jsparse.h>
+#include <mujs.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "DOjS.h"
+#include "util.h"
+
+/************
+** structs **
+************/
+//! header in front of the MuJS bytecode in a cache file
+typedef struct {
+    char magic[4];      //!< BC_MAGIC
+    uint32_t hash;      //!< hash of the source
+    uint32_t size;      //!< length of the source
+} bc_header_t;
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief FNV-1a hash over a chunk of memory.
+ *
+ * @param hash hash of the previous chunks or 0 to start.
+ * @param data the data.
+ * @param size number of bytes.
+ *
+ * @return uint32_t the new hash.
+ */
+static uint32_t bc_hash(uint32_t hash, const char *data, size_t size) {
+    if (!hash) {
+        hash = 2166136261u;
+    }
+    while (size--) {
+        hash = (hash ^ (uint8_t)*data++) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief create the name of the cache file for a script or function.
+ *
+ * @param buf buffer for the name.
+ * @param size size of the buffer.
+ * @param kind 'S' for scripts, 'F' for functions.
+ * @param fname file name of the source.
+ */
+static void bc_cachename(char *buf, size_t size, char kind, const char *fname) {
+    uint32_t hash = bc_hash(0, &kind, 1);
+    hash = bc_hash(hash, fname, strlen(fname));
+    snprintf(buf, size, BC_CACHE_DIR "/%08lX" BC_CACHE_EXT, (unsigned long)hash);
+}
+
+/**
+ * @brief try to load bytecode from the cache and push the function.
+ *
+ * @param J VM state.
+ * @param cname name of the cache file.
+ * @param fname file name of the source, used for error messages and stack traces.
+ * @param hash hash of the source.
+ * @param size length of the source.
+ *
+ * @return true if the cache was valid and a function was pushed.
+ * @return false if the source needs to be compiled.
+ */
+static bool bc_load(js_State *J, const char *cname, const char *fname, uint32_t hash, uint32_t size) {
+    bc_header_t *hdr;
+    size_t len;
+
+    if (!ut_read_file(cname, (void **)&hdr, &len)) {
+        return false;
+    }
+    if (len < sizeof(bc_header_t) || memcmp(hdr->magic, BC_MAGIC, sizeof(hdr->magic)) != 0 || hdr->hash != hash || hdr->size != size) {
+        DEBUGF("Stale bytecode cache '%s' for '%s'\n", cname, fname);
+        free(hdr);
+        return false;
+    }
+
+    if (js_try(J)) {
+        LOGF("Ignoring bytecode cache '%s' for '%s': %s\n", cname, fname, js_trystring(J, -1, "Error"));
+        js_pop(J, 1);
+        free(hdr);
+        return false;
+    }
+    js_loadbytecode(J, fname, hdr + 1, len - sizeof(bc_header_t));
+    js_endtry(J);
+
+    DEBUGF("Loaded '%s' from bytecode cache '%s'\n", fname, cname);
+    free(hdr);
+    return true;
+}
+
+/**
+ * @brief js_Writer for bc_store(), errors are checked with ferror() afterwards.
+ */
+static void bc_write(void *ctx, const void *data, int size) { fwrite(data, 1, size, (FILE *)ctx); }
+
+/**
+ * @brief write the function on top of the stack to the cache. Failures are logged and otherwise ignored.
+ * The file is written under a temporary name and renamed when complete, so an interrupted write never leaves a truncated cache file.
+ *
+ * @param J VM state.
+ * @param cname name of the cache file.
+ * @param hash hash of the source.
+ * @param size length of the source.
+ */
+static void bc_store(js_State *J, const char *cname, uint32_t hash, uint32_t size) {
+    bc_header_t hdr;
+    char tname[32];
+
+    snprintf(tname, sizeof(tname), "%.*s" BC_TEMP_EXT, (int)(strlen(cname) - strlen(BC_CACHE_EXT)), cname);
+
+    mkdir(BC_CACHE_DIR, 0);
+    FILE *f = fopen(tname, "wb");
+    if (!f) {
+        DEBUGF("Can't create bytecode cache '%s': %s\n", tname, strerror(errno));
+        return;
+    }
+
+    memcpy(hdr.magic, BC_MAGIC, sizeof(hdr.magic));
+    hdr.hash = hash;
+    hdr.size = size;
+
+    bool ok = true;
+    if (js_try(J)) {
+        js_pop(J, 1);
+        ok = false;
+    } else {
+        fwrite(&hdr, sizeof(hdr), 1, f);
+        js_savebytecode(J, -1, bc_write, f);
+        js_endtry(J);
+    }
+    if (ferror(f)) {
+        ok = false;
+    }
+    if (fclose(f) != 0 || !ok) {
+        LOGF("Can't write bytecode cache '%s'\n", tname);
+        remove(tname);
+        return;
+    }
+
+    // DOS can't rename onto an existing file, the stale cache file is removed first
+    remove(cname);
+    if (rename(tname, cname) != 0) {
+        LOGF("Can't rename bytecode cache '%s': %s\n", tname, strerror(errno));
+        remove(tname);
+    }
+}
+
+/**
+ * @brief compile the body of a function and push it.
+ *
+ * @param J VM state.
+ * @param fname file name of the source.
+ * @param params parameter list.
+ * @param body function body.
+ */
+static void bc_compilefunction(js_State *J, const char *fname, const char *params, const char *body) {
+    js_Buffer *sb = NULL;
+    js_Ast *parse;
+    js_Function *fun;
+
+    if (js_try(J)) {
+        js_free(J, sb);
+        jsP_freeparse(J);
+        js_throw(J);
+    }
+
+    js_puts(J, &sb, params);
+    js_putc(J, &sb, ')');
+    js_putc(J, &sb, 0);
+
+    parse = jsP_parsefunction(J, fname, sb ? sb->s : NULL, body);
+    fun = jsC_compilefunction(J, parse);
+
+    js_endtry(J);
+    js_free(J, sb);
+    jsP_freeparse(J);
+
+    js_newfunction(J, fun, J->GE);
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief compile a script (or load it from the bytecode cache) and push it.
+ *
+ * @param J VM state.
+ * @param fname file name of the source, also used as cache key.
+ * @param source the source.
+ */
+void bc_loadstring(js_State *J, const char *fname, const char *source) {
+    char cname[32];
+    size_t size = strlen(source);
+
+    if (DOjS.params.no_bccache || size < BC_MIN_SOURCE) {
+        js_loadstring(J, fname, source);
+        return;
+    }
+
+    uint32_t hash = bc_hash(0, source, size);
+    bc_cachename(cname, sizeof(cname), 'S', fname);
+    if (!bc_load(J, cname, fname, hash, size)) {
+        js_loadstring(J, fname, source);
+        bc_store(J, cname, hash, size);
+    }
+}
+
+/**
+ * @brief compile a function (or load it from the bytecode cache) and push it.
+ *
+ * @param J VM state.
+ * @param fname file name of the source, also used as cache key.
+ * @param params parameter list.
+ * @param body function body.
+ * @param cache true to use the bytecode cache.
+ */
+void bc_loadfunction(js_State *J, const char *fname, const char *params, const char *body, bool cache) {
+    char cname[32];
+    size_t size = strlen(body);
+
+    if (!cache || DOjS.params.no_bccache || size < BC_MIN_SOURCE) {
+        bc_compilefunction(J, fname, params, body);
+        return;
+    }
+
+    uint32_t hash = bc_hash(bc_hash(0, params, strlen(params) + 1), body, size);
+    bc_cachename(cname, sizeof(cname), 'F', fname);
+    if (!bc_load(J, cname, fname, hash, size)) {
+        bc_compilefunction(J, fname, params, body);
+        bc_store(J, cname, hash, size);
+    }
+}
@@ -0,0 +1,45 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __BYTECODE_H__
+#define __BYTECODE_H__
+
+#include <mujs.h>
+#include <stdbool.h>
+
+/************
+** defines **
+************/
+#define BC_CACHE_DIR "JSCACHE"  //!< directory for cached bytecode
+#define BC_CACHE_EXT ".JSC"     //!< extension of cached bytecode files
+#define BC_TEMP_EXT ".TMP"      //!< extension of cache files while they are written
+#define BC_MAGIC "DJSC"         //!< magic of the cache file header
+#define BC_MIN_SOURCE 1024      //!< smaller sources are always compiled
+
+/*********************
+** static functions **
+*********************/
+extern void bc_loadstring(js_State *J, const char *fname, const char *source);
+extern void bc_loadfunction(js_State *J, const char *fname, const char *params, const char *body, bool cache);
+
+#endif  // __BYTECODE_H__
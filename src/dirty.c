@@ -0,0 +1,252 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "dirty.h"
+
+#include <allegro.h>
+#include <mujs.h>
+#include <string.h>
+
+#include "DOjS.h"
+
+/************
+** structs **
+************/
+//! a dirty rectangle, all coordinates are inclusive
+typedef struct {
+    int x1;  //!< left
+    int y1;  //!< top
+    int x2;  //!< right
+    int y2;  //!< bottom
+} dirty_rect_t;
+
+//! dirty list and present statistics
+typedef struct {
+    int mode;                             //!< PRESENT_FULL or PRESENT_DIRTY
+    bool all;                             //!< the whole screen must be copied this frame
+    int num_rects;                        //!< number of entries in rects
+    dirty_rect_t rects[DIRTY_MAX_RECTS];  //!< the dirty rectangles of the current frame
+    int last_rects;                       //!< number of rectangles copied by the last frame
+    unsigned long last_bytes;             //!< number of bytes copied by the last frame
+    unsigned long frames;                 //!< number of presented frames
+    double total_bytes;                   //!< number of bytes copied since start
+} dirty_list_t;
+
+/*********************
+** static variables **
+*********************/
+static dirty_list_t dirty;  //!< dirty list of the current frame
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief number of pixels in a rectangle.
+ *
+ * @param r the rectangle.
+ *
+ * @return long the area.
+ */
+static long dirty_area(const dirty_rect_t *r) { return (long)(r->x2 - r->x1 + 1) * (r->y2 - r->y1 + 1); }
+
+/**
+ * @brief calculate the bounding box of two rectangles.
+ *
+ * @param a first rectangle.
+ * @param b second rectangle.
+ * @param u the union.
+ */
+static void dirty_union(const dirty_rect_t *a, const dirty_rect_t *b, dirty_rect_t *u) {
+    u->x1 = MIN(a->x1, b->x1);
+    u->y1 = MIN(a->y1, b->y1);
+    u->x2 = MAX(a->x2, b->x2);
+    u->y2 = MAX(a->y2, b->y2);
+}
+
+/**
+ * @brief set presentation mode.
+ * SetPresentMode(mode:number)
+ *
+ * @param J the JS context.
+ */
+static void f_SetPresentMode(js_State *J) {
+    int mode = js_toint32(J, 1);
+    if (mode != PRESENT_FULL && mode != PRESENT_DIRTY) {
+        js_error(J, "Unknown present mode: %d", mode);
+        return;
+    }
+    dirty.mode = mode;
+    dirty.num_rects = 0;
+    dirty.all = true;  // nothing was tracked so far
+}
+
+/**
+ * @brief get presentation statistics.
+ * PresentStats():PresentInfo
+ *
+ * @param J the JS context.
+ */
+static void f_PresentStats(js_State *J) {
+    js_newobject(J);
+    {
+        js_pushnumber(J, dirty.mode);
+        js_setproperty(J, -2, "mode");
+        js_pushnumber(J, dirty.last_rects);
+        js_setproperty(J, -2, "rects");
+        js_pushnumber(J, dirty.last_bytes);
+        js_setproperty(J, -2, "bytes");
+        js_pushnumber(J, dirty.frames);
+        js_setproperty(J, -2, "frames");
+        js_pushnumber(J, dirty.total_bytes);
+        js_setproperty(J, -2, "total_bytes");
+    }
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize dirty rectangle tracking.
+ *
+ * @param J VM state.
+ */
+void init_dirty(js_State *J) {
+    DEBUGF("%s\n", __PRETTY_FUNCTION__);
+
+    memset(&dirty, 0, sizeof(dirty));
+    dirty.mode = PRESENT_FULL;
+    dirty.all = true;
+
+    NFUNCDEF(J, SetPresentMode, 1);
+    NFUNCDEF(J, PresentStats, 0);
+}
+
+/**
+ * @brief record a changed area of a bitmap. Only changes to the render bitmap are tracked and only in PRESENT_DIRTY mode.
+ * Overlapping or close rectangles are merged.
+ *
+ * @param bm the bitmap that was drawn to.
+ * @param x1 first corner X (inclusive).
+ * @param y1 first corner Y (inclusive).
+ * @param x2 second corner X (inclusive).
+ * @param y2 second corner Y (inclusive).
+ */
+void dirty_add(BITMAP *bm, int x1, int y1, int x2, int y2) {
+    if (dirty.mode != PRESENT_DIRTY || dirty.all || bm != DOjS.render_bm) {
+        return;
+    }
+
+    dirty_rect_t r = {MAX(MIN(x1, x2), 0), MAX(MIN(y1, y2), 0), MIN(MAX(x1, x2), bm->w - 1), MIN(MAX(y1, y2), bm->h - 1)};
+    if (r.x1 > r.x2 || r.y1 > r.y2) {
+        return;
+    }
+
+    // merge with every rectangle that costs at most DIRTY_MERGE_SLACK extra pixels, repeat until nothing changes
+    int i = 0;
+    while (i < dirty.num_rects) {
+        dirty_rect_t u;
+        dirty_union(&dirty.rects[i], &r, &u);
+        if (dirty_area(&u) <= dirty_area(&dirty.rects[i]) + dirty_area(&r) + DIRTY_MERGE_SLACK) {
+            r = u;
+            dirty.rects[i] = dirty.rects[--dirty.num_rects];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    // list full: merge with the rectangle that grows least
+    if (dirty.num_rects == DIRTY_MAX_RECTS) {
+        int best = 0;
+        long best_growth = 0;
+        for (i = 0; i < dirty.num_rects; i++) {
+            dirty_rect_t u;
+            dirty_union(&dirty.rects[i], &r, &u);
+            long growth = dirty_area(&u) - dirty_area(&dirty.rects[i]);
+            if (i == 0 || growth < best_growth) {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        dirty_union(&dirty.rects[best], &r, &r);
+        dirty.rects[best] = dirty.rects[--dirty.num_rects];
+    }
+    dirty.rects[dirty.num_rects++] = r;
+
+    // copying (almost) everything in one go is cheaper than many rectangles
+    long total = 0;
+    for (i = 0; i < dirty.num_rects; i++) {
+        total += dirty_area(&dirty.rects[i]);
+    }
+    if (total > ((long)bm->w * bm->h / 100) * DIRTY_FULL_PERCENT) {
+        dirty.all = true;
+    }
+}
+
+/**
+ * @brief mark the whole bitmap as changed (e.g. for functions where the changed area is unknown).
+ *
+ * @param bm the bitmap that was drawn to.
+ */
+void dirty_add_all(BITMAP *bm) {
+    if (bm == DOjS.render_bm) {
+        dirty.all = true;
+    }
+}
+
+/**
+ * @brief copy the render bitmap to the screen. In PRESENT_DIRTY mode only the areas changed since the last frame are copied.
+ */
+void dirty_present() {
+    int bpp = (bitmap_color_depth(screen) + 7) / 8;
+    unsigned long bytes = 0;
+    int rects = 0;
+
+    if (dirty.mode == PRESENT_FULL || dirty.all) {
+        blit(DOjS.render_bm, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        bytes = (unsigned long)SCREEN_W * SCREEN_H * bpp;
+        rects = 1;
+    } else if (dirty.num_rects) {
+        if (DOjS.mouse_visible) {
+            // the cursor must not save/restore stale background while we copy
+            scare_mouse();
+        }
+        for (int i = 0; i < dirty.num_rects; i++) {
+            dirty_rect_t *r = &dirty.rects[i];
+            int w = r->x2 - r->x1 + 1;
+            int h = r->y2 - r->y1 + 1;
+            blit(DOjS.render_bm, screen, r->x1, r->y1, r->x1, r->y1, w, h);
+            bytes += (unsigned long)w * h * bpp;
+        }
+        if (DOjS.mouse_visible) {
+            unscare_mouse();
+        }
+        rects = dirty.num_rects;
+    }
+
+    dirty.last_rects = rects;
+    dirty.last_bytes = bytes;
+    dirty.total_bytes += bytes;
+    dirty.frames++;
+    dirty.num_rects = 0;
+    dirty.all = false;
+}
@@ -0,0 +1,48 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __DIRTY_H__
+#define __DIRTY_H__
+
+#include <allegro.h>
+#include <mujs.h>
+#include <stdbool.h>
+
+/************
+** defines **
+************/
+#define DIRTY_MAX_RECTS 32      //!< maximum number of dirty rectangles per frame
+#define DIRTY_MERGE_SLACK 4096  //!< number of clean pixels that may be copied to merge two rectangles into one
+#define DIRTY_FULL_PERCENT 75   //!< if more than this much of the screen is dirty the whole screen is copied
+
+#define PRESENT_FULL 0   //!< copy the whole render bitmap to the screen every frame
+#define PRESENT_DIRTY 1  //!< only copy the rectangles touched by drawing functions
+
+/*********************
+** static functions **
+*********************/
+extern void init_dirty(js_State *J);
+extern void dirty_add(BITMAP *bm, int x1, int y1, int x2, int y2);
+extern void dirty_add_all(BITMAP *bm);
+extern void dirty_present(void);
+
+#endif  // __DIRTY_H__
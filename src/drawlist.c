@@ -0,0 +1,549 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "drawlist.h"
+
+#include <allegro.h>
+#include <mujs.h>
+#include <stdlib.h>
+
+#include "DOjS.h"
+#include "bitmap.h"
+#include "dirty.h"
+#include "imgcache.h"
+#include "intarray.h"
+
+/*********************
+** static variables **
+*********************/
+//! number of arguments following each opcode
+static const int dl_args[DL_NUM_OPCODES] = {
+    0,  // unused
+    3,  // DL_PLOT
+    5,  // DL_LINE
+    5,  // DL_BOX
+    5,  // DL_FILLEDBOX
+    4,  // DL_CIRCLE
+    4,  // DL_FILLEDCIRCLE
+    5,  // DL_ELLIPSE
+    5,  // DL_FILLEDELLIPSE
+    3,  // DL_DRAW
+    3,  // DL_DRAWTRANS
+    1,  // DL_CLEARSCREEN
+};
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief finalize a DrawList and free resources.
+ *
+ * @param J VM state.
+ */
+static void DrawList_Finalize(js_State *J, void *data) {
+    drawlist_t *dl = (drawlist_t *)data;
+    IntArray_destroy(dl->cmds);
+    free(dl->bitmaps);
+    free(dl);
+}
+
+/**
+ * @brief check if an opcode takes a bitmap as first argument.
+ *
+ * @param op the opcode.
+ *
+ * @return true for DL_DRAW and DL_DRAWTRANS.
+ */
+static bool DL_isBitmapOp(int32_t op) { return op == DL_DRAW || op == DL_DRAWTRANS; }
+
+/**
+ * @brief throw away everything appended since a given state (used when an append fails halfway and by Clear()).
+ *
+ * @param J VM state, the DrawList is at stack index 0.
+ * @param dl the DrawList.
+ * @param size size of the command buffer to return to.
+ * @param num_commands number of commands to return to.
+ * @param num_bitmaps number of bitmaps to return to.
+ */
+static void DL_rollback(js_State *J, drawlist_t *dl, uint32_t size, int num_commands, int num_bitmaps) {
+    dl->cmds->size = size;
+    dl->num_commands = num_commands;
+    dl->num_bitmaps = num_bitmaps;
+
+    // the Bitmap references are dropped in place, the property itself is read-only
+    js_getproperty(J, 0, DL_BITMAPS);
+    js_setlength(J, -1, num_bitmaps);
+    js_pop(J, 1);
+}
+
+/**
+ * @brief get the table index of a bitmap, the bitmap is added to the table (and to the '__bitmaps__' property of the DrawList at stack index 0) if needed.
+ *
+ * @param J VM state.
+ * @param dl the DrawList.
+ * @param idx absolute stack index of the Bitmap object.
+ *
+ * @return the table index or -1 if out of memory.
+ */
+static int DL_bitmapIndex(js_State *J, drawlist_t *dl, int idx) {
+    BITMAP *bm = js_touserdata(J, idx, TAG_BITMAP);
+
+    // the same sprite is usually drawn many times in a row
+    for (int i = dl->num_bitmaps - 1; i >= 0; i--) {
+        if (dl->bitmaps[i] == bm) {
+            return i;
+        }
+    }
+
+    if (dl->num_bitmaps >= dl->alloc_bitmaps) {
+        BITMAP **larger = realloc(dl->bitmaps, (dl->alloc_bitmaps + DL_BITMAP_INC) * sizeof(BITMAP *));
+        if (!larger) {
+            return -1;
+        }
+        dl->bitmaps = larger;
+        dl->alloc_bitmaps += DL_BITMAP_INC;
+    }
+    dl->bitmaps[dl->num_bitmaps] = bm;
+
+    // keep a reference so the Bitmap is not collected while it is in the list
+    js_getproperty(J, 0, DL_BITMAPS);
+    js_copy(J, idx);
+    js_setindex(J, -2, dl->num_bitmaps);
+    js_pop(J, 1);
+
+    return dl->num_bitmaps++;
+}
+
+/**
+ * @brief append a command whose arguments are the JS call arguments. The last argument of all non-bitmap commands is a color.
+ *
+ * @param J VM state.
+ * @param op the opcode.
+ */
+static void DL_append(js_State *J, int32_t op) {
+    drawlist_t *dl = js_touserdata(J, 0, TAG_DRAWLIST);
+    int num = dl_args[op];
+    int32_t args[DL_MAX_ARGS];
+
+    // convert everything first, so a failing conversion does not leave half a command in the buffer
+    for (int i = 1; i <= num; i++) {
+        if (i == 1 && DL_isBitmapOp(op)) {
+            if (!js_isuserdata(J, 1, TAG_BITMAP)) {
+                js_error(J, "Bitmap expected");
+                return;
+            }
+            args[0] = 0;
+        } else if (i == num && !DL_isBitmapOp(op)) {
+            args[i - 1] = js_toint32(J, i);
+        } else {
+            args[i - 1] = js_toint16(J, i);
+        }
+    }
+
+    uint32_t size = dl->cmds->size;
+    int num_bitmaps = dl->num_bitmaps;
+    if (DL_isBitmapOp(op)) {
+        args[0] = DL_bitmapIndex(J, dl, 1);
+        if (args[0] < 0) {
+            JS_ENOMEM(J);
+            return;
+        }
+    }
+    if (IntArray_push(dl->cmds, op) < 0) {
+        DL_rollback(J, dl, size, dl->num_commands, num_bitmaps);
+        JS_ENOMEM(J);
+        return;
+    }
+    for (int i = 0; i < num; i++) {
+        if (IntArray_push(dl->cmds, args[i]) < 0) {
+            DL_rollback(J, dl, size, dl->num_commands, num_bitmaps);
+            JS_ENOMEM(J);
+            return;
+        }
+    }
+    dl->num_commands++;
+}
+
+/**
+ * @brief check that the '__bitmaps__' array of the DrawList at stack index 0 still references every bitmap in the table. Throws if not, so
+ * Execute() never draws a Bitmap that may have been collected.
+ *
+ * @param J VM state.
+ * @param dl the DrawList.
+ */
+static void DL_checkBitmaps(js_State *J, drawlist_t *dl) {
+    js_getproperty(J, 0, DL_BITMAPS);
+    if (!js_isarray(J, -1) || js_getlength(J, -1) != dl->num_bitmaps) {
+        js_error(J, "DrawList bitmap references were modified");
+        return;
+    }
+    for (int i = 0; i < dl->num_bitmaps; i++) {
+        js_getindex(J, -1, i);
+        if (!js_isuserdata(J, -1, TAG_BITMAP) || js_touserdata(J, -1, TAG_BITMAP) != dl->bitmaps[i]) {
+            js_error(J, "DrawList bitmap references were modified");
+            return;
+        }
+        js_pop(J, 1);
+    }
+    js_pop(J, 1);
+}
+
+/**
+ * @brief create an empty DrawList.
+ * dl = new DrawList()
+ *
+ * @param J VM state.
+ */
+static void new_DrawList(js_State *J) {
+    NEW_OBJECT_PREP(J);
+
+    drawlist_t *dl = calloc(1, sizeof(drawlist_t));
+    if (!dl) {
+        JS_ENOMEM(J);
+        return;
+    }
+    dl->cmds = IntArray_create();
+    if (!dl->cmds) {
+        free(dl);
+        JS_ENOMEM(J);
+        return;
+    }
+
+    js_currentfunction(J);
+    js_getproperty(J, -1, "prototype");
+    js_newuserdata(J, TAG_DRAWLIST, dl, DrawList_Finalize);
+
+    // the array is only ever changed in place, see DL_bitmapIndex() and DrawList_Clear()
+    js_newarray(J);
+    js_defproperty(J, -2, DL_BITMAPS, JS_READONLY | JS_DONTENUM | JS_DONTCONF);
+}
+
+/**
+ * @brief append a plot.
+ * dl.Plot(x:number, y:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_Plot(js_State *J) { DL_append(J, DL_PLOT); }
+
+/**
+ * @brief append a line.
+ * dl.Line(x1:number, y1:number, x2:number, y2:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_Line(js_State *J) { DL_append(J, DL_LINE); }
+
+/**
+ * @brief append a box.
+ * dl.Box(x1:number, y1:number, x2:number, y2:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_Box(js_State *J) { DL_append(J, DL_BOX); }
+
+/**
+ * @brief append a filled box.
+ * dl.FilledBox(x1:number, y1:number, x2:number, y2:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_FilledBox(js_State *J) { DL_append(J, DL_FILLEDBOX); }
+
+/**
+ * @brief append a circle.
+ * dl.Circle(x:number, y:number, r:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_Circle(js_State *J) { DL_append(J, DL_CIRCLE); }
+
+/**
+ * @brief append a filled circle.
+ * dl.FilledCircle(x:number, y:number, r:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_FilledCircle(js_State *J) { DL_append(J, DL_FILLEDCIRCLE); }
+
+/**
+ * @brief append an ellipse.
+ * dl.Ellipse(xc:number, yc:number, xa:number, ya:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_Ellipse(js_State *J) { DL_append(J, DL_ELLIPSE); }
+
+/**
+ * @brief append a filled ellipse.
+ * dl.FilledEllipse(xc:number, yc:number, xa:number, ya:number, c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_FilledEllipse(js_State *J) { DL_append(J, DL_FILLEDELLIPSE); }
+
+/**
+ * @brief append drawing a Bitmap.
+ * dl.Draw(bm:Bitmap, x:number, y:number)
+ *
+ * @param J VM state.
+ */
+static void DrawList_Draw(js_State *J) { DL_append(J, DL_DRAW); }
+
+/**
+ * @brief append drawing a Bitmap with transparency.
+ * dl.DrawTrans(bm:Bitmap, x:number, y:number)
+ *
+ * @param J VM state.
+ */
+static void DrawList_DrawTrans(js_State *J) { DL_append(J, DL_DRAWTRANS); }
+
+/**
+ * @brief append clearing the target.
+ * dl.ClearScreen(c:Color)
+ *
+ * @param J VM state.
+ */
+static void DrawList_ClearScreen(js_State *J) { DL_append(J, DL_CLEARSCREEN); }
+
+/**
+ * @brief append encoded commands: each opcode (DL.*) is followed by its arguments. Bitmap arguments are only possible in an Array.
+ * dl.Append(cmds:number[]|IntArray)
+ *
+ * @param J VM state.
+ */
+static void DrawList_Append(js_State *J) {
+    drawlist_t *dl = js_touserdata(J, 0, TAG_DRAWLIST);
+    int_array_t *ia = NULL;
+    uint32_t len;
+
+    if (js_isuserdata(J, 1, TAG_INT_ARRAY)) {
+        ia = js_touserdata(J, 1, TAG_INT_ARRAY);
+        len = ia->size;
+    } else if (js_isarray(J, 1)) {
+        len = js_getlength(J, 1);
+    } else {
+        JS_ENOARR(J);
+        return;
+    }
+
+    uint32_t size = dl->cmds->size;
+    int num_commands = dl->num_commands;
+    int num_bitmaps = dl->num_bitmaps;
+
+    // on any error the list is restored to the state before this call
+    if (js_try(J)) {
+        DL_rollback(J, dl, size, num_commands, num_bitmaps);
+        js_throw(J);
+    }
+
+    uint32_t i = 0;
+    while (i < len) {
+        int32_t op;
+        if (ia) {
+            op = ia->data[i];
+        } else {
+            js_getindex(J, 1, i);
+            op = js_toint32(J, -1);
+            js_pop(J, 1);
+        }
+
+        if (op <= 0 || op >= DL_NUM_OPCODES) {
+            js_error(J, "Unknown DrawList opcode %ld at index %lu", op, i);
+        }
+        if (i + dl_args[op] >= len) {
+            js_error(J, "Incomplete DrawList command at index %lu", i);
+        }
+        if (IntArray_push(dl->cmds, op) < 0) {
+            JS_ENOMEM(J);
+        }
+        i++;
+
+        for (int a = 0; a < dl_args[op]; a++, i++) {
+            int32_t val;
+            if (a == 0 && DL_isBitmapOp(op)) {
+                if (ia) {
+                    js_error(J, "Bitmap commands can not be added from an IntArray");
+                }
+                js_getindex(J, 1, i);
+                if (!js_isuserdata(J, -1, TAG_BITMAP)) {
+                    js_error(J, "Bitmap expected at index %lu", i);
+                }
+                val = DL_bitmapIndex(J, dl, js_gettop(J) - 1);
+                js_pop(J, 1);
+                if (val < 0) {
+                    JS_ENOMEM(J);
+                }
+            } else if (ia) {
+                val = ia->data[i];
+            } else {
+                js_getindex(J, 1, i);
+                val = js_toint32(J, -1);
+                js_pop(J, 1);
+            }
+
+            if (IntArray_push(dl->cmds, val) < 0) {
+                JS_ENOMEM(J);
+            }
+        }
+        dl->num_commands++;
+    }
+    js_endtry(J);
+}
+
+/**
+ * @brief remove all commands, the allocated memory is kept for the next frame.
+ * dl.Clear()
+ *
+ * @param J VM state.
+ */
+static void DrawList_Clear(js_State *J) {
+    drawlist_t *dl = js_touserdata(J, 0, TAG_DRAWLIST);
+
+    DL_rollback(J, dl, 0, 0, 0);
+}
+
+/**
+ * @brief get the number of commands in the list.
+ * dl.Length():number
+ *
+ * @param J VM state.
+ */
+static void DrawList_Length(js_State *J) {
+    drawlist_t *dl = js_touserdata(J, 0, TAG_DRAWLIST);
+
+    js_pushnumber(J, dl->num_commands);
+}
+
+/**
+ * @brief draw all commands of the list. The list is not changed and can be executed again.
+ * dl.Execute([target:Bitmap])
+ *
+ * @param J VM state.
+ */
+static void DrawList_Execute(js_State *J) {
+    drawlist_t *dl = js_touserdata(J, 0, TAG_DRAWLIST);
+    BITMAP *bm = DOjS.current_bm;
+    if (js_isuserdata(J, 1, TAG_BITMAP)) {
+        bm = js_touserdata(J, 1, TAG_BITMAP);
+        if (!imgcache_own(bm)) {
+            JS_ENOMEM(J);
+            return;
+        }
+    }
+    DL_checkBitmaps(J, dl);
+
+    const int32_t *c = dl->cmds->data;
+    uint32_t i = 0;
+    while (i < dl->cmds->size) {
+        int32_t op = c[i];
+        const int32_t *a = &c[i + 1];
+
+        switch (op) {
+            case DL_PLOT:
+                putpixel(bm, a[0], a[1], a[2]);
+                dirty_add(bm, a[0], a[1], a[0], a[1]);
+                break;
+            case DL_LINE:
+                line(bm, a[0], a[1], a[2], a[3], a[4]);
+                dirty_add(bm, a[0], a[1], a[2], a[3]);
+                break;
+            case DL_BOX:
+                rect(bm, a[0], a[1], a[2], a[3], a[4]);
+                dirty_add(bm, a[0], a[1], a[2], a[3]);
+                break;
+            case DL_FILLEDBOX:
+                rectfill(bm, a[0], a[1], a[2], a[3], a[4]);
+                dirty_add(bm, a[0], a[1], a[2], a[3]);
+                break;
+            case DL_CIRCLE:
+                circle(bm, a[0], a[1], a[2], a[3]);
+                dirty_add(bm, a[0] - a[2], a[1] - a[2], a[0] + a[2], a[1] + a[2]);
+                break;
+            case DL_FILLEDCIRCLE:
+                circlefill(bm, a[0], a[1], a[2], a[3]);
+                dirty_add(bm, a[0] - a[2], a[1] - a[2], a[0] + a[2], a[1] + a[2]);
+                break;
+            case DL_ELLIPSE:
+                ellipse(bm, a[0], a[1], a[2], a[3], a[4]);
+                dirty_add(bm, a[0] - abs(a[2]), a[1] - abs(a[3]), a[0] + abs(a[2]), a[1] + abs(a[3]));
+                break;
+            case DL_FILLEDELLIPSE:
+                ellipsefill(bm, a[0], a[1], a[2], a[3], a[4]);
+                dirty_add(bm, a[0] - abs(a[2]), a[1] - abs(a[3]), a[0] + abs(a[2]), a[1] + abs(a[3]));
+                break;
+            case DL_DRAW: {
+                BITMAP *src = dl->bitmaps[a[0]];
+                blit(src, bm, 0, 0, a[1], a[2], src->w, src->h);
+                dirty_add(bm, a[1], a[2], a[1] + src->w - 1, a[2] + src->h - 1);
+            } break;
+            case DL_DRAWTRANS: {
+                BITMAP *src = dl->bitmaps[a[0]];
+                draw_trans_sprite(bm, src, a[1], a[2]);
+                dirty_add(bm, a[1], a[2], a[1] + src->w - 1, a[2] + src->h - 1);
+            } break;
+            case DL_CLEARSCREEN:
+                clear_to_color(bm, a[0]);
+                dirty_add_all(bm);
+                break;
+            default:
+                js_error(J, "Corrupt DrawList at index %lu", i);
+                return;
+        }
+        i += 1 + dl_args[op];
+    }
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize DrawList subsystem.
+ *
+ * @param J VM state.
+ */
+void init_drawlist(js_State *J) {
+    DEBUGF("%s\n", __PRETTY_FUNCTION__);
+
+    // define the DrawList() object
+    js_newobject(J);
+    {
+        NPROTDEF(J, DrawList, Plot, 3);
+        NPROTDEF(J, DrawList, Line, 5);
+        NPROTDEF(J, DrawList, Box, 5);
+        NPROTDEF(J, DrawList, FilledBox, 5);
+        NPROTDEF(J, DrawList, Circle, 4);
+        NPROTDEF(J, DrawList, FilledCircle, 4);
+        NPROTDEF(J, DrawList, Ellipse, 5);
+        NPROTDEF(J, DrawList, FilledEllipse, 5);
+        NPROTDEF(J, DrawList, Draw, 3);
+        NPROTDEF(J, DrawList, DrawTrans, 3);
+        NPROTDEF(J, DrawList, ClearScreen, 1);
+        NPROTDEF(J, DrawList, Append, 1);
+        NPROTDEF(J, DrawList, Clear, 0);
+        NPROTDEF(J, DrawList, Length, 0);
+        NPROTDEF(J, DrawList, Execute, 1);
+    }
+    CTORDEF(J, new_DrawList, TAG_DRAWLIST, 0);
+
+    DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
+}
@@ -0,0 +1,70 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __DRAWLIST_H__
+#define __DRAWLIST_H__
+
+#include <allegro.h>
+#include <mujs.h>
+#include <stdbool.h>
+
+#include "intarray.h"
+
+/************
+** defines **
+************/
+#define TAG_DRAWLIST "DrawList"  //!< class name for DrawList()
+
+#define DL_PLOT 1           //!< x, y, color
+#define DL_LINE 2           //!< x1, y1, x2, y2, color
+#define DL_BOX 3            //!< x1, y1, x2, y2, color
+#define DL_FILLEDBOX 4      //!< x1, y1, x2, y2, color
+#define DL_CIRCLE 5         //!< x, y, r, color
+#define DL_FILLEDCIRCLE 6   //!< x, y, r, color
+#define DL_ELLIPSE 7        //!< xc, yc, xa, ya, color
+#define DL_FILLEDELLIPSE 8  //!< xc, yc, xa, ya, color
+#define DL_DRAW 9           //!< bitmap, x, y
+#define DL_DRAWTRANS 10     //!< bitmap, x, y
+#define DL_CLEARSCREEN 11   //!< color
+#define DL_NUM_OPCODES 12   //!< number of opcodes (including the unused 0)
+#define DL_MAX_ARGS 5       //!< maximum number of arguments of a command
+#define DL_BITMAP_INC 16    //!< number of entries the bitmap table grows by
+#define DL_BITMAPS "__bitmaps__"  //!< read-only property with the Bitmap objects of the bitmap table
+
+/************
+** structs **
+************/
+//! a list of drawing commands
+typedef struct {
+    int_array_t *cmds;  //!< opcodes, each followed by its arguments
+    BITMAP **bitmaps;   //!< bitmaps referenced by DL_DRAW/DL_DRAWTRANS, kept alive by the DL_BITMAPS property
+    int num_bitmaps;    //!< number of entries in bitmaps
+    int alloc_bitmaps;  //!< allocated size of bitmaps
+    int num_commands;   //!< number of commands in cmds
+} drawlist_t;
+
+/***********************
+** exported functions **
+***********************/
+extern void init_drawlist(js_State *J);
+
+#endif  // __DRAWLIST_H__
@@ -24,13 +24,434 @@ SOFTWARE.
 
 #include <allegro.h>
 #include <mujs.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "DOjS.h"
+#include "dirty.h"
 #include "zipfile.h"
 
+/************
+** defines **
+************/
+#define FLC_TYPE 0xAF12        //!< FLC file magic
+#define FLC_FRAME_TYPE 0xF1FA  //!< frame magic
+#define FLC_COLOR_256 4        //!< palette chunk with 8bit components
+#define FLC_DELTA 7            //!< word oriented delta chunk
+#define FLC_BRUN 15            //!< byte run length compressed full frame
+
+#define FLC_REC_WORD_EQ(a, b, x) ((a)[(x)*2] == (b)[(x)*2] && (a)[(x)*2 + 1] == (b)[(x)*2 + 1])  //!< compare two pixels at once
+
+/************
+** structs **
+************/
+//! state of the current recording
+typedef struct __flic_rec {
+    FILE *f;                //!< output file or NULL when no recording is running
+    char *vbuf;             //!< stdio buffer of the output file
+    BITMAP *bm;             //!< the recorded bitmap
+    int stride;             //!< bytes per line of bm
+    unsigned char *prev;    //!< content of bm when the last frame was recorded
+    unsigned char *frame8;  //!< the last recorded frame as palette indices
+    unsigned char *line8;   //!< the current line as palette indices
+    unsigned char *out;     //!< encoded frame
+    unsigned int frames;    //!< number of frames written so far
+    unsigned int repeated;  //!< number of empty frames written to keep the timing for slow Loop()s
+    unsigned int skipped;   //!< number of presented frames that were faster than the recording rate
+    unsigned long bytes;    //!< number of bytes written so far
+    unsigned long start;    //!< DOjS.sys_ticks when the recording was started
+    unsigned long speed;    //!< ms per frame
+    unsigned long frame2;   //!< file offset of the second frame
+} flic_rec_t;
+
+/*********************
+** static variables **
+*********************/
+static flic_rec_t flic_rec;  //!< the one and only recording
+
 /*********************
 ** static functions **
 *********************/
+/**
+ * @brief store a 16bit little endian value.
+ *
+ * @param p destination.
+ * @param v the value.
+ *
+ * @return the position after the value.
+ */
+static uint8_t *flic_put16(uint8_t *p, unsigned int v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    return p + 2;
+}
+
+/**
+ * @brief store a 32bit little endian value.
+ *
+ * @param p destination.
+ * @param v the value.
+ *
+ * @return the position after the value.
+ */
+static uint8_t *flic_put32(uint8_t *p, unsigned long v) {
+    p = flic_put16(p, v & 0xFFFF);
+    return flic_put16(p, (v >> 16) & 0xFFFF);
+}
+
+/**
+ * @brief write the 128 byte FLC header.
+ *
+ * @return true if the header could be written.
+ */
+static bool flic_rec_header(void) {
+    uint8_t hdr[FLIC_REC_HEADER];
+    bzero(hdr, sizeof(hdr));
+
+    flic_put32(&hdr[0], flic_rec.bytes);           // file size
+    flic_put16(&hdr[4], FLC_TYPE);                 // magic
+    flic_put16(&hdr[6], flic_rec.frames);          // number of frames
+    flic_put16(&hdr[8], flic_rec.bm->w);           // width
+    flic_put16(&hdr[10], flic_rec.bm->h);          // height
+    flic_put16(&hdr[12], 8);                       // depth
+    flic_put16(&hdr[14], 3);                       // flags
+    flic_put32(&hdr[16], flic_rec.speed);          // ms per frame
+    flic_put16(&hdr[56], 1);                       // aspect x
+    flic_put16(&hdr[58], 1);                       // aspect y
+    flic_put32(&hdr[80], FLIC_REC_HEADER);         // offset of frame 1
+    flic_put32(&hdr[84], flic_rec.frame2);         // offset of frame 2
+
+    return fseek(flic_rec.f, 0, SEEK_SET) == 0 && fwrite(hdr, sizeof(hdr), 1, flic_rec.f) == 1;
+}
+
+/**
+ * @brief finish the FLC file and free all resources of the recording.
+ *
+ * @return true if the file was written completely.
+ */
+static bool flic_rec_close(void) {
+    bool ret = true;
+
+    if (flic_rec.f) {
+        ret = flic_rec_header();
+        if (fclose(flic_rec.f) != 0) {
+            ret = false;
+        }
+        flic_rec.f = NULL;
+    }
+    free(flic_rec.vbuf);
+    free(flic_rec.prev);
+    free(flic_rec.frame8);
+    free(flic_rec.line8);
+    free(flic_rec.out);
+    flic_rec.vbuf = NULL;
+    flic_rec.prev = flic_rec.frame8 = flic_rec.line8 = flic_rec.out = NULL;
+
+    return ret;
+}
+
+/**
+ * @brief convert a line of the recorded bitmap to the 3-3-2 palette.
+ *
+ * @param y the line.
+ * @param dst destination for the palette indices.
+ */
+static void flic_rec_quantize(int y, unsigned char *dst) {
+    BITMAP *bm = flic_rec.bm;
+    int depth = bitmap_color_depth(bm);
+
+    if (depth == 32) {
+        uint32_t *src = (uint32_t *)bm->line[y];
+        for (int x = 0; x < bm->w; x++) {
+            uint32_t c = src[x];
+            int r = (c >> _rgb_r_shift_32) & 0xFF;
+            int g = (c >> _rgb_g_shift_32) & 0xFF;
+            int b = (c >> _rgb_b_shift_32) & 0xFF;
+            dst[x] = (r & 0xE0) | ((g & 0xE0) >> 3) | (b >> 6);
+        }
+    } else {
+        for (int x = 0; x < bm->w; x++) {
+            int c = getpixel(bm, x, y);
+            dst[x] = (getr_depth(depth, c) & 0xE0) | ((getg_depth(depth, c) & 0xE0) >> 3) | (getb_depth(depth, c) >> 6);
+        }
+    }
+}
+
+/**
+ * @brief count the number of equal bytes starting at x.
+ *
+ * @param l the line.
+ * @param x start position.
+ * @param w width of the line.
+ * @param max maximum number to count.
+ *
+ * @return the length of the run.
+ */
+static int flic_rec_run(const uint8_t *l, int x, int w, int max) {
+    int n = 1;
+    while (x + n < w && n < max && l[x + n] == l[x]) {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief count the number of equal words starting at word x.
+ *
+ * @param l the line.
+ * @param x start position in words.
+ * @param words width of the line in words.
+ * @param max maximum number to count.
+ *
+ * @return the length of the run in words.
+ */
+static int flic_rec_wrun(const uint8_t *l, int x, int words, int max) {
+    int n = 1;
+    while (x + n < words && n < max && l[(x + n) * 2] == l[x * 2] && l[(x + n) * 2 + 1] == l[x * 2 + 1]) {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief encode a full line as BRUN packets.
+ *
+ * @param o destination.
+ * @param l the line as palette indices.
+ * @param w width of the line.
+ *
+ * @return the position after the encoded line.
+ */
+static uint8_t *flic_rec_brun(uint8_t *o, const uint8_t *l, int w) {
+    int x = 0;
+
+    *o++ = 0;  // packet count, FLC players ignore it
+    while (x < w) {
+        int run = flic_rec_run(l, x, w, 127);
+        if (run >= 3) {
+            *o++ = run;
+            *o++ = l[x];
+            x += run;
+        } else {
+            // literal bytes up to the next run of three
+            int n = 0;
+            while (x + n < w && n < 127 && flic_rec_run(l, x + n, w, 3) < 3) {
+                n++;
+            }
+            *o++ = (uint8_t)-n;
+            memcpy(o, &l[x], n);
+            o += n;
+            x += n;
+        }
+    }
+    return o;
+}
+
+/**
+ * @brief encode the changed pixels of a line as DELTA_FLC packets.
+ *
+ * @param o destination.
+ * @param l the line as palette indices.
+ * @param p the same line in the previous frame.
+ * @param words width of the line in words.
+ *
+ * @return the position after the encoded line.
+ */
+static uint8_t *flic_rec_delta(uint8_t *o, const uint8_t *l, const uint8_t *p, int words) {
+    uint8_t *count = o;
+    int packets = 0;
+    int skip = 0;
+    int x = 0;
+
+    o += 2;
+    while (true) {
+        while (x < words && FLC_REC_WORD_EQ(l, p, x)) {
+            x++;
+            skip++;
+        }
+        if (x >= words) {
+            break;
+        }
+
+        // the skip count is a byte, longer gaps need empty packets
+        while (skip > 127) {
+            *o++ = 254;
+            *o++ = 0;
+            packets++;
+            skip -= 127;
+        }
+        *o++ = skip * 2;
+        skip = 0;
+
+        int run = flic_rec_wrun(l, x, words, 127);
+        if (run >= 2) {
+            *o++ = (uint8_t)-run;
+            *o++ = l[x * 2];
+            *o++ = l[x * 2 + 1];
+            x += run;
+        } else {
+            // literal words up to two unchanged words or a run of three
+            int n = 0;
+            while (x + n < words && n < 127) {
+                if (FLC_REC_WORD_EQ(l, p, x + n) && (x + n + 1 >= words || FLC_REC_WORD_EQ(l, p, x + n + 1))) {
+                    break;
+                }
+                if (n > 0 && flic_rec_wrun(l, x + n, words, 3) >= 3) {
+                    break;
+                }
+                n++;
+            }
+            *o++ = n;
+            memcpy(o, &l[x * 2], n * 2);
+            o += n * 2;
+            x += n;
+        }
+        packets++;
+    }
+    flic_put16(count, packets);
+    return o;
+}
+
+/**
+ * @brief encode the first frame: 3-3-2 palette and the full image.
+ *
+ * @param o destination (after the frame header).
+ * @param chunks number of chunks is stored here.
+ *
+ * @return the position after the encoded data.
+ */
+static uint8_t *flic_rec_first(uint8_t *o, int *chunks) {
+    BITMAP *bm = flic_rec.bm;
+    uint8_t *chunk = o;
+
+    // palette
+    o += FLIC_REC_CHUNK_HEADER;
+    o = flic_put16(o, 1);  // one packet
+    *o++ = 0;              // skip 0
+    *o++ = 0;              // 256 entries
+    for (int i = 0; i < 256; i++) {
+        *o++ = ((i >> 5) & 7) * 255 / 7;
+        *o++ = ((i >> 2) & 7) * 255 / 7;
+        *o++ = (i & 3) * 255 / 3;
+    }
+    flic_put32(chunk, o - chunk);
+    flic_put16(chunk + 4, FLC_COLOR_256);
+
+    // image
+    chunk = o;
+    o += FLIC_REC_CHUNK_HEADER;
+    for (int y = 0; y < bm->h; y++) {
+        uint8_t *l = &flic_rec.frame8[y * bm->w];
+        flic_rec_quantize(y, l);
+        o = flic_rec_brun(o, l, bm->w);
+        memcpy(&flic_rec.prev[y * flic_rec.stride], bm->line[y], flic_rec.stride);
+    }
+    if ((o - chunk) & 1) {
+        *o++ = 0;
+    }
+    flic_put32(chunk, o - chunk);
+    flic_put16(chunk + 4, FLC_BRUN);
+
+    *chunks = 2;
+    return o;
+}
+
+/**
+ * @brief encode the lines that changed since the last frame.
+ *
+ * @param o destination (after the frame header).
+ * @param chunks number of chunks is stored here.
+ *
+ * @return the position after the encoded data.
+ */
+static uint8_t *flic_rec_next(uint8_t *o, int *chunks) {
+    BITMAP *bm = flic_rec.bm;
+    uint8_t *chunk = o;
+    int lines = 0;
+    int skip = 0;
+
+    o += FLIC_REC_CHUNK_HEADER + 2;
+    for (int y = 0; y < bm->h; y++) {
+        uint8_t *prev = &flic_rec.prev[y * flic_rec.stride];
+        uint8_t *p = &flic_rec.frame8[y * bm->w];
+        uint8_t *l = flic_rec.line8;
+
+        // only lines that differ from the last frame are converted and compared
+        if (memcmp(bm->line[y], prev, flic_rec.stride) == 0) {
+            skip++;
+            continue;
+        }
+        memcpy(prev, bm->line[y], flic_rec.stride);
+        flic_rec_quantize(y, l);
+        if (memcmp(l, p, bm->w) == 0) {
+            skip++;
+            continue;
+        }
+
+        if (skip) {
+            o = flic_put16(o, (-skip) & 0xFFFF);
+            skip = 0;
+        }
+        if ((bm->w & 1) && l[bm->w - 1] != p[bm->w - 1]) {
+            o = flic_put16(o, 0x8000 | l[bm->w - 1]);
+        }
+        o = flic_rec_delta(o, l, p, bm->w / 2);
+        memcpy(p, l, bm->w);
+        lines++;
+    }
+
+    if (!lines) {
+        *chunks = 0;
+        return chunk;
+    }
+    if ((o - chunk) & 1) {
+        *o++ = 0;
+    }
+    flic_put32(chunk, o - chunk);
+    flic_put16(chunk + 4, FLC_DELTA);
+    flic_put16(chunk + FLIC_REC_CHUNK_HEADER, lines);
+
+    *chunks = 1;
+    return o;
+}
+
+/**
+ * @brief write a frame to the output file.
+ *
+ * @param empty true to write a frame without chunks that repeats the last image.
+ *
+ * @return true if the frame was written.
+ */
+static bool flic_rec_write(bool empty) {
+    uint8_t *o = flic_rec.out + FLIC_REC_FRAME_HEADER;
+    int chunks = 0;
+
+    if (!empty) {
+        if (flic_rec.frames == 0) {
+            o = flic_rec_first(o, &chunks);
+        } else {
+            o = flic_rec_next(o, &chunks);
+        }
+    }
+
+    size_t size = o - flic_rec.out;
+    bzero(flic_rec.out, FLIC_REC_FRAME_HEADER);
+    flic_put32(flic_rec.out, size);
+    flic_put16(flic_rec.out + 4, FLC_FRAME_TYPE);
+    flic_put16(flic_rec.out + 6, chunks);
+    if (fwrite(flic_rec.out, size, 1, flic_rec.f) != 1) {
+        return false;
+    }
+
+    flic_rec.bytes += size;
+    flic_rec.frames++;
+    if (flic_rec.frames == 1) {
+        flic_rec.frame2 = flic_rec.bytes;
+    }
+    return true;
+}
+
 
 /**
  * @brief open FLI/FLC file
@@ -77,6 +498,7 @@ static void f_FlicPlay(js_State *J) {
          0, fli_bmp_dirty_from,          // src x/y
          x, y,                           // dest x/y
          fli_bitmap->w, fli_bitmap->h);  // width and height
+    dirty_add(DOjS.current_bm, x, y, x + fli_bitmap->w - 1, y + fli_bitmap->h - 1);
     int ret = next_fli_frame(loop);
 
     if (ret == FLI_EOF) {
@@ -93,6 +515,101 @@ static void f_FlicPlay(js_State *J) {
  */
 static void f_FlicClose(js_State *J) { close_fli(); }
 
+/**
+ * @brief start recording the screen into a FLC file.
+ * FlicRecordStart(fname:string[, fps:number])
+ *
+ * @param J VM state.
+ */
+static void f_FlicRecordStart(js_State *J) {
+    const char *fname = js_tostring(J, 1);
+    float fps = DOjS.wanted_frame_rate;
+    if (js_isnumber(J, 2)) {
+        fps = js_tonumber(J, 2);
+    }
+
+    if (flic_rec.f) {
+        js_error(J, "FLC recording already running");
+        return;
+    }
+    if (DOjS.glide_enabled) {
+        js_error(J, "FLC recording is not available with 3dfx");
+        return;
+    }
+    if (fps <= 0 || fps > 1000 / TICK_DELAY) {
+        js_error(J, "Frame rate must be between 1 and %d", 1000 / TICK_DELAY);
+        return;
+    }
+
+    BITMAP *bm = DOjS.render_bm;
+    flic_rec.bm = bm;
+    flic_rec.stride = bm->w * ((bitmap_color_depth(bm) + 7) / 8);
+    flic_rec.frames = flic_rec.repeated = flic_rec.skipped = 0;
+    flic_rec.bytes = FLIC_REC_HEADER;
+    flic_rec.speed = MAX(1, (int)(1000 / fps));
+    flic_rec.frame2 = 0;
+
+    flic_rec.vbuf = malloc(FLIC_REC_BUFFER);
+    flic_rec.prev = malloc(flic_rec.stride * bm->h);
+    flic_rec.frame8 = malloc(bm->w * bm->h);
+    flic_rec.line8 = malloc(bm->w);
+    flic_rec.out = malloc((bm->w * 2 + 16) * bm->h + 1024);
+    if (!flic_rec.vbuf || !flic_rec.prev || !flic_rec.frame8 || !flic_rec.line8 || !flic_rec.out) {
+        flic_rec_close();
+        JS_ENOMEM(J);
+        return;
+    }
+
+    flic_rec.f = fopen(fname, "wb");
+    if (!flic_rec.f) {
+        flic_rec_close();
+        js_error(J, "Could not create FLC %s", fname);
+        return;
+    }
+    setvbuf(flic_rec.f, flic_rec.vbuf, _IOFBF, FLIC_REC_BUFFER);
+
+    // placeholder, the header is rewritten with the final values by FlicRecordStop()
+    if (!flic_rec_header()) {
+        flic_rec_close();
+        js_error(J, "Could not write FLC %s", fname);
+        return;
+    }
+}
+
+/**
+ * @brief stop recording and finish the FLC file.
+ * FlicRecordStop()
+ *
+ * @param J VM state.
+ */
+static void f_FlicRecordStop(js_State *J) {
+    if (flic_rec.f && !flic_rec_close()) {
+        js_error(J, "Could not write FLC");
+    }
+}
+
+/**
+ * @brief get statistics of the current/last recording.
+ * FlicRecordStats():{"recording":boolean, "frames":number, "repeated":number, "skipped":number, "bytes":number}
+ *
+ * @param J VM state.
+ */
+static void f_FlicRecordStats(js_State *J) {
+    js_newobject(J);
+    {
+        js_pushboolean(J, flic_rec.f != NULL);
+        js_setproperty(J, -2, "recording");
+        js_pushnumber(J, flic_rec.frames);
+        js_setproperty(J, -2, "frames");
+        js_pushnumber(J, flic_rec.repeated);
+        js_setproperty(J, -2, "repeated");
+        js_pushnumber(J, flic_rec.skipped);
+        js_setproperty(J, -2, "skipped");
+        js_pushnumber(J, flic_rec.bytes);
+        js_setproperty(J, -2, "bytes");
+    }
+}
+
 /***********************
 ** exported functions **
 ***********************/
@@ -108,6 +625,10 @@ void init_flic(js_State *J) {
     NFUNCDEF(J, FlicOpen, 1);
     NFUNCDEF(J, FlicPlay, 3);
 
+    NFUNCDEF(J, FlicRecordStart, 2);
+    NFUNCDEF(J, FlicRecordStop, 0);
+    NFUNCDEF(J, FlicRecordStats, 0);
+
     DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
 }
 
@@ -118,6 +639,44 @@ void shutdown_flic() {
     DEBUGF("%s\n", __PRETTY_FUNCTION__);
 
     close_fli();
+    flic_rec_close();
 
     DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
 }
+
+/**
+ * @brief append the presented render bitmap to the running FLC recording.
+ * Called by the main loop after each Loop(). Frames are timed by DOjS.sys_ticks: if Loop() is faster than the
+ * recording rate frames are dropped, if it is slower the previous image is repeated with empty frames.
+ */
+void flic_record_frame(void) {
+    if (!flic_rec.f) {
+        return;
+    }
+
+    if (flic_rec.frames == 0) {
+        flic_rec.start = DOjS.sys_ticks;
+    }
+    unsigned long due = (DOjS.sys_ticks - flic_rec.start) / flic_rec.speed;
+    if (due < flic_rec.frames) {
+        flic_rec.skipped++;
+        return;
+    }
+
+    bool ok = true;
+    while (ok && flic_rec.frames > 0 && flic_rec.frames < due && flic_rec.frames < FLIC_REC_MAX_FRAMES - 1) {
+        ok = flic_rec_write(true);
+        flic_rec.repeated++;
+    }
+    if (ok) {
+        ok = flic_rec_write(false);
+    }
+
+    if (!ok) {
+        LOGF("Error writing FLC, recording stopped\n");
+        flic_rec_close();
+    } else if (flic_rec.frames >= FLIC_REC_MAX_FRAMES) {
+        LOGF("FLC frame limit reached, recording stopped\n");
+        flic_rec_close();
+    }
+}
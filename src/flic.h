@@ -29,11 +29,17 @@ SOFTWARE.
 /************
 ** defines **
 ************/
+#define FLIC_REC_HEADER 128           //!< size of the FLC file header
+#define FLIC_REC_FRAME_HEADER 16      //!< size of a frame header
+#define FLIC_REC_CHUNK_HEADER 6       //!< size of a chunk header
+#define FLIC_REC_BUFFER (256 * 1024)  //!< size of the stdio buffer for the output file
+#define FLIC_REC_MAX_FRAMES 0xFFFF    //!< the frame counter in the header is 16bit
 
 /*********************
 ** static functions **
 *********************/
 extern void init_flic(js_State *J);
 extern void shutdown_flic(void);
+extern void flic_record_frame(void);
 
 #endif  // __FLIC_H__
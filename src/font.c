@@ -30,6 +30,7 @@ SOFTWARE.
 
 #include "DOjS.h"
 #include "color.h"
+#include "dirty.h"
 #include "zipfile.h"
 
 /*********************
@@ -113,6 +114,7 @@ static void Font_DrawStringLeft(js_State *J) {
     int bg = js_toint32(J, 5);
 
     textout_ex(DOjS.current_bm, f, str, x, y, fg, bg);
+    dirty_add(DOjS.current_bm, x, y, x + text_length(f, str) - 1, y + text_height(f) - 1);
 }
 
 /**
@@ -132,6 +134,8 @@ static void Font_DrawStringCenter(js_State *J) {
     int bg = js_toint32(J, 5);
 
     textout_centre_ex(DOjS.current_bm, f, str, x, y, fg, bg);
+    int len = text_length(f, str);
+    dirty_add(DOjS.current_bm, x - len / 2 - 1, y, x + len / 2, y + text_height(f) - 1);
 }
 
 /**
@@ -151,6 +155,7 @@ static void Font_DrawStringRight(js_State *J) {
     int bg = js_toint32(J, 5);
 
     textout_right_ex(DOjS.current_bm, f, str, x, y, fg, bg);
+    dirty_add(DOjS.current_bm, x - text_length(f, str), y, x, y + text_height(f) - 1);
 }
 
 /**
@@ -30,6 +30,7 @@ SOFTWARE.
 #include <dlfcn.h>
 
 #include "util.h"
+#include "bytecode.h"
 #include "socket.h"
 #include "zipfile.h"
 #include "jsi.h"
@@ -334,7 +335,44 @@ static void f_Stop(js_State *J) { DOjS.keep_running = false; }
  */
 static void f_Gc(js_State *J) {
     bool report = js_toboolean(J, 1);
-    js_gc(J, report);
+    gc_collect(J, report);
+}
+
+/**
+ * @brief get hit/miss counters of the property inline caches of all compiled functions.
+ * InlineCacheStats(reset:boolean):[{"file":XXX, "line":XXX, "name":XXX, "hits":XXX, "misses":XXX}, ...]
+ *
+ * @param J the JS context.
+ */
+static void f_InlineCacheStats(js_State *J) {
+    bool reset = js_toboolean(J, 1);
+    int idx = 0;
+
+    js_newarray(J);
+    for (js_Function *fun = J->gcfun; fun; fun = fun->gcnext) {
+        for (int i = 0; i < fun->cachelen; i++) {
+            js_InlineCache *ic = &fun->cachetab[i];
+            if (ic->hits || ic->misses) {
+                js_newobject(J);
+                {
+                    js_pushstring(J, fun->filename);
+                    js_setproperty(J, -2, "file");
+                    js_pushnumber(J, ic->line);
+                    js_setproperty(J, -2, "line");
+                    js_pushstring(J, ic->name);
+                    js_setproperty(J, -2, "name");
+                    js_pushnumber(J, ic->hits);
+                    js_setproperty(J, -2, "hits");
+                    js_pushnumber(J, ic->misses);
+                    js_setproperty(J, -2, "misses");
+                }
+                js_setindex(J, -2, idx++);
+            }
+            if (reset) {
+                ic->hits = ic->misses = 0;
+            }
+        }
+    }
 }
 
 /**
@@ -569,38 +607,17 @@ static void f_StringToBytes(js_State *J) {
 /**
  * @brief parse string and run it as function.
  * This works like Function(), but it only takes one parameter and the source of the parsed string can be provided.
+ * If the filename is provided the compiled function is kept in the bytecode cache.
  * NamedFunction(func_param, func_src, func_source_filename):function
  *
  * @param J
  */
 static void f_NamedFunction(js_State *J) {
-    js_Buffer *sb = NULL;
-    const char *body, *fname;
-    js_Ast *parse;
-    js_Function *fun;
-
-    if (js_try(J)) {
-        js_free(J, sb);
-        jsP_freeparse(J);
-        js_throw(J);
-    }
-
-    js_puts(J, &sb, js_tostring(J, 1));
-    js_putc(J, &sb, ')');
-    js_putc(J, &sb, 0);
-
-    /* body */
-    body = js_isdefined(J, 2) ? js_tostring(J, 2) : "";
-    fname = js_isdefined(J, 3) ? js_tostring(J, 3) : "[string]";
-
-    parse = jsP_parsefunction(J, fname, sb ? sb->s : NULL, body);
-    fun = jsC_compilefunction(J, parse);
-
-    js_endtry(J);
-    js_free(J, sb);
-    jsP_freeparse(J);
+    const char *params = js_tostring(J, 1);
+    const char *body = js_isdefined(J, 2) ? js_tostring(J, 2) : "";
+    const char *fname = js_isdefined(J, 3) ? js_tostring(J, 3) : "[string]";
 
-    js_newfunction(J, fun, J->GE);
+    bc_loadfunction(J, fname, params, body, js_isdefined(J, 3));
 }
 
 /**
@@ -816,6 +833,7 @@ void init_funcs(js_State *J, int argc, char **argv, int args) {
     NFUNCDEF(J, Stop, 0);
     NFUNCDEF(J, Gc, 1);
     NFUNCDEF(J, MemoryInfo, 0);
+    NFUNCDEF(J, InlineCacheStats, 1);
     NFUNCDEF(J, Sleep, 1);
     NFUNCDEF(J, MsecTime, 0);
     NFUNCDEF(J, SetFramerate, 1);
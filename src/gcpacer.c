@@ -0,0 +1,379 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gcpacer.h"
+
+#include <jsi.h>
+#include <mujs.h>
+#include <string.h>
+#include <time.h>
+
+#include "DOjS.h"
+
+/************
+** structs **
+************/
+typedef struct {
+    int growth;                 //!< allowed heap growth in percent before the next collection
+    size_t minimum;             //!< heap size that is always allowed without a collection
+    size_t live;                //!< heap size (JS + native) right after the last collection
+    size_t trigger;             //!< heap size that triggers the next collection
+    size_t freed;               //!< number of bytes freed by the last collection
+    unsigned long collections;  //!< number of collections since start
+    unsigned long paced;        //!< number of collections triggered by the pacer
+    double last_pause;          //!< duration of the last collection in ms
+    double max_pause;           //!< longest collection in ms
+    double total_pause;         //!< sum of all collections and incremental steps in ms
+    double budget;              //!< GC time per frame in ms, 0 for stop-the-world collections only
+    unsigned long steps;        //!< number of incremental steps since start
+    double last_step;           //!< duration of the last incremental step in ms
+    double max_step;            //!< longest incremental step in ms
+    double frame;               //!< GC time spent by gc_frame() in the last frame in ms
+    unsigned int cycles;        //!< value of J->gccycles when the pacer last looked
+    size_t cycle_start;         //!< heap size when the running incremental cycle was noticed, 0 if none
+} gc_pacer_t;
+
+/*********************
+** static variables **
+*********************/
+static gc_pacer_t gc_pacer;  //!< pacer state and statistics
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief current heap size as seen by the pacer (JS heap + native memory owned by userdata).
+ *
+ * @return size_t number of bytes.
+ */
+static size_t gc_heap_size() { return DOjS.js_bytes + DOjS.native_bytes; }
+
+/**
+ * @brief calculate the heap size that triggers the next collection from the live heap size.
+ */
+static void gc_update_trigger() {
+    size_t trigger = gc_pacer.live + (gc_pacer.live / 100) * gc_pacer.growth;
+    gc_pacer.trigger = trigger < gc_pacer.minimum ? gc_pacer.minimum : trigger;
+}
+
+/**
+ * @brief update statistics and trigger when a cycle was completed, either by gc_step() or by the interpreter.
+ *
+ * @param J VM state.
+ */
+static void gc_track(js_State *J) {
+    if (J->gccycles != gc_pacer.cycles) {
+        gc_pacer.cycles = J->gccycles;
+        gc_pacer.collections++;
+        gc_pacer.live = gc_heap_size();
+        gc_pacer.freed = gc_pacer.cycle_start > gc_pacer.live ? gc_pacer.cycle_start - gc_pacer.live : 0;
+        gc_pacer.cycle_start = 0;
+        gc_update_trigger();
+    }
+    if (J->gcstate != JS_GCIDLE && !gc_pacer.cycle_start) {
+        gc_pacer.cycle_start = gc_heap_size();
+    }
+}
+
+/**
+ * @brief run one incremental GC step (starting a new cycle if none is running) and record its duration.
+ *
+ * @param J VM state.
+ * @param report true to print collection stats to logfile when the cycle completes.
+ *
+ * @return true if the cycle was completed by this step.
+ */
+static bool gc_step(js_State *J, bool report) {
+    gc_track(J);
+    if (J->gcstate == JS_GCIDLE) {
+        gc_pacer.cycle_start = gc_heap_size();
+    }
+
+    uclock_t start = uclock();
+    bool done = js_gcstep(J, GC_STEP_WORK, report);
+    double pause = (double)(uclock() - start) * 1000.0 / UCLOCKS_PER_SEC;
+
+    gc_pacer.steps++;
+    gc_pacer.last_step = pause;
+    gc_pacer.total_pause += pause;
+    if (pause > gc_pacer.max_step) {
+        gc_pacer.max_step = pause;
+    }
+    gc_track(J);
+    return done;
+}
+
+/**
+ * @brief get GC statistics.
+ * GcStats():GcInfo
+ *
+ * @param J the JS context.
+ */
+static void f_GcStats(js_State *J) {
+    js_newobject(J);
+    {
+        js_pushnumber(J, DOjS.js_bytes);
+        js_setproperty(J, -2, "heap");
+        js_pushnumber(J, DOjS.native_bytes);
+        js_setproperty(J, -2, "native");
+        js_pushnumber(J, gc_pacer.live);
+        js_setproperty(J, -2, "live");
+        js_pushnumber(J, gc_pacer.trigger);
+        js_setproperty(J, -2, "trigger");
+        js_pushnumber(J, gc_pacer.freed);
+        js_setproperty(J, -2, "freed");
+        js_pushnumber(J, gc_pacer.growth);
+        js_setproperty(J, -2, "growth");
+        js_pushnumber(J, gc_pacer.minimum);
+        js_setproperty(J, -2, "minimum");
+        js_pushnumber(J, gc_pacer.collections);
+        js_setproperty(J, -2, "collections");
+        js_pushnumber(J, gc_pacer.paced);
+        js_setproperty(J, -2, "paced");
+        js_pushnumber(J, gc_pacer.last_pause);
+        js_setproperty(J, -2, "last_pause");
+        js_pushnumber(J, gc_pacer.max_pause);
+        js_setproperty(J, -2, "max_pause");
+        js_pushnumber(J, gc_pacer.total_pause);
+        js_setproperty(J, -2, "total_pause");
+        js_pushnumber(J, gc_pacer.budget);
+        js_setproperty(J, -2, "budget");
+        js_pushnumber(J, gc_pacer.steps);
+        js_setproperty(J, -2, "steps");
+        js_pushnumber(J, gc_pacer.last_step);
+        js_setproperty(J, -2, "last_step");
+        js_pushnumber(J, gc_pacer.max_step);
+        js_setproperty(J, -2, "max_step");
+        js_pushnumber(J, gc_pacer.frame);
+        js_setproperty(J, -2, "frame");
+        js_pushnumber(J, J->gcstate);
+        js_setproperty(J, -2, "state");
+    }
+}
+
+/**
+ * @brief get occupancy of the MuJS allocation pools.
+ * PoolStats():PoolInfo[]
+ *
+ * @param J the JS context.
+ */
+static void f_PoolStats(js_State *J) {
+    js_PoolInfo info;
+    int i;
+
+    js_newarray(J);
+    for (i = 0; js_poolinfo(J, i, &info); i++) {
+        js_newobject(J);
+        {
+            js_pushstring(J, info.name);
+            js_setproperty(J, -2, "name");
+            js_pushnumber(J, info.size);
+            js_setproperty(J, -2, "size");
+            js_pushnumber(J, info.used);
+            js_setproperty(J, -2, "used");
+            js_pushnumber(J, info.peak);
+            js_setproperty(J, -2, "peak");
+            js_pushnumber(J, info.capacity);
+            js_setproperty(J, -2, "capacity");
+            js_pushnumber(J, info.slabs);
+            js_setproperty(J, -2, "slabs");
+            js_pushnumber(J, info.released);
+            js_setproperty(J, -2, "released");
+        }
+        js_setindex(J, -2, i);
+    }
+}
+
+/**
+ * @brief configure the GC pacer.
+ * SetGcGrowth(percent:number[, minimum:number])
+ *
+ * @param J the JS context.
+ */
+static void f_SetGcGrowth(js_State *J) {
+    int growth = js_toint32(J, 1);
+    if (growth < 0 || growth > GC_MAX_GROWTH) {
+        js_error(J, "Growth must be between 0 and %d percent", GC_MAX_GROWTH);
+        return;
+    }
+    gc_pacer.growth = growth;
+
+    if (js_isnumber(J, 2)) {
+        int minimum = js_toint32(J, 2);
+        JS_CHECKPOS(J, minimum);
+        gc_pacer.minimum = minimum;
+    }
+    gc_update_trigger();
+}
+
+/**
+ * @brief set the time the GC may use per frame.
+ * SetGcBudget(ms:number)
+ *
+ * @param J the JS context.
+ */
+static void f_SetGcBudget(js_State *J) {
+    double budget = js_tonumber(J, 1);
+    if (!(budget >= 0 && budget <= GC_MAX_BUDGET)) {
+        js_error(J, "Budget must be between 0 and %d ms", (int)GC_MAX_BUDGET);
+        return;
+    }
+    gc_pacer.budget = budget;
+    js_gcincremental(J, budget > 0);
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize GC pacer subsystem.
+ *
+ * @param J VM state.
+ */
+void init_gcpacer(js_State *J) {
+    DEBUGF("%s\n", __PRETTY_FUNCTION__);
+
+    memset(&gc_pacer, 0, sizeof(gc_pacer));
+    gc_pacer.growth = GC_DEFAULT_GROWTH;
+    gc_pacer.minimum = GC_DEFAULT_MINIMUM;
+    gc_pacer.budget = GC_DEFAULT_BUDGET;
+    gc_pacer.live = gc_heap_size();
+    gc_pacer.cycles = J->gccycles;
+    gc_update_trigger();
+    js_gcincremental(J, true);
+
+    NFUNCDEF(J, GcStats, 0);
+    NFUNCDEF(J, SetGcGrowth, 2);
+    NFUNCDEF(J, SetGcBudget, 1);
+    NFUNCDEF(J, PoolStats, 0);
+
+    DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
+}
+
+/**
+ * @brief account native memory that is owned by a JS object (e.g. pixel data of a Bitmap).
+ *
+ * @param size number of bytes allocated.
+ */
+void gc_native_alloc(size_t size) { DOjS.native_bytes += size; }
+
+/**
+ * @brief account native memory that was released by a JS object.
+ *
+ * @param size number of bytes released.
+ */
+void gc_native_free(size_t size) {
+    if (size > DOjS.native_bytes) {
+        // more was freed than allocated, an alloc/free pair is unbalanced. Report it instead of wrapping around
+        LOGF("Unbalanced native memory accounting: freeing %lu bytes with only %lu accounted\n", (unsigned long)size,
+             (unsigned long)DOjS.native_bytes);
+        DOjS.native_bytes = 0;
+    } else {
+        DOjS.native_bytes -= size;
+    }
+}
+
+/**
+ * @brief run a collection if the heap grew beyond the current trigger size.
+ * This is cheap enough to be called before every native object creation.
+ * With a GC budget only a single incremental step is done, the rest of the cycle is run by gc_frame().
+ * A full collection is still done if the heap grows to twice the trigger size before the cycle completes.
+ *
+ * @param J VM state.
+ */
+void gc_check(js_State *J) {
+#ifdef MEMDEBUG
+    bool report = true;
+#else
+    bool report = false;
+#endif
+    size_t heap = gc_heap_size();
+
+    if (heap >= gc_pacer.trigger) {
+        if (gc_pacer.budget > 0 && heap < 2 * gc_pacer.trigger) {
+            if (J->gcstate == JS_GCIDLE) {
+                gc_pacer.paced++;
+            }
+            gc_step(J, report);
+        } else {
+            gc_pacer.paced++;
+            gc_collect(J, report);
+        }
+    }
+}
+
+/**
+ * @brief run incremental GC steps of a cycle in progress until it completes or the per-frame budget is used up.
+ * Called once per frame from the main loop.
+ *
+ * @param J VM state.
+ */
+void gc_frame(js_State *J) {
+    gc_pacer.frame = 0;
+    gc_track(J);
+    if (gc_pacer.budget <= 0 || J->gcpause) {
+        return;
+    }
+
+    uclock_t start = uclock();
+    while (J->gcstate != JS_GCIDLE) {
+#ifdef MEMDEBUG
+        gc_step(J, true);
+#else
+        gc_step(J, false);
+#endif
+        gc_pacer.frame = (double)(uclock() - start) * 1000.0 / UCLOCKS_PER_SEC;
+        if (gc_pacer.frame >= gc_pacer.budget) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief run a full collection, update the statistics and calculate the next trigger size.
+ *
+ * @param J VM state.
+ * @param report true to print collection stats to logfile.
+ */
+void gc_collect(js_State *J, bool report) {
+    if (J->gcpause) {
+        js_gc(J, report);  // let mujs do the reporting
+        return;
+    }
+
+    size_t before = gc_heap_size();
+    uclock_t start = uclock();
+    js_gc(J, report);
+    double pause = (double)(uclock() - start) * 1000.0 / UCLOCKS_PER_SEC;
+
+    gc_pacer.collections++;
+    gc_pacer.last_pause = pause;
+    gc_pacer.total_pause += pause;
+    if (pause > gc_pacer.max_pause) {
+        gc_pacer.max_pause = pause;
+    }
+    gc_pacer.live = gc_heap_size();
+    gc_pacer.freed = before > gc_pacer.live ? before - gc_pacer.live : 0;
+    gc_pacer.cycles = J->gccycles;
+    gc_pacer.cycle_start = 0;
+    gc_update_trigger();
+}
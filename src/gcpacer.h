@@ -0,0 +1,50 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __GCPACER_H__
+#define __GCPACER_H__
+
+#include <mujs.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/************
+** defines **
+************/
+#define GC_DEFAULT_GROWTH 100             //!< heap growth in percent of the live heap before the next collection
+#define GC_DEFAULT_MINIMUM (1024 * 1024)  //!< heap size below which no paced collection takes place
+#define GC_MAX_GROWTH 10000               //!< upper limit for the growth factor
+#define GC_DEFAULT_BUDGET 2.0             //!< GC time per frame in ms for incremental collection
+#define GC_MAX_BUDGET 1000.0              //!< upper limit for the per-frame GC budget
+#define GC_STEP_WORK 1000                 //!< work units (objects/properties) of a single incremental step
+
+/*********************
+** static functions **
+*********************/
+extern void init_gcpacer(js_State *J);
+extern void gc_native_alloc(size_t size);
+extern void gc_native_free(size_t size);
+extern void gc_check(js_State *J);
+extern void gc_collect(js_State *J, bool report);
+extern void gc_frame(js_State *J);
+
+#endif  // __GCPACER_H__
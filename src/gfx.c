@@ -33,9 +33,14 @@ SOFTWARE.
 
 #include "DOjS.h"
 #include "bitmap.h"
+#include "blender.h"
 #include "color.h"
+#include "dirty.h"
 #include "funcs.h"
 #include "gfx.h"
+#include "imgcache.h"
+#include "qoi.h"
+#include "stroke.h"
 #include "util.h"
 
 /************
@@ -65,11 +70,6 @@ typedef struct _arc_return {
  */
 static arc_return_t arcReturn;
 
-/**
- * @brief radius of the current custom primitive.
- */
-static int customRadius;
-
 /*********************
 ** static functions **
 *********************/
@@ -212,6 +212,7 @@ static void f_ClearScreen(js_State *J) {
     int color = js_toint32(J, 1);
 
     clear_to_color(DOjS.current_bm, color);
+    dirty_add_all(DOjS.current_bm);
 }
 
 /**
@@ -228,6 +229,7 @@ static void f_Plot(js_State *J) {
     int color = js_toint32(J, 3);
 
     putpixel(DOjS.current_bm, x, y, color);
+    dirty_add(DOjS.current_bm, x, y, x, y);
 }
 
 /**
@@ -246,22 +248,13 @@ static void f_Line(js_State *J) {
     int color = js_toint32(J, 5);
 
     line(DOjS.current_bm, x1, y1, x2, y2, color);
+    dirty_add(DOjS.current_bm, x1, y1, x2, y2);
 }
 
-/**
- * @brief custom function to draw 'larger pixels'.
- *
- * @param bmp destination BITMAP.
- * @param x pixel coordinate.
- * @param y pixel coordinate.
- * @param d color.
- */
-static void f_customPixel(BITMAP *bmp, int x, int y, int d) { circlefill(bmp, x, y, customRadius, d); }
-
 /**
  * @brief draw a line with variable thinkness.
  *
- * CustomLine(x1:number, y1:number, x2:number, y2:number, w:number, c:Color)
+ * CustomLine(x1:number, y1:number, x2:number, y2:number, w:number, c:Color[, cap:number])
  *
  * @param J the JS context.
  */
@@ -274,12 +267,14 @@ static void f_CustomLine(js_State *J) {
 
     int color = js_toint32(J, 6);
 
-    if (w % 2) {
-        customRadius = w / 2 + 1;
-    } else {
-        customRadius = w / 2;
+    int cap = CAP_ROUND;
+    if (js_isnumber(J, 7)) {
+        cap = js_toint32(J, 7);
     }
-    do_line(DOjS.current_bm, x1, y1, x2, y2, color, f_customPixel);
+
+    stroke_line(DOjS.current_bm, x1, y1, x2, y2, w, cap, color);
+    int m = STROKE_MARGIN(w);
+    dirty_add(DOjS.current_bm, MIN(x1, x2) - m, MIN(y1, y2) - m, MAX(x1, x2) + m, MAX(y1, y2) + m);
 }
 
 /**
@@ -298,6 +293,7 @@ static void f_Box(js_State *J) {
     int color = js_toint32(J, 5);
 
     rect(DOjS.current_bm, x1, y1, x2, y2, color);
+    dirty_add(DOjS.current_bm, x1, y1, x2, y2);
 }
 
 /**
@@ -315,6 +311,7 @@ static void f_Circle(js_State *J) {
     int color = js_toint32(J, 4);
 
     circle(DOjS.current_bm, x, y, r, color);
+    dirty_add(DOjS.current_bm, x - r, y - r, x + r, y + r);
 }
 
 /**
@@ -332,12 +329,14 @@ static void f_CustomCircle(js_State *J) {
 
     int color = js_toint32(J, 5);
 
-    if (w % 2) {
-        customRadius = w / 2 + 1;
-    } else {
-        customRadius = w / 2;
+    if (!stroke_begin(DOjS.current_bm, w)) {
+        JS_ENOMEM(J);
+        return;
     }
-    do_circle(DOjS.current_bm, x, y, r, color, f_customPixel);
+    do_circle(DOjS.current_bm, x, y, r, color, stroke_point);
+    stroke_end(DOjS.current_bm, color);
+    int m = STROKE_MARGIN(w);
+    dirty_add(DOjS.current_bm, x - r - m, y - r - m, x + r + m, y + r + m);
 }
 
 /**
@@ -356,6 +355,7 @@ static void f_Ellipse(js_State *J) {
     int color = js_toint32(J, 5);
 
     ellipse(DOjS.current_bm, xc, yc, xa, ya, color);
+    dirty_add(DOjS.current_bm, xc - abs(xa), yc - abs(ya), xc + abs(xa), yc + abs(ya));
 }
 
 /**
@@ -374,12 +374,14 @@ static void f_CustomEllipse(js_State *J) {
 
     int color = js_toint32(J, 6);
 
-    if (w % 2) {
-        customRadius = w / 2 + 1;
-    } else {
-        customRadius = w / 2;
+    if (!stroke_begin(DOjS.current_bm, w)) {
+        JS_ENOMEM(J);
+        return;
     }
-    do_ellipse(DOjS.current_bm, xc, yc, xa, ya, color, f_customPixel);
+    do_ellipse(DOjS.current_bm, xc, yc, xa, ya, color, stroke_point);
+    stroke_end(DOjS.current_bm, color);
+    int m = STROKE_MARGIN(w);
+    dirty_add(DOjS.current_bm, xc - abs(xa) - m, yc - abs(ya) - m, xc + abs(xa) + m, yc + abs(ya) + m);
 }
 
 /**
@@ -401,21 +403,21 @@ static void f_recordingPixel(BITMAP *bmp, int x, int y, int d) {
 }
 
 /**
- * @brief record the coordinates while drawing custom pixels.
+ * @brief record the coordinates while collecting the spans of a wide stroke.
  *
  * @param bmp destination BITMAP.
  * @param x pixel coordinate.
  * @param y pixel coordinate.
  * @param d color.
  */
-static void f_recordingCustomPixel(BITMAP *bmp, int x, int y, int d) {
+static void f_recordingStrokePoint(BITMAP *bmp, int x, int y, int d) {
     arcReturn.endX = x;
     arcReturn.endY = y;
     if (arcReturn.startX == -1) {
         arcReturn.startX = x;
         arcReturn.startY = y;
     }
-    circlefill(bmp, x, y, customRadius, d);
+    stroke_point(bmp, x, y, d);
 }
 
 /**
@@ -444,6 +446,7 @@ static void f_CircleArc(js_State *J) {
     arcReturn.centerX = x;
     arcReturn.centerY = y;
     do_arc(DOjS.current_bm, x, y, ftofix(start), ftofix(end), r, color, f_recordingPixel);
+    dirty_add(DOjS.current_bm, x - r, y - r, x + r, y + r);
 
     f_arcReturn(J, &arcReturn);
 }
@@ -472,15 +475,17 @@ static void f_CustomCircleArc(js_State *J) {
 
     int color = js_toint32(J, 7);
 
-    if (w % 2) {
-        customRadius = w / 2 + 1;
-    } else {
-        customRadius = w / 2;
+    if (!stroke_begin(DOjS.current_bm, w)) {
+        JS_ENOMEM(J);
+        return;
     }
     arcReturn.startX = arcReturn.startY = -1;
     arcReturn.centerX = x;
     arcReturn.centerY = y;
-    do_arc(DOjS.current_bm, x, y, ftofix(start), ftofix(end), r, color, f_recordingCustomPixel);
+    do_arc(DOjS.current_bm, x, y, ftofix(start), ftofix(end), r, color, f_recordingStrokePoint);
+    stroke_end(DOjS.current_bm, color);
+    int m = STROKE_MARGIN(w);
+    dirty_add(DOjS.current_bm, x - r - m, y - r - m, x + r + m, y + r + m);
 
     f_arcReturn(J, &arcReturn);
 }
@@ -501,6 +506,7 @@ static void f_FilledBox(js_State *J) {
     int color = js_toint32(J, 5);
 
     rectfill(DOjS.current_bm, x1, y1, x2, y2, color);
+    dirty_add(DOjS.current_bm, x1, y1, x2, y2);
 }
 
 /**
@@ -518,6 +524,7 @@ static void f_FilledCircle(js_State *J) {
     int color = js_toint32(J, 4);
 
     circlefill(DOjS.current_bm, x, y, r, color);
+    dirty_add(DOjS.current_bm, x - r, y - r, x + r, y + r);
 }
 
 /**
@@ -536,6 +543,7 @@ static void f_FilledEllipse(js_State *J) {
     int color = js_toint32(J, 5);
 
     ellipsefill(DOjS.current_bm, xc, yc, xa, ya, color);
+    dirty_add(DOjS.current_bm, xc - abs(xa), yc - abs(ya), xc + abs(xa), yc + abs(ya));
 }
 
 /**
@@ -551,6 +559,7 @@ static void f_FloodFill(js_State *J) {
     int color = js_toint32(J, 3);
 
     floodfill(DOjS.current_bm, x, y, color);
+    dirty_add_all(DOjS.current_bm);
 }
 
 /**
@@ -567,6 +576,16 @@ static void f_FilledPolygon(js_State *J) {
     int color = js_toint32(J, 2);
 
     polygon(DOjS.current_bm, array->len, array->data, color);
+    if (array->len > 0) {
+        int x1 = array->data[0], y1 = array->data[1], x2 = x1, y2 = y1;
+        for (int i = 1; i < array->len; i++) {
+            x1 = MIN(x1, array->data[i * 2 + 0]);
+            y1 = MIN(y1, array->data[i * 2 + 1]);
+            x2 = MAX(x2, array->data[i * 2 + 0]);
+            y2 = MAX(y2, array->data[i * 2 + 1]);
+        }
+        dirty_add(DOjS.current_bm, x1, y1, x2, y2);
+    }
 
     f_freeArray(array);
 }
@@ -587,6 +606,7 @@ static void f_TextXY(js_State *J) {
     int bg = js_toint32(J, 5);
 
     textout_ex(DOjS.current_bm, font, (char *)str, x, y, fg, bg);
+    dirty_add(DOjS.current_bm, x, y, x + text_length(font, str) - 1, y + text_height(font) - 1);
 }
 
 /**
@@ -623,6 +643,23 @@ static void f_SavePcxImage(js_State *J) {
     }
 }
 
+/**
+ * @brief save current screen to file.
+ * SaveQoiImage(fname:string)
+ *
+ * @param J the JS context.
+ */
+static void f_SaveQoiImage(js_State *J) {
+    const char *fname = js_tostring(J, 1);
+
+    PALETTE pal;
+    get_palette(pal);
+
+    if (save_qoi(fname, DOjS.current_bm, (const struct RGB *)&pal) != 0) {
+        js_error(J, "Can't save screen to QOI file '%s'", fname);
+    }
+}
+
 /**
  * @brief save current screen to file.
  * SaveTgaImage(fname:string)
@@ -663,6 +700,14 @@ static void f_TransparencyEnabled(js_State *J) {
     dojs_update_transparency();
 }
 
+/**
+ * @brief get the type of the blending kernels.
+ * BlendKernels():string
+ *
+ * @param J the JS context.
+ */
+static void f_BlendKernels(js_State *J) { js_pushstring(J, blender_has_mmx() ? "MMX" : "C"); }
+
 /**
  * @brief set the current rendering destination.
  * SetRenderBitmap(bm:Bitmap)
@@ -677,6 +722,10 @@ static void f_SetRenderBitmap(js_State *J) {
         JS_CHECKTYPE(J, 1, TAG_BITMAP);
 
         BITMAP *bm = js_touserdata(J, 1, TAG_BITMAP);
+        if (!imgcache_own(bm)) {
+            JS_ENOMEM(J);
+            return;
+        }
         DOjS.current_bm = bm;
         DEBUGF("Setting 0x%p\n", bm);
     }
@@ -693,12 +742,9 @@ static void f_DrawArray(js_State *J) {
     int y = js_tonumber(J, 3);
     int w = js_tonumber(J, 4);
     int h = js_tonumber(J, 5);
-    int arr_len = js_getlength(J, 1);
-    int len = arr_len < w * h ? arr_len : w * h;
-    for (int i = 0; i < len; i++) {
-        js_getindex(J, 1, i);
-        putpixel(DOjS.current_bm, x + (i % w), y + (i / w), js_touint32(J, -1));
-        js_pop(J, 1);
+    int len = Bitmap_putPixels(J, 1, DOjS.current_bm, x, y, w, h);
+    if (len > 0) {
+        dirty_add(DOjS.current_bm, x, y, x + w - 1, y + (len - 1) / w);
     }
 }
 
@@ -743,11 +789,13 @@ void init_gfx(js_State *J) {
     NFUNCDEF(J, SaveBmpImage, 1);
     NFUNCDEF(J, SavePcxImage, 1);
     NFUNCDEF(J, SaveTgaImage, 1);
+    NFUNCDEF(J, SaveQoiImage, 1);
 
     NFUNCDEF(J, GetPixel, 2);
     NFUNCDEF(J, DrawArray, 5);
 
     NFUNCDEF(J, TransparencyEnabled, 2);
+    NFUNCDEF(J, BlendKernels, 0);
 
     DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
 }
@@ -0,0 +1,467 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "imgcache.h"
+
+#include <allegro.h>
+#include <mujs.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "DOjS.h"
+#include "gcpacer.h"
+#include "zipfile.h"
+
+/************
+** structs **
+************/
+//! a decoded image
+typedef struct _imgcache_entry {
+    struct _imgcache_entry *prev;  //!< previous (more recently used) entry
+    struct _imgcache_entry *next;  //!< next (less recently used) entry
+    char *key;                     //!< file name or ZIP entry name as passed to new Bitmap()
+    time_t mtime;                  //!< modification time of the file (or the ZIP file)
+    BITMAP *bm;                    //!< the decoded image, never drawn to
+    size_t bytes;                  //!< size of the pixel data
+    int refs;                      //!< number of Bitmaps sharing the pixels
+} imgcache_entry_t;
+
+//! a Bitmap whose pixels are owned by a cache entry
+typedef struct {
+    BITMAP *bm;               //!< sub-bitmap given to the script
+    imgcache_entry_t *entry;  //!< owner of the pixels
+} imgcache_share_t;
+
+//! the cache
+typedef struct {
+    imgcache_entry_t *head;    //!< most recently used entry
+    imgcache_entry_t *tail;    //!< least recently used entry
+    size_t budget;             //!< maximum number of bytes, 0 disables the cache
+    size_t bytes;              //!< current number of bytes
+    int entries;               //!< number of entries
+    imgcache_share_t *shares;  //!< Bitmaps currently sharing pixels with an entry
+    int num_shares;            //!< number of entries in shares
+    int alloc_shares;          //!< allocated size of shares
+    unsigned long hits;        //!< number of images served from the cache
+    unsigned long misses;      //!< number of images that had to be decoded
+    unsigned long evictions;   //!< number of entries dropped to stay within the budget
+    unsigned long copies;      //!< number of shared Bitmaps that got their own pixels before being changed
+} imgcache_t;
+
+/*********************
+** static variables **
+*********************/
+static imgcache_t cache;  //!< the image cache
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief get the modification time of an image file, ZIP entries use the time of the ZIP file.
+ *
+ * @param fname file name or ZIP entry name.
+ * @param mtime the time is stored here.
+ *
+ * @return true if the file exists.
+ */
+static bool imgcache_mtime(const char *fname, time_t *mtime) {
+    struct stat st;
+    char *delim = strchr(fname, ZIP_DELIM);
+    if (delim) {
+        char *zname = malloc(delim - fname + 1);
+        if (!zname) {
+            return false;
+        }
+        memcpy(zname, fname, delim - fname);
+        zname[delim - fname] = 0;
+        int res = stat(zname, &st);
+        free(zname);
+        if (res != 0) {
+            return false;
+        }
+    } else if (stat(fname, &st) != 0) {
+        return false;
+    }
+    *mtime = st.st_mtime;
+    return true;
+}
+
+/**
+ * @brief number of bytes of pixel data.
+ *
+ * @param bm the bitmap.
+ *
+ * @return size_t the size.
+ */
+static size_t imgcache_size(BITMAP *bm) { return (size_t)bm->w * bm->h * ((bitmap_color_depth(bm) + 7) / 8); }
+
+/**
+ * @brief remove an entry from the LRU list.
+ *
+ * @param e the entry.
+ */
+static void imgcache_unlink(imgcache_entry_t *e) {
+    if (e->prev) {
+        e->prev->next = e->next;
+    } else {
+        cache.head = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    } else {
+        cache.tail = e->prev;
+    }
+    e->prev = e->next = NULL;
+}
+
+/**
+ * @brief put an entry at the front of the LRU list.
+ *
+ * @param e the entry.
+ */
+static void imgcache_push_front(imgcache_entry_t *e) {
+    e->prev = NULL;
+    e->next = cache.head;
+    if (cache.head) {
+        cache.head->prev = e;
+    } else {
+        cache.tail = e;
+    }
+    cache.head = e;
+}
+
+/**
+ * @brief remove an entry from the cache and free it, the entry must not be shared.
+ *
+ * @param e the entry.
+ */
+static void imgcache_free(imgcache_entry_t *e) {
+    imgcache_unlink(e);
+    cache.bytes -= e->bytes;
+    cache.entries--;
+    gc_native_free(e->bytes);
+    destroy_bitmap(e->bm);
+    free(e->key);
+    free(e);
+}
+
+/**
+ * @brief drop least recently used entries until the cache is within a given size. Shared entries are kept.
+ *
+ * @param limit maximum number of bytes.
+ */
+static void imgcache_shrink(size_t limit) {
+    imgcache_entry_t *e = cache.tail;
+    while (e && cache.bytes > limit) {
+        imgcache_entry_t *prev = e->prev;
+        if (!e->refs) {
+            imgcache_free(e);
+            cache.evictions++;
+        }
+        e = prev;
+    }
+}
+
+/**
+ * @brief drop least recently used entries until the cache is within its budget.
+ */
+static void imgcache_evict(void) { imgcache_shrink(cache.budget); }
+
+/**
+ * @brief create a Bitmap that shares the pixels of a cache entry.
+ *
+ * @param e the entry.
+ *
+ * @return BITMAP* the new bitmap or NULL if out of memory.
+ */
+static BITMAP *imgcache_share(imgcache_entry_t *e) {
+    if (cache.num_shares >= cache.alloc_shares) {
+        int larger = cache.alloc_shares ? cache.alloc_shares * 2 : 16;
+        imgcache_share_t *s = realloc(cache.shares, larger * sizeof(imgcache_share_t));
+        if (!s) {
+            return NULL;
+        }
+        cache.shares = s;
+        cache.alloc_shares = larger;
+    }
+
+    BITMAP *bm = create_sub_bitmap(e->bm, 0, 0, e->bm->w, e->bm->h);
+    if (!bm) {
+        return NULL;
+    }
+    cache.shares[cache.num_shares].bm = bm;
+    cache.shares[cache.num_shares].entry = e;
+    cache.num_shares++;
+    e->refs++;
+
+    return bm;
+}
+
+/**
+ * @brief find the share record of a Bitmap.
+ *
+ * @param bm the bitmap.
+ *
+ * @return int index into cache.shares or -1 if the bitmap has its own pixels.
+ */
+static int imgcache_find_share(BITMAP *bm) {
+    if (!is_sub_bitmap(bm)) {
+        return -1;
+    }
+    for (int i = cache.num_shares - 1; i >= 0; i--) {
+        if (cache.shares[i].bm == bm) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief drop a share record and unreference its entry.
+ *
+ * @param idx index into cache.shares.
+ */
+static void imgcache_unshare(int idx) {
+    imgcache_entry_t *e = cache.shares[idx].entry;
+    cache.shares[idx] = cache.shares[--cache.num_shares];
+    e->refs--;
+    if (!e->refs && cache.bytes > cache.budget) {
+        imgcache_evict();
+    }
+}
+
+/**
+ * @brief set the size of the image cache.
+ * SetImageCacheSize(bytes:number)
+ *
+ * @param J the JS context.
+ */
+static void f_SetImageCacheSize(js_State *J) {
+    double budget = js_tonumber(J, 1);
+    if (budget < 0) {
+        js_error(J, "Cache size must be >= 0");
+        return;
+    }
+    cache.budget = budget;
+    imgcache_evict();
+}
+
+/**
+ * @brief get image cache statistics.
+ * ImageCacheStats():ImageCacheInfo
+ *
+ * @param J the JS context.
+ */
+static void f_ImageCacheStats(js_State *J) {
+    js_newobject(J);
+    {
+        js_pushnumber(J, cache.budget);
+        js_setproperty(J, -2, "size");
+        js_pushnumber(J, cache.bytes);
+        js_setproperty(J, -2, "bytes");
+        js_pushnumber(J, cache.entries);
+        js_setproperty(J, -2, "entries");
+        js_pushnumber(J, cache.num_shares);
+        js_setproperty(J, -2, "shared");
+        js_pushnumber(J, cache.hits);
+        js_setproperty(J, -2, "hits");
+        js_pushnumber(J, cache.misses);
+        js_setproperty(J, -2, "misses");
+        js_pushnumber(J, cache.evictions);
+        js_setproperty(J, -2, "evictions");
+        js_pushnumber(J, cache.copies);
+        js_setproperty(J, -2, "copies");
+    }
+}
+
+/**
+ * @brief drop all cached images that are not used by a Bitmap.
+ * ImageCacheFlush()
+ *
+ * @param J the JS context.
+ */
+static void f_ImageCacheFlush(js_State *J) { imgcache_shrink(0); }
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize image cache.
+ *
+ * @param J VM state.
+ */
+void init_imgcache(js_State *J) {
+    DEBUGF("%s\n", __PRETTY_FUNCTION__);
+
+    memset(&cache, 0, sizeof(cache));
+    cache.budget = IMGCACHE_DEFAULT_BUDGET;
+
+    NFUNCDEF(J, SetImageCacheSize, 1);
+    NFUNCDEF(J, ImageCacheStats, 0);
+    NFUNCDEF(J, ImageCacheFlush, 0);
+}
+
+/**
+ * @brief look up a decoded image. Cache hits return a new Bitmap sharing the pixels with the cache (see imgcache_own()).
+ *
+ * @param fname file name or ZIP entry name.
+ *
+ * @return BITMAP* the image or NULL if it must be loaded (and passed to imgcache_put()).
+ */
+BITMAP *imgcache_get(const char *fname) {
+    if (!cache.budget) {
+        return NULL;
+    }
+
+    time_t mtime;
+    if (!imgcache_mtime(fname, &mtime)) {
+        return NULL;
+    }
+
+    for (imgcache_entry_t *e = cache.head; e; e = e->next) {
+        if (strcmp(e->key, fname) == 0) {
+            if (e->mtime != mtime) {
+                // file changed, the entry is replaced by the next imgcache_put()
+                break;
+            }
+            BITMAP *bm = imgcache_share(e);
+            if (bm) {
+                imgcache_unlink(e);
+                imgcache_push_front(e);
+                cache.hits++;
+            }
+            return bm;
+        }
+    }
+    cache.misses++;
+    return NULL;
+}
+
+/**
+ * @brief add a freshly loaded image to the cache.
+ *
+ * @param fname file name or ZIP entry name.
+ * @param bm the loaded image, the cache takes ownership if it is cached.
+ *
+ * @return BITMAP* the Bitmap to hand to the script: a shared copy of bm if it was cached or bm itself.
+ */
+BITMAP *imgcache_put(const char *fname, BITMAP *bm) {
+    time_t mtime;
+    size_t bytes = imgcache_size(bm);
+    if (!cache.budget || bytes > cache.budget || !is_memory_bitmap(bm) || !imgcache_mtime(fname, &mtime)) {
+        return bm;
+    }
+
+    // drop an outdated version of the file if nobody uses it anymore
+    for (imgcache_entry_t *e = cache.head; e; e = e->next) {
+        if (strcmp(e->key, fname) == 0) {
+            if (!e->refs) {
+                imgcache_free(e);
+            } else {
+                // still in use, just make sure it is never found again
+                e->key[0] = 0;
+            }
+            break;
+        }
+    }
+
+    imgcache_entry_t *e = calloc(1, sizeof(imgcache_entry_t));
+    if (!e) {
+        return bm;
+    }
+    e->key = strdup(fname);
+    if (!e->key) {
+        free(e);
+        return bm;
+    }
+    e->mtime = mtime;
+    e->bm = bm;
+    e->bytes = bytes;
+
+    BITMAP *shared = imgcache_share(e);
+    if (!shared) {
+        free(e->key);
+        free(e);
+        return bm;
+    }
+
+    imgcache_push_front(e);
+    cache.entries++;
+    cache.bytes += bytes;
+    gc_native_alloc(bytes);
+    imgcache_evict();
+
+    return shared;
+}
+
+/**
+ * @brief release a Bitmap before it is destroyed.
+ *
+ * @param bm the bitmap.
+ *
+ * @return true if the Bitmap shared its pixels with the cache (destroy_bitmap() then only frees the BITMAP struct).
+ */
+bool imgcache_release(BITMAP *bm) {
+    int idx = imgcache_find_share(bm);
+    if (idx < 0) {
+        return false;
+    }
+    imgcache_unshare(idx);
+    return true;
+}
+
+/**
+ * @brief make sure a Bitmap has its own pixels before it is changed (copy-on-write). Must be called by everything that draws into a Bitmap other than the screen.
+ *
+ * @param bm the bitmap.
+ *
+ * @return false if out of memory, true if bm can be changed.
+ */
+bool imgcache_own(BITMAP *bm) {
+    int idx = imgcache_find_share(bm);
+    if (idx < 0) {
+        return true;
+    }
+
+    // turn the sub-bitmap into a normal memory bitmap with a copy of the pixels
+    size_t bytes = imgcache_size(bm);
+    size_t pitch = bytes / bm->h;
+    unsigned char *dat = malloc(bytes);
+    if (!dat) {
+        return false;
+    }
+    for (int y = 0; y < bm->h; y++) {
+        memcpy(dat + y * pitch, bm->line[y], pitch);
+        bm->line[y] = dat + y * pitch;
+    }
+    bm->dat = dat;
+    bm->id = 0;
+    bm->x_ofs = bm->y_ofs = 0;
+
+    imgcache_unshare(idx);
+    gc_native_alloc(bytes);
+    cache.copies++;
+
+    return true;
+}
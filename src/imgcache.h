@@ -0,0 +1,44 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __IMGCACHE_H__
+#define __IMGCACHE_H__
+
+#include <allegro.h>
+#include <mujs.h>
+#include <stdbool.h>
+
+/************
+** defines **
+************/
+#define IMGCACHE_DEFAULT_BUDGET (4 * 1024 * 1024)  //!< default number of bytes of decoded images kept in the cache
+
+/***********************
+** exported functions **
+***********************/
+extern void init_imgcache(js_State *J);
+extern BITMAP *imgcache_get(const char *fname);
+extern BITMAP *imgcache_put(const char *fname, BITMAP *bm);
+extern bool imgcache_release(BITMAP *bm);
+extern bool imgcache_own(BITMAP *bm);
+
+#endif  // __IMGCACHE_H__
@@ -0,0 +1,765 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "imgload.h"
+
+#include <allegro.h>
+#include <limits.h>
+#include <mujs.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DOjS.h"
+#include "bitmap.h"
+#include "imgcache.h"
+#include "util.h"
+#include "zipfile.h"
+
+/************
+** defines **
+************/
+#define IMGLOAD_REG_PREFIX "ImgLoad"  //!< registry name prefix of the callbacks of a load
+#define IMGLOAD_CANARY 0xA5           //!< fill byte of the stack canary
+
+/*
+ * The decoders (loadpng/libpng, jpgalleg and QOI) are not resumable, so a
+ * load runs on its own stack and imgload_yield() switches back to the main
+ * loop with setjmp()/longjmp(). Jumping between stacks is undefined
+ * behaviour in ISO C, it is only done where we know how it works: DJGPP's
+ * longjmp() just reloads the saved registers including %esp. Everywhere
+ * else LoadBitmapAsync() decodes the whole image in the first slice.
+ *
+ * The decoders keep their image buffers on the heap and don't recurse, their
+ * call chains need well below IMGLOAD_STACK_SIZE. This is checked every time
+ * a decoder calls imgload_yield(), i.e. before it is suspended:
+ * - if its stack pointer is within IMGLOAD_STACK_RESERVE of the end of the
+ *   stack or the canary at the end was overwritten, the load is cancelled.
+ *   The decoder is not suspended again but runs on until it fails through
+ *   its own error path (the PACKFILE reports errors from now on), so it
+ *   frees its heap state itself. The callback gets an error.
+ * - a decoder that recurses deeper than that between two yields can't be
+ *   stopped (there are no guard pages under CWSDPMI). If the canary is found
+ *   broken after it returned, its result is dropped and the stack is
+ *   replaced. Nothing leaks in that case as the decoder ran to its end, but
+ *   the heap below the stack may already be damaged, which is logged.
+ */
+#if defined(__DJGPP__) && defined(__i386__)
+#define IMGLOAD_FIBER 1  //!< decoders run on their own stack
+#else
+#define IMGLOAD_FIBER 0  //!< decoders run synchronously
+#endif
+
+#define IL_WAITING 0  //!< load is queued, the file is not opened yet
+#define IL_RUNNING 1  //!< decoder is suspended on the loader stack
+#define IL_DONE 2     //!< decoder finished, callback not called yet
+
+/************
+** structs **
+************/
+//! an image loaded by LoadBitmapAsync()
+typedef struct _imgload {
+    struct _imgload *next;             //!< next load in the queue
+    int id;                            //!< id returned by LoadBitmapAsync()
+    char *fname;                       //!< file name or ZIP entry name
+    int state;                         //!< IL_WAITING, IL_RUNNING or IL_DONE
+    bool abort;                        //!< load was cancelled, make the decoder fail and drop the result
+    bool overflow;                     //!< decoder ran out of stack, it is not suspended any more and fails on the next read
+    bool cached;                       //!< bm shares its pixels with the image cache
+    BITMAP *bm;                        //!< the decoded image or NULL if decoding failed
+    PACKFILE *file;                    //!< source of plain files
+    zipstream_t *zs;                   //!< source of ZIP file entries, inflated while decoding
+    PACKFILE *pf;                      //!< PACKFILE handed to the decoder
+    unsigned long size;                //!< size of the file in bytes
+    unsigned long pos;                 //!< number of bytes read from the file
+    int buf_pos;                       //!< read position in buf
+    int buf_len;                       //!< number of valid bytes in buf
+    bool eof;                          //!< end of file reached
+    bool error;                        //!< reading failed or load was cancelled
+    jmp_buf caller;                    //!< context of imgload_tick() while the decoder runs
+    jmp_buf fiber;                     //!< context of the suspended decoder
+    unsigned char buf[IMGLOAD_CHUNK];  //!< read buffer
+} imgload_t;
+
+/*********************
+** static variables **
+*********************/
+static imgload_t *il_queue;           //!< pending loads in the order of LoadBitmapAsync() calls
+static imgload_t *il_current;         //!< load whose decoder is currently running or NULL
+static void *il_stack;                //!< stack the decoders run on, only one decoder runs at a time
+static int il_next_id;                //!< id of the next load
+static long il_slice;                 //!< minimum number of ms spent decoding per frame
+static unsigned long il_slice_start;  //!< DOjS.sys_ticks when the current slice started
+static long il_slice_budget;          //!< length of the current slice in ms
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief create the registry key of the callbacks of a load.
+ *
+ * @param il the load.
+ * @param key buffer of IMGLOAD_KEY_SIZE bytes.
+ */
+static void imgload_key(imgload_t *il, char *key) { snprintf(key, IMGLOAD_KEY_SIZE, "%s%d", IMGLOAD_REG_PREFIX, il->id); }
+
+/**
+ * @brief read the next chunk of the file. This is where most decoders give up the CPU when their time slice is used up.
+ *
+ * @param il the load.
+ *
+ * @return true if data is available in the buffer.
+ * @return false on EOF, read errors or when the load was cancelled.
+ */
+static bool imgload_fill(imgload_t *il) {
+    imgload_yield();
+
+    if (il->abort || il->overflow) {
+        il->error = true;
+    }
+    if (il->eof || il->error) {
+        return false;
+    }
+
+    long got;
+    if (il->zs) {
+        got = read_zipstream(il->zs, il->buf, IMGLOAD_CHUNK);
+    } else {
+        got = pack_fread(il->buf, IMGLOAD_CHUNK, il->file);
+    }
+    if (got <= 0) {
+        il->eof = true;
+        return false;
+    }
+    il->buf_pos = 0;
+    il->buf_len = got;
+    il->pos += got;
+    return true;
+}
+
+//! PACKFILE_VTABLE: sources are closed by imgload_close()
+static int imgload_pf_fclose(void *userdata) { return 0; }
+
+//! PACKFILE_VTABLE: read one byte
+static int imgload_pf_getc(void *userdata) {
+    imgload_t *il = (imgload_t *)userdata;
+    if (il->buf_pos >= il->buf_len && !imgload_fill(il)) {
+        return EOF;
+    }
+    return il->buf[il->buf_pos++];
+}
+
+//! PACKFILE_VTABLE: push back the last byte read
+static int imgload_pf_ungetc(int c, void *userdata) {
+    imgload_t *il = (imgload_t *)userdata;
+    if (il->buf_pos <= 0) {
+        return EOF;
+    }
+    il->buf[--il->buf_pos] = c;
+    return c;
+}
+
+//! PACKFILE_VTABLE: read a block of bytes
+static long imgload_pf_fread(void *p, long n, void *userdata) {
+    imgload_t *il = (imgload_t *)userdata;
+    unsigned char *dst = (unsigned char *)p;
+    long done = 0;
+    while (done < n) {
+        if (il->buf_pos >= il->buf_len && !imgload_fill(il)) {
+            break;
+        }
+        long avail = MIN(n - done, il->buf_len - il->buf_pos);
+        memcpy(&dst[done], &il->buf[il->buf_pos], avail);
+        il->buf_pos += avail;
+        done += avail;
+    }
+    return done;
+}
+
+//! PACKFILE_VTABLE: writing is not supported
+static int imgload_pf_putc(int c, void *userdata) { return EOF; }
+
+//! PACKFILE_VTABLE: writing is not supported
+static long imgload_pf_fwrite(AL_CONST void *p, long n, void *userdata) { return 0; }
+
+//! PACKFILE_VTABLE: skip forward
+static int imgload_pf_fseek(void *userdata, int offset) {
+    while (offset > 0) {
+        if (imgload_pf_getc(userdata) == EOF) {
+            return -1;
+        }
+        offset--;
+    }
+    return 0;
+}
+
+//! PACKFILE_VTABLE: end of file reached?
+static int imgload_pf_feof(void *userdata) {
+    imgload_t *il = (imgload_t *)userdata;
+    return il->buf_pos >= il->buf_len && (il->eof || il->error);
+}
+
+//! PACKFILE_VTABLE: reading failed?
+static int imgload_pf_ferror(void *userdata) {
+    imgload_t *il = (imgload_t *)userdata;
+    return il->error;
+}
+
+//! reads the file chunk by chunk and gives the main loop a chance to run in between
+static PACKFILE_VTABLE imgload_vtable = {
+    imgload_pf_fclose, imgload_pf_getc,  imgload_pf_ungetc, imgload_pf_fread, imgload_pf_putc,
+    imgload_pf_fwrite, imgload_pf_fseek, imgload_pf_feof,   imgload_pf_ferror};
+
+/**
+ * @brief open the file of a load.
+ *
+ * @param il the load.
+ *
+ * @return true if the decoder can be started.
+ */
+static bool imgload_open(imgload_t *il) {
+    if (strchr(il->fname, ZIP_DELIM)) {
+        il->zs = open_zipstream1(il->fname);
+        if (!il->zs) {
+            return false;
+        }
+        il->size = size_zipstream(il->zs);
+    } else {
+        il->file = pack_fopen(il->fname, F_READ);
+        if (!il->file) {
+            return false;
+        }
+        il->size = file_size_ex(il->fname);
+    }
+    il->pf = pack_fopen_vtable(&imgload_vtable, il);
+    return il->pf != NULL;
+}
+
+/**
+ * @brief close the file of a load.
+ *
+ * @param il the load.
+ */
+static void imgload_close(imgload_t *il) {
+    if (il->pf) {
+        pack_fclose(il->pf);
+        il->pf = NULL;
+    }
+    if (il->file) {
+        pack_fclose(il->file);
+        il->file = NULL;
+    }
+    if (il->zs) {
+        close_zipstream(il->zs);
+        il->zs = NULL;
+    }
+}
+
+/**
+ * @brief free a load and its image (if it was not passed to the script).
+ *
+ * @param il the load.
+ */
+static void imgload_free(imgload_t *il) {
+    imgload_close(il);
+    if (il->bm) {
+        if (il->cached) {
+            imgcache_release(il->bm);
+        }
+        destroy_bitmap(il->bm);
+    }
+    free(il->fname);
+    free(il);
+}
+
+/**
+ * @brief remove a load from the queue.
+ *
+ * @param il the load.
+ */
+static void imgload_unlink(imgload_t *il) {
+    imgload_t **pp = &il_queue;
+    while (*pp && *pp != il) {
+        pp = &(*pp)->next;
+    }
+    if (*pp) {
+        *pp = il->next;
+    }
+    il->next = NULL;
+}
+
+#if IMGLOAD_FIBER
+/**
+ * @brief allocate the loader stack and fill its canary.
+ *
+ * @return the stack or NULL if out of memory.
+ */
+static void *imgload_newstack(void) {
+    void *stack = malloc(IMGLOAD_STACK_SIZE);
+    if (stack) {
+        // the stack grows down, the canary is at its lowest addresses
+        memset(stack, IMGLOAD_CANARY, IMGLOAD_CANARY_SIZE);
+    }
+    return stack;
+}
+
+/**
+ * @brief check that the decoder did not run into the canary at the end of its stack.
+ *
+ * @return true if the canary is intact.
+ */
+static bool imgload_stack_ok(void) {
+    const unsigned char *c = (const unsigned char *)il_stack;
+    for (int i = 0; i < IMGLOAD_CANARY_SIZE; i++) {
+        if (c[i] != IMGLOAD_CANARY) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief check how deep the running decoder is in its stack. Must be called on the loader stack.
+ *
+ * @return true if at least IMGLOAD_STACK_RESERVE bytes are left above the canary and the canary is intact.
+ */
+static bool imgload_stack_left(void) {
+    volatile char here;
+    uintptr_t limit = (uintptr_t)il_stack + IMGLOAD_CANARY_SIZE + IMGLOAD_STACK_RESERVE;
+    return (uintptr_t)&here >= limit && imgload_stack_ok();
+}
+
+/**
+ * @brief entry point of the loader stack. Runs the decoder registered with Allegro for the file extension and returns to imgload_run().
+ */
+static void imgload_entry(void) {
+    imgload_t *il = il_current;
+
+    il->bm = load_bitmap_pf(il->pf, NULL, ut_getFilenameExt(il->fname));
+    il->state = IL_DONE;
+    longjmp(il->caller, 1);
+}
+
+/**
+ * @brief switch to the loader stack and call imgload_entry(). Never returns, imgload_entry() and imgload_yield() longjmp() back to imgload_run().
+ */
+static void imgload_start(void) {
+    uintptr_t top = ((uintptr_t)il_stack + IMGLOAD_STACK_SIZE) & ~(uintptr_t)15;
+
+    __asm__ __volatile__(
+        "movl %0, %%esp\n\t"
+        "call *%1\n\t"
+        :
+        : "r"(top), "r"(imgload_entry)
+        : "memory");
+    __builtin_unreachable();
+}
+#endif  // IMGLOAD_FIBER
+
+/**
+ * @brief run the decoder of a load until it is finished or 'budget' ms have passed.
+ *
+ * @param il the load.
+ * @param budget maximum number of ms to spend.
+ */
+static void imgload_run(imgload_t *il, long budget) {
+    if (il->state == IL_WAITING) {
+#if IMGLOAD_FIBER
+        if (!il_stack) {
+            il_stack = imgload_newstack();
+        }
+        if (!il_stack) {
+            il->state = IL_DONE;
+            return;
+        }
+#endif
+        if (!imgload_open(il)) {
+            imgload_close(il);
+            il->state = IL_DONE;
+            return;
+        }
+    }
+
+#if IMGLOAD_FIBER
+    il_slice_start = DOjS.sys_ticks;
+    il_slice_budget = budget;
+    il_current = il;
+    if (!setjmp(il->caller)) {
+        if (il->state == IL_RUNNING) {
+            longjmp(il->fiber, 1);
+        } else {
+            il->state = IL_RUNNING;
+            imgload_start();
+        }
+    }
+    il_current = NULL;
+
+    if (il->overflow && il->state == IL_DONE && il->bm) {
+        // stopped by imgload_yield(), the decoder may have returned a partial image
+        destroy_bitmap(il->bm);
+        il->bm = NULL;
+    }
+    if (!imgload_stack_ok()) {
+        // the decoder overflowed between two yields and has finished (imgload_yield() never suspends with a broken canary)
+        LOGF("Decoder stack overflow while loading '%s', memory may be corrupted\n", il->fname);
+        if (il->bm) {
+            destroy_bitmap(il->bm);
+            il->bm = NULL;
+        }
+        free(il_stack);
+        il_stack = NULL;
+    }
+#else
+    // no stack switching, il_current stays NULL so imgload_yield() does nothing
+    il->bm = load_bitmap_pf(il->pf, NULL, ut_getFilenameExt(il->fname));
+    il->state = IL_DONE;
+#endif
+
+    if (il->state == IL_DONE) {
+        imgload_close(il);
+    }
+}
+
+/**
+ * @brief pass the result of a finished load to its callback and free the load.
+ *
+ * @param J VM state.
+ * @param il the load, must be IL_DONE.
+ *
+ * @return true if the callback returned normally.
+ * @return false if the callback threw, the error is left on the stack.
+ */
+static bool imgload_deliver(js_State *J, imgload_t *il) {
+    char key[IMGLOAD_KEY_SIZE];
+    imgload_key(il, key);
+    imgload_unlink(il);
+
+    js_getregistry(J, key);
+    js_delregistry(J, key);
+    js_getindex(J, -1, 0);
+    js_pushnull(J);
+    if (il->bm) {
+        if (!il->cached) {
+            il->bm = imgcache_put(il->fname, il->bm);
+            il->cached = is_sub_bitmap(il->bm);
+        }
+        Bitmap_push(J, il->bm, il->fname, il->cached);
+        il->bm = NULL;  // owned by the script now
+        js_pushnull(J);
+    } else {
+        char msg[PATH_MAX + 32];
+        snprintf(msg, sizeof(msg), "Can't load image '%s'", il->fname);
+        js_pushnull(J);
+        js_pushstring(J, msg);
+    }
+    imgload_free(il);
+
+    if (js_pcall(J, 2)) {
+        js_rot2pop1(J);
+        return false;
+    }
+    js_pop(J, 2);
+    return true;
+}
+
+/**
+ * @brief call the progress callback of a running load (if any).
+ *
+ * @param J VM state.
+ * @param il the load.
+ *
+ * @return true if there was no callback or it returned normally.
+ * @return false if the callback threw, the error is left on the stack.
+ */
+static bool imgload_progress(js_State *J, imgload_t *il) {
+    char key[IMGLOAD_KEY_SIZE];
+    imgload_key(il, key);
+
+    js_getregistry(J, key);
+    js_getindex(J, -1, 1);
+    if (!js_iscallable(J, -1)) {
+        js_pop(J, 2);
+        return true;
+    }
+    js_pushnull(J);
+    js_pushnumber(J, il->size ? (double)il->pos / il->size : 0);
+    if (js_pcall(J, 1)) {
+        js_rot2pop1(J);
+        return false;
+    }
+    js_pop(J, 2);
+    return true;
+}
+
+/**
+ * @brief load an image in the background. The decoder runs in time slices between calls to Loop().
+ * LoadBitmapAsync(filename:string, callback:function(Bitmap, string), progress:function(number)):number
+ *
+ * @param J the JS context.
+ */
+static void f_LoadBitmapAsync(js_State *J) {
+    const char *fname = js_tostring(J, 1);
+    if (!js_iscallable(J, 2)) {
+        js_error(J, "Callback must be a function");
+        return;
+    }
+
+    imgload_t *il = calloc(1, sizeof(imgload_t));
+    if (!il) {
+        JS_ENOMEM(J);
+        return;
+    }
+    il->fname = strdup(fname);
+    if (!il->fname) {
+        free(il);
+        JS_ENOMEM(J);
+        return;
+    }
+    il->id = il_next_id++;
+
+    // cache hits need no decoding, they are delivered with the next frame
+    il->bm = imgcache_get(fname);
+    if (il->bm) {
+        il->cached = true;
+        il->state = IL_DONE;
+    }
+
+    char key[IMGLOAD_KEY_SIZE];
+    imgload_key(il, key);
+    js_newarray(J);
+    js_copy(J, 2);
+    js_setindex(J, -2, 0);
+    if (js_iscallable(J, 3)) {
+        js_copy(J, 3);
+        js_setindex(J, -2, 1);
+    }
+    js_setregistry(J, key);
+
+    imgload_t **pp = &il_queue;
+    while (*pp) {
+        pp = &(*pp)->next;
+    }
+    *pp = il;
+
+    js_pushnumber(J, il->id);
+}
+
+/**
+ * @brief cancel a load started with LoadBitmapAsync(). The callback will not be called.
+ * CancelBitmapLoad(id:number):boolean
+ *
+ * @param J the JS context.
+ */
+static void f_CancelBitmapLoad(js_State *J) {
+    int id = js_toint32(J, 1);
+
+    imgload_t *il = il_queue;
+    while (il && (il->id != id || il->abort)) {
+        il = il->next;
+    }
+    if (!il) {
+        js_pushboolean(J, false);
+        return;
+    }
+
+    char key[IMGLOAD_KEY_SIZE];
+    imgload_key(il, key);
+    js_delregistry(J, key);
+
+    if (il->state == IL_RUNNING) {
+        // the decoder can't be unwound, let it fail on the next read and free it when it returns
+        il->abort = true;
+    } else {
+        imgload_unlink(il);
+        imgload_free(il);
+    }
+    js_pushboolean(J, true);
+}
+
+/**
+ * @brief get the number of loads whose callback was not called yet.
+ * BitmapLoadsPending():number
+ *
+ * @param J the JS context.
+ */
+static void f_BitmapLoadsPending(js_State *J) {
+    int num = 0;
+    for (imgload_t *il = il_queue; il; il = il->next) {
+        if (!il->abort) {
+            num++;
+        }
+    }
+    js_pushnumber(J, num);
+}
+
+/**
+ * @brief set the minimum time spent decoding per frame.
+ * SetBitmapLoadSlice(ms:number)
+ *
+ * @param J the JS context.
+ */
+static void f_SetBitmapLoadSlice(js_State *J) {
+    int32_t ms = js_toint32(J, 1);
+    if (ms <= 0) {
+        js_error(J, "Slice must be > 0: %ld", ms);
+        return;
+    }
+    il_slice = ms;
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize background image loading.
+ *
+ * @param J VM state.
+ */
+void init_imgload(js_State *J) {
+    DEBUGF("%s\n", __PRETTY_FUNCTION__);
+
+    il_queue = NULL;
+    il_current = NULL;
+    il_next_id = 1;
+    il_slice = IMGLOAD_DEFAULT_SLICE;
+
+    NFUNCDEF(J, LoadBitmapAsync, 3);
+    NFUNCDEF(J, CancelBitmapLoad, 1);
+    NFUNCDEF(J, BitmapLoadsPending, 0);
+    NFUNCDEF(J, SetBitmapLoadSlice, 1);
+}
+
+/**
+ * @brief cancel all pending loads and free their resources.
+ */
+void shutdown_imgload(void) {
+    while (il_queue) {
+        imgload_t *il = il_queue;
+        if (il->state == IL_RUNNING) {
+            il->abort = true;
+            imgload_run(il, LONG_MAX);
+        }
+        il_queue = il->next;
+        imgload_free(il);
+    }
+    free(il_stack);
+    il_stack = NULL;
+}
+
+/**
+ * @brief decode pending images for (at least) the given time and call the callbacks of finished loads. Called once per frame by the main loop.
+ *
+ * @param J VM state.
+ * @param budget number of ms available, at least the value set by SetBitmapLoadSlice() is used.
+ *
+ * @return true if all callbacks returned normally.
+ * @return false if a callback threw, the error is left on the stack.
+ */
+bool imgload_tick(js_State *J, long budget) {
+    if (!il_queue) {
+        return true;
+    }
+    budget = MAX(budget, il_slice);
+
+    // decode in queue order, one decoder at a time
+    unsigned long start = DOjS.sys_ticks;
+    imgload_t *il = il_queue;
+    while (il) {
+        long left = budget - (long)(DOjS.sys_ticks - start);
+        if (left <= 0) {
+            break;
+        }
+        if (il->state != IL_DONE) {
+            imgload_run(il, left);
+            if (il->state != IL_DONE) {
+                break;
+            }
+        }
+        il = il->next;
+    }
+
+    // drop cancelled loads and deliver finished ones, callbacks may change the queue so always restart at its head
+    int last_id = il_next_id;
+    il = il_queue;
+    while (il) {
+        if (il->state == IL_DONE && il->id < last_id) {
+            if (il->abort) {
+                imgload_unlink(il);
+                imgload_free(il);
+            } else if (!imgload_deliver(J, il)) {
+                return false;
+            }
+            il = il_queue;
+        } else {
+            il = il->next;
+        }
+    }
+
+    // report the progress of the running load
+    for (il = il_queue; il; il = il->next) {
+        if (il->state == IL_RUNNING && !il->abort) {
+            return imgload_progress(J, il);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief give up the CPU if the decoder of a LoadBitmapAsync() load used up its time slice. Decoders call this regularly, it does nothing for
+ * loads done with new Bitmap().
+ */
+void imgload_yield(void) {
+    imgload_t *il = il_current;
+    if (!il || il->overflow) {
+        return;
+    }
+#if IMGLOAD_FIBER
+    if (!imgload_stack_left()) {
+        // don't suspend a decoder that is about to overflow, let it run into the read errors and fail
+        LOGF("Decoder stack exhausted while loading '%s'\n", il->fname);
+        il->overflow = true;
+        il->error = true;
+        return;
+    }
+#endif
+    if ((long)(DOjS.sys_ticks - il_slice_start) >= il_slice_budget) {
+        if (!setjmp(il->fiber)) {
+            longjmp(il->caller, 1);
+        }
+    }
+}
+
+/**
+ * @brief finish the suspended decoder (if any). Must be called before decoding an image synchronously as the decoders are not reentrant.
+ */
+void imgload_sync(void) {
+    if (il_current) {
+        return;  // called from within the decoder
+    }
+    for (imgload_t *il = il_queue; il; il = il->next) {
+        if (il->state == IL_RUNNING) {
+            imgload_run(il, LONG_MAX);
+        }
+    }
+}
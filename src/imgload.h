@@ -0,0 +1,48 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __IMGLOAD_H__
+#define __IMGLOAD_H__
+
+#include <mujs.h>
+#include <stdbool.h>
+
+/************
+** defines **
+************/
+#define IMGLOAD_DEFAULT_SLICE 10         //!< default minimum number of ms spent decoding per frame
+#define IMGLOAD_STACK_SIZE (256 * 1024)   //!< size of the stack the decoders run on, see imgload.c
+#define IMGLOAD_CANARY_SIZE (4 * 1024)    //!< bytes at the end of the decoder stack that must stay untouched
+#define IMGLOAD_STACK_RESERVE (64 * 1024)  //!< a decoder that gets closer than this to the canary is stopped
+#define IMGLOAD_CHUNK 4096               //!< number of bytes read from the file at once
+#define IMGLOAD_KEY_SIZE 32              //!< size of the registry key buffer
+
+/***********************
+** exported functions **
+***********************/
+extern void init_imgload(js_State *J);
+extern void shutdown_imgload(void);
+extern bool imgload_tick(js_State *J, long budget);
+extern void imgload_yield(void);
+extern void imgload_sync(void);
+
+#endif  // __IMGLOAD_H__
@@ -0,0 +1,416 @@
+/*
+MIT License
+
+Copyright (c) 2019-2021 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "input.h"
+
+#include <allegro.h>
+#include <mujs.h>
+
+#include "DOjS.h"
+
+/************
+** defines **
+************/
+#define INPUT_REG_POOL "InputPool"    //!< registry name of the preallocated event objects
+#define INPUT_REG_BATCH "InputBatch"  //!< registry name of the array passed to InputBatch()
+
+/************
+** structs **
+************/
+//! a key the keyboard callback handed to Allegro's key buffer because the ring buffer was busy or full
+typedef struct {
+    unsigned int seq;     //!< number of events queued to the ring buffer before the key
+    int x;                //!< mouse X
+    int y;                //!< mouse Y
+    int buttons;          //!< mouse buttons
+    unsigned long ticks;  //!< value of DOjS.sys_ticks when the key was pressed
+} input_spill_t;
+
+//! ring buffer filled by the keyboard and mouse interrupt callbacks
+typedef struct {
+    volatile int lock;                                //!< >0 while the buffer is accessed
+    volatile int start;                               //!< first queued event
+    volatile int end;                                 //!< index for the next event
+    volatile unsigned int queued;                     //!< number of events ever queued
+    volatile input_event_t event[INPUT_BUFFER_SIZE];  //!< the queued events
+    volatile int spill_start;                         //!< first spilled key, only changed by collect_input()
+    volatile int spill_end;                           //!< index for the next spilled key, only changed by the keyboard callback
+    volatile input_spill_t spill[INPUT_SPILL_SIZE];   //!< where and when the keys in Allegro's buffer were pressed
+} input_buffer_t;
+
+/*********************
+** static variables **
+*********************/
+static input_buffer_t input_buffer;                 //!< events queued by the interrupt callbacks
+static unsigned int input_collected;                 //!< number of queued events collected
+static input_event_t input_batch[INPUT_BATCH_SIZE];  //!< events collected for the current frame
+static int input_joy_buttons[INPUT_MAX_JOYSTICKS];   //!< last reported joystick buttons
+static bool input_pool_created;                      //!< the JS event objects were created
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief queue an event, called with the buffer locked.
+ *
+ * @param key key code or -1.
+ *
+ * @return true if the event was queued, false if the buffer is full.
+ */
+static bool input_queue(int key) {
+    int next = (input_buffer.end + 1) % INPUT_BUFFER_SIZE;
+    if (next == input_buffer.start) {
+        return false;
+    }
+    volatile input_event_t *ev = &input_buffer.event[input_buffer.end];
+    ev->key = key;
+    ev->x = mouse_x;
+    ev->y = mouse_y;
+    ev->buttons = mouse_b;
+    ev->joystick = -1;
+    ev->ticks = DOjS.sys_ticks;
+    input_buffer.end = next;
+    input_buffer.queued++;
+    return true;
+}
+END_OF_STATIC_FUNCTION(input_queue)
+
+/**
+ * @brief remember the position and time of a key that is handed to Allegro's key buffer.
+ * This is a single producer/single consumer ring, it is safe to use while the event buffer is locked.
+ */
+static void input_spill(void) {
+    int next = (input_buffer.spill_end + 1) % INPUT_SPILL_SIZE;
+    if (next == input_buffer.spill_start) {
+        return;  // the key is still delivered, but with the time it is collected
+    }
+    volatile input_spill_t *s = &input_buffer.spill[input_buffer.spill_end];
+    s->seq = input_buffer.queued;
+    s->x = mouse_x;
+    s->y = mouse_y;
+    s->buttons = mouse_b;
+    s->ticks = DOjS.sys_ticks;
+    input_buffer.spill_end = next;
+}
+END_OF_STATIC_FUNCTION(input_spill)
+
+/**
+ * @brief Allegro keyboard callback, timestamps a key press and queues it.
+ *
+ * @param key key (ASCII | scancode << 8).
+ *
+ * @return int 0 if the key was queued, the key (to let Allegro buffer it) if our buffer is busy or full.
+ */
+static int input_key_callback(int key) {
+    int ret = key;
+
+    input_buffer.lock++;
+    if (input_buffer.lock == 1 && input_queue(key)) {
+        ret = 0;
+    } else {
+        input_spill();
+    }
+    input_buffer.lock--;
+
+    return ret;
+}
+END_OF_STATIC_FUNCTION(input_key_callback)
+
+/**
+ * @brief Allegro mouse callback, timestamps a mouse event and queues it.
+ * Consecutive moves without button changes are merged into one event.
+ *
+ * @param flags MOUSE_FLAG_*.
+ */
+static void input_mouse_callback(int flags) {
+    input_buffer.lock++;
+    if (input_buffer.lock == 1) {
+        int last = (input_buffer.end + INPUT_BUFFER_SIZE - 1) % INPUT_BUFFER_SIZE;
+        volatile input_event_t *ev = &input_buffer.event[last];
+        if (!(flags & ~MOUSE_FLAG_MOVE) && input_buffer.start != input_buffer.end && ev->key == -1 && ev->buttons == mouse_b) {
+            ev->x = mouse_x;
+            ev->y = mouse_y;
+            ev->ticks = DOjS.sys_ticks;
+        } else {
+            input_queue(-1);
+        }
+    }
+    input_buffer.lock--;
+}
+END_OF_STATIC_FUNCTION(input_mouse_callback)
+
+/**
+ * @brief collect the next key from Allegro's key buffer if it was pressed before the next queued event.
+ *
+ * @param num number of collected events, incremented if a key was added.
+ *
+ * @return true if a spilled key was due (even if Allegro lost it), false if the next queued event comes first.
+ */
+static bool input_collect_spilled(int *num) {
+    if (input_buffer.spill_start == input_buffer.spill_end) {
+        return false;
+    }
+    volatile input_spill_t *s = &input_buffer.spill[input_buffer.spill_start];
+    if ((int)(s->seq - input_collected) > 0) {
+        return false;
+    }
+    if (keypressed()) {
+        input_event_t *ev = &input_batch[(*num)++];
+        ev->key = readkey();
+        ev->x = s->x;
+        ev->y = s->y;
+        ev->buttons = s->buttons;
+        ev->joystick = -1;
+        ev->ticks = s->ticks;
+    }
+    input_buffer.spill_start = (input_buffer.spill_start + 1) % INPUT_SPILL_SIZE;
+    return true;
+}
+
+/**
+ * @brief create the event objects that are reused for every frame.
+ *
+ * @param J VM state.
+ */
+static void input_create_pool(js_State *J) {
+    js_newarray(J);
+    for (int i = 0; i < INPUT_BATCH_SIZE; i++) {
+        // all properties are created up front so every event has the same layout
+        js_newobject(J);
+        {
+            js_pushnumber(J, 0);
+            js_setproperty(J, -2, "x");
+            js_pushnumber(J, 0);
+            js_setproperty(J, -2, "y");
+            js_pushnumber(J, 0);
+            js_setproperty(J, -2, "buttons");
+            js_pushnumber(J, -1);
+            js_setproperty(J, -2, "key");
+            js_pushnumber(J, 0);
+            js_setproperty(J, -2, "ticks");
+            js_pushnumber(J, -1);
+            js_setproperty(J, -2, "joystick");
+        }
+        js_setindex(J, -2, i);
+    }
+    js_setregistry(J, INPUT_REG_POOL);
+
+    js_newarray(J);
+    js_setregistry(J, INPUT_REG_BATCH);
+
+    input_pool_created = true;
+}
+
+/**
+ * @brief fill the event object on top of the stack with an event returned by collect_input().
+ *
+ * @param J VM state.
+ * @param idx index of the event returned by collect_input().
+ */
+static void input_fill_event(js_State *J, int idx) {
+    input_event_t *ev = &input_batch[idx];
+
+    js_pushnumber(J, ev->x);
+    js_setproperty(J, -2, "x");
+    js_pushnumber(J, ev->y);
+    js_setproperty(J, -2, "y");
+    js_pushnumber(J, ev->buttons);
+    js_setproperty(J, -2, "buttons");
+    js_pushnumber(J, ev->key);
+    js_setproperty(J, -2, "key");
+    js_pushnumber(J, ev->ticks);
+    js_setproperty(J, -2, "ticks");
+    js_pushnumber(J, ev->joystick);
+    js_setproperty(J, -2, "joystick");
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief install the keyboard and mouse callbacks that timestamp and queue input events.
+ */
+void init_input() {
+    LOCK_VARIABLE(input_buffer);
+    LOCK_FUNCTION(input_queue);
+    LOCK_FUNCTION(input_spill);
+    LOCK_FUNCTION(input_key_callback);
+    LOCK_FUNCTION(input_mouse_callback);
+
+    input_buffer.lock = input_buffer.start = input_buffer.end = 0;
+    input_buffer.spill_start = input_buffer.spill_end = 0;
+    input_buffer.queued = input_collected = 0;
+    input_pool_created = false;
+    keyboard_callback = input_key_callback;
+    if (DOjS.mouse_available) {
+        mouse_callback = input_mouse_callback;
+    }
+}
+
+/**
+ * @brief remove the input callbacks.
+ */
+void shutdown_input() {
+    keyboard_callback = NULL;
+    mouse_callback = NULL;
+}
+
+/**
+ * @brief collect all pending keyboard, mouse and (optionally) joystick events since the last call.
+ *
+ * @param joystick true to include joystick button changes.
+ * @param count number of events.
+ *
+ * @return const input_event_t* the events, valid until the next call.
+ */
+const input_event_t *collect_input(bool joystick, int *count) {
+    int num = 0;
+
+    if (keyboard_needs_poll()) {
+        poll_keyboard();
+    }
+    if (mouse_needs_poll()) {
+        poll_mouse();
+    }
+
+    // events queued by the callbacks. The interrupt callbacks leave the buffer alone while it is locked,
+    // keys that went to Allegro's buffer instead are put back between the events they were pressed between
+    input_buffer.lock++;
+    while (num < INPUT_BATCH_SIZE && input_buffer.start != input_buffer.end) {
+        if (input_collect_spilled(&num)) {
+            continue;
+        }
+        volatile input_event_t *ev = &input_buffer.event[input_buffer.start];
+        input_batch[num].key = ev->key;
+        input_batch[num].x = ev->x;
+        input_batch[num].y = ev->y;
+        input_batch[num].buttons = ev->buttons;
+        input_batch[num].joystick = ev->joystick;
+        input_batch[num].ticks = ev->ticks;
+        input_buffer.start = (input_buffer.start + 1) % INPUT_BUFFER_SIZE;
+        input_collected++;
+        num++;
+    }
+    input_buffer.lock--;
+
+    // keys that went to Allegro's buffer after the last queued event
+    while (num < INPUT_BATCH_SIZE && input_collect_spilled(&num)) {
+    }
+
+    // keys without a record (the spill ring was full) or put into Allegro's buffer by someone else get the current time
+    while (num < INPUT_BATCH_SIZE && input_buffer.spill_start == input_buffer.spill_end && keypressed()) {
+        input_event_t *ev = &input_batch[num++];
+        ev->key = readkey();
+        ev->x = mouse_x;
+        ev->y = mouse_y;
+        ev->buttons = mouse_b;
+        ev->joystick = -1;
+        ev->ticks = DOjS.sys_ticks;
+    }
+
+    // mouse changes that were dropped while the buffer was locked
+    if (num < INPUT_BATCH_SIZE && ((DOjS.last_mouse_x != mouse_x) || (DOjS.last_mouse_y != mouse_y) || (DOjS.last_mouse_b != mouse_b))) {
+        bool seen = false;
+        for (int i = num - 1; i >= 0; i--) {
+            if (input_batch[i].joystick < 0) {
+                seen = input_batch[i].x == mouse_x && input_batch[i].y == mouse_y && input_batch[i].buttons == mouse_b;
+                break;
+            }
+        }
+        if (!seen) {
+            input_event_t *ev = &input_batch[num++];
+            ev->key = -1;
+            ev->x = mouse_x;
+            ev->y = mouse_y;
+            ev->buttons = mouse_b;
+            ev->joystick = -1;
+            ev->ticks = DOjS.sys_ticks;
+        }
+    }
+    DOjS.last_mouse_x = mouse_x;
+    DOjS.last_mouse_y = mouse_y;
+    DOjS.last_mouse_b = mouse_b;
+
+    // joysticks are polled, report button changes
+    if (joystick && DOjS.joystick_available) {
+        poll_joystick();
+        for (int j = 0; j < MIN(num_joysticks, INPUT_MAX_JOYSTICKS) && num < INPUT_BATCH_SIZE; j++) {
+            int buttons = 0;
+            for (int b = 0; b < joy[j].num_buttons && b < 32; b++) {
+                if (joy[j].button[b].b) {
+                    buttons |= 1 << b;
+                }
+            }
+            if (buttons != input_joy_buttons[j]) {
+                input_joy_buttons[j] = buttons;
+
+                input_event_t *ev = &input_batch[num++];
+                ev->key = -1;
+                if (joy[j].num_sticks > 0 && joy[j].stick[0].num_axis > 1) {
+                    ev->x = joy[j].stick[0].axis[0].pos;
+                    ev->y = joy[j].stick[0].axis[1].pos;
+                } else {
+                    ev->x = ev->y = 0;
+                }
+                ev->buttons = buttons;
+                ev->joystick = j;
+                ev->ticks = DOjS.sys_ticks;
+            }
+        }
+    }
+
+    *count = num;
+    return input_batch;
+}
+
+/**
+ * @brief push a new event object filled with an event returned by collect_input().
+ * Input() gets a fresh object for every call, as scripts may keep it.
+ *
+ * @param J VM state.
+ * @param idx index of the event returned by collect_input().
+ */
+void push_input_event(js_State *J, int idx) {
+    js_newobject(J);
+    input_fill_event(J, idx);
+}
+
+/**
+ * @brief push the reusable array for InputBatch() filled with the first 'num' events returned by collect_input().
+ *
+ * @param J VM state.
+ * @param num number of events.
+ */
+void push_input_batch(js_State *J, int num) {
+    if (!input_pool_created) {
+        input_create_pool(J);
+    }
+    js_getregistry(J, INPUT_REG_BATCH);
+    js_setlength(J, -1, 0);
+    js_getregistry(J, INPUT_REG_POOL);
+    for (int i = 0; i < num; i++) {
+        js_getindex(J, -1, i);
+        input_fill_event(J, i);
+        js_setindex(J, -3, i);
+    }
+    js_pop(J, 1);
+}
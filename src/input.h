@@ -0,0 +1,58 @@
+/*
+MIT License
+
+Copyright (c) 2019-2021 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include "DOjS.h"
+
+/************
+** defines **
+************/
+#define INPUT_BUFFER_SIZE 64  //!< number of events queued between two frames
+#define INPUT_BATCH_SIZE 96   //!< maximum number of events delivered per frame
+#define INPUT_SPILL_SIZE 64   //!< number of keys remembered that went to Allegro's key buffer, matches its size
+#define INPUT_MAX_JOYSTICKS 4  //!< number of joysticks that generate events
+
+/************
+** structs **
+************/
+//! a single input event
+typedef struct {
+    int key;              //!< key code or -1 for mouse/joystick events
+    int x;                //!< mouse X (or stick X for joystick events)
+    int y;                //!< mouse Y (or stick Y for joystick events)
+    int buttons;          //!< mouse (or joystick) buttons
+    int joystick;         //!< joystick index or -1 for mouse/keyboard events
+    unsigned long ticks;  //!< value of DOjS.sys_ticks when the event occured
+} input_event_t;
+
+/*********************
+** static functions **
+*********************/
+extern void init_input(void);
+extern void shutdown_input(void);
+extern const input_event_t *collect_input(bool joystick, int *count);
+extern void push_input_event(js_State *J, int idx);
+extern void push_input_batch(js_State *J, int num);
+
+#endif  // __INPUT_H__
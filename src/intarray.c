@@ -317,6 +317,18 @@ static void IntArray_Append(js_State *J) {
     IA_UPDATE(J, "length", ia->size);
 }
 
+/**
+ * @brief get an ArrayBuffer that uses the storage of this IntArray, wrap it in an Int32Array() to access it.
+ * ia.GetBuffer():ArrayBuffer
+ *
+ * @param J VM state.
+ */
+static void IntArray_GetBuffer(js_State *J) {
+    int_array_t *ia = js_touserdata(J, 0, TAG_INT_ARRAY);
+
+    js_newarraybufferp(J, 0, (void **)&ia->data, (unsigned int *)&ia->size, sizeof(IA_TYPE));
+}
+
 /***********************
 ** exported functions **
 ***********************/
@@ -339,6 +351,7 @@ void init_intarray(js_State *J) {
         NPROTDEF(J, IntArray, Clear, 0);
         NPROTDEF(J, IntArray, ToString, 0);
         NPROTDEF(J, IntArray, Append, 1);
+        NPROTDEF(J, IntArray, GetBuffer, 0);
     }
     CTORDEF(J, new_IntArray, TAG_INT_ARRAY, 0);
 
@@ -353,6 +366,7 @@ void init_intarray(js_State *J) {
         NPROTDEF(J, IntArray, Clear, 0);
         NPROTDEF(J, IntArray, ToString, 0);
         NPROTDEF(J, IntArray, Append, 1);
+        NPROTDEF(J, IntArray, GetBuffer, 0);
     }
     js_setregistry(J, TAG_INT_ARRAY);
 
@@ -380,6 +394,7 @@ void IntArray_fromBytes(js_State *J, const uint8_t *data, uint32_t size) {
     }
     ia->alloc_size = size;
     ia->size = size;
+    gc_native_alloc(ia->alloc_size * sizeof(IA_TYPE));
 
     for (uint32_t i = 0; i < size; i++) {
         ia->data[i] = data[i];
@@ -422,6 +437,7 @@ void IntArray_fromStruct(js_State *J, int_array_t *ia) {
 void IntArray_destroy(int_array_t *ia) {
     if (ia) {
         if (ia->data) {
+            gc_native_free(ia->alloc_size * sizeof(IA_TYPE));
             free(ia->data);
         }
         free(ia);
@@ -445,6 +461,7 @@ int_array_t *IntArray_create() {
     }
     ia->alloc_size = IA_DEFAULT_SIZE;
     ia->size = 0;
+    gc_native_alloc(ia->alloc_size * sizeof(IA_TYPE));
 
     return ia;
 }
@@ -470,6 +487,8 @@ int IntArray_push(int_array_t *ia, IA_TYPE val) {
             larger[i] = ia->data[i];
         }
 
+        gc_native_free(ia->alloc_size * sizeof(IA_TYPE));
+        gc_native_alloc(larger_size * sizeof(IA_TYPE));
         free(ia->data);
         ia->data = larger;
         ia->alloc_size = larger_size;
@@ -0,0 +1,288 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+QOI (Quite OK Image format) loader/saver, see https://qoiformat.org/
+Based on the reference implementation by Dominic Szablewski (MIT License).
+*/
+
+#include "qoi.h"
+
+#include <allegro.h>
+#include <allegro/internal/aintern.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "imgload.h"
+
+/************
+** defines **
+************/
+#define QOI_HASH(p) (((p).r * 3 + (p).g * 5 + (p).b * 7 + (p).a * 11) % 64)  //!< index position of a pixel
+
+/************
+** structs **
+************/
+//! a pixel as stored in a QOI file
+typedef union {
+    struct {
+        uint8_t r, g, b, a;  //!< color components
+    };
+    uint32_t v;  //!< all components for comparison
+} qoi_rgba_t;
+
+/*********************
+** static variables **
+*********************/
+static const uint8_t qoi_magic[] = {'q', 'o', 'i', 'f'};                        //!< file magic
+static const uint8_t qoi_padding[QOI_PADDING_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};  //!< end marker
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief load a QOI image from a PACKFILE.
+ *
+ * @param f the PACKFILE to load from.
+ * @param pal palette (is ignored).
+ *
+ * @return BITMAP* or NULL if loading fails.
+ */
+BITMAP *load_qoi_pf(PACKFILE *f, RGB *pal) {
+    uint8_t magic[sizeof(qoi_magic)];
+
+    if (pack_fread(magic, sizeof(magic), f) != sizeof(magic) || memcmp(magic, qoi_magic, sizeof(magic)) != 0) {
+        return NULL;
+    }
+    uint32_t w = pack_mgetl(f);
+    uint32_t h = pack_mgetl(f);
+    int channels = pack_getc(f);
+    int colorspace = pack_getc(f);
+    if (w == 0 || h == 0 || h >= QOI_PIXELS_MAX / w || channels < 3 || channels > 4 || colorspace < QOI_SRGB || colorspace > QOI_LINEAR) {
+        return NULL;
+    }
+
+    BITMAP *bm = create_bitmap_ex(32, w, h);
+    if (!bm) {
+        return NULL;
+    }
+
+    qoi_rgba_t index[64];
+    qoi_rgba_t px = {.r = 0, .g = 0, .b = 0, .a = 255};
+    int run = 0;
+    memset(index, 0, sizeof(index));
+
+    for (int y = 0; y < bm->h; y++) {
+        uint32_t *dst = (uint32_t *)bm->line[y];
+
+        imgload_yield();
+        for (int x = 0; x < bm->w; x++) {
+            if (run > 0) {
+                run--;
+            } else {
+                int b1 = pack_getc(f);
+                if (b1 == EOF) {
+                    destroy_bitmap(bm);
+                    return NULL;
+                }
+
+                if (b1 == QOI_OP_RGB) {
+                    px.r = pack_getc(f);
+                    px.g = pack_getc(f);
+                    px.b = pack_getc(f);
+                } else if (b1 == QOI_OP_RGBA) {
+                    px.r = pack_getc(f);
+                    px.g = pack_getc(f);
+                    px.b = pack_getc(f);
+                    px.a = pack_getc(f);
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+                    px = index[b1];
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                    px.r += ((b1 >> 4) & 0x03) - 2;
+                    px.g += ((b1 >> 2) & 0x03) - 2;
+                    px.b += (b1 & 0x03) - 2;
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                    int b2 = pack_getc(f);
+                    int vg = (b1 & 0x3f) - 32;
+                    px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                    px.g += vg;
+                    px.b += vg - 8 + (b2 & 0x0f);
+                } else {
+                    run = b1 & 0x3f;
+                }
+                index[QOI_HASH(px)] = px;
+            }
+            dst[x] = makeacol32(px.r, px.g, px.b, px.a);
+        }
+    }
+    if (pack_ferror(f)) {
+        destroy_bitmap(bm);
+        return NULL;
+    }
+
+    // convert to the color depth requested by set_color_depth()/set_color_conversion()
+    int dest_depth = _color_load_depth(32, channels == 4);
+    if (dest_depth != 32) {
+        bm = _fixup_loaded_bitmap(bm, pal, dest_depth);
+    }
+    return bm;
+}
+
+/**
+ * @brief load a QOI image from file system.
+ *
+ * @param filename the name of the file.
+ * @param pal palette (is ignored).
+ *
+ * @return BITMAP* or NULL if loading fails.
+ */
+BITMAP *load_qoi(AL_CONST char *filename, RGB *pal) {
+    PACKFILE *f = pack_fopen(filename, F_READ);
+    if (!f) {
+        return NULL;
+    }
+    BITMAP *bm = load_qoi_pf(f, pal);
+    pack_fclose(f);
+    return bm;
+}
+
+/**
+ * @brief save a BITMAP as QOI image to a PACKFILE. Bitmaps with alpha values are saved with 4 channels, all others with 3.
+ *
+ * @param f the PACKFILE to write to.
+ * @param bmp the BITMAP to save.
+ * @param pal palette for 8bpp bitmaps.
+ *
+ * @return int 0 for success, non-zero on error.
+ */
+int save_qoi_pf(PACKFILE *f, BITMAP *bmp, AL_CONST RGB *pal) {
+    int depth = bitmap_color_depth(bmp);
+    int channels = (depth == 32 && _bitmap_has_alpha(bmp)) ? 4 : 3;
+
+    pack_fwrite(qoi_magic, sizeof(qoi_magic), f);
+    pack_mputl(bmp->w, f);
+    pack_mputl(bmp->h, f);
+    pack_putc(channels, f);
+    pack_putc(QOI_SRGB, f);
+
+    if (depth == 8 && pal) {
+        select_palette(pal);
+    }
+
+    qoi_rgba_t index[64];
+    qoi_rgba_t px_prev = {.r = 0, .g = 0, .b = 0, .a = 255};
+    qoi_rgba_t px;
+    int run = 0;
+    int last_y = bmp->h - 1;
+    int last_x = bmp->w - 1;
+    memset(index, 0, sizeof(index));
+
+    for (int y = 0; y < bmp->h; y++) {
+        for (int x = 0; x < bmp->w; x++) {
+            if (depth == 32) {
+                uint32_t c = ((uint32_t *)bmp->line[y])[x];
+                px.r = getr32(c);
+                px.g = getg32(c);
+                px.b = getb32(c);
+                px.a = channels == 4 ? geta32(c) : 255;
+            } else {
+                int c = getpixel(bmp, x, y);
+                px.r = getr_depth(depth, c);
+                px.g = getg_depth(depth, c);
+                px.b = getb_depth(depth, c);
+                px.a = 255;
+            }
+
+            if (px.v == px_prev.v) {
+                run++;
+                if (run == 62 || (y == last_y && x == last_x)) {
+                    pack_putc(QOI_OP_RUN | (run - 1), f);
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                pack_putc(QOI_OP_RUN | (run - 1), f);
+                run = 0;
+            }
+
+            int index_pos = QOI_HASH(px);
+            if (index[index_pos].v == px.v) {
+                pack_putc(QOI_OP_INDEX | index_pos, f);
+            } else {
+                index[index_pos] = px;
+
+                if (px.a == px_prev.a) {
+                    signed char vr = px.r - px_prev.r;
+                    signed char vg = px.g - px_prev.g;
+                    signed char vb = px.b - px_prev.b;
+                    signed char vg_r = vr - vg;
+                    signed char vg_b = vb - vg;
+
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        pack_putc(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2), f);
+                    } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                        pack_putc(QOI_OP_LUMA | (vg + 32), f);
+                        pack_putc((vg_r + 8) << 4 | (vg_b + 8), f);
+                    } else {
+                        pack_putc(QOI_OP_RGB, f);
+                        pack_putc(px.r, f);
+                        pack_putc(px.g, f);
+                        pack_putc(px.b, f);
+                    }
+                } else {
+                    pack_putc(QOI_OP_RGBA, f);
+                    pack_putc(px.r, f);
+                    pack_putc(px.g, f);
+                    pack_putc(px.b, f);
+                    pack_putc(px.a, f);
+                }
+            }
+            px_prev = px;
+        }
+    }
+    pack_fwrite(qoi_padding, sizeof(qoi_padding), f);
+
+    if (depth == 8 && pal) {
+        unselect_palette();
+    }
+
+    return pack_ferror(f) ? -1 : 0;
+}
+
+/**
+ * @brief save a BITMAP as QOI image to file system.
+ *
+ * @param filename the name of the file.
+ * @param bmp the BITMAP to save.
+ * @param pal palette for 8bpp bitmaps.
+ *
+ * @return int 0 for success, non-zero on error.
+ */
+int save_qoi(AL_CONST char *filename, BITMAP *bmp, AL_CONST RGB *pal) {
+    PACKFILE *f = pack_fopen(filename, F_WRITE);
+    if (!f) {
+        return -1;
+    }
+    int ret = save_qoi_pf(f, bmp, pal);
+    pack_fclose(f);
+    return ret;
+}
@@ -0,0 +1,54 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __QOI_H__
+#define __QOI_H__
+
+#include <allegro.h>
+
+/************
+** defines **
+************/
+#define QOI_HEADER_SIZE 14        //!< magic, width, height, channels, colorspace
+#define QOI_PADDING_SIZE 8        //!< size of the end marker
+#define QOI_PIXELS_MAX 400000000  //!< refuse images with more pixels than this
+
+#define QOI_OP_INDEX 0x00  //!< 00xxxxxx
+#define QOI_OP_DIFF 0x40   //!< 01xxxxxx
+#define QOI_OP_LUMA 0x80   //!< 10xxxxxx
+#define QOI_OP_RUN 0xc0    //!< 11xxxxxx
+#define QOI_OP_RGB 0xfe    //!< 11111110
+#define QOI_OP_RGBA 0xff   //!< 11111111
+#define QOI_MASK_2 0xc0    //!< 11000000
+
+#define QOI_SRGB 0    //!< sRGB with linear alpha
+#define QOI_LINEAR 1  //!< all channels linear
+
+/***********************
+** exported functions **
+***********************/
+extern BITMAP *load_qoi(AL_CONST char *filename, RGB *pal);
+extern BITMAP *load_qoi_pf(PACKFILE *f, RGB *pal);
+extern int save_qoi(AL_CONST char *filename, BITMAP *bmp, AL_CONST RGB *pal);
+extern int save_qoi_pf(PACKFILE *f, BITMAP *bmp, AL_CONST RGB *pal);
+
+#endif  // __QOI_H__
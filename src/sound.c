@@ -198,6 +198,19 @@ static void Sample_Get(js_State *J) {
     }
 }
 
+/**
+ * @brief get an ArrayBuffer over the sample data (no copy), wrap it in a Uint8Array() for 8 bit or a Uint16Array() for 16 bit samples.
+ * Samples are unsigned, stereo samples are interleaved left/right.
+ * snd.GetBuffer():ArrayBuffer
+ *
+ * @param J VM state.
+ */
+static void Sample_GetBuffer(js_State *J) {
+    SAMPLE *snd = js_touserdata(J, 0, TAG_SAMPLE);
+
+    js_newarraybufferx(J, 0, snd->data, snd->len * (snd->stereo ? 2 : 1) * (snd->bits == 8 ? 1 : 2));
+}
+
 /**
  * @brief got current play position of given voice.
  * VoiceGetPosition(voc:number):number
@@ -458,6 +471,7 @@ void init_sound(js_State *J) {
         NPROTDEF(J, Sample, Play, 0);
         NPROTDEF(J, Sample, Stop, 1);
         NPROTDEF(J, Sample, Get, 1);
+        NPROTDEF(J, Sample, GetBuffer, 0);
     }
     CTORDEF(J, new_Sample, TAG_SAMPLE, 1);
 
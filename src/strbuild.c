@@ -0,0 +1,218 @@
+/*
+MIT License
+
+Copyright (c) 2019-2021 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "strbuild.h"
+
+#include <mujs.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DOjS.h"
+
+/************
+** defines **
+************/
+#define SB_DEFAULT_SIZE 256               //!< initial buffer size
+#define SB_MAX_SIZE (1024 * 1024 * 1024)  //!< longest string the builder will hold
+
+#define SB_UPDATE(j, sb)                \
+    {                                   \
+        js_pushnumber(j, sb->size);     \
+        js_setproperty(j, 0, "length"); \
+    }
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief free resources of a StringBuilder.
+ *
+ * @param sb pointer to an existing struct.
+ */
+static void StringBuilder_destroy(string_builder_t *sb) {
+    if (sb) {
+        if (sb->data) {
+            gc_native_free(sb->alloc_size);
+            free(sb->data);
+        }
+        free(sb);
+    }
+}
+
+/**
+ * @brief finalize a StringBuilder and free resources.
+ *
+ * @param J VM state.
+ */
+static void StringBuilder_Finalize(js_State *J, void *data) {
+    string_builder_t *sb = (string_builder_t *)data;
+    StringBuilder_destroy(sb);
+}
+
+/**
+ * @brief append characters to the buffer, doubling its size when it is full.
+ *
+ * @param sb pointer to an existing struct.
+ * @param str the characters to append.
+ * @param len number of characters.
+ *
+ * @return true if the characters were appended, false if out of memory.
+ */
+static bool StringBuilder_append(string_builder_t *sb, const char *str, uint32_t len) {
+    if (len > SB_MAX_SIZE - sb->size) {
+        return false;
+    }
+    if (sb->size + len > sb->alloc_size) {
+        uint32_t larger_size = sb->alloc_size * 2;
+        while (larger_size < sb->size + len) {
+            larger_size *= 2;
+        }
+        char *larger = realloc(sb->data, larger_size);
+        if (!larger) {
+            return false;
+        }
+        gc_native_free(sb->alloc_size);
+        gc_native_alloc(larger_size);
+        sb->data = larger;
+        sb->alloc_size = larger_size;
+    }
+    memcpy(sb->data + sb->size, str, len);
+    sb->size += len;
+    return true;
+}
+
+/**
+ * @brief append the string representation of all parameters.
+ *
+ * @param J VM state.
+ * @param sb pointer to an existing struct.
+ * @param first index of the first parameter.
+ * @param top index after the last parameter.
+ */
+static void StringBuilder_appendargs(js_State *J, string_builder_t *sb, int first, int top) {
+    for (int i = first; i < top; i++) {
+        const char *str = js_tostring(J, i);
+        if (!StringBuilder_append(sb, str, strlen(str))) {
+            JS_ENOMEM(J);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief create a new StringBuilder, optionally with initial contents.
+ * new StringBuilder([...values:any])
+ *
+ * @param J VM state.
+ */
+static void new_StringBuilder(js_State *J) {
+    NEW_OBJECT_PREP(J);
+    int top = js_gettop(J);
+
+    string_builder_t *sb = calloc(sizeof(string_builder_t), 1);
+    if (!sb) {
+        JS_ENOMEM(J);
+        return;
+    }
+    sb->data = malloc(SB_DEFAULT_SIZE);
+    if (!sb->data) {
+        free(sb);
+        JS_ENOMEM(J);
+        return;
+    }
+    sb->alloc_size = SB_DEFAULT_SIZE;
+    sb->size = 0;
+    gc_native_alloc(sb->alloc_size);
+
+    js_currentfunction(J);
+    js_getproperty(J, -1, "prototype");
+    js_newuserdata(J, TAG_STRINGBUILDER, sb, StringBuilder_Finalize);
+
+    // js_tostring() may run script code (toString()), so the buffer must be owned by the object first
+    StringBuilder_appendargs(J, sb, 1, top);
+
+    // add properties
+    js_pushnumber(J, sb->size);
+    js_defproperty(J, -2, "length", JS_DONTCONF);
+}
+
+/**
+ * @brief append the string representation of all parameters, returns the StringBuilder for chaining.
+ * sb.Append(...values:any):StringBuilder
+ *
+ * @param J VM state.
+ */
+static void StringBuilder_Append(js_State *J) {
+    string_builder_t *sb = js_touserdata(J, 0, TAG_STRINGBUILDER);
+
+    StringBuilder_appendargs(J, sb, 1, js_gettop(J));
+    SB_UPDATE(J, sb);
+
+    js_copy(J, 0);
+}
+
+/**
+ * @brief get the contents as a string.
+ * sb.ToString():string
+ *
+ * @param J VM state.
+ */
+static void StringBuilder_ToString(js_State *J) {
+    string_builder_t *sb = js_touserdata(J, 0, TAG_STRINGBUILDER);
+
+    js_pushlstring(J, sb->data, sb->size);
+}
+
+/**
+ * @brief remove all contents, the buffer is kept for reuse.
+ * sb.Clear()
+ *
+ * @param J VM state.
+ */
+static void StringBuilder_Clear(js_State *J) {
+    string_builder_t *sb = js_touserdata(J, 0, TAG_STRINGBUILDER);
+
+    sb->size = 0;
+    SB_UPDATE(J, sb);
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief initialize StringBuilder class.
+ *
+ * @param J VM state.
+ */
+void init_strbuild(js_State *J) {
+    DEBUGF("%s\n", __PRETTY_FUNCTION__);
+
+    js_newobject(J);
+    {
+        NPROTDEF(J, StringBuilder, Append, 1);
+        NPROTDEF(J, StringBuilder, ToString, 0);
+        NPROTDEF(J, StringBuilder, Clear, 0);
+    }
+    CTORDEF(J, new_StringBuilder, TAG_STRINGBUILDER, 0);
+
+    DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
+}
@@ -0,0 +1,360 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "stroke.h"
+
+#include <allegro.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "DOjS.h"
+
+/************
+** structs **
+************/
+//! a horizontal run of pixels, both ends inclusive
+typedef struct {
+    int x1;  //!< left end
+    int x2;  //!< right end
+} stroke_span_t;
+
+//! span buffer of the current curve stroke
+typedef struct {
+    stroke_span_t *spans;  //!< max_spans entries per scanline
+    int *num;              //!< number of spans per scanline
+    int rows;              //!< number of allocated scanlines
+    int max_spans;         //!< number of allocated spans per scanline
+    int top;               //!< first scanline of the bitmap clip rectangle
+    int bottom;            //!< last scanline of the bitmap clip rectangle
+    int ymin;              //!< first scanline with spans
+    int ymax;              //!< last scanline with spans
+    int radius;            //!< number of entries in half_width - 1
+    int *half_width;       //!< half width of the pen for each distance from its center line
+} stroke_buffer_t;
+
+/*********************
+** static variables **
+*********************/
+static stroke_buffer_t stroke;  //!< there is only ever one curve stroked at a time
+
+/*********************
+** static functions **
+*********************/
+/**
+ * @brief double the number of spans per scanline of the span buffer.
+ *
+ * @return false if out of memory.
+ */
+static bool stroke_grow(void) {
+    int max_spans = stroke.max_spans * 2;
+    stroke_span_t *spans = malloc(stroke.rows * max_spans * sizeof(stroke_span_t));
+    if (!spans) {
+        return false;
+    }
+    for (int row = 0; row < stroke.rows; row++) {
+        for (int i = 0; i < stroke.num[row]; i++) {
+            spans[row * max_spans + i] = stroke.spans[row * stroke.max_spans + i];
+        }
+    }
+    free(stroke.spans);
+    stroke.spans = spans;
+    stroke.max_spans = max_spans;
+    return true;
+}
+
+/**
+ * @brief add a span to a scanline of the span buffer, overlapping and touching spans are merged.
+ *
+ * @param y the scanline.
+ * @param x1 left end.
+ * @param x2 right end.
+ *
+ * @return false if the scanline is full and the buffer could not be grown, the span was not added.
+ */
+static bool stroke_add_span(int y, int x1, int x2) {
+    if (y < stroke.top || y > stroke.bottom) {
+        return true;
+    }
+    int row = y - stroke.top;
+    stroke_span_t *s = &stroke.spans[row * stroke.max_spans];
+    int n = stroke.num[row];
+
+    // merge with all spans that overlap or touch
+    int i = 0;
+    while (i < n) {
+        if (s[i].x1 <= x2 + 1 && x1 <= s[i].x2 + 1) {
+            x1 = MIN(x1, s[i].x1);
+            x2 = MAX(x2, s[i].x2);
+            s[i] = s[--n];
+        } else {
+            i++;
+        }
+    }
+
+    if (n == stroke.max_spans) {
+        // spans that don't touch must stay separate, merging them would fill the gap in between
+        stroke.num[row] = n;
+        if (!stroke_grow()) {
+            return false;
+        }
+        s = &stroke.spans[row * stroke.max_spans];
+    }
+    s[n].x1 = x1;
+    s[n].x2 = x2;
+    stroke.num[row] = n + 1;
+
+    if (y < stroke.ymin) {
+        stroke.ymin = y;
+    }
+    if (y > stroke.ymax) {
+        stroke.ymax = y;
+    }
+    return true;
+}
+
+/**
+ * @brief add a span to the span buffer. If the buffer can't grow, everything collected so far is drawn first to make room.
+ * Pixels covered by spans before and after the flush are drawn twice then, but no gap between spans is ever filled.
+ *
+ * @param bm destination.
+ * @param y the scanline.
+ * @param x1 left end.
+ * @param x2 right end.
+ * @param color the color.
+ */
+static void stroke_put_span(BITMAP *bm, int y, int x1, int x2, int color) {
+    if (!stroke_add_span(y, x1, x2)) {
+        stroke_end(bm, color);
+        stroke_add_span(y, x1, x2);  // the scanline is empty now, this can't fail
+    }
+}
+
+/**
+ * @brief limit a pixel span of a line stroke on one scanline by a band |a * x + b| <= c.
+ *
+ * @param a factor of x.
+ * @param b constant part.
+ * @param c half height of the band.
+ * @param x1 left end of the span, updated.
+ * @param x2 right end of the span, updated.
+ */
+static void stroke_band(double a, double b, double c, double *x1, double *x2) {
+    if (fabs(a) < 1e-9) {
+        if (fabs(b) > c) {
+            *x1 = 1;
+            *x2 = 0;
+        }
+    } else {
+        double l = (-c - b) / a;
+        double r = (c - b) / a;
+        if (l > r) {
+            double t = l;
+            l = r;
+            r = t;
+        }
+        *x1 = MAX(*x1, l);
+        *x2 = MIN(*x2, r);
+    }
+}
+
+/**
+ * @brief extend a span by another one (only used for spans that are known to overlap).
+ *
+ * @param x1 left end of the span, updated.
+ * @param x2 right end of the span, updated.
+ * @param l left end of the other span.
+ * @param r right end of the other span, empty if smaller than l.
+ */
+static void stroke_union(double *x1, double *x2, double l, double r) {
+    if (l <= r) {
+        *x1 = MIN(*x1, l);
+        *x2 = MAX(*x2, r);
+    }
+}
+
+/**
+ * @brief draw a span if it covers at least one pixel center.
+ *
+ * @param bm destination.
+ * @param y the scanline.
+ * @param x1 left end.
+ * @param x2 right end.
+ * @param color the color.
+ */
+static void stroke_hline(BITMAP *bm, int y, double x1, double x2, int color) {
+    int l = (int)ceil(x1 - 1e-9);
+    int r = (int)floor(x2 + 1e-9);
+    if (l <= r) {
+        hline(bm, l, y, r, color);
+    }
+}
+
+/***********************
+** exported functions **
+***********************/
+/**
+ * @brief draw a line of given width. Every pixel whose center is inside the stroke is drawn exactly once.
+ *
+ * @param bm destination.
+ * @param x1 start point X.
+ * @param y1 start point Y.
+ * @param x2 end point X.
+ * @param y2 end point Y.
+ * @param w line width.
+ * @param cap one of CAP_ROUND, CAP_SQUARE or CAP_PROJECT.
+ * @param color the color.
+ */
+void stroke_line(BITMAP *bm, int x1, int y1, int x2, int y2, int w, int cap, int color) {
+    double r = MAX(w, 1) / 2.0;
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    double len = sqrt(dx * dx + dy * dy);
+
+    // unit direction of the line, a single point is treated like a horizontal line
+    double ux = len < 1e-9 ? 1 : dx / len;
+    double uy = len < 1e-9 ? 0 : dy / len;
+    double ext = (cap == CAP_PROJECT || (cap == CAP_SQUARE && len < 1e-9)) ? r : 0;
+
+    int ytop = MAX((int)floor(MIN(y1, y2) - r), bm->ct);
+    int ybot = MIN((int)ceil(MAX(y1, y2) + r), bm->cb - 1);
+
+    for (int y = ytop; y <= ybot; y++) {
+        double py = y - y1;
+
+        // body: distance from the center line |-uy * px + ux * py| <= r and position along the line -ext <= ux * px + uy * py <= len + ext
+        double l = -INFINITY;
+        double rr = INFINITY;
+        stroke_band(-uy, ux * py, r, &l, &rr);
+        stroke_band(ux, uy * py - len / 2, len / 2 + ext, &l, &rr);
+        if (l > rr) {
+            l = INFINITY;
+            rr = -INFINITY;
+        }
+
+        if (cap == CAP_ROUND) {
+            // round caps are the disks around both end points, the stroke is convex so the union is a single span
+            double h = r * r - py * py;
+            if (h >= 0) {
+                h = sqrt(h);
+                stroke_union(&l, &rr, -h, h);
+            }
+            double py2 = y - y2;
+            h = r * r - py2 * py2;
+            if (h >= 0) {
+                h = sqrt(h);
+                stroke_union(&l, &rr, dx - h, dx + h);
+            }
+        }
+
+        if (l <= rr) {
+            stroke_hline(bm, y, x1 + l, x1 + rr, color);
+        }
+    }
+}
+
+/**
+ * @brief start stroking a curve. All points passed to stroke_point() are collected as spans of a round pen and drawn by stroke_end().
+ *
+ * @param bm destination.
+ * @param w pen width.
+ *
+ * @return false if out of memory.
+ */
+bool stroke_begin(BITMAP *bm, int w) {
+    int rows = bm->cb - bm->ct;
+    if (!stroke.max_spans) {
+        stroke.max_spans = STROKE_MIN_SPANS;
+    }
+    if (rows > stroke.rows) {
+        stroke_span_t *spans = realloc(stroke.spans, rows * stroke.max_spans * sizeof(stroke_span_t));
+        if (!spans) {
+            return false;
+        }
+        stroke.spans = spans;
+        int *num = realloc(stroke.num, rows * sizeof(int));
+        if (!num) {
+            return false;
+        }
+        stroke.num = num;
+        for (int i = stroke.rows; i < rows; i++) {
+            stroke.num[i] = 0;
+        }
+        stroke.rows = rows;
+    }
+
+    // half width of the pen for each vertical distance from its center
+    double r = MAX(w, 1) / 2.0;
+    int radius = (int)floor(r);
+    int *half_width = realloc(stroke.half_width, (radius + 1) * sizeof(int));
+    if (!half_width) {
+        return false;
+    }
+    stroke.half_width = half_width;
+    for (int i = 0; i <= radius; i++) {
+        stroke.half_width[i] = (int)floor(sqrt(r * r - i * i) + 1e-9);
+    }
+    stroke.radius = radius;
+
+    stroke.top = bm->ct;
+    stroke.bottom = bm->cb - 1;
+    stroke.ymin = INT_MAX;
+    stroke.ymax = INT_MIN;
+    return true;
+}
+
+/**
+ * @brief add the pen at a curve point to the current stroke. The signature matches the callbacks of do_line(), do_circle(), do_ellipse() and do_arc().
+ *
+ * @param bm destination.
+ * @param x pen center.
+ * @param y pen center.
+ * @param d color.
+ */
+void stroke_point(BITMAP *bm, int x, int y, int d) {
+    for (int i = 0; i <= stroke.radius; i++) {
+        int h = stroke.half_width[i];
+        stroke_put_span(bm, y - i, x - h, x + h, d);
+        if (i) {
+            stroke_put_span(bm, y + i, x - h, x + h, d);
+        }
+    }
+}
+
+/**
+ * @brief draw all spans of the current stroke.
+ *
+ * @param bm destination.
+ * @param color the color.
+ */
+void stroke_end(BITMAP *bm, int color) {
+    for (int y = stroke.ymin; y <= stroke.ymax; y++) {
+        int row = y - stroke.top;
+        stroke_span_t *s = &stroke.spans[row * stroke.max_spans];
+        for (int i = 0; i < stroke.num[row]; i++) {
+            hline(bm, s[i].x1, y, s[i].x2, color);
+        }
+        stroke.num[row] = 0;
+    }
+    stroke.ymin = INT_MAX;
+    stroke.ymax = INT_MIN;
+}
@@ -0,0 +1,48 @@
+/*
+MIT License
+
+Copyright (c) 2019-2022 Andre Seidelt <superilu@yahoo.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __STROKE_H__
+#define __STROKE_H__
+
+#include <allegro.h>
+#include <stdbool.h>
+
+/************
+** defines **
+************/
+#define STROKE_MIN_SPANS 1  //!< initial number of separate spans per scanline, the buffer grows when a scanline needs more
+
+#define STROKE_MARGIN(w) ((w) / 2 + 1)  //!< distance a stroke of width w may cover around its center line
+
+#define CAP_ROUND 0    //!< round line ends
+#define CAP_SQUARE 1   //!< line ends exactly at the end points
+#define CAP_PROJECT 2  //!< square line ends extended by half the width
+
+/***********************
+** exported functions **
+***********************/
+extern void stroke_line(BITMAP *bm, int x1, int y1, int x2, int y2, int w, int cap, int color);
+extern bool stroke_begin(BITMAP *bm, int w);
+extern void stroke_point(BITMAP *bm, int x, int y, int d);
+extern void stroke_end(BITMAP *bm, int color);
+
+#endif  // __STROKE_H__
@@ -72,9 +72,10 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTBLUE, ".prototype"),   //
 
     // DOjS functions
-    EDI_SYNTAX(MAGENTA, "Setup"),  //
-    EDI_SYNTAX(MAGENTA, "Loop"),   //
-    EDI_SYNTAX(MAGENTA, "Input"),  //
+    EDI_SYNTAX(MAGENTA, "Setup"),       //
+    EDI_SYNTAX(MAGENTA, "Loop"),        //
+    EDI_SYNTAX(MAGENTA, "InputBatch"),  //
+    EDI_SYNTAX(MAGENTA, "Input"),       //
 
     // array methods
     EDI_SYNTAX(LIGHTCYAN, ".lastIndexOf"),  //
@@ -142,6 +143,8 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "fxLfbConstantAlpha"),            //
     EDI_SYNTAX(LIGHTRED, "fxFogTableIndexToW"),            //
     EDI_SYNTAX(LIGHTRED, "ReadSoundInputInts"),            //
+    EDI_SYNTAX(LIGHTRED, "BitmapLoadsPending"),            //
+    EDI_SYNTAX(LIGHTRED, "SetBitmapLoadSlice"),            //
     EDI_SYNTAX(LIGHTRED, "NGetRotationMatrix"),            //
     EDI_SYNTAX(LIGHTRED, "MouseSetCursorMode"),            //
     EDI_SYNTAX(LIGHTRED, "IpxStringToAddress"),            //
@@ -152,6 +155,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "glGetTexParameter"),             //
     EDI_SYNTAX(LIGHTRED, "fxTexLodBiasValue"),             //
     EDI_SYNTAX(LIGHTRED, "fxGetZDepthMinMax"),             //
+    EDI_SYNTAX(LIGHTRED, "SetImageCacheSize"),             //
     EDI_SYNTAX(LIGHTRED, "fxGetWDepthMinMax"),             //
     EDI_SYNTAX(LIGHTRED, "fxFogGenerateExp2"),             //
     EDI_SYNTAX(LIGHTRED, "fxDrawVertexArray"),             //
@@ -166,6 +170,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "EnableRemoteDebug"),             //
     EDI_SYNTAX(LIGHTRED, "glPolygonStipple"),              //
     EDI_SYNTAX(LIGHTRED, "glDeleteTextures"),              //
+    EDI_SYNTAX(LIGHTRED, "CancelBitmapLoad"),              //
     EDI_SYNTAX(LIGHTRED, "fxGetRevisionTmu"),              //
     EDI_SYNTAX(LIGHTRED, "fxFogGenerateExp"),              //
     EDI_SYNTAX(LIGHTRED, "fxDepthBiasLevel"),              //
@@ -176,6 +181,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "QTranslateMatrix"),              //
     EDI_SYNTAX(LIGHTRED, "JoystickSaveData"),              //
     EDI_SYNTAX(LIGHTRED, "JoystickLoadData"),              //
+    EDI_SYNTAX(LIGHTRED, "InlineCacheStats"),              //
     EDI_SYNTAX(LIGHTRED, "GetZRotateMatrix"),              //
     EDI_SYNTAX(LIGHTRED, "GetYRotateMatrix"),              //
     EDI_SYNTAX(LIGHTRED, "GetXRotateMatrix"),              //
@@ -195,7 +201,16 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "fxFogColorValue"),               //
     EDI_SYNTAX(LIGHTRED, "fxChromakeyMode"),               //
     EDI_SYNTAX(LIGHTRED, "SoundStartInput"),               //
+    EDI_SYNTAX(LIGHTRED, "ImageCacheStats"),               //
+    EDI_SYNTAX(LIGHTRED, "ImageCacheFlush"),               //
+    EDI_SYNTAX(LIGHTRED, "LoadBitmapAsync"),               //
+    EDI_SYNTAX(LIGHTRED, "FlicRecordStart"),               //
+    EDI_SYNTAX(LIGHTRED, "FlicRecordStats"),               //
     EDI_SYNTAX(LIGHTRED, "SetRenderBitmap"),               //
+    EDI_SYNTAX(LIGHTRED, "BlendKernels"),                  //
+    EDI_SYNTAX(LIGHTRED, "SetPresentMode"),                //
+    EDI_SYNTAX(LIGHTRED, "FlicRecordStop"),                //
+    EDI_SYNTAX(LIGHTRED, "PresentStats"),                  //
     EDI_SYNTAX(LIGHTRED, "NormalizeVector"),               //
     EDI_SYNTAX(LIGHTRED, "NPolygonZNormal"),               //
     EDI_SYNTAX(LIGHTRED, "MouseShowCursor"),               //
@@ -248,6 +263,8 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "fxTexNCCTable"),                 //
     EDI_SYNTAX(LIGHTRED, "fxGetMemoryFb"),                 //
     EDI_SYNTAX(LIGHTRED, "fxBufferClear"),                 //
+    EDI_SYNTAX(LIGHTRED, "ZipCacheStats"),                 //
+    EDI_SYNTAX(LIGHTRED, "ZipCacheFlush"),                 //
     EDI_SYNTAX(LIGHTRED, "StringToBytes"),                 //
     EDI_SYNTAX(LIGHTRED, "NamedFunction"),                 //
     EDI_SYNTAX(LIGHTRED, "NPerspProject"),                 //
@@ -299,6 +316,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "VectorLength"),                  //
     EDI_SYNTAX(LIGHTRED, "SetFramerate"),                  //
     EDI_SYNTAX(LIGHTRED, "SaveTgaImage"),                  //
+    EDI_SYNTAX(LIGHTRED, "SaveQoiImage"),                  //
     EDI_SYNTAX(LIGHTRED, "SavePngImage"),                  //
     EDI_SYNTAX(LIGHTRED, "SavePcxImage"),                  //
     EDI_SYNTAX(LIGHTRED, "SaveBmpImage"),                  //
@@ -349,6 +367,8 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "fxColorMask"),                   //
     EDI_SYNTAX(LIGHTRED, "StartupInfo"),                   //
     EDI_SYNTAX(LIGHTRED, "SetSceneGap"),                   //
+    EDI_SYNTAX(LIGHTRED, "SetGcGrowth"),                   //
+    EDI_SYNTAX(LIGHTRED, "SetGcBudget"),                   //
     EDI_SYNTAX(LIGHTRED, "RequireFile"),                   //
     EDI_SYNTAX(LIGHTRED, "RenderScene"),                   //
     EDI_SYNTAX(LIGHTRED, "OutPortWord"),                   //
@@ -400,6 +420,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "CompareKey"),                    //
     EDI_SYNTAX(LIGHTRED, "ClearScene"),                    //
     EDI_SYNTAX(LIGHTRED, "gluLookAt"),                     //
+    EDI_SYNTAX(LIGHTRED, "PoolStats"),                     //
     EDI_SYNTAX(LIGHTRED, "glVertex4"),                     //
     EDI_SYNTAX(LIGHTRED, "glVertex3"),                     //
     EDI_SYNTAX(LIGHTRED, "glVertex2"),                     //
@@ -477,6 +498,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "IpDebug"),                       //
     EDI_SYNTAX(LIGHTRED, "Include"),                       //
     EDI_SYNTAX(LIGHTRED, "GetBlue"),                       //
+    EDI_SYNTAX(LIGHTRED, "GcStats"),                       //
     EDI_SYNTAX(LIGHTRED, "Ellipse"),                       //
     EDI_SYNTAX(LIGHTRED, "glRect"),                        //
     EDI_SYNTAX(LIGHTRED, "glInit"),                        //
@@ -519,8 +541,10 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(LIGHTRED, "Gc"),                            //
 
     // Classes
+    EDI_SYNTAX(LIGHTGREEN, "StringBuilder"),  // .ctor()
     EDI_SYNTAX(LIGHTGREEN, "DoubleArray"),  // .ctor()
     EDI_SYNTAX(LIGHTGREEN, "IntArray"),     // .ctor()
+    EDI_SYNTAX(LIGHTGREEN, "DrawList"),     // .ctor()
     EDI_SYNTAX(LIGHTGREEN, "GIFAnim"),      // .ctor()
     EDI_SYNTAX(LIGHTGREEN, "TexInfo"),      // .ctor()
     EDI_SYNTAX(LIGHTGREEN, "COMPort"),      // .ctor()
@@ -571,7 +595,9 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(RED, "SetProxyUser"),            //
     EDI_SYNTAX(RED, "SetProxyPort"),            //
     EDI_SYNTAX(RED, "SetMaxRedirs"),            //
+    EDI_SYNTAX(RED, "UnlockPixels"),            //
     EDI_SYNTAX(RED, "SaveTgaImage"),            //
+    EDI_SYNTAX(RED, "SaveQoiImage"),            //
     EDI_SYNTAX(RED, "SavePngImage"),            //
     EDI_SYNTAX(RED, "SavePcxImage"),            //
     EDI_SYNTAX(RED, "SaveBmpImage"),            //
@@ -594,6 +620,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(RED, "AddTextWrap"),             //
     EDI_SYNTAX(RED, "AddBookmark"),             //
     EDI_SYNTAX(RED, "WriteBytes"),              //
+    EDI_SYNTAX(RED, "LockPixels"),              //
     EDI_SYNTAX(RED, "SetTimeout"),              //
     EDI_SYNTAX(RED, "SetReferer"),              //
     EDI_SYNTAX(RED, "SetCookies"),              //
@@ -612,6 +639,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(RED, "AddEllipse"),              //
     EDI_SYNTAX(RED, "AddBarcode"),              //
     EDI_SYNTAX(RED, "WriteLine"),               //
+    EDI_SYNTAX(RED, "GetBuffer"),               //
     EDI_SYNTAX(RED, "WriteInts"),               //
     EDI_SYNTAX(RED, "WriteByte"),               //
     EDI_SYNTAX(RED, "WaitInput"),               //
@@ -636,6 +664,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(RED, "HasEnded"),                //
     EDI_SYNTAX(RED, "GetPixel"),                //
     EDI_SYNTAX(RED, "ToArray"),                 //
+    EDI_SYNTAX(RED, "Execute"),                 //
     EDI_SYNTAX(RED, "SetPost"),                 //
     EDI_SYNTAX(RED, "SetFont"),                 //
     EDI_SYNTAX(RED, "NoFlush"),                 //
@@ -644,6 +673,7 @@ const syntax_t edi_wordlist[] = {
     EDI_SYNTAX(RED, "AddLine"),                 //
     EDI_SYNTAX(RED, "AddFile"),                 //
     EDI_SYNTAX(RED, "Source"),                  //
+    EDI_SYNTAX(RED, "Length"),                  //
     EDI_SYNTAX(RED, "SetPut"),                  //
     EDI_SYNTAX(RED, "SetKey"),                  //
     EDI_SYNTAX(RED, "SetGet"),                  //
@@ -22,21 +22,30 @@ SOFTWARE.
 
 #include "zipfile.h"
 
+#include <ctype.h>
 #include <errno.h>
 #include <mujs.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include "DOjS.h"
 #include "zip.h"
 #include "bytearray.h"
+#include "util.h"
 
 /************
 ** defines **
 ************/
 #define MAX_LINE_LENGTH 4096  //!< read at max 4KiB
+#define ZIP_CACHE_SIZE 4      //!< number of archives kept open by the archive cache
+#define ZIP_READ_CHUNK 4096   //!< buffer size for Zip.ReadBytes()
+
+#define ZIPSTREAM_WINDOW (16 * 1024)        //!< size of the window a streamed entry is inflated into
+#define ZIPSTREAM_CHECKPOINT (1024 * 1024)  //!< distance of the inflate checkpoints used for seeking backwards
 
 /************
 ** structs **
@@ -49,6 +58,54 @@ typedef struct __file {
     bool deleteable;    //!< indicates the zip was opened for deleting
 } jszip_t;
 
+//! entry of the name index of a cached archive
+typedef struct {
+    char *name;      //!< lower case entry name with '/' as separator, NULL for empty slots
+    uint32_t hash;   //!< hash of the name
+    size_t index;    //!< index in the central directory
+} zipcache_entry_t;
+
+//! an archive kept open by the archive cache
+typedef struct {
+    char *path;                 //!< path of the archive, NULL for unused slots
+    time_t mtime;               //!< modification time when the archive was opened
+    off_t size;                 //!< file size when the archive was opened
+    struct zip_t *zip;          //!< the open archive
+    zipcache_entry_t *entries;  //!< hash table of the entry names
+    size_t capacity;            //!< size of the hash table (power of two)
+    size_t num_entries;         //!< number of entries in the archive
+    unsigned long last_use;     //!< value of 'zipcache_clock' on last use
+    int refs;                   //!< number of references (the cache slot and open streams)
+} zipcache_archive_t;
+
+//! statistics of the archive cache
+typedef struct {
+    unsigned long hits;       //!< lookups served by an open archive
+    unsigned long misses;     //!< lookups that had to open the archive
+    unsigned long stale;      //!< archives reopened because they changed on disk
+    unsigned long evictions;  //!< archives closed to make room for another one
+    unsigned long failed;     //!< lookups of missing archives or entries
+} zipcache_stats_t;
+
+//! an entry of a ZIP file that is inflated on demand
+struct zipstream {
+    zipcache_archive_t *archive;        //!< the archive, referenced while the stream is open
+    struct zip_entry_reader_t *reader;  //!< the entry reader
+    unsigned long size;                 //!< uncompressed size of the entry
+    unsigned long window_pos;           //!< stream position of window[0]
+    long length;                        //!< number of valid bytes in the window
+    long offset;                        //!< read position in the window
+    bool error;                         //!< a read error occured
+    uint8_t window[ZIPSTREAM_WINDOW];   //!< inflated data
+};
+
+/*********************
+** static variables **
+*********************/
+static zipcache_archive_t *zipcache[ZIP_CACHE_SIZE];  //!< the open archives
+static zipcache_stats_t zipcache_stats;               //!< cache statistics
+static unsigned long zipcache_clock;                  //!< use counter for LRU eviction
+
 /*********************
 ** static functions **
 *********************/
@@ -65,6 +122,29 @@ static void Zip_Finalize(js_State *J, void *data) {
     free(z);
 }
 
+/**
+ * @brief open an entry of a zip for incremental reading, throws an exception if the entry can't be opened.
+ *
+ * @param J VM state.
+ * @param z the zip.
+ * @param zip_name name of the entry.
+ *
+ * @return struct zip_entry_reader_t* the reader, must be closed with zip_entry_reader_close().
+ */
+static struct zip_entry_reader_t *Zip_OpenReader(js_State *J, jszip_t *z, const char *zip_name) {
+    if (zip_entry_open(z->zip, zip_name) < 0) {
+        js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_open)!", zip_name);
+        return NULL;
+    }
+    struct zip_entry_reader_t *reader = zip_entry_reader_open(z->zip, 0);
+    if (zip_entry_close(z->zip) < 0 || !reader) {
+        zip_entry_reader_close(reader);
+        js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_reader_open)!", zip_name);
+        return NULL;
+    }
+    return reader;
+}
+
 /**
  * @brief open a zip and store it as userdata in JS object.
  * new Zip(filename:string, mode:string, [compression:number])
@@ -107,6 +187,10 @@ static void new_Zip(js_State *J) {
         level = ZIP_DEFAULT_COMPRESSION_LEVEL;
     }
 
+    if (!z->readable) {
+        flush_zipcache(fname);
+    }
+
     z->zip = zip_open(fname, level, mode[0]);
     if (!z->zip) {
         js_error(J, "cannot open ZIP '%s'", fname);
@@ -312,31 +396,25 @@ static void Zip_ReadBytes(js_State *J) {
         js_error(J, "ZIP was not opened for reading!");
         return;
     } else {
-        uint8_t *buf = NULL;
-        size_t bufsize;
-
+        uint8_t buf[ZIP_READ_CHUNK];
         const char *zip_name = js_tostring(J, 1);
 
-        if (zip_entry_open(z->zip, zip_name) < 0) {
-            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_open)!", zip_name);
-            return;
-        }
-        if (zip_entry_read(z->zip, (void **)&buf, &bufsize) < 0) {
-            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_open)!", zip_name);
-            return;
-        }
-        if (zip_entry_close(z->zip) < 0) {
-            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_close)!", zip_name);
-            free(buf);
-            return;
-        }
+        struct zip_entry_reader_t *reader = Zip_OpenReader(J, z, zip_name);
 
         js_newarray(J);
-        for (int i = 0; i < bufsize; i++) {
-            js_pushnumber(J, buf[i]);
-            js_setindex(J, -2, i);
+        int idx = 0;
+        ssize_t got;
+        while ((got = zip_entry_reader_read(reader, buf, sizeof(buf))) > 0) {
+            for (int i = 0; i < got; i++) {
+                js_pushnumber(J, buf[i]);
+                js_setindex(J, -2, idx++);
+            }
+        }
+        zip_entry_reader_close(reader);
+        if (got < 0) {
+            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_reader_read)!", zip_name);
+            return;
         }
-        free(buf);
     }
 }
 
@@ -357,26 +435,38 @@ static void Zip_ReadInts(js_State *J) {
         js_error(J, "ZIP was not opened for reading!");
         return;
     } else {
-        uint8_t *buf = NULL;
-        size_t bufsize;
-
         const char *zip_name = js_tostring(J, 1);
 
-        if (zip_entry_open(z->zip, zip_name) < 0) {
-            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_open)!", zip_name);
+        struct zip_entry_reader_t *reader = Zip_OpenReader(J, z, zip_name);
+
+        // inflate directly into the ByteArray
+        byte_array_t *ba = calloc(sizeof(byte_array_t), 1);
+        if (!ba) {
+            zip_entry_reader_close(reader);
+            JS_ENOMEM(J);
             return;
         }
-        if (zip_entry_read(z->zip, (void **)&buf, &bufsize) < 0) {
-            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_open)!", zip_name);
+        uint32_t size = zip_entry_reader_size(reader);
+        ba->data = malloc(MAX(size, 1) * sizeof(BA_TYPE));
+        if (!ba->data) {
+            zip_entry_reader_close(reader);
+            free(ba);
+            JS_ENOMEM(J);
             return;
         }
-        if (zip_entry_close(z->zip) < 0) {
-            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_close)!", zip_name);
-            free(buf);
+        ssize_t got = zip_entry_reader_read(reader, ba->data, size);
+        zip_entry_reader_close(reader);
+        if (got != size) {
+            free(ba->data);
+            free(ba);
+            js_error(J, "Could not extract entry '%s' from ZIP (zip_entry_reader_read)!", zip_name);
             return;
         }
-        ByteArray_fromBytes(J, buf, bufsize);
-        free(buf);
+        ba->alloc_size = MAX(size, 1);
+        ba->size = size;
+        gc_native_alloc(ba->alloc_size * sizeof(BA_TYPE));
+
+        ByteArray_fromStruct(J, ba);
     }
 }
 
@@ -476,101 +566,337 @@ static void Zip_WriteInts(js_State *J) {
 }
 
 /*----------------------------------------------------------------------*/
-/*                memory vtable                                         */
+/*                archive cache                                         */
 /*----------------------------------------------------------------------*/
 
-/* The packfile data for our memory reader. */
-typedef struct MEMREAD_INFO {
-    AL_CONST unsigned char *block;
-    long unsigned int length;
-    long unsigned int offset;
-} MEMREAD_INFO;
+/**
+ * @brief hash an entry name the way zip_entry_open() compares names (case insensitive, '\' equals '/').
+ *
+ * @param name the entry name.
+ *
+ * @return uint32_t the hash.
+ */
+static uint32_t zipcache_hash(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (; *name; name++) {
+        int c = *name == '\\' ? '/' : tolower((unsigned char)*name);
+        hash = (hash ^ (uint8_t)c) * 16777619u;
+    }
+    return hash;
+}
 
-static int memread_getc(void *userdata) {
-    MEMREAD_INFO *info = userdata;
-    ASSERT(info);
-    ASSERT(info->offset <= info->length);
+/**
+ * @brief compare two entry names the way zip_entry_open() does.
+ *
+ * @param a normalized entry name from the index.
+ * @param b entry name as requested.
+ *
+ * @return true if the names match.
+ */
+static bool zipcache_match(const char *a, const char *b) {
+    for (; *a && *b; a++, b++) {
+        int c = *b == '\\' ? '/' : tolower((unsigned char)*b);
+        if (*a != c) {
+            return false;
+        }
+    }
+    return *a == *b;
+}
 
-    if (info->offset == info->length) {
-        return EOF;
-    } else {
-        return info->block[info->offset++];
+/**
+ * @brief drop a reference to a cached archive, close it and free its index when it was the last one.
+ *
+ * @param za the cached archive.
+ */
+static void zipcache_release(zipcache_archive_t *za) {
+    if (--za->refs > 0) {
+        return;
     }
+    if (za->entries) {
+        for (size_t i = 0; i < za->capacity; i++) {
+            free(za->entries[i].name);
+        }
+        free(za->entries);
+    }
+    if (za->zip) {
+        zip_close(za->zip);
+    }
+    free(za->path);
+    free(za);
 }
 
-static int memread_ungetc(int c, void *userdata) {
-    MEMREAD_INFO *info = userdata;
-    unsigned char ch = c;
+/**
+ * @brief build the name index of a freshly opened archive.
+ *
+ * @param za the cached archive with a valid 'zip'.
+ *
+ * @return true if the index could be created, false on errors.
+ */
+static bool zipcache_index(zipcache_archive_t *za) {
+    ssize_t total = zip_entries_total(za->zip);
+    if (total < 0) {
+        return false;
+    }
+    za->num_entries = total;
 
-    if ((info->offset > 0) && (info->block[info->offset - 1] == ch)) {
-        return ch;
-    } else {
-        return EOF;
+    // keep the table at most half full
+    za->capacity = 16;
+    while (za->capacity < za->num_entries * 2) {
+        za->capacity *= 2;
+    }
+    za->entries = calloc(za->capacity, sizeof(zipcache_entry_t));
+    if (!za->entries) {
+        return false;
     }
+
+    for (size_t i = 0; i < za->num_entries; i++) {
+        if (zip_entry_openbyindex(za->zip, i) < 0) {
+            return false;
+        }
+        const char *ename = zip_entry_name(za->zip);
+        char *name = ut_clone_string(ename ? ename : "");
+        zip_entry_close(za->zip);
+        if (!name) {
+            return false;
+        }
+        for (char *c = name; *c; c++) {
+            *c = *c == '\\' ? '/' : tolower((unsigned char)*c);
+        }
+
+        uint32_t hash = zipcache_hash(name);
+        size_t slot = hash & (za->capacity - 1);
+        while (za->entries[slot].name) {
+            if (za->entries[slot].hash == hash && !strcmp(za->entries[slot].name, name)) {
+                break;  // duplicate name, the first entry wins
+            }
+            slot = (slot + 1) & (za->capacity - 1);
+        }
+        if (za->entries[slot].name) {
+            free(name);
+        } else {
+            za->entries[slot].name = name;
+            za->entries[slot].hash = hash;
+            za->entries[slot].index = i;
+        }
+    }
+    return true;
 }
 
-static int memread_putc(int c, void *userdata) { return EOF; }
+/**
+ * @brief get an open archive from the cache, open (and index) it if necessary.
+ *
+ * @param zname path of the archive.
+ *
+ * @return zipcache_archive_t* the cached archive or NULL if it can't be opened.
+ */
+static zipcache_archive_t *zipcache_get(const char *zname) {
+    struct stat st;
+    if (stat(zname, &st) != 0) {
+        zipcache_stats.failed++;
+        return NULL;
+    }
 
-static long memread_fread(void *p, long n, void *userdata) {
-    MEMREAD_INFO *info = userdata;
-    size_t actual;
-    ASSERT(info);
-    ASSERT(info->offset <= info->length);
+    int victim = 0;
+    for (int i = 0; i < ZIP_CACHE_SIZE; i++) {
+        zipcache_archive_t *za = zipcache[i];
+        if (za && !strcmp(za->path, zname)) {
+            if (za->mtime == st.st_mtime && za->size == st.st_size) {
+                zipcache_stats.hits++;
+                za->last_use = ++zipcache_clock;
+                return za;
+            }
+            DEBUGF("ZIP cache: '%s' changed on disk\n", zname);
+            zipcache_stats.stale++;
+            zipcache_release(za);
+            zipcache[i] = za = NULL;
+        }
+        if (zipcache[victim] && (!za || za->last_use < zipcache[victim]->last_use)) {
+            victim = i;
+        }
+    }
 
-    actual = MIN(n, info->length - info->offset);
+    zipcache_stats.misses++;
+    if (zipcache[victim]) {
+        DEBUGF("ZIP cache: evicting '%s'\n", zipcache[victim]->path);
+        zipcache_stats.evictions++;
+        zipcache_release(zipcache[victim]);
+        zipcache[victim] = NULL;
+    }
 
-    memcpy(p, info->block + info->offset, actual);
-    info->offset += actual;
+    zipcache_archive_t *za = calloc(1, sizeof(zipcache_archive_t));
+    if (!za) {
+        zipcache_stats.failed++;
+        return NULL;
+    }
+    za->refs = 1;
+    za->path = ut_clone_string(zname);
+    za->zip = zip_open(zname, 0, 'r');
+    if (!za->path || !za->zip || !zipcache_index(za)) {
+        zipcache_stats.failed++;
+        zipcache_release(za);
+        return NULL;
+    }
+    za->mtime = st.st_mtime;
+    za->size = st.st_size;
+    za->last_use = ++zipcache_clock;
+    zipcache[victim] = za;
+    DEBUGF("ZIP cache: opened '%s' with %ld entries\n", zname, (long)za->num_entries);
+    return za;
+}
 
-    ASSERT(info->offset <= info->length);
+/**
+ * @brief open an entry of an archive through the cache.
+ *
+ * @param zname path of the archive.
+ * @param ename name of the entry.
+ *
+ * @return zipcache_archive_t* the archive with the entry opened (close it with zip_entry_close()) or NULL if the entry does not exist.
+ */
+static zipcache_archive_t *zipcache_open_entry(const char *zname, const char *ename) {
+    zipcache_archive_t *za = zipcache_get(zname);
+    if (!za) {
+        return NULL;
+    }
 
-    return actual;
+    uint32_t hash = zipcache_hash(ename);
+    size_t slot = hash & (za->capacity - 1);
+    while (za->entries[slot].name) {
+        if (za->entries[slot].hash == hash && zipcache_match(za->entries[slot].name, ename)) {
+            if (zip_entry_openbyindex(za->zip, za->entries[slot].index) < 0) {
+                break;
+            }
+            return za;
+        }
+        slot = (slot + 1) & (za->capacity - 1);
+    }
+    zipcache_stats.failed++;
+    return NULL;
 }
 
-static long memread_fwrite(AL_CONST void *p, long n, void *userdata) { return 0; }
+/**
+ * @brief get statistics of the ZIP archive cache.
+ * ZipCacheStats():ZipCacheInfo
+ *
+ * @param J VM state.
+ */
+static void f_ZipCacheStats(js_State *J) {
+    int open = 0;
+    for (int i = 0; i < ZIP_CACHE_SIZE; i++) {
+        if (zipcache[i]) {
+            open++;
+        }
+    }
 
-static int memread_seek(void *userdata, int offset) {
-    MEMREAD_INFO *info = userdata;
-    long actual;
-    ASSERT(info);
-    ASSERT(info->offset <= info->length);
+    js_newobject(J);
+    {
+        js_pushnumber(J, zipcache_stats.hits);
+        js_setproperty(J, -2, "hits");
+        js_pushnumber(J, zipcache_stats.misses);
+        js_setproperty(J, -2, "misses");
+        js_pushnumber(J, zipcache_stats.stale);
+        js_setproperty(J, -2, "stale");
+        js_pushnumber(J, zipcache_stats.evictions);
+        js_setproperty(J, -2, "evictions");
+        js_pushnumber(J, zipcache_stats.failed);
+        js_setproperty(J, -2, "failed");
+        js_pushnumber(J, open);
+        js_setproperty(J, -2, "open");
+        js_pushnumber(J, ZIP_CACHE_SIZE);
+        js_setproperty(J, -2, "size");
+    }
+}
 
-    actual = MIN(offset, info->length - info->offset);
+/**
+ * @brief close all archives kept open by the ZIP archive cache.
+ * ZipCacheFlush()
+ *
+ * @param J VM state.
+ */
+static void f_ZipCacheFlush(js_State *J) { flush_zipcache(NULL); }
 
-    info->offset += actual;
+/*----------------------------------------------------------------------*/
+/*                stream vtable                                         */
+/*----------------------------------------------------------------------*/
 
-    ASSERT(info->offset <= info->length);
+/**
+ * @brief inflate the next window of a stream.
+ *
+ * @param zs the stream.
+ *
+ * @return true if data is available, false at the end of the entry or on errors.
+ */
+static bool zipstream_fill(zipstream_t *zs) {
+    zs->window_pos += zs->length;
+    zs->offset = zs->length = 0;
+
+    ssize_t got = zip_entry_reader_read(zs->reader, zs->window, ZIPSTREAM_WINDOW);
+    if (got < 0) {
+        zs->error = true;
+        return false;
+    }
+    zs->length = got;
+    return got > 0;
+}
+
+static int zipstream_getc(void *userdata) {
+    zipstream_t *zs = userdata;
 
-    if (offset == actual) {
-        return 0;
+    if (zs->offset == zs->length && !zipstream_fill(zs)) {
+        return EOF;
+    }
+    return zs->window[zs->offset++];
+}
+
+static int zipstream_ungetc(int c, void *userdata) {
+    zipstream_t *zs = userdata;
+    unsigned char ch = c;
+
+    if ((zs->offset > 0) && (zs->window[zs->offset - 1] == ch)) {
+        zs->offset--;
+        return ch;
     } else {
+        return EOF;
+    }
+}
+
+static int zipstream_putc(int c, void *userdata) { return EOF; }
+
+static long zipstream_fread(void *p, long n, void *userdata) { return read_zipstream(userdata, p, n); }
+
+static long zipstream_fwrite(AL_CONST void *p, long n, void *userdata) { return 0; }
+
+static int zipstream_fseek(void *userdata, int offset) {
+    zipstream_t *zs = userdata;
+
+    // PACKFILE seeking is relative and forward only
+    if (offset < 0) {
         return -1;
     }
+    return seek_zipstream(zs, tell_zipstream(zs) + offset) ? 0 : -1;
 }
 
-static int memread_fclose(void *userdata) {
-    MEMREAD_INFO *info = userdata;
-    free((void *)info->block);
-    free(info);
+static int zipstream_fclose(void *userdata) {
+    close_zipstream(userdata);
     return 0;
 }
 
-static int memread_feof(void *userdata) {
-    MEMREAD_INFO *info = userdata;
+static int zipstream_feof(void *userdata) {
+    zipstream_t *zs = userdata;
 
-    return info->offset >= info->length;
+    return tell_zipstream(zs) >= zs->size;
 }
 
-static int memread_ferror(void *userdata) {
-    (void)userdata;
+static int zipstream_ferror(void *userdata) {
+    zipstream_t *zs = userdata;
 
-    return FALSE;
+    return zs->error;
 }
 
 /* The actual vtable. Note that writing is not supported, the functions for
  * writing above are only placeholders.
  */
-static PACKFILE_VTABLE memread_vtable = {memread_fclose, memread_getc, memread_ungetc, memread_fread, memread_putc, memread_fwrite, memread_seek, memread_feof, memread_ferror};
+static PACKFILE_VTABLE zipstream_vtable = {zipstream_fclose, zipstream_getc,   zipstream_ungetc, zipstream_fread,  zipstream_putc,
+                                           zipstream_fwrite, zipstream_fseek, zipstream_feof,   zipstream_ferror};
 
 /***********************
 ** exported functions **
@@ -598,11 +924,14 @@ void init_zipfile(js_State *J) {
     }
     CTORDEF(J, new_Zip, TAG_ZIP, 3);
 
+    NFUNCDEF(J, ZipCacheStats, 0);
+    NFUNCDEF(J, ZipCacheFlush, 0);
+
     DEBUGF("%s DONE\n", __PRETTY_FUNCTION__);
 }
 
 /**
- * @brief read an entry from a ZIP file into memory and provide its contents as a PACKFILE.
+ * @brief provide the contents of a ZIP file entry as a PACKFILE. The entry is inflated on demand while reading.
  *
  * @param zname name of the ZIP file.
  * @param ename name of the entry.
@@ -610,36 +939,20 @@ void init_zipfile(js_State *J) {
  * @return PACKFILE* on success, NULL on failure.
  */
 PACKFILE *open_zipfile2(const char *zname, const char *ename) {
-    MEMREAD_INFO *info = malloc(sizeof(MEMREAD_INFO));
-    if (!info) {
+    zipstream_t *zs = open_zipstream2(zname, ename);
+    if (!zs) {
         return NULL;
     }
-    info->offset = 0;
 
-    struct zip_t *zip = zip_open(zname, 0, 'r');
-    if (!zip) {
-        free(info);
-        return NULL;
-    }
-
-    if (zip_entry_open(zip, ename) < 0) {
-        zip_close(zip);
-        free(info);
-        return NULL;
-    }
-    if (zip_entry_read(zip, (void **)&info->block, &info->length) < 0) {
-        zip_close(zip);
-        free(info);
-        return NULL;
+    PACKFILE *pf = pack_fopen_vtable(&zipstream_vtable, zs);
+    if (!pf) {
+        close_zipstream(zs);
     }
-    zip_entry_close(zip);
-    zip_close(zip);
-
-    return pack_fopen_vtable(&memread_vtable, info);
+    return pf;
 }
 
 /**
- * @brief read an entry from a ZIP file into memory and provide its contents as a PACKFILE.
+ * @brief provide the contents of a ZIP file entry as a PACKFILE. The entry is inflated on demand while reading.
  *
  * @param fname a filename in the format of "<zip file>=<entry name>".
  *
@@ -725,26 +1038,22 @@ bool read_zipfile2(const char *zname, const char *ename, void **buf, size_t *siz
     *size = 0;
     *buf = NULL;
 
-    struct zip_t *zip = zip_open(zname, 0, 'r');
-    if (!zip) {
-        return false;
-    }
-
-    if (zip_entry_open(zip, ename) < 0) {
-        zip_close(zip);
+    zipcache_archive_t *za = zipcache_open_entry(zname, ename);
+    if (!za) {
         return false;
     }
+    struct zip_t *zip = za->zip;
     *size = zip_entry_size(zip);
     *buf = malloc(*size + 1);
     char *b = *buf;
     if (!*buf) {
-        zip_close(zip);
+        zip_entry_close(zip);
         *size = 0;
         *buf = NULL;
         return false;
     }
     if (zip_entry_noallocread(zip, *buf, *size) < 0) {
-        zip_close(zip);
+        zip_entry_close(zip);
         free(*buf);
         *size = 0;
         *buf = NULL;
@@ -752,7 +1061,6 @@ bool read_zipfile2(const char *zname, const char *ename, void **buf, size_t *siz
     }
     b[*size] = 0;  // always null-terminate data
     zip_entry_close(zip);
-    zip_close(zip);
 
     return true;
 }
@@ -797,17 +1105,187 @@ bool check_zipfile1(const char *fname) {
  * @return true if the ZIP file and the entry could be found, else false.
  */
 bool check_zipfile2(const char *zname, const char *ename) {
-    struct zip_t *zip = zip_open(zname, 0, 'r');
-    if (!zip) {
+    zipcache_archive_t *za = zipcache_open_entry(zname, ename);
+    if (!za) {
         return false;
     }
+    zip_entry_close(za->zip);
+
+    return true;
+}
+
+/**
+ * @brief open a ZIP file entry for reading. The entry is inflated on demand in small windows instead of being loaded into memory as a whole.
+ *
+ * @param fname a filename in the format of "<zip file>=<entry name>".
+ *
+ * @return zipstream_t* the stream or NULL on failure.
+ */
+zipstream_t *open_zipstream1(const char *fname) {
+    char *delim = strchr(fname, ZIP_DELIM);
+
+    if (!delim) {
+        return NULL;
+    }
+
+    // get memory for a copy of the filename
+    int flen = strlen(fname) + 1;
+    char *zname = malloc(flen);
+    if (!zname) {
+        return NULL;
+    }
+    memcpy(zname, fname, flen);
+    int idx = delim - fname;
+    zname[idx] = 0;
+    char *ename = &zname[idx + 1];
+
+    zipstream_t *ret = open_zipstream2(zname, ename);
+
+    free(zname);
+    return ret;
+}
+
+/**
+ * @brief open a ZIP file entry for reading. The entry is inflated on demand in small windows instead of being loaded into memory as a whole.
+ *
+ * @param zname name of the ZIP file.
+ * @param ename name of the entry.
+ *
+ * @return zipstream_t* the stream or NULL on failure.
+ */
+zipstream_t *open_zipstream2(const char *zname, const char *ename) {
+    zipstream_t *zs = calloc(1, sizeof(zipstream_t));
+    if (!zs) {
+        return NULL;
+    }
+
+    zipcache_archive_t *za = zipcache_open_entry(zname, ename);
+    if (!za) {
+        free(zs);
+        return NULL;
+    }
+    zs->reader = zip_entry_reader_open(za->zip, ZIPSTREAM_CHECKPOINT);
+    zip_entry_close(za->zip);
+    if (!zs->reader) {
+        free(zs);
+        return NULL;
+    }
+
+    // keep the archive open even if it is evicted from the cache
+    zs->archive = za;
+    za->refs++;
+    zs->size = zip_entry_reader_size(zs->reader);
+
+    return zs;
+}
+
+/**
+ * @brief read from a ZIP file entry.
+ *
+ * @param zs the stream.
+ * @param buf destination buffer.
+ * @param n number of bytes to read.
+ *
+ * @return long number of bytes actually read, less than n at the end of the entry or on errors.
+ */
+long read_zipstream(zipstream_t *zs, void *buf, long n) {
+    uint8_t *dst = buf;
+    long total = 0;
+
+    while (total < n) {
+        if (zs->offset == zs->length) {
+            if (n - total >= ZIPSTREAM_WINDOW) {
+                // large reads bypass the window
+                zs->window_pos += zs->length;
+                zs->offset = zs->length = 0;
+                ssize_t got = zip_entry_reader_read(zs->reader, dst + total, n - total);
+                if (got < 0) {
+                    zs->error = true;
+                } else {
+                    zs->window_pos += got;
+                    total += got;
+                }
+                break;
+            }
+            if (!zipstream_fill(zs)) {
+                break;
+            }
+        }
+        long chunk = MIN(n - total, zs->length - zs->offset);
+        memcpy(dst + total, &zs->window[zs->offset], chunk);
+        zs->offset += chunk;
+        total += chunk;
+    }
+    return total;
+}
 
-    if (zip_entry_open(zip, ename) < 0) {
-        zip_close(zip);
+/**
+ * @brief move the read position of a ZIP file entry.
+ * Seeking backwards inflates the entry again from the nearest checkpoint, so it is much slower than seeking in a plain file.
+ *
+ * @param zs the stream.
+ * @param pos the new absolute position.
+ *
+ * @return true on success, false if pos is beyond the end of the entry or on errors.
+ */
+bool seek_zipstream(zipstream_t *zs, unsigned long pos) {
+    if (pos >= zs->window_pos && pos <= zs->window_pos + zs->length) {
+        zs->offset = pos - zs->window_pos;
+        return true;
+    }
+    if (pos > zs->size) {
         return false;
     }
-    zip_entry_close(zip);
-    zip_close(zip);
 
+    zs->offset = zs->length = 0;
+    if (zip_entry_reader_seek(zs->reader, pos) < 0) {
+        zs->window_pos = zip_entry_reader_tell(zs->reader);
+        zs->error = true;
+        return false;
+    }
+    zs->window_pos = pos;
     return true;
 }
+
+/**
+ * @brief get the read position of a ZIP file entry.
+ *
+ * @param zs the stream.
+ *
+ * @return unsigned long the current position.
+ */
+unsigned long tell_zipstream(zipstream_t *zs) { return zs->window_pos + zs->offset; }
+
+/**
+ * @brief get the uncompressed size of a ZIP file entry.
+ *
+ * @param zs the stream.
+ *
+ * @return unsigned long the size in bytes.
+ */
+unsigned long size_zipstream(zipstream_t *zs) { return zs->size; }
+
+/**
+ * @brief close a ZIP file entry opened with open_zipstream1() or open_zipstream2().
+ *
+ * @param zs the stream.
+ */
+void close_zipstream(zipstream_t *zs) {
+    zip_entry_reader_close(zs->reader);
+    zipcache_release(zs->archive);
+    free(zs);
+}
+
+/**
+ * @brief close archives kept open by the archive cache. Must be called before an archive is modified.
+ *
+ * @param zname name of the ZIP file or NULL to close all archives.
+ */
+void flush_zipcache(const char *zname) {
+    for (int i = 0; i < ZIP_CACHE_SIZE; i++) {
+        if (zipcache[i] && (!zname || !strcmp(zipcache[i]->path, zname))) {
+            zipcache_release(zipcache[i]);
+            zipcache[i] = NULL;
+        }
+    }
+}
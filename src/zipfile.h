@@ -32,6 +32,11 @@ SOFTWARE.
 #define ZIP_DELIM '='
 #define ZIP_DELIM_STR "="
 
+/************
+** structs **
+************/
+typedef struct zipstream zipstream_t;  //!< a ZIP file entry that is inflated on demand
+
 /***********************
 ** exported functions **
 ***********************/
@@ -42,5 +47,13 @@ extern bool read_zipfile1(const char *fname, void **buf, size_t *size);
 extern bool read_zipfile2(const char *zname, const char *ename, void **buf, size_t *size);
 extern bool check_zipfile1(const char *fname);
 extern bool check_zipfile2(const char *zname, const char *ename);
+extern zipstream_t *open_zipstream1(const char *fname);
+extern zipstream_t *open_zipstream2(const char *zname, const char *ename);
+extern long read_zipstream(zipstream_t *zs, void *buf, long n);
+extern bool seek_zipstream(zipstream_t *zs, unsigned long pos);
+extern unsigned long tell_zipstream(zipstream_t *zs);
+extern unsigned long size_zipstream(zipstream_t *zs);
+extern void close_zipstream(zipstream_t *zs);
+extern void flush_zipcache(const char *zname);
 
 #endif  // __ZIP_H__
@@ -0,0 +1,49 @@
+LoadLibrary("png");
+LoadLibrary("jpeg");
+
+var images = [];
+var progress = 0;
+var angle = 0;
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+    SetFramerate(30);
+
+    // the spinner must keep turning while the images are decoded
+    ["tests/rose.jpg", "tests/test.jpg", "tests/test.png", "tests/testgrad.png", "tests/missing.png"].forEach(function (f) {
+        LoadBitmapAsync(f, function (bm, err) {
+            if (bm) {
+                images.push(bm);
+            } else {
+                Println(err);
+            }
+        }, function (p) {
+            progress = p;
+        });
+    });
+
+    // cancelled loads never call back
+    var id = LoadBitmapAsync("tests/rose.jpg", function () {
+        throw new Error("cancelled load delivered");
+    });
+    CancelBitmapLoad(id);
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+    ClearScreen(EGA.BLACK);
+
+    var x = 0;
+    images.forEach(function (bm) {
+        bm.Draw(x, 40);
+        x += bm.width;
+    });
+
+    angle += 0.2;
+    CustomLine(40, SizeY() - 40, 40 + Math.cos(angle) * 30, SizeY() - 40 + Math.sin(angle) * 30, 5, EGA.WHITE);
+    TextXY(80, SizeY() - 40, "pending=" + BitmapLoadsPending() + " progress=" + Math.round(progress * 100) + "% fps=" + GetFramerate(), EGA.WHITE, NO_COLOR);
+}
@@ -0,0 +1,71 @@
+/*
+** Measures the blending speed of all BLEND_* modes in Mpixels/s for FilledBox() and Bitmap.DrawTrans().
+*/
+var ITERATIONS = 50;
+var SIZE = 200;
+
+var MODES = [
+	"ALPHA",
+	"ADD",
+	"DARKEST",
+	"LIGHTEST",
+	"DIFFERENCE",
+	"EXCLUSION",
+	"MULTIPLY",
+	"SCREEN",
+	"OVERLAY",
+	"HARD_LIGHT",
+	"DOGE",
+	"BURN",
+	"SUBSTRACT"
+];
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+	// sprite with a gradient in alpha and color, created without blending so the alpha values are kept
+	TransparencyEnabled(BLEND.REPLACE);
+	var data = new IntArray();
+	for (var y = 0; y < SIZE; y++) {
+		for (var x = 0; x < SIZE; x++) {
+			data.Push(Color(x % 256, y % 256, (x + y) % 256, (x * 255 / SIZE) & 0xFF));
+		}
+	}
+	var sprite = new Bitmap(data, SIZE, SIZE);
+	var pixels = ITERATIONS * SIZE * SIZE;
+
+	// some background so the blenders have something to work with
+	for (var i = 0; i < 16; i++) {
+		FilledBox(i * 20, 0, i * 20 + 19, SizeY(), Color(i * 16, 255 - i * 16, 128));
+	}
+
+	Println("Blend kernels: " + BlendKernels());
+	Println("mode       FilledBox  DrawTrans   [Mpixels/s]");
+	for (var m = 0; m < MODES.length; m++) {
+		TransparencyEnabled(BLEND[MODES[m]]);
+
+		var start = MsecTime();
+		for (var i = 0; i < ITERATIONS; i++) {
+			FilledBox(10, 10, 10 + SIZE - 1, 10 + SIZE - 1, Color(200, 100, 50, 128));
+		}
+		var fill = pixels / ((MsecTime() - start) || 1) / 1000;
+
+		start = MsecTime();
+		for (var i = 0; i < ITERATIONS; i++) {
+			sprite.DrawTrans(10, 10);
+		}
+		var sprt = pixels / ((MsecTime() - start) || 1) / 1000;
+
+		Println(pad(MODES[m], 10) + " " + pad(fill.toFixed(2), 10) + " " + pad(sprt.toFixed(2), 10));
+	}
+	TransparencyEnabled(BLEND.ALPHA);
+	Stop();
+}
+
+function pad(s, len) {
+	while (s.length < len) {
+		s += " ";
+	}
+	return s;
+}
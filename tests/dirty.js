@@ -0,0 +1,35 @@
+var x = 0;
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+    SetFramerate(60);
+    ClearScreen(EGA.BLACK);
+    SetPresentMode(PRESENT.DIRTY);
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+    // erase old box, draw new one
+    FilledBox(x, 100, x + 20, 120, EGA.BLACK);
+    x = (x + 2) % (SizeX() - 20);
+    FilledBox(x, 100, x + 20, 120, EGA.YELLOW);
+
+    var s = PresentStats();
+    FilledBox(10, 10, 300, 20, EGA.BLACK);
+    TextXY(10, 10, "rects=" + s.rects + " bytes=" + s.bytes + " frames=" + s.frames, EGA.WHITE);
+}
+
+/*
+** This function is called on any input.
+*/
+function Input(e) {
+    if (CompareKey(e.key, 'f')) {
+        SetPresentMode(PRESENT.FULL);
+    } else if (CompareKey(e.key, 'd')) {
+        SetPresentMode(PRESENT.DIRTY);
+    }
+}
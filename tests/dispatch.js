@@ -0,0 +1,92 @@
+/*
+** Interpreter dispatch micro benchmark.
+**
+** Runs small loops that are dominated by bytecode dispatch and prints the
+** executed bytecodes per second. Compare a build with the default threaded
+** dispatch against one where MuJS was built with XCFLAGS=-DJS_THREADED=0.
+**
+** "instr" is the number of bytecodes one loop iteration executes with the
+** bytecode optimizer enabled (counted with a MuJS built with -DJS_OPSTATS).
+** The figures are not exact when running with '-o'.
+*/
+var ITERATIONS = 100000;
+
+var KERNELS = [
+	{ name: "arith", func: k_arith, instr: 16 },
+	{ name: "call", func: k_call, instr: 20 },
+	{ name: "prop", func: k_prop, instr: 27 },
+	{ name: "array", func: k_array, instr: 22 }
+];
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+	var total = 0;
+	for (var i = 0; i < KERNELS.length; i++) {
+		var k = KERNELS[i];
+		var sw = new StopWatch();
+		sw.Start();
+		k.func(ITERATIONS);
+		sw.Stop();
+		var ms = Math.max(sw.ResultMs(), 1);
+		var ips = ITERATIONS * k.instr * 1000 / ms;
+		total += ips;
+		Println(k.name + ": " + ms + "ms, " + Math.round(ips / 1000) + " kbytecodes/s");
+	}
+	Println("average: " + Math.round(total / KERNELS.length / 1000) + " kbytecodes/s");
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+	Stop();
+}
+
+function Input(e) {
+}
+
+function k_arith(n) {
+	var s = 0;
+	for (var i = 0; i < n; i++) {
+		s = (s + i * 3) & 0xFFFF;
+	}
+	return s;
+}
+
+function add(a, b) {
+	return a + b;
+}
+
+function k_call(n) {
+	var s = 0;
+	for (var i = 0; i < n; i++) {
+		s = add(s, i) & 0xFFFF;
+	}
+	return s;
+}
+
+function k_prop(n) {
+	var p = { x: 0, vx: 1 };
+	for (var i = 0; i < n; i++) {
+		p.x += p.vx;
+		if (p.x > 100) {
+			p.vx = -1;
+		} else if (p.x < 0) {
+			p.vx = 1;
+		}
+	}
+	return p.x;
+}
+
+function k_array(n) {
+	var a = [], i;
+	for (i = 0; i < 256; i++) {
+		a[i] = i;
+	}
+	for (i = 0; i < n; i++) {
+		a[i & 255] = a[(i + 1) & 255] + 1;
+	}
+	return a[0];
+}
@@ -0,0 +1,76 @@
+var NUM = 2000;
+var parts = [];
+var cmds = [];
+var dl;
+var mode = 0;
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+    SetFramerate(60);
+    dl = new DrawList();
+
+    // the Bitmap references of a DrawList can't be replaced or dropped by scripts
+    var bl = new DrawList();
+    bl.Draw(new Bitmap(8, 8), 0, 0);
+    try {
+        bl.__bitmaps__ = [];
+        bl.__bitmaps__.length = 0;
+        bl.Execute(new Bitmap(16, 16));
+        Println("DrawList references: not detected");
+    } catch (e) {
+        Println("DrawList references: " + e);
+    }
+    for (var i = 0; i < NUM; i++) {
+        parts.push({ x: Math.random() * SizeX(), y: Math.random() * SizeY(), dx: Math.random() * 4 - 2, dy: Math.random() * 4 - 2 });
+    }
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+    var start = MsecTime();
+
+    ClearScreen(EGA.BLACK);
+    for (var i = 0; i < NUM; i++) {
+        var p = parts[i];
+        p.x = (p.x + p.dx + SizeX()) % SizeX();
+        p.y = (p.y + p.dy + SizeY()) % SizeY();
+    }
+
+    if (mode == 0) {
+        // one native call per primitive
+        for (var i = 0; i < NUM; i++) {
+            FilledCircle(parts[i].x, parts[i].y, 2, EGA.YELLOW);
+        }
+    } else if (mode == 1) {
+        // DrawList methods, one Execute()
+        dl.Clear();
+        for (var i = 0; i < NUM; i++) {
+            dl.FilledCircle(parts[i].x, parts[i].y, 2, EGA.LIGHT_GREEN);
+        }
+        dl.Execute();
+    } else {
+        // encoded in a plain array, one Append() and one Execute()
+        cmds.length = 0;
+        for (var i = 0; i < NUM; i++) {
+            cmds.push(DL.FILLEDCIRCLE, parts[i].x, parts[i].y, 2, EGA.LIGHT_CYAN);
+        }
+        dl.Clear();
+        dl.Append(cmds);
+        dl.Execute();
+    }
+
+    TextXY(10, 10, ["direct", "DrawList", "DL array"][mode] + ": " + (MsecTime() - start) + "ms (SPACE to switch)", EGA.WHITE, EGA.BLACK);
+}
+
+/*
+** This function is called on any input.
+*/
+function Input(e) {
+    if (CompareKey(e.key, ' ')) {
+        mode = (mode + 1) % 3;
+    }
+}
@@ -21,7 +21,6 @@ SOFTWARE.
 */
 
 Include("qoi");
-Include("qoienc");
 
 function Setup() {
 	var start = MsecTime();
@@ -42,8 +41,7 @@ function Setup() {
 
 	// save resulting image
 	var bm = new Bitmap(0, 0, Width, Height);
-	//EncodeQoi(bm);
-	SaveQoiImage(bm, "test.qoi");
+	bm.SaveQoiImage("test.qoi");
 	var end = MsecTime();
 
 	Println("Runtime   := " + (end - start) + "ms");
@@ -0,0 +1,42 @@
+var objects = [];
+var budgets = [0, 1, 2, 5];
+var current = 2;
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+    SetFramerate(60);
+    SetGcBudget(budgets[current]);
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+    // produce plenty of garbage while keeping a large live heap
+    for (var i = 0; i < 2000; i++) {
+        objects[(Math.random() * 20000) | 0] = { x: i, y: [i, i * 2], name: "obj" + i };
+    }
+
+    var s = GcStats();
+    ClearScreen(EGA.BLACK);
+    TextXY(10, 10, "Budget     : " + s.budget + "ms (press SPACE to change)", EGA.WHITE);
+    TextXY(10, 20, "State      : " + ["idle", "mark", "sweep"][s.state], EGA.WHITE);
+    TextXY(10, 30, "Heap       : " + s.heap + " / trigger " + s.trigger, EGA.WHITE);
+    TextXY(10, 40, "Collections: " + s.collections + ", steps " + s.steps, EGA.WHITE);
+    TextXY(10, 50, "Full pause : last " + s.last_pause.toFixed(2) + "ms, max " + s.max_pause.toFixed(2) + "ms", EGA.WHITE);
+    TextXY(10, 60, "Step pause : last " + s.last_step.toFixed(2) + "ms, max " + s.max_step.toFixed(2) + "ms", EGA.WHITE);
+    TextXY(10, 70, "GC in frame: " + s.frame.toFixed(2) + "ms", EGA.WHITE);
+    TextXY(10, 80, "FPS        : " + GetFramerate(), EGA.WHITE);
+}
+
+/*
+** This function is called on any input.
+*/
+function Input(e) {
+    if (CompareKey(e.key, ' ')) {
+        current = (current + 1) % budgets.length;
+        SetGcBudget(budgets[current]);
+    }
+}
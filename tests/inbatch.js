@@ -0,0 +1,40 @@
+var lines = [];
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+    SetFramerate(10);
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+    ClearScreen(EGA.BLACK);
+    TextXY(10, 10, "Type fast, the events of one frame are shown in one line", EGA.WHITE);
+    for (var i = 0; i < lines.length; i++) {
+        TextXY(10, 30 + i * 10, lines[i], EGA.LIGHT_GREEN);
+    }
+}
+
+/*
+** This function is called once per frame with all events since the last frame.
+*/
+function InputBatch(events) {
+    var txt = events.length + " events:";
+    for (var i = 0; i < events.length; i++) {
+        var e = events[i];
+        if (e.joystick >= 0) {
+            txt += " J" + e.joystick + "=" + e.buttons + "@" + e.ticks;
+        } else if (e.key != -1) {
+            txt += " " + String.fromCharCode(e.key & 0xFF) + "@" + e.ticks;
+        } else {
+            txt += " M" + e.x + "/" + e.y + "@" + e.ticks;
+        }
+    }
+    lines.push(txt);
+    if (lines.length > 40) {
+        lines.shift();
+    }
+}
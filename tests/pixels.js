@@ -0,0 +1,35 @@
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+	bm = new Bitmap(256, 256);
+	var t = 0;
+	SetFramerate(30);
+}
+
+var t = 0;
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+	// ARGB view
+	var px = bm.LockPixels();
+	for (var y = 0; y < px.height; y++) {
+		var line = y * px.stride;
+		for (var x = 0; x < px.width; x++) {
+			px[line + x] = Color(x ^ y, (x + t) & 0xFF, (y + t) & 0xFF);
+		}
+	}
+	bm.UnlockPixels();
+
+	// RGBA byte view: clear the red channel of the upper half
+	var bytes = bm.LockPixels(true);
+	for (var i = 0; i < bytes.length / 2; i += 4) {
+		bytes[i] = 0;
+	}
+	bm.UnlockPixels();
+
+	bm.Draw(10, 10);
+	t += 4;
+}
@@ -0,0 +1,49 @@
+var FNAME = "RECORD.FLC";
+var FRAMES = 150;
+
+var angle = 0;
+var frame = 0;
+var playing = false;
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+    SetFramerate(30);
+    FlicRecordStart(FNAME);
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+    if (playing) {
+        // play back what was recorded
+        if (FlicPlay(0, 0, false) < 0) {
+            FlicClose();
+            Stop();
+        }
+        return;
+    }
+
+    ClearScreen(EGA.BLACK);
+
+    // moving objects on a static background, only a few lines change every frame
+    for (var i = 0; i < 8; i++) {
+        var x = SizeX() / 2 + Math.cos(angle + i * Math.PI / 4) * 100;
+        var y = SizeY() / 2 + Math.sin(angle + i * Math.PI / 4) * 100;
+        FilledCircle(x, y, 15, Color(i * 32, 255 - i * 32, 128));
+    }
+    angle += 0.05;
+
+    var st = FlicRecordStats();
+    TextXY(10, 10, "frame=" + frame + " recorded=" + st.frames + " repeated=" + st.repeated + " skipped=" + st.skipped + " bytes=" + st.bytes, EGA.WHITE, NO_COLOR);
+
+    frame++;
+    if (frame >= FRAMES) {
+        FlicRecordStop();
+        Println(JSON.stringify(FlicRecordStats()));
+        FlicOpen(FNAME);
+        playing = true;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+** String building benchmark.
+**
+** Builds the same CSV text with `+=`, with an Array and join() and with a
+** StringBuilder and prints the time each method needs.
+*/
+var ROWS = 20000;
+
+var METHODS = [
+	{ name: "+=", func: m_concat },
+	{ name: "join", func: m_join },
+	{ name: "StringBuilder", func: m_builder }
+];
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+	var expected = null;
+	for (var i = 0; i < METHODS.length; i++) {
+		var m = METHODS[i];
+		var sw = new StopWatch();
+		sw.Start();
+		var txt = m.func(ROWS);
+		sw.Stop();
+		if (expected === null) {
+			expected = txt;
+		}
+		Println(m.name + ": " + sw.ResultMs() + "ms, " + txt.length + " chars" + (txt === expected ? "" : " MISMATCH"));
+	}
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+	Stop();
+}
+
+function Input(e) {
+}
+
+function m_concat(n) {
+	var s = "";
+	for (var i = 0; i < n; i++) {
+		s += i + ";" + (i * 2) + ";row " + i + "\n";
+	}
+	return s;
+}
+
+function m_join(n) {
+	var a = [];
+	for (var i = 0; i < n; i++) {
+		a.push(i + ";" + (i * 2) + ";row " + i + "\n");
+	}
+	return a.join("");
+}
+
+function m_builder(n) {
+	var sb = new StringBuilder();
+	for (var i = 0; i < n; i++) {
+		sb.Append(i, ";", i * 2, ";row ", i, "\n");
+	}
+	return sb.ToString();
+}
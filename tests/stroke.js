@@ -0,0 +1,36 @@
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+    SetFramerate(30);
+    ClearScreen(EGA.BLACK);
+
+    // with blending every pixel must be hit exactly once, overdraw shows up as brighter spots
+    TransparencyEnabled(BLEND.ALPHA);
+    var c = Color(255, 255, 0, 128);
+    for (var w = 1; w < 16; w += 2) {
+        CustomLine(20, 10 + w * 6, 200, 30 + w * 6, w, c, CAP.ROUND);
+        CustomLine(240, 10 + w * 6, 420, 30 + w * 6, w, c, CAP.SQUARE);
+        CustomLine(460, 10 + w * 6, 620, 30 + w * 6, w, c, CAP.PROJECT);
+    }
+    CustomCircle(100, 300, 60, 12, c);
+    CustomEllipse(300, 300, 90, 40, 9, c);
+    var arc = CustomCircleArc(500, 300, 70, 0, 160, 15, c);
+    TransparencyEnabled(BLEND.REPLACE);
+    Plot(arc.startX, arc.startY, EGA.RED);
+    Plot(arc.endX, arc.endY, EGA.RED);
+
+    // a ring crosses most scanlines twice, more separate spans than the buffer starts with. The gap must stay empty
+    var bm = new Bitmap(64, 64);
+    SetRenderBitmap(bm);
+    ClearScreen(EGA.BLACK);
+    CustomCircle(32, 32, 20, 3, EGA.WHITE);
+    SetRenderBitmap(null);
+    Println("stroke spans: " + (bm.GetPixel(32, 32) === EGA.BLACK) + " " + (bm.GetPixel(20, 32) === EGA.BLACK) + " " + (bm.GetPixel(12, 32) === EGA.WHITE) + " " + (bm.GetPixel(52, 32) === EGA.WHITE));
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+}
@@ -0,0 +1,67 @@
+var N = 100000;
+
+var bm = new Bitmap(256, 256);
+var pixels = new Uint32Array(bm.GetBuffer());
+var shift = 0;
+
+function bench(name, f) {
+	var start = MsecTime();
+	f();
+	Println(name + ": " + (MsecTime() - start) + "ms");
+}
+
+/*
+** This function is called once when the script is started.
+*/
+function Setup() {
+	var arr = [], ta = new Float64Array(N), ia = new IntArray();
+	for (var i = 0; i < N; i++) {
+		arr.push(0);
+		ia.Push(i);
+	}
+
+	bench("Array       ", function () { for (var i = 0; i < N; i++) { arr[i] = i * 0.5; } for (var i = 0, s = 0; i < N; i++) { s += arr[i]; } });
+	bench("Float64Array", function () { for (var i = 0; i < N; i++) { ta[i] = i * 0.5; } for (var i = 0, s = 0; i < N; i++) { s += ta[i]; } });
+
+	// the view shares the IntArray storage and follows its length
+	var view = new Int32Array(ia.GetBuffer());
+	view[10] = -1;
+	ia.Push(42);
+	Println("IntArray: " + ia.Get(10) + " " + view.length + " " + view[N]);
+
+	// the second load is served from the image cache as a sub-bitmap, GetBuffer() gives it its own pixels
+	var img1 = new Bitmap("tests/testgrad.png");
+	var img2 = new Bitmap("tests/testgrad.png");
+	var buf1 = new Uint32Array(img1.GetBuffer());
+	var buf2 = new Uint32Array(img2.GetBuffer());
+	buf2[0] = 0xFF123456;
+	Println("GetBuffer(file): " + buf1.length + " " + (((buf1[1] | 0xFF000000) >>> 0) === img1.GetPixel(1, 0)) + " " + (img2.GetPixel(0, 0) === 0xFF123456) + " " + (img1.GetPixel(0, 0) !== 0xFF123456));
+
+	// lengths that don't fit must throw instead of being clamped
+	var lengths = [1e12, -1, 1.5, Infinity];
+	for (var i = 0; i < lengths.length; i++) {
+		try {
+			new ArrayBuffer(lengths[i]);
+			Println("ArrayBuffer(" + lengths[i] + "): no error");
+		} catch (e) {
+			Println("ArrayBuffer(" + lengths[i] + "): " + (e instanceof RangeError ? "RangeError" : e));
+		}
+	}
+
+	var dv = new DataView(new ArrayBuffer(8));
+	dv.setUint32(0, 0x11223344);
+	Println("DataView: " + dv.getUint8(0).toString(16) + " " + dv.getUint32(0, true).toString(16));
+}
+
+/*
+** This function is repeatedly until ESC is pressed or Stop() is called.
+*/
+function Loop() {
+	for (var y = 0; y < 256; y++) {
+		for (var x = 0; x < 256; x++) {
+			pixels[y * 256 + x] = 0xFF000000 | (((x + shift) & 0xFF) << 16) | (y << 8) | ((x ^ y) & 0xFF);
+		}
+	}
+	bm.Draw(0, 0);
+	shift++;
+}